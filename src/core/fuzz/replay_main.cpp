@@ -0,0 +1,86 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by kaichiuchu <kaichiuchu@protonmail.com>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+// Compilers without libFuzzer get this driver instead, which runs the fuzz
+// target once on every file named on the command line, and on every file of
+// every directory named on it. Arguments starting with a dash are libFuzzer
+// flags and are ignored, so both builds can be invoked the same way.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern "C" auto LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+    -> int;
+
+namespace {
+/// Runs the fuzz target on the contents of a file.
+///
+/// \param path The path to the file.
+///
+/// \returns true if the file was read, or false otherwise.
+auto RunInput(const std::filesystem::path& path) noexcept -> bool {
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file) {
+    std::fprintf(stderr, "Unable to open %s\n", path.string().c_str());
+    return false;
+  }
+
+  const std::vector<uint8_t> input(std::istreambuf_iterator<char>(file), {});
+  LLVMFuzzerTestOneInput(input.data(), input.size());
+
+  return true;
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  size_t num_inputs = 0;
+  auto failed = false;
+
+  for (auto index = 1; index < argc; ++index) {
+    if (argv[index][0] == '-') {
+      continue;
+    }
+
+    const std::filesystem::path path(argv[index]);
+    std::error_code error_code;
+
+    if (!std::filesystem::is_directory(path, error_code)) {
+      failed |= !RunInput(path);
+      ++num_inputs;
+      continue;
+    }
+
+    // Sort the corpus so that runs are reproducible.
+    std::vector<std::filesystem::path> paths;
+
+    for (std::filesystem::directory_iterator it(path, error_code), end;
+         !error_code && (it != end); it.increment(error_code)) {
+      paths.push_back(it->path());
+    }
+
+    std::sort(paths.begin(), paths.end());
+
+    for (const auto& input_path : paths) {
+      failed |= !RunInput(input_path);
+      ++num_inputs;
+    }
+  }
+
+  std::printf("Executed %zu inputs\n", num_inputs);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by kaichiuchu <kaichiuchu@protonmail.com>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+// This fuzz target runs arbitrary guest programs, starting from arbitrary
+// register state and fed an arbitrary schedule of key presses, through
+// VMInstance. Inputs are laid out as follows:
+//
+//   offset  size  contents
+//   0       1     bits 0-1: variant (0 and 3: CHIP-8, 1: SUPER-CHIP,
+//                 2: XO-CHIP), bits 2-6: quirks, in the order of \ref Quirks
+//   1       16    V0 to VF
+//   17      2     I, big-endian
+//   19      1     delay timer
+//   20      1     sound timer
+//   21      1     number of key events, at most kMaxKeyEvents
+//   22      2*n   key events: the frame to apply the event before, then the
+//                 key in bits 0-3 and whether it is pressed in bit 4
+//   22+2*n  rest  the program
+//
+// Memory errors are left to the sanitizers; the target itself aborts if the
+// virtual machine ever ends up in a state no instruction should lead to.
+
+#include <core/analysis.h>
+#include <core/rom_database.h>
+#include <core/vm_instance.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+/// The number of bytes before the key events.
+constexpr size_t kHeaderSize = 22;
+
+/// The most key events an input may schedule.
+constexpr size_t kMaxKeyEvents = 16;
+
+/// The number of frames each input runs for.
+constexpr unsigned int kNumFrames = 30;
+
+/// The number of instructions executed per second. Along with the frame rate
+/// below this makes for 100 steps per frame, which is plenty to reach deep
+/// into a program while keeping thousands of executions per second.
+constexpr unsigned int kInstructionsPerSecond = 6000;
+
+/// The frame rate the virtual machine runs at.
+constexpr double kFrameRate = 60.0;
+
+/// Decodes the variant and quirks of an input.
+///
+/// \param config The first byte of the input.
+///
+/// \returns The profile to run the program with.
+auto DecodeProfile(const uint8_t config) noexcept -> chip8::RomProfile {
+  chip8::RomProfile profile;
+
+  switch (config & 0b11) {
+    case 1:
+      profile.variant_ = chip8::Variant::kSuperChip;
+      break;
+
+    case 2:
+      profile.variant_ = chip8::Variant::kXoChip;
+      break;
+
+    default:
+      profile.variant_ = chip8::Variant::kChip8;
+      break;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  profile.quirks_.shift_uses_vy_ = (config & (1 << 2)) != 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  profile.quirks_.load_store_increments_i_ = (config & (1 << 3)) != 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  profile.quirks_.jump_uses_vx_ = (config & (1 << 4)) != 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  profile.quirks_.logic_resets_vf_ = (config & (1 << 5)) != 0;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  profile.quirks_.clip_sprites_ = (config & (1 << 6)) != 0;
+
+  return profile;
+}
+
+/// Aborts if the state of the virtual machine is one that no instruction
+/// should be able to produce.
+///
+/// \param impl The implementation to check.
+void CheckInvariants(const chip8::ImplementationInterface& impl) noexcept {
+  const auto memory_size = impl.GetMemorySize();
+
+  // The next instruction must be entirely within memory.
+  if ((impl.program_counter_ + chip8::data_size::kInstructionLength) >
+      memory_size) {
+    std::abort();
+  }
+
+  if ((impl.stack_pointer_ < chip8::initial_values::kStackPointer) ||
+      (impl.stack_pointer_ >= chip8::data_size::kStack)) {
+    std::abort();
+  }
+
+  if (impl.I_ > chip8::data_limits::kIndexRegister) {
+    std::abort();
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  if (impl.selected_planes_ > 0b11) {
+    std::abort();
+  }
+}
+}  // namespace
+
+extern "C" auto LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+    -> int {
+  if (size < kHeaderSize) {
+    return 0;
+  }
+
+  const auto num_key_events = std::min<size_t>(data[21], kMaxKeyEvents);
+  const auto* key_events = data + kHeaderSize;
+  const auto program_offset = kHeaderSize + (num_key_events * 2);
+
+  if (size < program_offset) {
+    return 0;
+  }
+
+  // The core works with uint_fast8_t, which need not be a byte.
+  const std::vector<uint_fast8_t> program(data + program_offset, data + size);
+
+  // The analysis is only ever fed programs the virtual machine accepted, but
+  // it has to cope with whatever those contain.
+  static_cast<void>(chip8::analysis::AnalyzeProgram(program));
+
+  // The program is run with the variant and quirks chosen by the input rather
+  // than whatever the database might know it as.
+  auto& rom_database = chip8::RomDatabase::Get();
+  const auto hash =
+      chip8::analysis::HashProgram(program.data(), program.size());
+
+  rom_database.SetOverride(hash, DecodeProfile(data[0]));
+
+  chip8::VMInstance vm_instance;
+  const auto loaded = vm_instance.LoadProgram(program);
+
+  rom_database.ClearOverride(hash);
+
+  if (!loaded) {
+    return 0;
+  }
+
+  vm_instance.SetKeyWaitMode(chip8::VMInstance::KeyWaitMode::kIdle);
+  vm_instance.SetTiming(kInstructionsPerSecond, kFrameRate);
+
+  auto& impl = *vm_instance.impl_;
+
+  for (size_t index = 0; index < impl.V_.size(); ++index) {
+    impl.V_[index] = data[1 + index];
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  impl.I_ = (data[17] << 8) | data[18];
+  impl.SetDelayTimerValue(data[19]);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  impl.sound_timer_ = data[20];
+
+  // Touch every pixel of every screen update so that a bad framebuffer is
+  // noticed right away, rather than when it happens to be displayed.
+  unsigned int lit_pixels = 0;
+
+  vm_instance.update_screen_func_ = [&lit_pixels](
+                                        const chip8::Screen& screen) {
+    for (auto y = 0U; y < screen.GetHeight(); ++y) {
+      for (auto x = 0U; x < screen.GetWidth(); ++x) {
+        lit_pixels += screen.GetPixel(x, y) != 0;
+      }
+    }
+  };
+
+  for (unsigned int frame = 0; frame < kNumFrames; ++frame) {
+    for (size_t index = 0; index < num_key_events; ++index) {
+      const auto* event = key_events + (index * 2);
+
+      if (event[0] != frame) {
+        continue;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+      const auto key = static_cast<chip8::Key>(event[1] & 0xF);
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+      const auto state = ((event[1] & 0x10) != 0) ? chip8::KeyState::kPressed
+                                                  : chip8::KeyState::kReleased;
+
+      vm_instance.QueueKeyState(key, state);
+    }
+
+    const auto step_result = vm_instance.RunForOneFrame();
+
+    // Errors are how the virtual machine is supposed to reject bad programs,
+    // but they must leave it in a sane state all the same.
+    CheckInvariants(impl);
+
+    if (step_result != chip8::StepResult::kSuccess) {
+      break;
+    }
+  }
+
+  return 0;
+}
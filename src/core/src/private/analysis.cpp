@@ -0,0 +1,556 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include <core/analysis.h>
+
+#include <algorithm>
+
+namespace {
+/// Defines how an instruction affects the flow of control.
+enum class Flow {
+  /// Control continues at the next instruction.
+  kNext,
+
+  /// Control continues at the address of the instruction.
+  kJump,
+
+  /// Control continues at the address of the instruction, and comes back to
+  /// the next instruction.
+  kCall,
+
+  /// Control continues at the next instruction, or the one after it.
+  kSkip,
+
+  /// Control goes back to the caller.
+  kReturn,
+
+  /// Control continues at an address only known when the program runs.
+  kIndirectJump,
+
+  /// The program stops.
+  kExit,
+
+  /// The instruction can't be executed.
+  kInvalid
+};
+
+/// Determines how an instruction affects the flow of control.
+///
+/// \param instruction The instruction to process.
+///
+/// \returns The effect of the instruction on the flow of control.
+auto GetFlow(const chip8::Instruction& instruction) noexcept -> Flow {
+  switch (instruction.group_) {
+    case chip8::instruction_groups::kControlFlowAndScreen:
+      switch (instruction.byte_) {
+        case chip8::control_flow_and_screen_instructions::kCLS:
+        case chip8::control_flow_and_screen_instructions::kSCR:
+        case chip8::control_flow_and_screen_instructions::kSCL:
+        case chip8::control_flow_and_screen_instructions::kLOW:
+        case chip8::control_flow_and_screen_instructions::kHIGH:
+          return Flow::kNext;
+
+        case chip8::control_flow_and_screen_instructions::kRET:
+          return Flow::kReturn;
+
+        case chip8::control_flow_and_screen_instructions::kEXIT:
+          return Flow::kExit;
+
+        default:
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+          switch (instruction.byte_ & 0xF0) {
+            case chip8::control_flow_and_screen_instructions::kSCD:
+            case chip8::control_flow_and_screen_instructions::kSCU:
+              return Flow::kNext;
+
+            default:
+              return Flow::kInvalid;
+          }
+      }
+
+    case chip8::ungrouped_instructions::kJP_Address:
+      return Flow::kJump;
+
+    case chip8::ungrouped_instructions::kCALL_Address:
+      return Flow::kCall;
+
+    case chip8::ungrouped_instructions::kSE_Vx_Vy:
+      switch (instruction.nibble_) {
+        case chip8::register_range_instructions::kLD_I_Vx_Vy:
+        case chip8::register_range_instructions::kLD_Vx_Vy_I:
+          return Flow::kNext;
+
+        default:
+          return Flow::kSkip;
+      }
+
+    case chip8::ungrouped_instructions::kSE_Vx_Imm:
+    case chip8::ungrouped_instructions::kSNE_Vx_Imm:
+    case chip8::ungrouped_instructions::kSNE_Vx_Vy:
+      return Flow::kSkip;
+
+    case chip8::ungrouped_instructions::kLD_Vx_Imm:
+    case chip8::ungrouped_instructions::kADD:
+    case chip8::ungrouped_instructions::kLD_I_Addr:
+    case chip8::ungrouped_instructions::kRND:
+    case chip8::ungrouped_instructions::kDRW:
+      return Flow::kNext;
+
+    case chip8::ungrouped_instructions::kJP_V0_Addr:
+      return Flow::kIndirectJump;
+
+    case chip8::instruction_groups::kMath:
+      switch (instruction.nibble_) {
+        case chip8::math_instructions::kLD:
+        case chip8::math_instructions::kOR:
+        case chip8::math_instructions::kAND:
+        case chip8::math_instructions::kXOR:
+        case chip8::math_instructions::kADD:
+        case chip8::math_instructions::kSUB:
+        case chip8::math_instructions::kSHR_Vx:
+        case chip8::math_instructions::kSUBN:
+        case chip8::math_instructions::kSHL_Vx:
+          return Flow::kNext;
+
+        default:
+          return Flow::kInvalid;
+      }
+
+    case chip8::instruction_groups::kKeyboardControlFlow:
+      switch (instruction.byte_) {
+        case chip8::keyboard_control_flow_instructions::kSKP:
+        case chip8::keyboard_control_flow_instructions::kSKNP:
+          return Flow::kSkip;
+
+        default:
+          return Flow::kInvalid;
+      }
+
+    case chip8::instruction_groups::kTimerAndMemoryControl:
+      switch (instruction.byte_) {
+        case chip8::timer_and_memory_control_instructions::kPLANE:
+        case chip8::timer_and_memory_control_instructions::kLD_PITCH_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_Vx_DT:
+        case chip8::timer_and_memory_control_instructions::kLD_Vx_K:
+        case chip8::timer_and_memory_control_instructions::kLD_DT_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_ST_Vx:
+        case chip8::timer_and_memory_control_instructions::kADD_I_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_F_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_B_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_I_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_Vx_I:
+        case chip8::timer_and_memory_control_instructions::kLD_HF_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_R_Vx:
+        case chip8::timer_and_memory_control_instructions::kLD_Vx_R:
+          return Flow::kNext;
+
+        case chip8::timer_and_memory_control_instructions::kLD_I_Long:
+        case chip8::timer_and_memory_control_instructions::kLD_AUDIO_I:
+          return (instruction.x_ == 0) ? Flow::kNext : Flow::kInvalid;
+
+        default:
+          return Flow::kInvalid;
+      }
+
+    default:
+      return Flow::kInvalid;
+  }
+}
+
+/// Determines the length of an instruction. Every instruction is two bytes
+/// long, except for the XO-CHIP `LD I, NNNN` instruction, which is followed
+/// by its address.
+///
+/// \param instruction The instruction to process.
+///
+/// \returns The length of the instruction, in bytes.
+auto GetLength(const chip8::Instruction& instruction) noexcept -> size_t {
+  if ((instruction.group_ ==
+       chip8::instruction_groups::kTimerAndMemoryControl) &&
+      (instruction.x_ == 0) &&
+      (instruction.byte_ ==
+       chip8::timer_and_memory_control_instructions::kLD_I_Long)) {
+    return chip8::data_size::kLongInstructionLength;
+  }
+  return chip8::data_size::kInstructionLength;
+}
+
+/// Gives access to the instructions of a program by address.
+///
+/// Only the part of the program within the classic 4 KB of internal memory is
+/// visible; the rest of an XO-CHIP program is almost always data, and the
+/// analysis stays a fixed size.
+class ProgramView {
+ public:
+  ProgramView(const uint_fast8_t* program, const size_t program_size) noexcept
+      : program_(program),
+        end_(chip8::memory_region::kProgramArea +
+             std::min<size_t>(program_size,
+                              chip8::memory_region::kProgramAreaSize)) {}
+
+  /// Determines whether or not a whole instruction lies within the program.
+  ///
+  /// \param address The address of the instruction.
+  ///
+  /// \returns true if the instruction lies within the program, or false
+  /// otherwise.
+  auto Contains(const uint_fast16_t address) const noexcept -> bool {
+    return (address >= chip8::memory_region::kProgramArea) &&
+           ((address + chip8::data_size::kInstructionLength) <= end_);
+  }
+
+  /// Retrieves an instruction; it must lie within the program.
+  ///
+  /// \param address The address of the instruction.
+  ///
+  /// \returns The instruction.
+  auto Fetch(const uint_fast16_t address) const noexcept
+      -> chip8::Instruction {
+    const auto offset = address - chip8::memory_region::kProgramArea;
+    return chip8::Instruction((program_[offset] << 8) | program_[offset + 1]);
+  }
+
+  /// Retrieves the address of the instruction following the next one, which
+  /// is where a skip goes to.
+  ///
+  /// \param next The address of the next instruction.
+  ///
+  /// \returns The address an instruction skipping \p next continues at.
+  auto GetSkipTarget(const uint_fast16_t next) const noexcept -> size_t {
+    if (!Contains(next)) {
+      return next + chip8::data_size::kInstructionLength;
+    }
+    return next + GetLength(Fetch(next));
+  }
+
+  /// Retrieves the address just past the end of the program.
+  ///
+  /// \returns The end of the program.
+  auto GetEnd() const noexcept -> size_t { return end_; }
+
+ private:
+  /// The program data.
+  const uint_fast8_t* program_;
+
+  /// The address just past the end of the program.
+  size_t end_;
+};
+
+/// The addresses of instructions, or bytes, within internal memory.
+using AddressSet = std::bitset<chip8::data_size::kInternalMemory>;
+}  // namespace
+
+auto chip8::analysis::ProgramAnalysis::FindBlock(
+    const uint_fast16_t address) const noexcept -> const BasicBlock* {
+  // Find the last block starting at or before the address.
+  const auto next_block =
+      std::upper_bound(blocks_.cbegin(), blocks_.cend(), address,
+                       [](const uint_fast16_t block_address,
+                          const BasicBlock& block) {
+                         return block_address < block.start_;
+                       });
+
+  if (next_block == blocks_.cbegin()) {
+    return nullptr;
+  }
+
+  const auto& block = *std::prev(next_block);
+  return (address < block.end_) ? &block : nullptr;
+}
+
+auto chip8::analysis::ProgramAnalysis::IsCode(
+    const uint_fast16_t address) const noexcept -> bool {
+  return (address < code_.size()) && code_[address];
+}
+
+auto chip8::analysis::AnalyzeProgram(const uint_fast8_t* program,
+                                     const size_t program_size) noexcept
+    -> ProgramAnalysis {
+  ProgramAnalysis analysis;
+  const ProgramView view{program, program_size};
+
+  // First, find every reachable instruction, and where blocks have to start:
+  // the targets of branches and the instructions following them.
+  AddressSet reachable;
+  AddressSet block_starts;
+  std::vector<uint_fast16_t> pending;
+
+  const auto visit = [&view, &reachable, &block_starts, &pending](
+                         const uint_fast16_t address, const bool block_start) {
+    if (!view.Contains(address)) {
+      return;
+    }
+
+    if (block_start) {
+      block_starts.set(address);
+    }
+
+    if (!reachable[address]) {
+      reachable.set(address);
+      pending.push_back(address);
+    }
+  };
+
+  visit(memory_region::kProgramArea, true);
+
+  if (view.Contains(memory_region::kProgramArea)) {
+    analysis.subroutines_.push_back(memory_region::kProgramArea);
+  }
+
+  while (!pending.empty()) {
+    const auto address = pending.back();
+    pending.pop_back();
+
+    const auto instruction = view.Fetch(address);
+    const auto next = address + GetLength(instruction);
+
+    for (auto byte = address;
+         byte < std::min<size_t>(next, analysis.code_.size()); ++byte) {
+      analysis.code_.set(byte);
+    }
+
+    switch (GetFlow(instruction)) {
+      case Flow::kNext:
+        visit(next, false);
+        break;
+
+      case Flow::kJump:
+        visit(instruction.address_, true);
+        break;
+
+      case Flow::kCall:
+        if (view.Contains(instruction.address_)) {
+          analysis.subroutines_.push_back(instruction.address_);
+        }
+        visit(instruction.address_, true);
+        visit(next, true);
+        break;
+
+      case Flow::kSkip:
+        visit(next, true);
+        visit(view.GetSkipTarget(next), true);
+        break;
+
+      case Flow::kIndirectJump:
+        analysis.indirect_jumps_.push_back(address);
+        break;
+
+      case Flow::kReturn:
+      case Flow::kExit:
+      case Flow::kInvalid:
+        break;
+    }
+  }
+
+  // Then, form the blocks by running from each block start until control
+  // leaves, or the next block starts.
+  for (size_t start = memory_region::kProgramArea; start < view.GetEnd();
+       ++start) {
+    if (!block_starts[start]) {
+      continue;
+    }
+
+    BasicBlock block{static_cast<uint_fast16_t>(start), 0,
+                     BlockExit::kFallThrough, {}};
+
+    const auto add_successor = [&view, &block](const uint_fast16_t address) {
+      if (view.Contains(address)) {
+        block.successors_.push_back(address);
+      }
+    };
+
+    auto address = block.start_;
+
+    for (;;) {
+      const auto instruction = view.Fetch(address);
+      const auto next = address + GetLength(instruction);
+      const auto flow = GetFlow(instruction);
+
+      block.end_ = next;
+
+      if (flow == Flow::kNext) {
+        if (!view.Contains(next)) {
+          block.exit_ = BlockExit::kLeavesProgram;
+          break;
+        }
+
+        if (block_starts[next]) {
+          block.exit_ = BlockExit::kFallThrough;
+          add_successor(next);
+          break;
+        }
+
+        address = next;
+        continue;
+      }
+
+      switch (flow) {
+        case Flow::kJump:
+          block.exit_ = BlockExit::kJump;
+          add_successor(instruction.address_);
+          break;
+
+        case Flow::kCall:
+          block.exit_ = BlockExit::kCall;
+          add_successor(next);
+          break;
+
+        case Flow::kSkip:
+          block.exit_ = BlockExit::kSkip;
+          add_successor(next);
+          add_successor(view.GetSkipTarget(next));
+          break;
+
+        case Flow::kReturn:
+          block.exit_ = BlockExit::kReturn;
+          break;
+
+        case Flow::kIndirectJump:
+          block.exit_ = BlockExit::kIndirectJump;
+          break;
+
+        case Flow::kExit:
+          block.exit_ = BlockExit::kExit;
+          break;
+
+        default:
+          block.exit_ = BlockExit::kInvalid;
+          break;
+      }
+      break;
+    }
+    analysis.blocks_.push_back(std::move(block));
+  }
+
+  // Now that the blocks are known, walk each subroutine to build the call
+  // graph. Subroutines aren't entered, calls continue at the next block.
+  std::sort(analysis.subroutines_.begin(), analysis.subroutines_.end());
+  analysis.subroutines_.erase(
+      std::unique(analysis.subroutines_.begin(), analysis.subroutines_.end()),
+      analysis.subroutines_.end());
+
+  for (const auto subroutine : analysis.subroutines_) {
+    AddressSet walked;
+    std::vector<uint_fast16_t> blocks_to_walk{subroutine};
+
+    while (!blocks_to_walk.empty()) {
+      const auto block_start = blocks_to_walk.back();
+      blocks_to_walk.pop_back();
+
+      if (walked[block_start]) {
+        continue;
+      }
+      walked.set(block_start);
+
+      const auto* block = analysis.FindBlock(block_start);
+
+      if (block == nullptr) {
+        continue;
+      }
+
+      if (block->exit_ == BlockExit::kCall) {
+        const auto call_address = block->end_ - data_size::kInstructionLength;
+
+        analysis.calls_.push_back(
+            {subroutine, static_cast<uint_fast16_t>(call_address),
+             static_cast<uint_fast16_t>(view.Fetch(call_address).address_)});
+      }
+
+      for (const auto successor : block->successors_) {
+        blocks_to_walk.push_back(successor);
+      }
+    }
+  }
+
+  std::sort(analysis.calls_.begin(), analysis.calls_.end(),
+            [](const CallSite& lhs, const CallSite& rhs) {
+              if (lhs.caller_ != rhs.caller_) {
+                return lhs.caller_ < rhs.caller_;
+              }
+              return lhs.address_ < rhs.address_;
+            });
+  std::sort(analysis.indirect_jumps_.begin(), analysis.indirect_jumps_.end());
+
+  // Whatever isn't code within the program is data, as far as we can tell.
+  for (size_t address = memory_region::kProgramArea;
+       address < std::min<size_t>(view.GetEnd(), analysis.data_.size());
+       ++address) {
+    analysis.data_[address] = !analysis.code_[address];
+  }
+  return analysis;
+}
+
+auto chip8::analysis::HashProgram(const uint_fast8_t* program,
+                                  const size_t program_size) noexcept
+    -> uint64_t {
+  constexpr uint64_t kOffsetBasis = 0xCBF29CE484222325;
+  constexpr uint64_t kPrime = 0x100000001B3;
+
+  auto hash = kOffsetBasis;
+
+  for (size_t index = 0; index < program_size; ++index) {
+    hash ^= program[index];
+    hash *= kPrime;
+  }
+  return hash;
+}
+
+auto chip8::analysis::AnalysisCache::Get() noexcept -> AnalysisCache& {
+  static AnalysisCache analysis_cache;
+  return analysis_cache;
+}
+
+auto chip8::analysis::AnalysisCache::Analyze(const uint_fast8_t* program,
+                                             const size_t program_size) noexcept
+    -> std::shared_ptr<const ProgramAnalysis> {
+  const auto hash = HashProgram(program, program_size);
+
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  const auto entry = std::find_if(
+      entries_.begin(), entries_.end(),
+      [hash, program, program_size](const Entry& cached) {
+        return (cached.hash_ == hash) &&
+               std::equal(cached.program_.cbegin(), cached.program_.cend(),
+                          program, program + program_size);
+      });
+
+  if (entry != entries_.end()) {
+    // Move the program to the back, it's now the most recently used.
+    std::rotate(entry, std::next(entry), entries_.end());
+    return entries_.back().analysis_;
+  }
+
+  if (entries_.size() == kMaxEntries) {
+    entries_.erase(entries_.begin());
+  }
+
+  auto analysis = std::make_shared<const ProgramAnalysis>(
+      AnalyzeProgram(program, program_size));
+  num_analyses_++;
+
+  entries_.push_back(
+      {hash, std::vector<uint_fast8_t>(program, program + program_size),
+       analysis});
+  return analysis;
+}
+
+auto chip8::analysis::AnalysisCache::GetNumberOfAnalyses() const noexcept
+    -> uintmax_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return num_analyses_;
+}
+
+void chip8::analysis::AnalysisCache::Clear() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  entries_.clear();
+}
@@ -11,149 +11,571 @@
 // <http://creativecommons.org/publicdomain/zero/1.0/>.
 
 #include <core/disasm.h>
-#include <fmt/core.h>
 
-auto chip8::debug::DisassembleInstruction(
-    const chip8::Instruction& instruction) noexcept -> std::string {
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+namespace {
+/// Identifies the text of an instruction, see \ref kTemplates.
+enum Template : uint8_t {
+  kSCD,
+  kSCU,
+  kCLS,
+  kRET,
+  kSCR,
+  kSCL,
+  kEXIT,
+  kLOW,
+  kHIGH,
+  kJP_Address,
+  kCALL_Address,
+  kSE_Vx_Imm,
+  kSNE_Vx_Imm,
+  kSE_Vx_Vy,
+  kLD_I_Vx_Vy,
+  kLD_Vx_Vy_I,
+  kLD_Vx_Imm,
+  kADD_Vx_Imm,
+  kLD_Vx_Vy,
+  kOR,
+  kAND,
+  kXOR,
+  kADD_Vx_Vy,
+  kSUB,
+  kSHR,
+  kSUBN,
+  kSHL,
+  kSNE_Vx_Vy,
+  kLD_I_Addr,
+  kJP_V0_Addr,
+  kRND,
+  kDRW,
+  kSKP,
+  kSKNP,
+  kLD_I_Long,
+  kPLANE,
+  kLD_AUDIO_I,
+  kLD_Vx_DT,
+  kLD_Vx_K,
+  kLD_DT_Vx,
+  kLD_ST_Vx,
+  kADD_I_Vx,
+  kLD_F_Vx,
+  kLD_HF_Vx,
+  kLD_B_Vx,
+  kLD_I_Vx,
+  kLD_Vx_I,
+  kLD_R_Vx,
+  kLD_Vx_R,
+  kLD_PITCH_Vx,
+  kIllegal,
+  kNumTemplates
+};
+
+/// The text of every instruction, indexed by \ref Template.
+///
+/// Lowercase letters are replaced by the operands of the instruction:
+///
+/// - \p x and \p y: the register numbers, as a hexadecimal digit
+/// - \p k: the lowest 8 bits, as 2 hexadecimal digits
+/// - \p a: the lowest 12 bits, as 4 hexadecimal digits
+/// - \p n: the lowest 4 bits, in decimal
+/// - \p v: the whole instruction, as 4 hexadecimal digits
+constexpr std::array<std::string_view, kNumTemplates> kTemplates{
+    "SCD n",          // kSCD
+    "SCU n",          // kSCU
+    "CLS",            // kCLS
+    "RET",            // kRET
+    "SCR",            // kSCR
+    "SCL",            // kSCL
+    "EXIT",           // kEXIT
+    "LOW",            // kLOW
+    "HIGH",           // kHIGH
+    "JP $a",          // kJP_Address
+    "CALL $a",        // kCALL_Address
+    "SE Vx, $k",      // kSE_Vx_Imm
+    "SNE Vx, $k",     // kSNE_Vx_Imm
+    "SE Vx, Vy",      // kSE_Vx_Vy
+    "LD [I], Vx-Vy",  // kLD_I_Vx_Vy
+    "LD Vx-Vy, [I]",  // kLD_Vx_Vy_I
+    "LD Vx, $k",      // kLD_Vx_Imm
+    "ADD Vx, $k",     // kADD_Vx_Imm
+    "LD Vx, Vy",      // kLD_Vx_Vy
+    "OR Vx, Vy",      // kOR
+    "AND Vx, Vy",     // kAND
+    "XOR Vx, Vy",     // kXOR
+    "ADD Vx, Vy",     // kADD_Vx_Vy
+    "SUB Vx, Vy",     // kSUB
+    "SHR Vx",         // kSHR
+    "SUBN Vx, Vy",    // kSUBN
+    "SHL Vx",         // kSHL
+    "SNE Vx, Vy",     // kSNE_Vx_Vy
+    "LD I, $a",       // kLD_I_Addr
+    "JP V0, $a",      // kJP_V0_Addr
+    "RND Vx, $k",     // kRND
+    "DRW Vx, Vy, n",  // kDRW
+    "SKP Vx",         // kSKP
+    "SKNP Vx",        // kSKNP
+    "LD I, LONG",     // kLD_I_Long
+    "PLANE x",        // kPLANE
+    "LD AUDIO, [I]",  // kLD_AUDIO_I
+    "LD Vx, DT",      // kLD_Vx_DT
+    "LD Vx, K",       // kLD_Vx_K
+    "LD DT, Vx",      // kLD_DT_Vx
+    "LD ST, Vx",      // kLD_ST_Vx
+    "ADD I, Vx",      // kADD_I_Vx
+    "LD F, Vx",       // kLD_F_Vx
+    "LD HF, Vx",      // kLD_HF_Vx
+    "LD B, Vx",       // kLD_B_Vx
+    "LD [I], Vx",     // kLD_I_Vx
+    "LD Vx, [I]",     // kLD_Vx_I
+    "LD R, Vx",       // kLD_R_Vx
+    "LD Vx, R",       // kLD_Vx_R
+    "LD PITCH, Vx",   // kLD_PITCH_Vx
+    "ILLEGAL $v",     // kIllegal
+};
+
+/// A template prepared ahead of time, so that disassembling an instruction only
+/// takes copying its text and writing the operands over the placeholders.
+struct CompiledTemplate {
+  /// Where an operand goes within the text.
+  struct Operand {
+    /// The placeholder letter of the operand, see \ref kTemplates.
+    char kind_;
+
+    /// The position of the first character of the operand.
+    uint8_t position_;
+  };
+
+  /// The maximum number of operands an instruction can have.
+  static constexpr size_t kMaxOperands = 3;
+
+  /// The text of the template, where each placeholder letter is repeated as
+  /// many times as the operand takes characters.
+  std::array<char, chip8::debug::kMaxDisassemblyLength> text_;
+
+  /// The number of characters of \ref text_ in use.
+  uint8_t length_;
+
+  /// The operands to write over the placeholders.
+  std::array<Operand, kMaxOperands> operands_;
+
+  /// The number of entries of \ref operands_ in use.
+  uint8_t num_operands_;
+};
+
+/// Retrieves the number of characters an operand takes.
+///
+/// \param kind The placeholder letter of the operand, see \ref kTemplates.
+///
+/// \returns The number of characters the operand takes, or 0 if \p kind isn't
+/// a placeholder letter.
+constexpr auto GetOperandWidth(const char kind) noexcept -> uint8_t {
+  switch (kind) {
+    case 'x':
+    case 'y':
+    case 'n':
+      return 1;
+
+    case 'k':
+      return 2;
+
+    case 'a':
+    case 'v':
+      return 4;
+
+    default:
+      return 0;
+  }
+}
+
+/// Prepares a template ahead of time.
+///
+/// \param text The text of the template, see \ref kTemplates.
+///
+/// \returns The compiled template.
+constexpr auto CompileTemplate(const std::string_view text) noexcept
+    -> CompiledTemplate {
+  CompiledTemplate compiled{};
+
+  for (const auto character : text) {
+    const auto width = GetOperandWidth(character);
+
+    if (width != 0) {
+      compiled.operands_[compiled.num_operands_++] = {character,
+                                                      compiled.length_};
+    }
+
+    for (auto count = std::max(width, uint8_t{1}); count != 0; --count) {
+      compiled.text_[compiled.length_++] = character;
+    }
+  }
+  return compiled;
+}
+
+/// Prepares every template ahead of time.
+///
+/// \returns The compiled templates, indexed by \ref Template.
+constexpr auto CompileTemplates() noexcept
+    -> std::array<CompiledTemplate, kNumTemplates> {
+  std::array<CompiledTemplate, kNumTemplates> compiled{};
+
+  for (size_t index = 0; index < kNumTemplates; ++index) {
+    compiled[index] = CompileTemplate(kTemplates[index]);
+  }
+  return compiled;
+}
+
+/// Every template, prepared at compile time.
+constexpr auto kCompiledTemplates = CompileTemplates();
+
+/// Determines whether or not the templates can be expanded safely: every
+/// template must have been given text (which catches \ref kTemplates falling
+/// out of step with \ref Template), and must fit within \ref
+/// chip8::debug::kMaxDisassemblyLength characters. The \p n operand may take an
+/// extra character, so it must come last.
+///
+/// \returns true if the templates are valid, or false otherwise.
+constexpr auto AreTemplatesValid() noexcept -> bool {
+  for (size_t index = 0; index < kNumTemplates; ++index) {
+    const auto& compiled = kCompiledTemplates[index];
+
+    if ((compiled.length_ == 0) ||
+        (compiled.length_ >= chip8::debug::kMaxDisassemblyLength)) {
+      return false;
+    }
+
+    for (size_t operand = 0; operand < compiled.num_operands_; ++operand) {
+      if ((compiled.operands_[operand].kind_ == 'n') &&
+          (compiled.operands_[operand].position_ != (compiled.length_ - 1))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static_assert(AreTemplatesValid(), "The disassembly templates are invalid");
+
+/// Determines which template an instruction is disassembled with.
+///
+/// \param instruction The instruction to process.
+///
+/// \returns The template of the instruction.
+auto FindTemplate(const chip8::Instruction& instruction) noexcept -> Template {
   switch (instruction.group_) {
     case chip8::instruction_groups::kControlFlowAndScreen:
       switch (instruction.byte_) {
         case chip8::control_flow_and_screen_instructions::kCLS:
-          return "CLS";
+          return Template::kCLS;
 
         case chip8::control_flow_and_screen_instructions::kRET:
-          return "RET";
+          return Template::kRET;
+
+        case chip8::control_flow_and_screen_instructions::kSCR:
+          return Template::kSCR;
+
+        case chip8::control_flow_and_screen_instructions::kSCL:
+          return Template::kSCL;
+
+        case chip8::control_flow_and_screen_instructions::kEXIT:
+          return Template::kEXIT;
+
+        case chip8::control_flow_and_screen_instructions::kLOW:
+          return Template::kLOW;
+
+        case chip8::control_flow_and_screen_instructions::kHIGH:
+          return Template::kHIGH;
 
         default:
-          return fmt::format("ILLEGAL ${:04X}", instruction.value_);
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+          switch (instruction.byte_ & 0xF0) {
+            case chip8::control_flow_and_screen_instructions::kSCD:
+              return Template::kSCD;
+
+            case chip8::control_flow_and_screen_instructions::kSCU:
+              return Template::kSCU;
+
+            default:
+              return Template::kIllegal;
+          }
       }
 
     case chip8::ungrouped_instructions::kJP_Address:
-      return fmt::format("JP ${:04X}", instruction.address_);
+      return Template::kJP_Address;
 
     case chip8::ungrouped_instructions::kCALL_Address:
-      return fmt::format("CALL ${:04X}", instruction.address_);
+      return Template::kCALL_Address;
 
     case chip8::ungrouped_instructions::kSE_Vx_Imm:
-      return fmt::format("SE V{:X}, ${:02X}", instruction.x_,
-                         instruction.byte_);
+      return Template::kSE_Vx_Imm;
 
     case chip8::ungrouped_instructions::kSNE_Vx_Imm:
-      return fmt::format("SNE V{:X}, ${:02X}", instruction.x_,
-                         instruction.byte_);
+      return Template::kSNE_Vx_Imm;
 
     case chip8::ungrouped_instructions::kSE_Vx_Vy:
-      return fmt::format("SE V{:X}, V{:X}", instruction.x_, instruction.y_);
+      switch (instruction.nibble_) {
+        case chip8::register_range_instructions::kLD_I_Vx_Vy:
+          return Template::kLD_I_Vx_Vy;
+
+        case chip8::register_range_instructions::kLD_Vx_Vy_I:
+          return Template::kLD_Vx_Vy_I;
+
+        default:
+          return Template::kSE_Vx_Vy;
+      }
 
     case chip8::ungrouped_instructions::kLD_Vx_Imm:
-      return fmt::format("LD V{:X}, ${:02X}", instruction.x_,
-                         instruction.byte_);
+      return Template::kLD_Vx_Imm;
 
     case chip8::ungrouped_instructions::kADD:
-      return fmt::format("ADD V{:X}, ${:02X}", instruction.x_,
-                         instruction.byte_);
+      return Template::kADD_Vx_Imm;
 
     case chip8::instruction_groups::kMath:
       switch (instruction.nibble_) {
         case chip8::math_instructions::kLD:
-          return fmt::format("LD V{:X}, V{:X}", instruction.x_, instruction.y_);
+          return Template::kLD_Vx_Vy;
 
         case chip8::math_instructions::kOR:
-          return fmt::format("OR V{:X}, V{:X}", instruction.x_, instruction.y_);
+          return Template::kOR;
 
         case chip8::math_instructions::kAND:
-          return fmt::format("AND V{:X}, V{:X}", instruction.x_,
-                             instruction.y_);
+          return Template::kAND;
 
         case chip8::math_instructions::kXOR:
-          return fmt::format("XOR V{:X}, V{:X}", instruction.x_,
-                             instruction.y_);
+          return Template::kXOR;
 
         case chip8::math_instructions::kADD:
-          return fmt::format("ADD V{:X}, V{:X}", instruction.x_,
-                             instruction.y_);
+          return Template::kADD_Vx_Vy;
 
         case chip8::math_instructions::kSUB:
-          return fmt::format("SUB V{:X}, V{:X}", instruction.x_,
-                             instruction.y_);
+          return Template::kSUB;
 
         case chip8::math_instructions::kSHR_Vx:
-          return fmt::format("SHR V{:X}", instruction.x_);
+          return Template::kSHR;
 
         case chip8::math_instructions::kSUBN:
-          return fmt::format("SUBN V{:X}, V{:X}", instruction.x_,
-                             instruction.y_);
+          return Template::kSUBN;
 
         case chip8::math_instructions::kSHL_Vx:
-          return fmt::format("SHL V{:X}", instruction.x_);
+          return Template::kSHL;
 
         default:
-          return fmt::format("ILLEGAL ${:X}", instruction.value_);
+          return Template::kIllegal;
       }
 
     case chip8::ungrouped_instructions::kSNE_Vx_Vy:
-      return fmt::format("SNE V{:X}, V{:X}", instruction.x_, instruction.y_);
+      return Template::kSNE_Vx_Vy;
 
     case chip8::ungrouped_instructions::kLD_I_Addr:
-      return fmt::format("LD I, ${:04X}", instruction.address_);
+      return Template::kLD_I_Addr;
 
     case chip8::ungrouped_instructions::kJP_V0_Addr:
-      return fmt::format("JP V0, ${:04X}", instruction.address_);
+      return Template::kJP_V0_Addr;
 
     case chip8::ungrouped_instructions::kRND:
-      return fmt::format("RND V{:X}, ${:02X}", instruction.x_,
-                         instruction.byte_);
+      return Template::kRND;
 
     case chip8::ungrouped_instructions::kDRW:
-      return fmt::format("DRW V{:X}, V{:X}, {:#}", instruction.x_,
-                         instruction.y_, instruction.nibble_);
+      return Template::kDRW;
 
     case chip8::instruction_groups::kKeyboardControlFlow:
       switch (instruction.byte_) {
         case chip8::keyboard_control_flow_instructions::kSKP:
-          return fmt::format("SKP V{:X}", instruction.x_);
+          return Template::kSKP;
 
         case chip8::keyboard_control_flow_instructions::kSKNP:
-          return fmt::format("SKNP V{:X}", instruction.x_);
+          return Template::kSKNP;
 
         default:
-          return fmt::format("ILLEGAL ${:X}", instruction.value_);
+          return Template::kIllegal;
       }
 
     case chip8::instruction_groups::kTimerAndMemoryControl:
       switch (instruction.byte_) {
+        case chip8::timer_and_memory_control_instructions::kLD_I_Long:
+          return (instruction.x_ == 0) ? Template::kLD_I_Long
+                                       : Template::kIllegal;
+
+        case chip8::timer_and_memory_control_instructions::kPLANE:
+          return Template::kPLANE;
+
+        case chip8::timer_and_memory_control_instructions::kLD_AUDIO_I:
+          return (instruction.x_ == 0) ? Template::kLD_AUDIO_I
+                                       : Template::kIllegal;
+
         case chip8::timer_and_memory_control_instructions::kLD_Vx_DT:
-          return fmt::format("LD V{:X}, DT", instruction.x_);
+          return Template::kLD_Vx_DT;
 
         case chip8::timer_and_memory_control_instructions::kLD_Vx_K:
-          return fmt::format("LD V{:X}, K", instruction.x_);
+          return Template::kLD_Vx_K;
 
         case chip8::timer_and_memory_control_instructions::kLD_DT_Vx:
-          return fmt::format("LD DT, V{:X}", instruction.x_);
+          return Template::kLD_DT_Vx;
 
         case chip8::timer_and_memory_control_instructions::kLD_ST_Vx:
-          return fmt::format("LD ST, V{:X}", instruction.x_);
+          return Template::kLD_ST_Vx;
 
         case chip8::timer_and_memory_control_instructions::kADD_I_Vx:
-          return fmt::format("ADD I, V{:X}", instruction.x_);
+          return Template::kADD_I_Vx;
 
         case chip8::timer_and_memory_control_instructions::kLD_F_Vx:
-          return fmt::format("LD F, V{:X}", instruction.x_);
+          return Template::kLD_F_Vx;
+
+        case chip8::timer_and_memory_control_instructions::kLD_HF_Vx:
+          return Template::kLD_HF_Vx;
 
         case chip8::timer_and_memory_control_instructions::kLD_B_Vx:
-          return fmt::format("LD B, V{:X}", instruction.x_);
+          return Template::kLD_B_Vx;
 
         case chip8::timer_and_memory_control_instructions::kLD_I_Vx:
-          return fmt::format("LD [I], V{:X}", instruction.x_);
+          return Template::kLD_I_Vx;
 
         case chip8::timer_and_memory_control_instructions::kLD_Vx_I:
-          return fmt::format("LD V{:X}, [I]", instruction.x_);
+          return Template::kLD_Vx_I;
+
+        case chip8::timer_and_memory_control_instructions::kLD_R_Vx:
+          return Template::kLD_R_Vx;
+
+        case chip8::timer_and_memory_control_instructions::kLD_Vx_R:
+          return Template::kLD_Vx_R;
+
+        case chip8::timer_and_memory_control_instructions::kLD_PITCH_Vx:
+          return Template::kLD_PITCH_Vx;
 
         default:
-          return fmt::format("ILLEGAL ${:X}", instruction.value_);
+          return Template::kIllegal;
       }
 
     default:
-      return fmt::format("ILLEGAL ${:X}", instruction.value_);
+      return Template::kIllegal;
+  }
+}
+
+/// Retrieves the template of every possible instruction.
+///
+/// The table is built the first time this function is called; it takes 64KB
+/// and saves decoding the instruction every time it's disassembled.
+///
+/// \returns A table of templates, indexed by instruction.
+auto GetTemplateTable() noexcept -> const std::array<Template, 0x10000>& {
+  static const auto kTemplateTable = []() {
+    std::array<Template, 0x10000> template_table{};
+
+    for (size_t value = 0; value < template_table.size(); ++value) {
+      template_table[value] = FindTemplate(chip8::Instruction(value));
+    }
+    return template_table;
+  }();
+  return kTemplateTable;
+}
+
+/// Writes the disassembly of an instruction.
+///
+/// \param instruction The instruction to process.
+///
+/// \param output Where to write the disassembly to; this must have room for
+/// \ref chip8::debug::kMaxDisassemblyLength characters.
+///
+/// \returns The number of characters of \p output that make up the
+/// disassembly.
+auto ExpandTemplate(const chip8::Instruction& instruction,
+                    char* const output) noexcept -> size_t {
+  constexpr std::string_view kHexDigits = "0123456789ABCDEF";
+  constexpr auto kDecimalBase = 10U;
+
+  const auto& compiled =
+      kCompiledTemplates[GetTemplateTable()[instruction.value_]];
+
+  std::copy(compiled.text_.cbegin(), compiled.text_.cend(), output);
+  size_t length = compiled.length_;
+
+  const auto write_hex = [output, kHexDigits](const size_t position,
+                                              const unsigned int value,
+                                              const size_t num_digits) {
+    for (size_t digit = 0; digit < num_digits; ++digit) {
+      const auto shift = (num_digits - digit - 1) * 4;
+      output[position + digit] = kHexDigits[(value >> shift) & 0xF];
+    }
+  };
+
+  for (size_t operand_num = 0; operand_num < compiled.num_operands_;
+       ++operand_num) {
+    const auto operand = compiled.operands_[operand_num];
+
+    switch (operand.kind_) {
+      case 'x':
+        write_hex(operand.position_, instruction.x_, 1);
+        break;
+
+      case 'y':
+        write_hex(operand.position_, instruction.y_, 1);
+        break;
+
+      case 'k':
+        write_hex(operand.position_, instruction.byte_, 2);
+        break;
+
+      case 'a':
+        write_hex(operand.position_, instruction.address_, 4);
+        break;
+
+      case 'v':
+        write_hex(operand.position_, instruction.value_, 4);
+        break;
+
+      case 'n':
+        // This is always the last operand, so it may take an extra character.
+        if (instruction.nibble_ >= kDecimalBase) {
+          output[operand.position_] = '1';
+          length++;
+        }
+        output[length - 1] = kHexDigits[instruction.nibble_ % kDecimalBase];
+        break;
+
+      default:
+        break;
+    }
   }
+  return length;
+}
+}  // namespace
+
+auto chip8::debug::DisassembleInstruction(
+    const chip8::Instruction& instruction) noexcept -> std::string {
+  std::array<char, kMaxDisassemblyLength> disassembly;
+  const auto length = ExpandTemplate(instruction, disassembly.data());
+
+  // The disassembly always fits within the small string buffer of every
+  // standard library we know of, so this doesn't allocate either.
+  return {disassembly.data(), length};
+}
+
+auto chip8::debug::DisassembleInstruction(const chip8::Instruction& instruction,
+                                          fmt::memory_buffer& buffer) noexcept
+    -> size_t {
+  // The disassembly is written in place, and the buffer trimmed down to it.
+  const auto start = buffer.size();
+  buffer.resize(start + kMaxDisassemblyLength);
+
+  const auto length = ExpandTemplate(instruction, buffer.data() + start);
+  buffer.resize(start + length);
+
+  return length;
+}
+
+auto chip8::debug::DisassembleInstruction(const chip8::Instruction& instruction,
+                                          char* const buffer,
+                                          const size_t buffer_size) noexcept
+    -> size_t {
+  if (buffer_size >= kMaxDisassemblyLength) {
+    return ExpandTemplate(instruction, buffer);
+  }
+
+  std::array<char, kMaxDisassemblyLength> disassembly;
+  const auto length = ExpandTemplate(instruction, disassembly.data());
+
+  std::copy_n(disassembly.cbegin(), std::min(length, buffer_size), buffer);
+  return length;
 }
@@ -12,13 +12,49 @@
 
 #include "impl_interpreter.h"
 
-auto InterpreterImplementation::GetPixelIndex(const size_t x_coord,
-                                              const size_t y_coord) noexcept
-    -> size_t {
-  return y_coord * chip8::framebuffer::kWidth + x_coord;
+template <size_t MemorySize, unsigned int NumPlanes>
+void BasicInterpreterImplementation<MemorySize, NumPlanes>::CopyScreen(
+    chip8::Screen& screen) const noexcept {
+  screen.Assign(framebuffer_);
 }
 
-auto InterpreterImplementation::FetchAndDecodeInstruction() const noexcept
+template <size_t MemorySize, unsigned int NumPlanes>
+void BasicInterpreterImplementation<MemorySize,
+                                    NumPlanes>::ResetFramebuffer() noexcept {
+  framebuffer_.SetHighResolution(false);
+  chip8::Logger::Get().Emit(chip8::Logger::LogLevel::kDebug,
+                            "Framebuffer has been reset");
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::IsSuperChip()
+    const noexcept -> bool {
+  // XO-CHIP builds on SUPER-CHIP.
+  return (variant_ == chip8::Variant::kSuperChip) || IsXoChip();
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::IsXoChip()
+    const noexcept -> bool {
+  return (NumPlanes > 1) && (variant_ == chip8::Variant::kXoChip);
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::GetSelectedPlanes()
+    const noexcept -> unsigned int {
+  return IsXoChip() ? (selected_planes_ & Framebuffer::kAllPlanes) : 1U;
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<
+    MemorySize, NumPlanes>::GetNumberOfRplFlags() const noexcept -> size_t {
+  return IsXoChip() ? chip8::data_size::kXoChipRplFlags
+                    : chip8::data_size::kRplFlags;
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<
+    MemorySize, NumPlanes>::FetchAndDecodeInstruction() const noexcept
     -> chip8::Instruction {
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,cppcoreguidelines-pro-bounds-constant-array-index,readability-magic-numbers)
   const auto kInstructionHiByte = memory_[program_counter_];
@@ -30,22 +66,153 @@ auto InterpreterImplementation::FetchAndDecodeInstruction() const noexcept
   return chip8::Instruction((kInstructionHiByte << 8) | kInstructionLoByte);
 }
 
-void InterpreterImplementation::SkipNextInstructionIf(
-    const bool condition_met) noexcept {
-  if (condition_met) {
-    next_program_counter_ =
-        program_counter_ + (chip8::data_size::kInstructionLength *
-                            chip8::data_size::kInstructionLength);
+template <size_t MemorySize, unsigned int NumPlanes>
+void BasicInterpreterImplementation<MemorySize, NumPlanes>::
+    SkipNextInstructionIf(const bool condition_met) noexcept {
+  if (!condition_met) {
+    return;
   }
+
+  const auto skipped = program_counter_ + chip8::data_size::kInstructionLength;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+  const auto skipping_long_load = IsXoChip() && ((skipped + 1) < MemorySize) &&
+                                  (memory_[skipped] == 0xF0) &&
+                                  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                                  (memory_[skipped + 1] == 0x00);
+
+  next_program_counter_ =
+      skipped + (skipping_long_load ? chip8::data_size::kLongInstructionLength
+                                    : chip8::data_size::kInstructionLength);
 }
 
-auto InterpreterImplementation::GetVxVyRegisters(
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::GetVxVyRegisters(
     const chip8::Instruction& instruction) noexcept -> VxVyRegisters {
   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
   return {V_[instruction.x_], V_[instruction.y_]};
 }
 
-chip8::StepResult InterpreterImplementation::Step() noexcept {
+template <size_t MemorySize, unsigned int NumPlanes>
+void BasicInterpreterImplementation<MemorySize,
+                                    NumPlanes>::ResetFlagAfterLogic() noexcept {
+  if (quirks_.logic_resets_vf_) {
+    VF = 0;
+  }
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+void BasicInterpreterImplementation<MemorySize, NumPlanes>::
+    IncrementIAfterLoadStore(const chip8::Instruction& instruction) noexcept {
+  if (quirks_.load_store_increments_i_) {
+    I_ = (I_ + instruction.x_ + 1) & chip8::data_limits::kIndexRegister;
+  }
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::DrawSprite(
+    const chip8::Instruction& instruction) noexcept -> chip8::StepResult {
+  const auto [Vx, Vy] = GetVxVyRegisters(instruction);
+
+  // SUPER-CHIP draws 16x16 sprites, two bytes per row, when the height is 0.
+  const auto large = IsSuperChip() && (instruction.nibble_ == 0);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  const auto num_rows = large ? 16U : instruction.nibble_;
+  const auto bytes_per_row = large ? 2U : 1U;
+
+  const auto width = framebuffer_.GetWidth();
+  const auto height = framebuffer_.GetHeight();
+
+  // The starting position always wraps around; see \ref
+  // chip8::Quirks::clip_sprites_ for the rest of the sprite.
+  const auto x_pos = Vx % width;
+  const auto y_start = Vy % height;
+
+  const auto planes = GetSelectedPlanes();
+  auto sprite_start = I_;
+
+  VF = 0;
+
+  for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+    if ((planes & (1U << plane)) == 0) {
+      continue;
+    }
+
+    for (unsigned int row = 0; row < num_rows; ++row) {
+      const auto sprite_location = sprite_start + (row * bytes_per_row);
+
+      if ((sprite_location + bytes_per_row) > memory_.size()) {
+        return chip8::StepResult::kInvalidSpriteLocation;
+      }
+
+      auto y_pos = y_start + row;
+
+      if (y_pos >= height) {
+        if (quirks_.clip_sprites_) {
+          break;
+        }
+        y_pos -= height;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      unsigned int sprite_row = memory_[sprite_location];
+
+      if (large) {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-pro-bounds-constant-array-index)
+        sprite_row = (sprite_row << 8) | memory_[sprite_location + 1];
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+      if (framebuffer_.DrawSpriteRow(x_pos, y_pos, sprite_row, large ? 16 : 8,
+                                     quirks_.clip_sprites_, plane)) {
+        VF = 1;
+      }
+    }
+
+    // Each plane takes the sprite data following that of the previous one.
+    sprite_start += num_rows * bytes_per_row;
+  }
+  return chip8::StepResult::kSuccess;
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::
+    TransferRegisterRange(const chip8::Instruction& instruction) noexcept
+    -> chip8::StepResult {
+  // The registers are accessed from Vx to Vy, which may go backwards.
+  const auto first = instruction.x_;
+  const auto last = instruction.y_;
+  const auto count = ((first <= last) ? (last - first) : (first - last)) + 1;
+
+  if ((I_ + count) > memory_.size()) {
+    return chip8::StepResult::kInvalidMemoryLocation;
+  }
+
+  const auto store = (instruction.nibble_ ==
+                      chip8::register_range_instructions::kLD_I_Vx_Vy);
+
+  if (store) {
+    MarkMemoryDirty(I_, count);
+  }
+
+  for (size_t index = 0; index < count; ++index) {
+    const auto reg = (first <= last) ? (first + index) : (first - index);
+
+    if (store) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      memory_[I_ + index] = V_[reg];
+    } else {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      V_[reg] = memory_[I_ + index];
+    }
+  }
+  return chip8::StepResult::kSuccess;
+}
+
+template <size_t MemorySize, unsigned int NumPlanes>
+auto BasicInterpreterImplementation<MemorySize, NumPlanes>::Step() noexcept
+    -> chip8::StepResult {
   if (IsHaltedUntilKeyPress()) {
     return chip8::StepResult::kHaltUntilKeyPress;
   }
@@ -62,7 +229,7 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
     case chip8::instruction_groups::kControlFlowAndScreen:
       switch (instruction.byte_) {
         case chip8::control_flow_and_screen_instructions::kCLS:
-          ResetFramebuffer();
+          framebuffer_.Clear(GetSelectedPlanes());
           break;
 
         case chip8::control_flow_and_screen_instructions::kRET:
@@ -78,7 +245,62 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
           next_program_counter_ = stack_[stack_pointer_--];
           break;
 
+        case chip8::control_flow_and_screen_instructions::kSCR:
+          if (!IsSuperChip()) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+          framebuffer_.ScrollRight(4, GetSelectedPlanes());
+          break;
+
+        case chip8::control_flow_and_screen_instructions::kSCL:
+          if (!IsSuperChip()) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+          framebuffer_.ScrollLeft(4, GetSelectedPlanes());
+          break;
+
+        case chip8::control_flow_and_screen_instructions::kEXIT:
+          // Like an error, this leaves the program counter on the
+          // instruction, so the program stays exited.
+          step_result = IsSuperChip() ? chip8::StepResult::kExited
+                                      : chip8::StepResult::kInvalidInstruction;
+          break;
+
+        case chip8::control_flow_and_screen_instructions::kLOW:
+        case chip8::control_flow_and_screen_instructions::kHIGH:
+          if (!IsSuperChip()) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          framebuffer_.SetHighResolution(
+              instruction.byte_ ==
+              chip8::control_flow_and_screen_instructions::kHIGH);
+          break;
+
         default:
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+          if (IsSuperChip() &&
+              ((instruction.byte_ & 0xF0) ==
+               chip8::control_flow_and_screen_instructions::kSCD)) {
+            framebuffer_.ScrollDown(instruction.nibble_, GetSelectedPlanes());
+            break;
+          }
+
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+          if (IsXoChip() &&
+              ((instruction.byte_ & 0xF0) ==
+               chip8::control_flow_and_screen_instructions::kSCU)) {
+            framebuffer_.ScrollUp(instruction.nibble_, GetSelectedPlanes());
+            break;
+          }
+
           step_result = chip8::StepResult::kInvalidInstruction;
           break;
       }
@@ -109,6 +331,15 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
       break;
 
     case chip8::ungrouped_instructions::kSE_Vx_Vy:
+      if (IsXoChip() &&
+          ((instruction.nibble_ ==
+            chip8::register_range_instructions::kLD_I_Vx_Vy) ||
+           (instruction.nibble_ ==
+            chip8::register_range_instructions::kLD_Vx_Vy_I))) {
+        step_result = TransferRegisterRange(instruction);
+        break;
+      }
+
       SkipNextInstructionIf(Vx == Vy);
       break;
 
@@ -137,14 +368,17 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
 
         case chip8::math_instructions::kOR:
           Vx |= Vy;
+          ResetFlagAfterLogic();
           break;
 
         case chip8::math_instructions::kAND:
           Vx &= Vy;
+          ResetFlagAfterLogic();
           break;
 
         case chip8::math_instructions::kXOR:
           Vx ^= Vy;
+          ResetFlagAfterLogic();
           break;
 
         case chip8::math_instructions::kADD: {
@@ -164,11 +398,14 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
 
           break;
 
-        case chip8::math_instructions::kSHR_Vx:
-          VF = Vx & 1;
-          Vx >>= 1;
+        case chip8::math_instructions::kSHR_Vx: {
+          const auto source = quirks_.shift_uses_vy_ ? Vy : Vx;
+
+          VF = source & 1;
+          Vx = source >> 1;
 
           break;
+        }
 
         case chip8::math_instructions::kSUBN:
           VF = Vy > Vx;  // NOLINT(readability-implicit-bool-conversion)
@@ -176,10 +413,12 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
 
           break;
 
-        case chip8::math_instructions::kSHL_Vx:
+        case chip8::math_instructions::kSHL_Vx: {
+          const auto source = quirks_.shift_uses_vy_ ? Vy : Vx;
+
           // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,readability-implicit-bool-conversion)
-          VF = (Vx & 0x80) != 0;
-          Vx <<= 1;
+          VF = (source & 0x80) != 0;
+          Vx = source << 1;
 
           // Because we use `uint_fast8_t` for registers, there's no guarantee
           // that there's only 8 bits; this type only guarantees that we have at
@@ -190,6 +429,7 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
           // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
           Vx &= 0xFF;
           break;
+        }
 
         default:
           step_result = chip8::StepResult::kInvalidInstruction;
@@ -206,7 +446,9 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
       break;
 
     case chip8::ungrouped_instructions::kJP_V0_Addr:
-      next_program_counter_ = V0 + instruction.address_;
+      // With the quirk, \p x is the highest nibble of the address itself.
+      next_program_counter_ =
+          (quirks_.jump_uses_vx_ ? Vx : V0) + instruction.address_;
       break;
 
     case chip8::ungrouped_instructions::kRND:
@@ -214,33 +456,7 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
       break;
 
     case chip8::ungrouped_instructions::kDRW:
-      VF = 0;
-
-      for (unsigned int y = 0; y < instruction.nibble_; ++y) {
-        const auto sprite_location = I_ + y;
-
-        if (sprite_location >= memory_.size()) {
-          step_result = chip8::StepResult::kInvalidSpriteLocation;
-          break;
-        }
-
-        const auto sprite_line = memory_[sprite_location];
-        const unsigned int y_pos = (Vy + y) % chip8::framebuffer::kHeight;
-
-        for (auto x = 0; x < 8; x++) {
-          const unsigned int x_pos = (Vx + x) % chip8::framebuffer::kWidth;
-          const auto pixel_location = GetPixelIndex(x_pos, y_pos);
-
-          if (sprite_line & (0x80 >> x)) {
-            if (framebuffer_[pixel_location] == chip8::pixel::kWhite) {
-              framebuffer_[pixel_location] = chip8::pixel::kBlack;
-              VF = 1;
-            } else {
-              framebuffer_[pixel_location] = chip8::pixel::kWhite;
-            }
-          }
-        }
-      }
+      step_result = DrawSprite(instruction);
       break;
 
     case chip8::instruction_groups::kKeyboardControlFlow:
@@ -279,6 +495,52 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
 
     case chip8::instruction_groups::kTimerAndMemoryControl:
       switch (instruction.byte_) {
+        case chip8::timer_and_memory_control_instructions::kLD_I_Long: {
+          if (!IsXoChip() || (instruction.x_ != 0)) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          const auto address_location =
+              program_counter_ + chip8::data_size::kInstructionLength;
+
+          if ((address_location + 1) >= memory_.size()) {
+            step_result = chip8::StepResult::kInvalidMemoryLocation;
+            break;
+          }
+
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-pro-bounds-constant-array-index)
+          I_ = (memory_[address_location] << 8) | memory_[address_location + 1];
+
+          next_program_counter_ =
+              program_counter_ + chip8::data_size::kLongInstructionLength;
+          break;
+        }
+
+        case chip8::timer_and_memory_control_instructions::kPLANE:
+          if (!IsXoChip() || (instruction.x_ > Framebuffer::kAllPlanes)) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          selected_planes_ = instruction.x_;
+          break;
+
+        case chip8::timer_and_memory_control_instructions::kLD_AUDIO_I:
+          if (!IsXoChip() || (instruction.x_ != 0)) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          if ((I_ + audio_pattern_.size()) > memory_.size()) {
+            step_result = chip8::StepResult::kInvalidMemoryLocation;
+            break;
+          }
+
+          std::copy_n(memory_.cbegin() + I_, audio_pattern_.size(),
+                      audio_pattern_.begin());
+          break;
+
         case chip8::timer_and_memory_control_instructions::kLD_Vx_DT:
           Vx = delay_timer_;
           break;
@@ -298,7 +560,7 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
           break;
 
         case chip8::timer_and_memory_control_instructions::kADD_I_Vx:
-          I_ += Vx;
+          I_ = (I_ + Vx) & chip8::data_limits::kIndexRegister;
           break;
 
         case chip8::timer_and_memory_control_instructions::kLD_F_Vx:
@@ -331,19 +593,76 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
           // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index,cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
           memory_[ones_digit_store_address] = ones_digit;
 
+          // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+          MarkMemoryDirty(I_, 3);
+
           break;
         }
 
         case chip8::timer_and_memory_control_instructions::kLD_I_Vx:
+          if ((I_ + instruction.x_ + 1) > memory_.size()) {
+            step_result = chip8::StepResult::kInvalidMemoryLocation;
+            break;
+          }
+
           // NOLINTNEXTLINE(cppcoreguidelines-narrowing-conversions)
           std::copy(V_.cbegin(), V_.cbegin() + instruction.x_ + 1,
                     memory_.begin() + I_);
+          MarkMemoryDirty(I_, instruction.x_ + 1);
+          IncrementIAfterLoadStore(instruction);
           break;
 
         case chip8::timer_and_memory_control_instructions::kLD_Vx_I:
+          if ((I_ + instruction.x_ + 1) > memory_.size()) {
+            step_result = chip8::StepResult::kInvalidMemoryLocation;
+            break;
+          }
+
           std::copy(memory_.cbegin() + I_,
                     // NOLINTNEXTLINE(cppcoreguidelines-narrowing-conversions)
                     memory_.cbegin() + I_ + instruction.x_ + 1, V_.begin());
+          IncrementIAfterLoadStore(instruction);
+          break;
+
+        case chip8::timer_and_memory_control_instructions::kLD_HF_Vx:
+          if (!IsSuperChip()) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          I_ = chip8::memory_region::kBigFont +
+               (Vx * chip8::data_size::kBigFontLength);
+          break;
+
+        case chip8::timer_and_memory_control_instructions::kLD_PITCH_Vx:
+          if (!IsXoChip()) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          pitch_ = Vx;
+          break;
+
+        case chip8::timer_and_memory_control_instructions::kLD_R_Vx:
+          if (!IsSuperChip() || (instruction.x_ >= GetNumberOfRplFlags())) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          // NOLINTNEXTLINE(cppcoreguidelines-narrowing-conversions)
+          std::copy(V_.cbegin(), V_.cbegin() + instruction.x_ + 1,
+                    rpl_flags_.begin());
+          break;
+
+        case chip8::timer_and_memory_control_instructions::kLD_Vx_R:
+          if (!IsSuperChip() || (instruction.x_ >= GetNumberOfRplFlags())) {
+            step_result = chip8::StepResult::kInvalidInstruction;
+            break;
+          }
+
+          // NOLINTNEXTLINE(cppcoreguidelines-narrowing-conversions)
+          std::copy(rpl_flags_.cbegin(),
+                    rpl_flags_.cbegin() + instruction.x_ + 1, V_.begin());
           break;
 
         default:
@@ -358,9 +677,24 @@ chip8::StepResult InterpreterImplementation::Step() noexcept {
   }
 
   // If an error occurred, we want the program counter that caused the fault.
-  if ((step_result == chip8::StepResult::kSuccess) ||
-      (step_result == chip8::StepResult::kHaltUntilKeyPress)) {
-    program_counter_ = next_program_counter_;
+  if ((step_result != chip8::StepResult::kSuccess) &&
+      (step_result != chip8::StepResult::kHaltUntilKeyPress)) {
+    return step_result;
+  }
+
+  // Jumps, returns and skips can all take control to the last byte of memory
+  // or past it, where a whole instruction can't be fetched from. That's the
+  // fault of the instruction that went there.
+  if ((next_program_counter_ + chip8::data_size::kInstructionLength) >
+      memory_.size()) {
+    return chip8::StepResult::kInvalidMemoryLocation;
   }
+
+  program_counter_ = next_program_counter_;
   return step_result;
 }
+
+template class BasicInterpreterImplementation<chip8::data_size::kInternalMemory,
+                                              1>;
+template class BasicInterpreterImplementation<
+    chip8::data_size::kXoChipInternalMemory, chip8::framebuffer::kMaxPlanes>;
@@ -44,8 +44,22 @@
 /// We're going to write a JIT because this is a tutorial project, but please be
 /// mindful of your guest target's technical specifications before you try to
 /// write a JIT, and ask yourself if you really have to.
-class InterpreterImplementation : public chip8::ImplementationInterface {
+///
+/// \tparam MemorySize The size of the internal memory, in bytes.
+/// \tparam NumPlanes The number of bitplanes of the screen.
+template <size_t MemorySize, unsigned int NumPlanes>
+class BasicInterpreterImplementation : public chip8::ImplementationInterface {
  public:
+  /// The type of the screen.
+  using Framebuffer = chip8::BasicFramebuffer<NumPlanes>;
+
+  /// Instantiates the implementation, resetting it to the default startup
+  /// state.
+  BasicInterpreterImplementation() noexcept
+      : chip8::ImplementationInterface(memory_.data(), memory_.size()) {
+    Reset();
+  }
+
   /// Executes the next instruction.
   ///
   /// Example code:
@@ -61,6 +75,32 @@ class InterpreterImplementation : public chip8::ImplementationInterface {
   /// definition for more information.
   chip8::StepResult Step() noexcept override;
 
+  /// Copies the screen, widening it to the number of planes frontends deal
+  /// with.
+  ///
+  /// \param screen Where to copy the screen to.
+  void CopyScreen(chip8::Screen& screen) const noexcept override;
+
+  /// CHIP-8 contains an internal memory space totaling 4,096 bytes (or 4KB),
+  /// and XO-CHIP 65,536 bytes (or 64KB). Historically, the first 512 bytes
+  /// (0x000-0x1FF) contained the virtual machine itself. In modern
+  /// implementations, a font set totaling 80 bytes (0x50) is stored at the
+  /// beginning of this memory area. Programs may choose to use the font set,
+  /// but it is not mandatory.
+  std::array<uint_fast8_t, MemorySize> memory_;
+
+  /// CHIP-8 contains a 64x32 monochrome framebuffer used for displaying
+  /// graphics, which SUPER-CHIP programs may switch to 128x64, and XO-CHIP
+  /// programs draw to 2 bitplanes of. We store it packed, one bit per pixel;
+  /// frontends convert it to whatever their display API wants, see \ref
+  /// chip8::BasicFramebuffer.
+  Framebuffer framebuffer_;
+
+ protected:
+  /// Clears every plane of the framebuffer, and switches it back to the low
+  /// resolution mode.
+  void ResetFramebuffer() noexcept override;
+
  private:
   /// We use the default random engine because there's no way in hell a CHIP-8
   /// virtual machine needs anything more sophisticated. This is necessary for
@@ -83,21 +123,28 @@ class InterpreterImplementation : public chip8::ImplementationInterface {
   /// documentation.
   uint_fast8_t& VF = V_[0xF];
 
-  /// Returns the index of a pixel in the framebuffer.
+  /// Determines whether or not SUPER-CHIP instructions are available.
   ///
-  /// Example code:
-  ///   \code
-  ///     const auto index = GetPixelIndex(10, 14);
-  ///   \endcode
+  /// \returns true if the guest program is written for SUPER-CHIP, or false
+  /// otherwise.
+  auto IsSuperChip() const noexcept -> bool;
+
+  /// Determines whether or not XO-CHIP instructions are available. They never
+  /// are if the screen has a single plane.
   ///
-  /// This will return the index of (10, 14) within the framebuffer.
+  /// \returns true if the guest program is written for XO-CHIP, or false
+  /// otherwise.
+  auto IsXoChip() const noexcept -> bool;
+
+  /// Retrieves the planes drawn to, cleared and scrolled.
   ///
-  /// \param x_coord The X coordinate of the pixel.
-  /// \param y_coord The Y coordinate of the pixel.
+  /// \returns The mask of the selected planes that the screen has.
+  auto GetSelectedPlanes() const noexcept -> unsigned int;
+
+  /// Retrieves the number of registers `LD R, Vx` and `LD Vx, R` can save.
   ///
-  /// \returns An index into the framebuffer, referring to the location of a
-  /// pixel at (x_coord, y_coord).
-  static auto GetPixelIndex(size_t x_coord, size_t y_coord) noexcept -> size_t;
+  /// \returns 16 for XO-CHIP, or 8 for SUPER-CHIP.
+  auto GetNumberOfRplFlags() const noexcept -> size_t;
 
   /// Skips the next instruction if the condition specifed was met.
   ///
@@ -108,7 +155,8 @@ class InterpreterImplementation : public chip8::ImplementationInterface {
   ///
   /// If the contents of register Vx are equal to the contents of register Vy,
   /// then the program counter will be incremented by 4. Otherwise, it will be
-  /// incremented normally (by 2).
+  /// incremented normally (by 2). XO-CHIP programs skip over the 4 bytes of
+  /// `LD I, LONG` as a whole.
   ///
   /// \param condition_met The result of a boolean expression.
   void SkipNextInstructionIf(bool condition_met) noexcept;
@@ -135,6 +183,27 @@ class InterpreterImplementation : public chip8::ImplementationInterface {
   auto GetVxVyRegisters(const chip8::Instruction& instruction) noexcept
       -> VxVyRegisters;
 
+  /// Executes `DRW Vx, Vy, n`, including the SUPER-CHIP 16x16 variant. On
+  /// XO-CHIP, the sprite is drawn to every selected plane in turn, each taking
+  /// its own sprite data following the previous one.
+  ///
+  /// \param instruction The instruction to execute.
+  ///
+  /// \returns The result of the instruction.
+  auto DrawSprite(const chip8::Instruction& instruction) noexcept
+      -> chip8::StepResult;
+
+  /// Clears the \p VF register after `OR`, `AND` or `XOR` if the guest program
+  /// expects it, see \ref chip8::Quirks::logic_resets_vf_.
+  void ResetFlagAfterLogic() noexcept;
+
+  /// Moves the \p I register past the bytes accessed by `LD [I], Vx` or
+  /// `LD Vx, [I]` if the guest program expects it, see \ref
+  /// chip8::Quirks::load_store_increments_i_.
+  ///
+  /// \param instruction The instruction that accessed memory.
+  void IncrementIAfterLoadStore(const chip8::Instruction& instruction) noexcept;
+
   /// Fetches the next instruction and decodes it.
   ///
   /// The location of the instruction is dependent on the current value of the
@@ -147,6 +216,15 @@ class InterpreterImplementation : public chip8::ImplementationInterface {
   /// \returns A \ref chip8::Instruction instance.
   auto FetchAndDecodeInstruction() const noexcept -> chip8::Instruction;
 
+  /// Copies registers to or from internal memory for `LD [I], Vx-Vy` and `LD
+  /// Vx-Vy, [I]`.
+  ///
+  /// \param instruction The instruction to execute.
+  ///
+  /// \returns The result of the instruction.
+  auto TransferRegisterRange(const chip8::Instruction& instruction) noexcept
+      -> chip8::StepResult;
+
   /// The program counter to use after the current instruction has been
   /// executed.
   ///
@@ -154,3 +232,18 @@ class InterpreterImplementation : public chip8::ImplementationInterface {
   /// caused the fault.
   size_t next_program_counter_;
 };
+
+/// The interpreter for CHIP-8 and SUPER-CHIP programs.
+using InterpreterImplementation =
+    BasicInterpreterImplementation<chip8::data_size::kInternalMemory, 1>;
+
+/// The interpreter for XO-CHIP programs.
+using XoChipInterpreterImplementation =
+    BasicInterpreterImplementation<chip8::data_size::kXoChipInternalMemory,
+                                   chip8::framebuffer::kMaxPlanes>;
+
+// Both are instantiated once, in impl_interpreter.cpp.
+extern template class BasicInterpreterImplementation<
+    chip8::data_size::kInternalMemory, 1>;
+extern template class BasicInterpreterImplementation<
+    chip8::data_size::kXoChipInternalMemory, chip8::framebuffer::kMaxPlanes>;
@@ -0,0 +1,47 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include <core/input_queue.h>
+
+auto chip8::InputQueue::Push(const InputEvent& event) noexcept -> bool {
+  const auto tail = tail_.load(std::memory_order_relaxed);
+
+  if ((tail - head_.load(std::memory_order_acquire)) == kCapacity) {
+    return false;
+  }
+
+  events_[tail & (kCapacity - 1)] = event;
+
+  // Publish the event; the consumer won't look at the slot until it sees the
+  // new tail.
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+auto chip8::InputQueue::Pop(InputEvent& event) noexcept -> bool {
+  const auto head = head_.load(std::memory_order_relaxed);
+
+  if (head == tail_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  event = events_[head & (kCapacity - 1)];
+
+  // Hand the slot back to the producer.
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+auto chip8::InputQueue::IsEmpty() const noexcept -> bool {
+  return head_.load(std::memory_order_relaxed) ==
+         tail_.load(std::memory_order_acquire);
+}
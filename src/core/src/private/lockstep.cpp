@@ -0,0 +1,402 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include <core/lockstep.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+/// The number of differing bytes of memory \ref chip8::DescribeDivergence()
+/// lists before summing the rest up.
+constexpr size_t kMaxMemoryDifferences = 8;
+
+/// Determines the address of the instruction following another in memory.
+///
+/// \param impl The implementation about to execute the instruction.
+///
+/// \returns The address following the instruction at the program counter.
+auto GetNextAddress(const chip8::ImplementationInterface& impl) noexcept
+    -> size_t {
+  const auto* const memory = impl.GetMemory();
+  const auto pc = impl.program_counter_;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  const chip8::Instruction instruction((memory[pc] << 8) | memory[pc + 1]);
+
+  // Only `LD I, NNNN` is followed by a word of its own.
+  const auto long_instruction =
+      (instruction.group_ ==
+       chip8::instruction_groups::kTimerAndMemoryControl) &&
+      (instruction.x_ == 0) &&
+      (instruction.byte_ ==
+       chip8::timer_and_memory_control_instructions::kLD_I_Long);
+
+  return pc + (long_instruction ? chip8::data_size::kLongInstructionLength
+                                : chip8::data_size::kInstructionLength);
+}
+
+/// One of the implementations of a lockstep run, along with the input it
+/// has been fed.
+struct LockstepMachine {
+  /// Constructs one side of a lockstep run.
+  ///
+  /// \param trusted Whether or not the implementation is the reference one,
+  /// trusted to report every write to memory through \ref
+  /// chip8::ImplementationInterface::MarkMemoryDirty().
+  explicit LockstepMachine(const bool trusted) noexcept : trusted_(trusted) {}
+
+  /// Loads the program.
+  ///
+  /// \param factory Creates the implementation.
+  /// \param program The program data.
+  /// \param program_size The size of the program, in bytes.
+  ///
+  /// \returns true if the program was loaded, or false otherwise.
+  auto Load(const chip8::VMInstance::ImplementationFactory& factory,
+            const uint_fast8_t* const program,
+            const size_t program_size) noexcept -> bool {
+    vm_instance_.SetImplementationFactory(factory);
+    return vm_instance_.LoadProgram(program, program_size);
+  }
+
+  /// Applies the key state changes scheduled for the next step, and executes
+  /// it.
+  ///
+  /// \param inputs The key state changes, sorted by step.
+  ///
+  /// \returns The result of the step.
+  auto Step(const std::vector<chip8::ScheduledKeyState>& inputs) noexcept
+      -> chip8::StepResult {
+    const auto step = vm_instance_.GetNumberOfStepsExecuted();
+
+    while ((next_input_ < inputs.size()) &&
+           (inputs[next_input_].step_ <= step)) {
+      const auto& input = inputs[next_input_++];
+      vm_instance_.QueueKeyState(input.key_, input.state_);
+    }
+    return vm_instance_.Step();
+  }
+
+  /// Hashes the whole state of the implementation.
+  ///
+  /// Only the pages an implementation reports as written to are hashed again,
+  /// so the candidate implementation has all of its memory hashed again every
+  /// time; otherwise a write it fails to report would go unnoticed.
+  ///
+  /// \returns The hash of the state.
+  auto Hash() noexcept -> uint64_t {
+    if (!trusted_) {
+      auto& impl = *vm_instance_.impl_;
+      impl.MarkMemoryDirty(0, impl.GetMemorySize());
+    }
+    return vm_instance_.GetStateHash();
+  }
+
+  /// Captures the whole state of the implementation.
+  ///
+  /// \param result The result of the last step.
+  ///
+  /// \returns The state.
+  auto Capture(const chip8::StepResult result) noexcept
+      -> chip8::LockstepState {
+    chip8::LockstepState state{result, Hash(), {}, {}};
+
+    state.snapshot_.Capture(*vm_instance_.impl_);
+    vm_instance_.impl_->CopyScreen(state.screen_);
+
+    return state;
+  }
+
+  /// The virtual machine the implementation runs in.
+  chip8::VMInstance vm_instance_;
+
+  /// The index of the next key state change to apply.
+  size_t next_input_ = 0;
+
+  /// Whether or not the implementation is the reference one.
+  bool trusted_;
+};
+
+/// Runs a program on both implementations from the start, for a number of
+/// steps that is known to succeed.
+///
+/// \param program The program data.
+/// \param program_size The size of the program, in bytes.
+/// \param options The implementations and how to run them.
+/// \param num_steps The number of steps to execute.
+/// \param reference Where to run the reference implementation.
+/// \param candidate Where to run the candidate implementation.
+void Replay(const uint_fast8_t* const program, const size_t program_size,
+            const chip8::LockstepOptions& options, const uintmax_t num_steps,
+            LockstepMachine& reference, LockstepMachine& candidate) noexcept {
+  reference.Load(options.reference_, program, program_size);
+  candidate.Load(options.candidate_, program, program_size);
+
+  for (uintmax_t step = 0; step < num_steps; ++step) {
+    reference.Step(options.inputs_);
+    candidate.Step(options.inputs_);
+  }
+}
+
+/// Finds the first step after which the implementations differ.
+///
+/// \param program The program data.
+/// \param program_size The size of the program, in bytes.
+/// \param options The implementations and how to run them.
+/// \param agreed A number of steps after which the implementations agree.
+/// \param differed A greater number of steps after which they differ.
+///
+/// \returns Where the implementations stopped agreeing.
+auto Bisect(const uint_fast8_t* const program, const size_t program_size,
+            const chip8::LockstepOptions& options, uintmax_t agreed,
+            uintmax_t differed) noexcept -> chip8::LockstepDivergence {
+  while ((differed - agreed) > 1) {
+    const auto middle = agreed + ((differed - agreed) / 2);
+
+    LockstepMachine reference{true};
+    LockstepMachine candidate{false};
+
+    Replay(program, program_size, options, middle, reference, candidate);
+
+    // Every step before the one that failed the comparison had the same
+    // result on both sides, so only the states are left to compare.
+    if (reference.Hash() == candidate.Hash()) {
+      agreed = middle;
+    } else {
+      differed = middle;
+    }
+  }
+
+  LockstepMachine reference{true};
+  LockstepMachine candidate{false};
+
+  Replay(program, program_size, options, agreed, reference, candidate);
+
+  const auto program_counter = reference.vm_instance_.impl_->program_counter_;
+
+  const auto reference_result = reference.Step(options.inputs_);
+  const auto candidate_result = candidate.Step(options.inputs_);
+
+  return {agreed, program_counter, reference.Capture(reference_result),
+          candidate.Capture(candidate_result)};
+}
+
+/// Formats a difference between the states of a divergence, if there is one.
+///
+/// \param description Where to append the line describing the difference.
+/// \param name The name of what is being compared.
+/// \param reference The value in the reference implementation.
+/// \param candidate The value in the candidate implementation.
+template <typename T>
+void DescribeDifference(fmt::memory_buffer& description, const char* name,
+                        const T reference, const T candidate) noexcept {
+  if (reference == candidate) {
+    return;
+  }
+
+  fmt::format_to(std::back_inserter(description), "{}: ${:02X} != ${:02X}\n",
+                 name, reference, candidate);
+}
+}  // namespace
+
+auto chip8::RunLockstep(const uint_fast8_t* const program,
+                        const size_t program_size,
+                        const LockstepOptions& options) noexcept
+    -> LockstepResult {
+  LockstepResult result;
+
+  LockstepMachine reference{true};
+  LockstepMachine candidate{false};
+
+  if (!reference.Load(options.reference_, program, program_size) ||
+      !candidate.Load(options.candidate_, program, program_size)) {
+    return result;
+  }
+  result.loaded_ = true;
+
+  // The end of a frame is when the reference implementation updates its
+  // screen.
+  auto frame_ended = false;
+
+  reference.vm_instance_.update_screen_func_ =
+      [&frame_ended](const Screen&) { frame_ended = true; };
+
+  // The implementations must agree before they run anything at all.
+  auto agreed = uintmax_t{0};
+  auto differed = false;
+
+  result.num_comparisons_++;
+
+  if (reference.Hash() != candidate.Hash()) {
+    result.divergence_ = LockstepDivergence{
+        0, reference.vm_instance_.impl_->program_counter_,
+        reference.Capture(StepResult::kSuccess),
+        candidate.Capture(StepResult::kSuccess)};
+    return result;
+  }
+
+  while (result.steps_executed_ < options.max_steps_) {
+    const auto next_address = GetNextAddress(*reference.vm_instance_.impl_);
+
+    const auto reference_result = reference.Step(options.inputs_);
+    const auto candidate_result = candidate.Step(options.inputs_);
+
+    result.steps_executed_++;
+    result.result_ = reference_result;
+
+    const auto stopped =
+        (reference_result != StepResult::kSuccess) &&
+        (reference_result != StepResult::kHaltUntilKeyPress);
+
+    auto compare = stopped || (reference_result != candidate_result) ||
+                   (result.steps_executed_ == options.max_steps_);
+
+    switch (options.granularity_) {
+      case LockstepGranularity::kStep:
+        compare = true;
+        break;
+
+      case LockstepGranularity::kBlock:
+        compare |=
+            (reference.vm_instance_.impl_->program_counter_ != next_address);
+        break;
+
+      case LockstepGranularity::kFrame:
+        compare |= frame_ended;
+        break;
+    }
+    frame_ended = false;
+
+    if (!compare) {
+      continue;
+    }
+    result.num_comparisons_++;
+
+    if ((reference_result != candidate_result) ||
+        (reference.Hash() != candidate.Hash())) {
+      differed = true;
+      break;
+    }
+
+    agreed = result.steps_executed_;
+
+    if (stopped) {
+      break;
+    }
+  }
+
+  if (!differed) {
+    return result;
+  }
+
+  result.divergence_ =
+      Bisect(program, program_size, options, agreed, result.steps_executed_);
+
+  Logger::Get().Emit(Logger::LogLevel::kError,
+                     "Implementations diverged after {} steps, at ${:04X}",
+                     result.divergence_->step_,
+                     result.divergence_->program_counter_);
+  return result;
+}
+
+auto chip8::DescribeDivergence(const LockstepDivergence& divergence) noexcept
+    -> std::string {
+  fmt::memory_buffer description;
+
+  const auto& reference = divergence.reference_;
+  const auto& candidate = divergence.candidate_;
+
+  DescribeDifference(description, "Result",
+                     static_cast<unsigned int>(reference.result_),
+                     static_cast<unsigned int>(candidate.result_));
+  DescribeDifference(description, "Hash", reference.hash_, candidate.hash_);
+
+  const auto& reference_snapshot = reference.snapshot_;
+  const auto& candidate_snapshot = candidate.snapshot_;
+
+  DescribeDifference(description, "PC", reference_snapshot.program_counter_,
+                     candidate_snapshot.program_counter_);
+  DescribeDifference(description, "SP", reference_snapshot.stack_pointer_,
+                     candidate_snapshot.stack_pointer_);
+  DescribeDifference(description, "I", reference_snapshot.I_,
+                     candidate_snapshot.I_);
+  DescribeDifference(description, "DT", reference_snapshot.delay_timer_,
+                     candidate_snapshot.delay_timer_);
+  DescribeDifference(description, "ST", reference_snapshot.sound_timer_,
+                     candidate_snapshot.sound_timer_);
+
+  for (size_t index = 0; index < reference_snapshot.V_.size(); ++index) {
+    DescribeDifference(description, fmt::format("V{:X}", index).c_str(),
+                       reference_snapshot.V_[index],
+                       candidate_snapshot.V_[index]);
+  }
+
+  for (size_t index = 0; index < reference_snapshot.stack_.size(); ++index) {
+    DescribeDifference(description, fmt::format("Stack {}", index).c_str(),
+                       reference_snapshot.stack_[index],
+                       candidate_snapshot.stack_[index]);
+  }
+
+  const auto& reference_memory = reference_snapshot.memory_;
+  const auto& candidate_memory = candidate_snapshot.memory_;
+
+  DescribeDifference(description, "Memory size", reference_memory.size(),
+                     candidate_memory.size());
+
+  const auto memory_size =
+      std::min(reference_memory.size(), candidate_memory.size());
+  size_t num_memory_differences = 0;
+
+  for (size_t address = 0; address < memory_size; ++address) {
+    if (reference_memory[address] == candidate_memory[address]) {
+      continue;
+    }
+
+    if (num_memory_differences++ < kMaxMemoryDifferences) {
+      DescribeDifference(description,
+                         fmt::format("Memory ${:04X}", address).c_str(),
+                         reference_memory[address], candidate_memory[address]);
+    }
+  }
+
+  if (num_memory_differences > kMaxMemoryDifferences) {
+    fmt::format_to(std::back_inserter(description),
+                   "Memory: {} more bytes differ\n",
+                   num_memory_differences - kMaxMemoryDifferences);
+  }
+
+  const auto& reference_screen = reference.screen_;
+  const auto& candidate_screen = candidate.screen_;
+
+  DescribeDifference(
+      description, "High resolution",
+      static_cast<unsigned int>(reference_screen.IsHighResolution()),
+      static_cast<unsigned int>(candidate_screen.IsHighResolution()));
+
+  size_t num_pixel_differences = 0;
+
+  for (auto y = 0U; y < reference_screen.GetHeight(); ++y) {
+    for (auto x = 0U; x < reference_screen.GetWidth(); ++x) {
+      num_pixel_differences +=
+          reference_screen.GetPixel(x, y) != candidate_screen.GetPixel(x, y);
+    }
+  }
+
+  if (num_pixel_differences != 0) {
+    fmt::format_to(std::back_inserter(description),
+                   "Screen: {} pixels differ\n", num_pixel_differences);
+  }
+  return fmt::to_string(description);
+}
@@ -0,0 +1,67 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/rom.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+auto chip8::LoadRom(const std::string& file_name, Rom& rom) noexcept
+    -> RomLoadResult {
+  const std::unique_ptr<std::FILE, decltype(&std::fclose)> file{
+      std::fopen(file_name.c_str(), "rb"), &std::fclose};
+
+  if (!file) {
+    return RomLoadResult::kOpenFailed;
+  }
+
+  // The program is read in one go, so there's nothing for the stream to buffer
+  // other than an extra copy.
+  std::setvbuf(file.get(), nullptr, _IONBF, 0);
+
+  rom.size_ = std::fread(rom.data_.data(), 1, rom.data_.size(), file.get());
+
+  if (std::ferror(file.get()) != 0) {
+    return RomLoadResult::kReadFailed;
+  }
+
+  // If the program area was filled, there must be nothing left in the file.
+  if ((rom.size_ == rom.data_.size()) && (std::fgetc(file.get()) != EOF)) {
+    return RomLoadResult::kTooLarge;
+  }
+  return RomLoadResult::kSuccess;
+}
+
+auto chip8::GetVariantFromExtension(const std::string& file_name) noexcept
+    -> std::optional<Variant> {
+  auto extension = std::filesystem::path{file_name}.extension().string();
+
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](const unsigned char c) { return std::tolower(c); });
+
+  if ((extension == ".ch8") || (extension == ".c8")) {
+    return Variant::kChip8;
+  }
+
+  if (extension == ".sc8") {
+    return Variant::kSuperChip;
+  }
+
+  if (extension == ".xo8") {
+    return Variant::kXoChip;
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,113 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/analysis.h>
+#include <core/rom_database.h>
+
+#include <algorithm>
+#include <array>
+
+namespace {
+/// The programs whose profile is known ahead of time, sorted by hash so they
+/// can be binary searched.
+///
+/// To add a program, compute the hash of the exact file with \ref
+/// chip8::analysis::HashProgram() (the ROM library shows it for every
+/// program it finds), and insert an entry at the right position. Only
+/// include what differs from the default \ref chip8::RomProfile; anything
+/// left out keeps the behavior every other program gets.
+constexpr std::array<chip8::RomDatabaseEntry, 0> kBuiltInEntries{};
+
+/// Determines whether or not entries are sorted by hash, without duplicates.
+///
+/// \param entries The entries to check.
+///
+/// \returns true if the entries are sorted, or false otherwise.
+template <size_t N>
+constexpr auto IsSortedByHash(
+    const std::array<chip8::RomDatabaseEntry, N>& entries) noexcept -> bool {
+  for (size_t index = 1; index < N; ++index) {
+    if (entries[index - 1].hash_ >= entries[index].hash_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(IsSortedByHash(kBuiltInEntries),
+              "The built-in entries must be sorted by hash");
+}  // namespace
+
+auto chip8::RomDatabase::Get() noexcept -> RomDatabase& {
+  static RomDatabase rom_database{kBuiltInEntries.data(),
+                                  kBuiltInEntries.size()};
+  return rom_database;
+}
+
+chip8::RomDatabase::RomDatabase(const RomDatabaseEntry* const entries,
+                                const size_t num_entries) noexcept
+    : entries_(entries), num_entries_(num_entries) {}
+
+auto chip8::RomDatabase::FindBuiltInProfile(const uint64_t hash) const noexcept
+    -> std::optional<RomProfile> {
+  const auto* const end = entries_ + num_entries_;
+  const auto* const entry = std::lower_bound(
+      entries_, end, hash, [](const RomDatabaseEntry& lhs, const uint64_t rhs) {
+        return lhs.hash_ < rhs;
+      });
+
+  if ((entry == end) || (entry->hash_ != hash)) {
+    return std::nullopt;
+  }
+  return entry->profile_;
+}
+
+auto chip8::RomDatabase::Find(const uint64_t hash) const noexcept
+    -> std::optional<RomProfile> {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto override_found = overrides_.find(hash);
+
+    if (override_found != overrides_.end()) {
+      return override_found->second;
+    }
+  }
+  return FindBuiltInProfile(hash);
+}
+
+auto chip8::RomDatabase::Lookup(const uint64_t hash) const noexcept
+    -> RomProfile {
+  return Find(hash).value_or(RomProfile{});
+}
+
+auto chip8::RomDatabase::Lookup(const uint_fast8_t* const program,
+                                const size_t program_size) const noexcept
+    -> RomProfile {
+  return Lookup(analysis::HashProgram(program, program_size));
+}
+
+void chip8::RomDatabase::SetOverride(const uint64_t hash,
+                                     const RomProfile& profile) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  overrides_[hash] = profile;
+}
+
+void chip8::RomDatabase::ClearOverride(const uint64_t hash) noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  overrides_.erase(hash);
+}
+
+void chip8::RomDatabase::ClearOverrides() noexcept {
+  std::lock_guard<std::mutex> lock{mutex_};
+  overrides_.clear();
+}
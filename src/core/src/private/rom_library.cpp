@@ -0,0 +1,335 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/analysis.h>
+#include <core/rom.h>
+#include <core/rom_library.h>
+#include <core/vm_instance.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+/// Identifies a cache file written by \ref chip8::RomLibrary::Save().
+constexpr std::array<char, 8> kCacheMagic = {'V', 'M', 'T', 'R',
+                                             'O', 'M', 'L', 'B'};
+
+/// The version of the cache file format. It must be changed whenever the
+/// format changes, so that older cache files are ignored.
+constexpr uint32_t kCacheVersion = 1;
+
+/// The longest path accepted from a cache file, so that a corrupt cache file
+/// can't make us allocate arbitrary amounts of memory.
+constexpr uint32_t kMaxPathLength = 32768;
+
+/// The most significant bit of a byte of a thumbnail.
+constexpr uint8_t kThumbnailPixelMask = 0x80;
+
+/// A file closed when it goes out of scope.
+using File = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+/// Writes a value to a file as it is laid out in memory.
+///
+/// \param file The file to write to.
+/// \param value The value to write.
+///
+/// \returns true if the value was written, or false otherwise.
+template <typename T>
+auto Write(std::FILE* const file, const T& value) noexcept -> bool {
+  static_assert(std::is_trivially_copyable_v<T>);
+  return std::fwrite(&value, sizeof(value), 1, file) == 1;
+}
+
+/// Reads a value written by \ref Write() from a file.
+///
+/// \param file The file to read from.
+/// \param value Where to store the value.
+///
+/// \returns true if the value was read, or false otherwise.
+template <typename T>
+auto Read(std::FILE* const file, T& value) noexcept -> bool {
+  static_assert(std::is_trivially_copyable_v<T>);
+  return std::fread(&value, sizeof(value), 1, file) == 1;
+}
+
+/// Determines whether or not a file is a ROM file by its extension, see \ref
+/// chip8::GetVariantFromExtension().
+///
+/// \param path The path to the file.
+///
+/// \returns true if the file is a ROM file, or false otherwise.
+auto IsRomFile(const std::filesystem::path& path) noexcept -> bool {
+  return chip8::GetVariantFromExtension(path.string()).has_value();
+}
+
+/// Reads a ROM file and fills in the rest of its entry.
+///
+/// \param vm_instance The virtual machine used to take the thumbnail.
+/// \param entry The entry of the ROM file, whose path is already set.
+///
+/// \returns true if the ROM file was indexed, or false if it couldn't be read.
+auto IndexRom(chip8::VMInstance& vm_instance,
+              chip8::RomLibraryEntry& entry) noexcept -> bool {
+  chip8::Rom rom;
+
+  // The virtual machine is shared by every ROM file, so the variant guessed
+  // from the extension of the previous one must not stick.
+  vm_instance.SetDefaultVariant(
+      chip8::GetVariantFromExtension(entry.path_).value_or(
+          chip8::Variant::kChip8));
+
+  if ((chip8::LoadRom(entry.path_, rom) != chip8::RomLoadResult::kSuccess) ||
+      !vm_instance.LoadProgram(rom)) {
+    return false;
+  }
+
+  entry.size_ = rom.size();
+  entry.hash_ = chip8::analysis::HashProgram(rom.data(), rom.size());
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(rom);
+
+  entry.num_blocks_ = static_cast<uint32_t>(analysis.blocks_.size());
+  entry.num_subroutines_ = static_cast<uint32_t>(analysis.subroutines_.size());
+  entry.num_indirect_jumps_ =
+      static_cast<uint32_t>(analysis.indirect_jumps_.size());
+  entry.code_size_ = static_cast<uint32_t>(analysis.code_.count());
+
+  for (auto frame = 0; frame < chip8::RomLibrary::kThumbnailFrames; ++frame) {
+    // Programs waiting for a key press won't draw anything more, and neither
+    // will programs that crashed.
+    if (vm_instance.RunForOneFrame() != chip8::StepResult::kSuccess) {
+      break;
+    }
+  }
+
+  chip8::Screen framebuffer;
+  vm_instance.impl_->CopyScreen(framebuffer);
+  entry.thumbnail_.fill(0);
+
+  // Thumbnails are always 64x32; in the high resolution mode, a pixel of the
+  // thumbnail is on if any of the 2x2 pixels it covers is.
+  const auto scale = framebuffer.IsHighResolution() ? 2U : 1U;
+
+  for (unsigned int y = 0; y < framebuffer.GetHeight(); ++y) {
+    for (unsigned int x = 0; x < framebuffer.GetWidth(); ++x) {
+      if (framebuffer.IsPixelOn(x, y)) {
+        const auto pixel =
+            ((y / scale) * chip8::framebuffer::kWidth) + (x / scale);
+
+        entry.thumbnail_[pixel / CHAR_BIT] |=
+            kThumbnailPixelMask >> (pixel % CHAR_BIT);
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+auto chip8::RomLibraryEntry::IsPixelOn(const unsigned int x,
+                                       const unsigned int y) const noexcept
+    -> bool {
+  const auto pixel = (y * framebuffer::kWidth) + x;
+
+  return (thumbnail_[pixel / CHAR_BIT] &
+          (kThumbnailPixelMask >> (pixel % CHAR_BIT))) != 0;
+}
+
+auto chip8::RomLibrary::Scan(const std::string& directory,
+                             const CancelFunc& cancel_func) noexcept
+    -> size_t {
+  namespace fs = std::filesystem;
+
+  std::unordered_map<std::string_view, const RomLibraryEntry*> indexed;
+
+  for (const auto& entry : entries_) {
+    indexed.emplace(entry.path_, &entry);
+  }
+
+  std::vector<RomLibraryEntry> entries;
+  size_t num_read = 0;
+
+  // Only created once a ROM file actually has to be read, so that scanning a
+  // library which is up to date costs nothing more than listing it.
+  std::unique_ptr<VMInstance> vm_instance;
+
+  std::error_code error;
+  fs::recursive_directory_iterator it{
+      directory, fs::directory_options::skip_permission_denied, error};
+
+  for (; !error && (it != fs::recursive_directory_iterator{});
+       it.increment(error)) {
+    if (cancel_func && cancel_func()) {
+      return num_read;
+    }
+
+    // A file that can't be inspected is skipped; it doesn't end the scan.
+    std::error_code file_error;
+
+    if (!it->is_regular_file(file_error) || !IsRomFile(it->path())) {
+      continue;
+    }
+
+    const auto size = it->file_size(file_error);
+
+    if (file_error || (size > memory_region::kXoChipProgramAreaSize)) {
+      continue;
+    }
+
+    const auto modified_time =
+        it->last_write_time(file_error).time_since_epoch().count();
+
+    if (file_error) {
+      continue;
+    }
+
+    auto path = it->path().string();
+
+    if (const auto found = indexed.find(path);
+        (found != indexed.cend()) && (found->second->size_ == size) &&
+        (found->second->modified_time_ == modified_time)) {
+      entries.push_back(*found->second);
+      continue;
+    }
+
+    RomLibraryEntry entry{};
+    entry.path_ = std::move(path);
+    entry.modified_time_ = modified_time;
+
+    if (!vm_instance) {
+      vm_instance = std::make_unique<VMInstance>();
+    }
+
+    if (IndexRom(*vm_instance, entry)) {
+      entries.push_back(std::move(entry));
+      ++num_read;
+    }
+  }
+
+  // If the directory couldn't be listed, it may only be unavailable for the
+  // moment; don't throw away what we know about it.
+  if (error) {
+    return num_read;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const RomLibraryEntry& lhs, const RomLibraryEntry& rhs) {
+              return lhs.path_ < rhs.path_;
+            });
+
+  entries_ = std::move(entries);
+  return num_read;
+}
+
+auto chip8::RomLibrary::Save(const std::string& file_name) const noexcept
+    -> bool {
+  // The cache file is written next to the real one and moved over it, so that
+  // a crash never leaves a truncated cache file behind.
+  const auto temporary_file_name = file_name + ".tmp";
+
+  {
+    const File file{std::fopen(temporary_file_name.c_str(), "wb"),
+                    &std::fclose};
+
+    if (!file) {
+      return false;
+    }
+
+    auto ok = Write(file.get(), kCacheMagic) &&
+              Write(file.get(), kCacheVersion) &&
+              Write(file.get(), static_cast<uint64_t>(entries_.size()));
+
+    for (const auto& entry : entries_) {
+      if (!ok) {
+        break;
+      }
+
+      const auto path_length = static_cast<uint32_t>(entry.path_.size());
+
+      ok = Write(file.get(), path_length) &&
+           (std::fwrite(entry.path_.data(), 1, path_length, file.get()) ==
+            path_length) &&
+           Write(file.get(), entry.modified_time_) &&
+           Write(file.get(), entry.size_) && Write(file.get(), entry.hash_) &&
+           Write(file.get(), entry.thumbnail_) &&
+           Write(file.get(), entry.num_blocks_) &&
+           Write(file.get(), entry.num_subroutines_) &&
+           Write(file.get(), entry.num_indirect_jumps_) &&
+           Write(file.get(), entry.code_size_);
+    }
+
+    if (!ok || (std::fflush(file.get()) != 0)) {
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_file_name, file_name, error);
+
+  return !error;
+}
+
+auto chip8::RomLibrary::Load(const std::string& file_name) noexcept -> bool {
+  entries_.clear();
+
+  const File file{std::fopen(file_name.c_str(), "rb"), &std::fclose};
+
+  if (!file) {
+    return false;
+  }
+
+  std::array<char, kCacheMagic.size()> magic{};
+  uint32_t version = 0;
+  uint64_t num_entries = 0;
+
+  if (!Read(file.get(), magic) || (magic != kCacheMagic) ||
+      !Read(file.get(), version) || (version != kCacheVersion) ||
+      !Read(file.get(), num_entries)) {
+    return false;
+  }
+
+  std::vector<RomLibraryEntry> entries;
+
+  for (uint64_t index = 0; index < num_entries; ++index) {
+    RomLibraryEntry entry{};
+    uint32_t path_length = 0;
+
+    if (!Read(file.get(), path_length) || (path_length > kMaxPathLength)) {
+      return false;
+    }
+
+    entry.path_.resize(path_length);
+
+    const auto ok =
+        (std::fread(entry.path_.data(), 1, path_length, file.get()) ==
+         path_length) &&
+        Read(file.get(), entry.modified_time_) &&
+        Read(file.get(), entry.size_) && Read(file.get(), entry.hash_) &&
+        Read(file.get(), entry.thumbnail_) &&
+        Read(file.get(), entry.num_blocks_) &&
+        Read(file.get(), entry.num_subroutines_) &&
+        Read(file.get(), entry.num_indirect_jumps_) &&
+        Read(file.get(), entry.code_size_);
+
+    if (!ok) {
+      return false;
+    }
+    entries.push_back(std::move(entry));
+  }
+
+  entries_ = std::move(entries);
+  return true;
+}
@@ -0,0 +1,76 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/snapshot.h>
+
+#include <algorithm>
+
+void chip8::StateSnapshot::Capture(
+    const ImplementationInterface& impl) noexcept {
+  V_ = impl.V_;
+  stack_ = impl.stack_;
+  memory_.assign(impl.GetMemory(), impl.GetMemory() + impl.GetMemorySize());
+  program_counter_ = impl.program_counter_;
+  stack_pointer_ = impl.stack_pointer_;
+  delay_timer_ = impl.delay_timer_;
+  sound_timer_ = impl.sound_timer_;
+  I_ = impl.I_;
+  breakpoints_.clear();
+}
+
+void chip8::StateSnapshot::Capture(const VMInstance& vm_instance) noexcept {
+  Capture(*vm_instance.impl_);
+
+  for (const auto& breakpoint : vm_instance.breakpoints_) {
+    breakpoints_.push_back(breakpoint.first);
+  }
+}
+
+auto chip8::StateSnapshot::HasBreakpoint(const size_t address) const noexcept
+    -> bool {
+  return std::find(breakpoints_.cbegin(), breakpoints_.cend(), address) !=
+         breakpoints_.cend();
+}
+
+void chip8::SnapshotBuffer::Publish(
+    const ImplementationInterface& impl) noexcept {
+  snapshots_[write_index_].Capture(impl);
+  HandOver();
+}
+
+void chip8::SnapshotBuffer::Publish(const VMInstance& vm_instance) noexcept {
+  snapshots_[write_index_].Capture(vm_instance);
+  HandOver();
+}
+
+void chip8::SnapshotBuffer::HandOver() noexcept {
+  // Hand the snapshot over, and take back whichever one was there; the
+  // consumer isn't reading that one.
+  const auto previous = shared_.exchange(write_index_ | kNewSnapshot,
+                                         std::memory_order_acq_rel);
+  write_index_ = previous & ~kNewSnapshot;
+}
+
+auto chip8::SnapshotBuffer::Acquire() noexcept -> const StateSnapshot* {
+  if ((shared_.load(std::memory_order_relaxed) & kNewSnapshot) == 0) {
+    return nullptr;
+  }
+
+  // Swap the snapshot we're done with for the one handed over. The producer
+  // may have published an even newer one in the meantime, which is fine.
+  const auto previous =
+      shared_.exchange(read_index_, std::memory_order_acq_rel);
+  read_index_ = previous & ~kNewSnapshot;
+
+  return &snapshots_[read_index_];
+}
@@ -10,17 +10,85 @@
 // with this software. If not, see
 // <http://creativecommons.org/publicdomain/zero/1.0/>.
 
+#include <core/analysis.h>
 #include <core/disasm.h>
+#include <core/rom_database.h>
 #include <core/vm_instance.h>
 
 #include <algorithm>
+#include <iterator>
+#include <utility>
 
 #include "impl_interpreter.h"
 
+namespace {
+/// The primes of xxHash64, whose round and avalanche \ref GetStateHash() uses.
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4F;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9;
+
+/// Mixes a word into a hash.
+///
+/// \param hash The hash so far.
+/// \param word The word to mix in.
+///
+/// \returns The new hash.
+constexpr auto MixWord(uint64_t hash, const uint64_t word) noexcept
+    -> uint64_t {
+  hash += word * kPrime2;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  hash = (hash << 31) | (hash >> 33);
+  return hash * kPrime1;
+}
+
+/// Scrambles a hash so that every bit of the input affects every bit of the
+/// result.
+///
+/// \param hash The hash.
+///
+/// \returns The scrambled hash.
+constexpr auto Avalanche(uint64_t hash) noexcept -> uint64_t {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/// Mixes bytes into a hash, 8 at a time.
+///
+/// \param hash The hash so far.
+/// \param bytes The bytes to mix in.
+/// \param num_bytes The number of bytes, which must be a multiple of 8.
+///
+/// \returns The new hash.
+auto MixBytes(uint64_t hash, const uint_fast8_t* const bytes,
+              const size_t num_bytes) noexcept -> uint64_t {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+  for (size_t offset = 0; offset < num_bytes; offset += 8) {
+    uint64_t word = 0;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    for (size_t byte = 0; byte < 8; ++byte) {
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+      word |= static_cast<uint64_t>(bytes[offset + byte] & 0xFF) << (byte * 8);
+    }
+    hash = MixWord(hash, word);
+  }
+  return hash;
+}
+}  // namespace
+
 chip8::VMInstance::VMInstance() noexcept
-    : impl_(std::make_unique<InterpreterImplementation>()),
+    : impl_(MakeInterpreter(Variant::kChip8)),
       update_screen_func_(nullptr),
-      play_tone_func_(nullptr) {
+      beeper_func_(nullptr),
+      beeper_on_(false) {
   Logger::Get().Emit(Logger::LogLevel::kInfo, "Initializing CHIP-8 core");
 
   SetTiming(chip8::timing::kDefaultInstructionsPerSecond,
@@ -28,6 +96,19 @@ chip8::VMInstance::VMInstance() noexcept
   Reset();
 }
 
+auto chip8::VMInstance::MakeInterpreter(const Variant variant) noexcept
+    -> std::unique_ptr<ImplementationInterface> {
+  if (variant == Variant::kXoChip) {
+    return std::make_unique<XoChipInterpreterImplementation>();
+  }
+  return std::make_unique<InterpreterImplementation>();
+}
+
+void chip8::VMInstance::SetImplementationFactory(
+    ImplementationFactory factory) noexcept {
+  impl_factory_ = std::move(factory);
+}
+
 auto chip8::VMInstance::StartTracing(std::string_view file_name) noexcept
     -> bool {
   if (trace_info_.file_handle_.is_open()) {
@@ -64,10 +145,41 @@ auto chip8::VMInstance::GetTargetFrameRate() const noexcept -> unsigned int {
   return target_frame_rate_;
 }
 
+auto chip8::VMInstance::GetFrameRate() const noexcept -> double {
+  return frame_rate_;
+}
+
 auto chip8::VMInstance::GetMaxFrameTime() const noexcept -> double {
   return max_frame_time_;
 }
 
+auto chip8::VMInstance::GetNumberOfStepsExecuted() const noexcept
+    -> uintmax_t {
+  return number_of_steps_executed_;
+}
+
+auto chip8::VMInstance::IsBeeperOn() const noexcept -> bool {
+  return beeper_on_;
+}
+
+auto chip8::VMInstance::GetRomProfile() const noexcept -> const RomProfile& {
+  return rom_profile_;
+}
+
+void chip8::VMInstance::SetDefaultVariant(const Variant variant) noexcept {
+  default_variant_ = variant;
+}
+
+auto chip8::VMInstance::GetDefaultVariant() const noexcept -> Variant {
+  return default_variant_;
+}
+
+auto chip8::VMInstance::GetProgramAnalysis() const noexcept
+    -> std::shared_ptr<const analysis::ProgramAnalysis> {
+  return analysis::AnalysisCache::Get().Analyze(
+      impl_->GetMemory() + memory_region::kProgramArea, program_size_);
+}
+
 auto chip8::VMInstance::FindBreakpoint(const uint_fast16_t address) noexcept
     -> std::optional<BreakpointsIterator> {
   const auto bp_found =
@@ -82,11 +194,82 @@ auto chip8::VMInstance::FindBreakpoint(const uint_fast16_t address) noexcept
   return std::nullopt;
 }
 
-auto chip8::VMInstance::CalculateDurationOfTone() const noexcept -> double {
-  constexpr auto kTimerDecrementRate = 60.0;
-  constexpr auto kMilliseconds = 1000;
+auto chip8::VMInstance::GetStateHash() noexcept -> uint64_t {
+  constexpr auto kPagesPerWord = 64;
+
+  const auto& impl = *impl_;
+  const auto num_pages = impl.GetMemorySize() / data_size::kMemoryPage;
+
+  auto dirty_pages = impl_->TakeDirtyPages();
+
+  if ((hashed_impl_ != &impl) || (page_hashes_.size() != num_pages)) {
+    hashed_impl_ = &impl;
+    page_hashes_.assign(num_pages, 0);
+    memory_hash_ = 0;
+    dirty_pages.fill(~uint64_t{0});
+  }
+
+  // The pages are summed rather than chained, so that a page hashed again
+  // only has to replace its own share of the sum. Each page is seeded with
+  // its index, so that moving data around changes the hash.
+  const auto* const memory = impl.GetMemory();
+
+  const auto num_words = (num_pages + kPagesPerWord - 1) / kPagesPerWord;
+
+  for (size_t word = 0; word < num_words; ++word) {
+    auto dirty_page_bits = dirty_pages[word];
+
+    for (auto page = word * kPagesPerWord;
+         (dirty_page_bits != 0) && (page < num_pages);
+         ++page, dirty_page_bits >>= 1) {
+      if ((dirty_page_bits & 1) == 0) {
+        continue;
+      }
+
+      const auto page_hash = Avalanche(
+          MixBytes(page, memory + (page * data_size::kMemoryPage),
+                   data_size::kMemoryPage));
+
+      memory_hash_ += page_hash - page_hashes_[page];
+      page_hashes_[page] = page_hash;
+    }
+  }
+
+  auto hash = MixBytes(memory_hash_, impl.V_.data(), impl.V_.size());
+
+  for (const auto address : impl.stack_) {
+    hash = MixWord(hash, address);
+  }
 
-  return (impl_->sound_timer_ / kTimerDecrementRate) * kMilliseconds;
+  hash = MixWord(hash, impl.program_counter_);
+  hash = MixWord(hash, impl.stack_pointer_);
+  hash = MixWord(hash, impl.I_);
+  hash = MixWord(hash, impl.delay_timer_);
+  hash = MixWord(hash, impl.sound_timer_);
+  hash = MixWord(hash, impl.IsHaltedUntilKeyPress());
+  hash = MixWord(hash, impl.selected_planes_);
+  hash = MixWord(hash, impl.pitch_);
+  hash = MixBytes(hash, impl.audio_pattern_.data(),
+                  impl.audio_pattern_.size());
+  hash = MixBytes(hash, impl.rpl_flags_.data(), impl.rpl_flags_.size());
+
+  // Only the part of the screen in use in the current resolution counts.
+  impl.CopyScreen(screen_);
+  hash = MixWord(hash, screen_.IsHighResolution());
+
+  const auto words_per_row = screen_.GetWidth() / Screen::kWordBits;
+
+  for (unsigned int plane = 0; plane < Screen::kNumPlanes; ++plane) {
+    for (auto y = 0U; y < screen_.GetHeight(); ++y) {
+      const auto& row = screen_.GetRow(y, plane);
+
+      for (auto word = 0U; word < words_per_row; ++word) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        hash = MixWord(hash, row[word]);
+      }
+    }
+  }
+  return Avalanche(hash);
 }
 
 void chip8::VMInstance::CheckTimers() noexcept {
@@ -100,45 +283,129 @@ void chip8::VMInstance::CheckTimers() noexcept {
 }
 
 void chip8::VMInstance::DecrementTimers() noexcept {
-  auto logger = Logger::Get();
-
   if (impl_->sound_timer_ > 0) {
-    // We need a boolean here to make sure we're not calling the play tone
-    // function just because the sound timer is >0. We have to check to see if
-    // this condition was met at least once, otherwise we'll just call it over
-    // and over, giving us a bad result. But we'll still need to decrement the
-    // sound timer for proper operation of future conditions.
-    if (!is_playing_tone_ && play_tone_func_) {
-      const auto tone_duration = CalculateDurationOfTone();
-
-      logger.Emit(Logger::LogLevel::kDebug, "Emitting a {:.2f}ms long tone.",
-                  tone_duration);
-
-      play_tone_func_(tone_duration);
-      is_playing_tone_ = true;
-    }
     impl_->sound_timer_--;
-  } else if (impl_->sound_timer_ == 0) {
-    is_playing_tone_ = false;
   }
 
   if (impl_->delay_timer_ > 0) {
     impl_->delay_timer_--;
   }
+  UpdateBeeper();
+}
+
+void chip8::VMInstance::UpdateBeeper() noexcept {
+  const auto beeper_on = (impl_->sound_timer_ > 0);
+
+  if (beeper_on == beeper_on_) {
+    return;
+  }
+  beeper_on_ = beeper_on;
+
+  Logger::Get().Emit(Logger::LogLevel::kDebug, "Beeper switched {}.",
+                     beeper_on ? "on" : "off");
+
+  if (beeper_func_) {
+    beeper_func_(beeper_on);
+  }
 }
 
 void chip8::VMInstance::Reset() noexcept {
   impl_->Reset();
+  ClearInputTraces();
   number_of_steps_executed_ = 0;
-  is_playing_tone_ = false;
+  step_remainder_ = 0.0;
+  steps_until_screen_update_ = number_of_steps_per_frame_;
+  UpdateBeeper();
 
   Logger::Get().Emit(Logger::LogLevel::kInfo,
                      "Virtual machine has been reset.");
 }
 
+auto chip8::VMInstance::LoadProgram(const uint_fast8_t* const program,
+                                    const size_t program_size) noexcept
+    -> bool {
+  const auto& logger = Logger::Get();
+
+  // Hashing a program is a single pass over at most a few kilobytes, so
+  // there's no point in caching the profile.
+  auto known_profile =
+      RomDatabase::Get().Find(analysis::HashProgram(program, program_size));
+
+  if (!known_profile) {
+    known_profile.emplace();
+    known_profile->variant_ = default_variant_;
+  }
+
+  auto rom_profile = *std::move(known_profile);
+  const auto xo_chip = (rom_profile.variant_ == Variant::kXoChip);
+
+  const auto program_area_size = xo_chip
+                                     ? memory_region::kXoChipProgramAreaSize
+                                     : memory_region::kProgramAreaSize;
+
+  if (program_size > program_area_size) {
+    logger.Emit(Logger::LogLevel::kError,
+                "Could not load the requested program as it is too "
+                "large to fit ({} > {})",
+                program_size, program_area_size);
+    return false;
+  }
+
+  // Classic programs keep the 4 KB implementation, so that they don't pay
+  // for memory and bitplanes they can't use.
+  const size_t memory_size =
+      xo_chip ? data_size::kXoChipInternalMemory : data_size::kInternalMemory;
+
+  if (impl_factory_) {
+    auto impl = impl_factory_(rom_profile.variant_);
+
+    if (!impl || (impl->GetMemorySize() < memory_size)) {
+      logger.Emit(Logger::LogLevel::kError,
+                  "The implementation factory returned an implementation "
+                  "unfit for the program");
+      return false;
+    }
+    impl_ = std::move(impl);
+  } else if (impl_->GetMemorySize() != memory_size) {
+    impl_ = MakeInterpreter(rom_profile.variant_);
+  }
+
+  rom_profile_ = std::move(rom_profile);
+  impl_->quirks_ = rom_profile_.quirks_;
+  impl_->variant_ = rom_profile_.variant_;
+
+  if (rom_profile_.instructions_per_second_ != 0) {
+    ApplyTiming(rom_profile_.instructions_per_second_, frame_rate_);
+  } else {
+    ApplyTiming(default_instructions_per_sec_, frame_rate_);
+  }
+
+  Reset();
+  std::copy_n(program, program_size,
+              impl_->GetMemory() + memory_region::kProgramArea);
+  impl_->MarkMemoryDirty(memory_region::kProgramArea, program_size);
+  program_size_ = program_size;
+
+  logger.Emit(Logger::LogLevel::kDebug,
+              "Loaded a program of size {} into internal memory",
+              program_size);
+  return true;
+}
+
 auto chip8::VMInstance::SetTiming(const unsigned int instructions_per_second,
                                   const double desired_frame_rate) noexcept
     -> bool {
+  if (!ApplyTiming(instructions_per_second, desired_frame_rate)) {
+    return false;
+  }
+
+  default_instructions_per_sec_ = instructions_per_second;
+  return true;
+}
+
+auto chip8::VMInstance::ApplyTiming(
+    const unsigned int instructions_per_second,
+    const double desired_frame_rate) noexcept -> bool {
   if ((instructions_per_second == 0) || (desired_frame_rate <= 0.0)) {
     return false;
   }
@@ -152,6 +419,7 @@ auto chip8::VMInstance::SetTiming(const unsigned int instructions_per_second,
 
   target_frame_rate_ = static_cast<unsigned int>(desired_frame_rate);
   number_of_steps_per_frame_ = static_cast<unsigned int>(steps_per_frame);
+  exact_steps_per_frame_ = steps_per_frame;
 
   constexpr auto kSecInMs = 1000;
   max_frame_time_ = kSecInMs / desired_frame_rate;
@@ -172,14 +440,50 @@ auto chip8::VMInstance::SetInstructionsPerSecond(
 }
 
 auto chip8::VMInstance::SetFrameRate(const double frame_rate) noexcept -> bool {
-  return SetTiming(instructions_per_sec_, frame_rate);
+  return ApplyTiming(instructions_per_sec_, frame_rate);
+}
+
+void chip8::VMInstance::SetKeyWaitMode(
+    const KeyWaitMode key_wait_mode) noexcept {
+  key_wait_mode_ = key_wait_mode;
+}
+
+auto chip8::VMInstance::GetKeyWaitMode() const noexcept -> KeyWaitMode {
+  return key_wait_mode_;
 }
 
 auto chip8::VMInstance::RunForOneFrame() noexcept -> chip8::StepResult {
-  for (auto executed_steps = 0U; executed_steps < number_of_steps_per_frame_;
+  const auto idle_while_waiting = (key_wait_mode_ == KeyWaitMode::kIdle);
+
+  const auto frame_steps = exact_steps_per_frame_ + step_remainder_;
+  const auto steps_this_frame = static_cast<unsigned int>(frame_steps);
+
+  step_remainder_ = frame_steps - steps_this_frame;
+
+  // Whatever happened before, the screen is updated at the end of this frame.
+  steps_until_screen_update_ = steps_this_frame;
+
+  for (auto executed_steps = 0U; executed_steps < steps_this_frame;
        ++executed_steps) {
+    if (idle_while_waiting) {
+      // The key we're waiting for may have been pressed in the meantime.
+      ApplyQueuedInput();
+
+      if (impl_->IsHaltedUntilKeyPress()) {
+        IdleStep();
+        continue;
+      }
+    }
+
     const auto step_result = Step();
 
+    if ((step_result == chip8::StepResult::kHaltUntilKeyPress) &&
+        idle_while_waiting) {
+      // The instruction that started the wait has been executed; idle for the
+      // remainder of the frame.
+      continue;
+    }
+
     if (step_result != chip8::StepResult::kSuccess) {
       return step_result;
     }
@@ -188,16 +492,25 @@ auto chip8::VMInstance::RunForOneFrame() noexcept -> chip8::StepResult {
 }
 
 auto chip8::VMInstance::Step() noexcept -> chip8::StepResult {
+  ApplyQueuedInput();
+
   if (trace_info_.file_handle_) {
-    const auto hi = impl_->memory_[impl_->program_counter_ + 0];
-    const auto lo = impl_->memory_[impl_->program_counter_ + 1];
+    const auto* const memory = impl_->GetMemory();
+    const auto hi = memory[impl_->program_counter_ + 0];
+    const auto lo = memory[impl_->program_counter_ + 1];
 
     chip8::Instruction instruction((hi << 8) | lo);
 
-    trace_info_.file_handle_
-        << fmt::format("${:04X}: {}", impl_->program_counter_,
-                       chip8::debug::DisassembleInstruction(instruction))
-        << '\n';
+    // The line is put together on the stack; tracing doesn't allocate memory
+    // for every instruction.
+    fmt::memory_buffer trace_line;
+    fmt::format_to(std::back_inserter(trace_line), "${:04X}: ",
+                   impl_->program_counter_);
+
+    chip8::debug::DisassembleInstruction(instruction, trace_line);
+    trace_line.push_back('\n');
+
+    trace_info_.file_handle_.write(trace_line.data(), trace_line.size());
   }
 
   // Check to see if we have a breakpoint corresponding to the current program
@@ -212,19 +525,186 @@ auto chip8::VMInstance::Step() noexcept -> chip8::StepResult {
     }
     return chip8::StepResult::kBreakpointReached;
   }
+
+  if (num_active_input_traces_ != 0) {
+    const auto* const memory = impl_->GetMemory();
+    const auto hi = memory[impl_->program_counter_ + 0];
+    const auto lo = memory[impl_->program_counter_ + 1];
+
+    TraceInstruction(chip8::Instruction((hi << 8) | lo));
+  }
   CheckTimers();
 
   const auto result = impl_->Step();
   number_of_steps_executed_++;
 
-  if (update_screen_func_ &&
-      (number_of_steps_executed_ % number_of_steps_per_frame_) ==
-          (number_of_steps_per_frame_ - 1)) {
-    update_screen_func_(impl_->framebuffer_);
-  }
+  // The instruction may have set or cleared the sound timer; the beeper follows
+  // it right away rather than on the next timer tick.
+  UpdateBeeper();
+
+  CheckScreenUpdate();
   return result;
 }
 
+auto chip8::VMInstance::QueueKeyState(
+    const Key key, const KeyState state,
+    const InputEvent::Clock::time_point timestamp) noexcept -> bool {
+  return input_queue_.Push({key, state, timestamp});
+}
+
+void chip8::VMInstance::ApplyQueuedInput() noexcept {
+  InputEvent event{};
+
+  while (input_queue_.Pop(event)) {
+    const auto was_halted = impl_->IsHaltedUntilKeyPress();
+    impl_->SetKeyState(event.key_, event.state_);
+
+    const auto applied = InputEvent::Clock::now();
+
+    if (input_latency_func_) {
+      input_latency_func_(applied - event.timestamp_);
+    }
+
+    if (input_trace_func_) {
+      // A guest program waiting for a key press observes the key as soon as
+      // it's pressed.
+      StartInputTrace(event, applied,
+                      was_halted && !impl_->IsHaltedUntilKeyPress());
+    }
+  }
+}
+
+void chip8::VMInstance::StartInputTrace(
+    const InputEvent& event, const InputEvent::Clock::time_point applied,
+    const bool observed) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+  auto& pending = input_traces_[event.key_];
+
+  // Only the latest change of a key is traced; if the previous one was never
+  // observed, it never will be.
+  if (pending.active_) {
+    num_active_input_traces_--;
+
+    if (pending.observed_) {
+      num_observed_input_traces_--;
+    }
+  }
+
+  pending.trace_.key_ = event.key_;
+  pending.trace_.state_ = event.state_;
+  pending.trace_.reported_ = event.timestamp_;
+  pending.trace_.applied_ = applied;
+  pending.trace_.observed_ = applied;
+  pending.active_ = true;
+  pending.observed_ = observed;
+
+  num_active_input_traces_++;
+
+  if (observed) {
+    num_observed_input_traces_++;
+  }
+}
+
+void chip8::VMInstance::TraceInstruction(
+    const Instruction& instruction) noexcept {
+  switch (instruction.group_) {
+    case chip8::instruction_groups::kKeyboardControlFlow: {
+      const auto key = impl_->V_[instruction.x_];
+
+      if (key >= input_traces_.size()) {
+        return;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      auto& pending = input_traces_[key];
+
+      if (pending.active_ && !pending.observed_) {
+        pending.trace_.observed_ = InputEvent::Clock::now();
+        pending.observed_ = true;
+
+        num_observed_input_traces_++;
+      }
+      return;
+    }
+
+    case chip8::instruction_groups::kControlFlowAndScreen:
+      if (instruction.byte_ !=
+          chip8::control_flow_and_screen_instructions::kCLS) {
+        return;
+      }
+      break;
+
+    case chip8::ungrouped_instructions::kDRW:
+      break;
+
+    default:
+      return;
+  }
+
+  if (num_observed_input_traces_ != 0) {
+    input_trace_frame_drawn_ = true;
+  }
+}
+
+void chip8::VMInstance::FinishInputTraces() noexcept {
+  const auto frame_sent = InputEvent::Clock::now();
+
+  for (auto& pending : input_traces_) {
+    if (!pending.active_ || !pending.observed_) {
+      continue;
+    }
+
+    pending.trace_.frame_sent_ = frame_sent;
+    pending.active_ = false;
+    pending.observed_ = false;
+
+    num_active_input_traces_--;
+    num_observed_input_traces_--;
+
+    if (input_trace_func_) {
+      input_trace_func_(pending.trace_);
+    }
+  }
+  input_trace_frame_drawn_ = false;
+}
+
+void chip8::VMInstance::ClearInputTraces() noexcept {
+  for (auto& pending : input_traces_) {
+    pending.active_ = false;
+    pending.observed_ = false;
+  }
+
+  num_active_input_traces_ = 0;
+  num_observed_input_traces_ = 0;
+  input_trace_frame_drawn_ = false;
+}
+
+void chip8::VMInstance::IdleStep() noexcept {
+  CheckTimers();
+  number_of_steps_executed_++;
+
+  CheckScreenUpdate();
+}
+
+void chip8::VMInstance::CheckScreenUpdate() noexcept {
+  if (--steps_until_screen_update_ != 0) {
+    return;
+  }
+
+  // Steps taken outside of \ref RunForOneFrame(), for instance by a debugger,
+  // update the screen every whole frame.
+  steps_until_screen_update_ = number_of_steps_per_frame_;
+
+  if (update_screen_func_) {
+    impl_->CopyScreen(screen_);
+    update_screen_func_(screen_);
+  }
+
+  if (input_trace_frame_drawn_) {
+    FinishInputTraces();
+  }
+}
+
 void chip8::VMInstance::PrepareForStepOver() noexcept {
   const auto pc =
       impl_->program_counter_ + chip8::data_size::kInstructionLength;
@@ -0,0 +1,224 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "spec.h"
+
+namespace chip8 {
+namespace analysis {
+/// Defines how control leaves a basic block.
+enum class BlockExit {
+  /// The last instruction runs into the next block, which starts at the
+  /// target of a branch.
+  kFallThrough,
+
+  /// The block ends with `JP addr`.
+  kJump,
+
+  /// The block ends with `CALL addr`; it continues at the next instruction
+  /// when the subroutine returns.
+  kCall,
+
+  /// The block ends with an instruction that may skip the next one.
+  kSkip,
+
+  /// The block ends with `RET`.
+  kReturn,
+
+  /// The block ends with `JP V0, addr`, whose target can't be known without
+  /// running the program.
+  kIndirectJump,
+
+  /// The block ends with the SUPER-CHIP `EXIT` instruction.
+  kExit,
+
+  /// The block ends with an instruction the virtual machine can't execute.
+  kInvalid,
+
+  /// The last instruction is followed by the end of the program.
+  kLeavesProgram
+};
+
+/// A run of instructions that is always executed from start to end.
+struct BasicBlock {
+  /// The address of the first instruction.
+  uint_fast16_t start_;
+
+  /// The address just past the last instruction.
+  uint_fast16_t end_;
+
+  /// How control leaves the block.
+  BlockExit exit_;
+
+  /// The addresses of the blocks control may continue at within the program.
+  /// Subroutines called are not included, see \ref ProgramAnalysis::calls_.
+  std::vector<uint_fast16_t> successors_;
+};
+
+/// A `CALL addr` instruction.
+struct CallSite {
+  /// The address of the first instruction of the subroutine the call is made
+  /// from.
+  uint_fast16_t caller_;
+
+  /// The address of the call instruction.
+  uint_fast16_t address_;
+
+  /// The address of the subroutine being called.
+  uint_fast16_t callee_;
+};
+
+/// The result of \ref AnalyzeProgram().
+struct ProgramAnalysis {
+  /// Finds the block an instruction belongs to.
+  ///
+  /// \param address The address of the instruction.
+  ///
+  /// \returns The block containing \p address, or \p nullptr if the address
+  /// isn't reachable code.
+  auto FindBlock(uint_fast16_t address) const noexcept -> const BasicBlock*;
+
+  /// Determines whether or not a byte is part of a reachable instruction.
+  ///
+  /// \param address The address of the byte.
+  ///
+  /// \returns true if the byte is code, or false otherwise.
+  auto IsCode(uint_fast16_t address) const noexcept -> bool;
+
+  /// Every reachable block, sorted by start address.
+  std::vector<BasicBlock> blocks_;
+
+  /// The start of every subroutine, sorted. The program area is considered a
+  /// subroutine of its own.
+  std::vector<uint_fast16_t> subroutines_;
+
+  /// The call graph, sorted by caller and then by address.
+  std::vector<CallSite> calls_;
+
+  /// The address of every reachable `JP V0, addr` instruction, sorted.
+  std::vector<uint_fast16_t> indirect_jumps_;
+
+  /// The bytes that are part of a reachable instruction.
+  std::bitset<data_size::kInternalMemory> code_;
+
+  /// The bytes of the program that aren't part of any reachable instruction.
+  /// These are sprites and other data, or code only reached through an
+  /// indirect jump.
+  std::bitset<data_size::kInternalMemory> data_;
+};
+
+/// Recovers the control flow of a program without running it.
+///
+/// Instructions are followed from the start of the program area through
+/// jumps, calls, skips and returns. Targets outside of the program aren't
+/// followed. SUPER-CHIP and XO-CHIP instructions are always recognized; no
+/// CHIP-8 program can use them anyway. Only the part of the program within
+/// the classic 4 KB of internal memory is analyzed.
+///
+/// \param program The program, as it is loaded at the start of the program
+/// area.
+///
+/// \param program_size The size of the program, in bytes.
+///
+/// \returns The control flow of the program.
+auto AnalyzeProgram(const uint_fast8_t* program, size_t program_size) noexcept
+    -> ProgramAnalysis;
+
+/// \copydoc AnalyzeProgram(const uint_fast8_t*, size_t)
+///
+/// \param program_data A container containing program data. This container
+/// MUST hold elements of the `uint_fast8_t` type.
+template <typename Container,
+          typename = std::enable_if_t<
+              std::is_same_v<typename Container::value_type, uint_fast8_t>>>
+auto AnalyzeProgram(const Container& program_data) noexcept
+    -> ProgramAnalysis {
+  return AnalyzeProgram(program_data.data(), program_data.size());
+}
+
+/// Computes a 64-bit FNV-1a hash of a program.
+///
+/// \param program The program data.
+///
+/// \param program_size The size of the program, in bytes.
+///
+/// \returns The hash of the program.
+auto HashProgram(const uint_fast8_t* program, size_t program_size) noexcept
+    -> uint64_t;
+
+/// This class keeps the analysis of the programs seen most recently, so that
+/// the debugger and anything else interested in the control flow of a program
+/// don't analyze the same program over and over.
+///
+/// This class is thread-safe.
+class AnalysisCache {
+ public:
+  /// The maximum number of programs whose analysis is kept.
+  static constexpr size_t kMaxEntries = 8;
+
+  /// Retrieves the cache shared by the whole program.
+  ///
+  /// \returns The shared instance of \p AnalysisCache.
+  static auto Get() noexcept -> AnalysisCache&;
+
+  /// Retrieves the analysis of a program, analyzing it if it hasn't been seen
+  /// recently.
+  ///
+  /// \param program The program data.
+  ///
+  /// \param program_size The size of the program, in bytes.
+  ///
+  /// \returns The analysis of the program.
+  auto Analyze(const uint_fast8_t* program, size_t program_size) noexcept
+      -> std::shared_ptr<const ProgramAnalysis>;
+
+  /// Retrieves the number of programs actually analyzed, as opposed to found
+  /// in the cache.
+  ///
+  /// \returns The number of programs analyzed.
+  auto GetNumberOfAnalyses() const noexcept -> uintmax_t;
+
+  /// Forgets every program analyzed.
+  void Clear() noexcept;
+
+ private:
+  /// A program that has been analyzed.
+  struct Entry {
+    /// The hash of the program, see \ref HashProgram().
+    uint64_t hash_;
+
+    /// The program itself, to tell programs with the same hash apart.
+    std::vector<uint_fast8_t> program_;
+
+    /// The analysis of the program.
+    std::shared_ptr<const ProgramAnalysis> analysis_;
+  };
+
+  /// Protects every member below.
+  mutable std::mutex mutex_;
+
+  /// The programs analyzed, least recently used first.
+  std::vector<Entry> entries_;
+
+  /// The number of programs analyzed.
+  uintmax_t num_analyses_ = 0;
+};
+}  // namespace analysis
+}  // namespace chip8
@@ -12,12 +12,17 @@
 
 #pragma once
 
+#include <fmt/format.h>
+
 #include <string>
 
 #include "spec.h"
 
 namespace chip8 {
 namespace debug {
+/// The maximum number of characters the disassembly of an instruction can take.
+constexpr size_t kMaxDisassemblyLength = 14;
+
 /// Converts a CHIP-8 bytecode instruction into human-readable CHIP-8 assembly
 /// language.
 ///
@@ -36,5 +41,38 @@ namespace debug {
 /// \returns Human-readable CHIP-8 assembly language.
 auto DisassembleInstruction(const Instruction& instruction) noexcept
     -> std::string;
+
+/// Converts a CHIP-8 bytecode instruction into human-readable CHIP-8 assembly
+/// language, appending it to \p buffer.
+///
+/// Unlike the overload returning a string, this never allocates memory unless
+/// \p buffer has to grow, which makes it suitable for disassembling large
+/// amounts of instructions at once.
+///
+/// \param instruction The instruction to process.
+///
+/// \param buffer The buffer to append the disassembly to.
+///
+/// \returns The number of characters appended.
+auto DisassembleInstruction(const Instruction& instruction,
+                            fmt::memory_buffer& buffer) noexcept -> size_t;
+
+/// Converts a CHIP-8 bytecode instruction into human-readable CHIP-8 assembly
+/// language, writing it to \p buffer. The disassembly is not null-terminated.
+///
+/// This never allocates memory. If \p buffer is too small, the disassembly is
+/// truncated; a buffer of \ref kMaxDisassemblyLength characters is always large
+/// enough.
+///
+/// \param instruction The instruction to process.
+///
+/// \param buffer The buffer to write the disassembly to.
+///
+/// \param buffer_size The size of \p buffer, in characters.
+///
+/// \returns The length of the disassembly, which may be larger than \p
+/// buffer_size if it was truncated.
+auto DisassembleInstruction(const Instruction& instruction, char* buffer,
+                            size_t buffer_size) noexcept -> size_t;
 }  // namespace debug
 }  // namespace chip8
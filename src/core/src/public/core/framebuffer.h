@@ -0,0 +1,413 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "spec.h"
+
+namespace chip8 {
+/// This class holds the screen of the virtual machine, made of \p NumPlanes
+/// monochrome bitplanes. The color of a pixel is the number formed by its bit
+/// in every plane, plane 0 being the least significant bit.
+///
+/// Rather than storing a color per pixel, every row of a plane is packed into
+/// 64-bit words, one bit per pixel, with the leftmost pixel in the most
+/// significant bit of the first word. Drawing a sprite row then takes a shift
+/// and an XOR per word instead of a loop over its pixels, and scrolling boils
+/// down to shifting words horizontally and moving whole rows vertically.
+///
+/// Operations that affect the whole screen take a mask of the planes to
+/// affect, as XO-CHIP programs pick the planes they draw to.
+///
+/// Storage is always large enough for the high resolution mode. In the low
+/// resolution mode, only the first word of the first \ref
+/// framebuffer::kHeight rows of each plane is in use.
+///
+/// \tparam NumPlanes The number of bitplanes, between 1 and 8.
+template <unsigned int NumPlanes>
+class BasicFramebuffer {
+  static_assert((NumPlanes >= 1) && (NumPlanes <= 8),
+                "A framebuffer has between 1 and 8 planes");
+
+ public:
+  /// The type of the words a row is packed into.
+  using Word = uint64_t;
+
+  /// The number of pixels stored in a word.
+  static constexpr unsigned int kWordBits = 64;
+
+  /// The number of words a row takes in the high resolution mode.
+  static constexpr unsigned int kWordsPerRow =
+      framebuffer::kHighResolutionWidth / kWordBits;
+
+  /// The number of bitplanes.
+  static constexpr unsigned int kNumPlanes = NumPlanes;
+
+  /// The mask selecting every plane.
+  static constexpr unsigned int kAllPlanes = (1U << NumPlanes) - 1;
+
+  /// A row of pixels of a plane.
+  using Row = std::array<Word, kWordsPerRow>;
+
+  /// The rows of a plane.
+  using Plane = std::array<Row, framebuffer::kHighResolutionHeight>;
+
+  /// Constructs a blank framebuffer in the low resolution mode.
+  BasicFramebuffer() noexcept { Clear(); }
+
+  /// Copies the screen of a framebuffer with fewer planes; the planes it
+  /// doesn't have are blank.
+  ///
+  /// \param other The framebuffer to copy.
+  template <unsigned int OtherNumPlanes>
+  explicit BasicFramebuffer(
+      const BasicFramebuffer<OtherNumPlanes>& other) noexcept {
+    Assign(other);
+  }
+
+  /// Copies the screen of a framebuffer with fewer planes; the planes it
+  /// doesn't have are blank.
+  ///
+  /// \param other The framebuffer to copy.
+  template <unsigned int OtherNumPlanes>
+  void Assign(const BasicFramebuffer<OtherNumPlanes>& other) noexcept {
+    static_assert(OtherNumPlanes <= NumPlanes,
+                  "Planes can't be dropped from a framebuffer");
+
+    high_resolution_ = other.IsHighResolution();
+
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      if (plane < OtherNumPlanes) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        planes_[plane] = other.GetPlane(plane);
+      } else {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        planes_[plane].fill(Row{});
+      }
+    }
+  }
+
+  /// Retrieves the width of the screen in the current resolution mode.
+  ///
+  /// \returns The number of pixels per row.
+  auto GetWidth() const noexcept -> unsigned int {
+    return high_resolution_ ? framebuffer::kHighResolutionWidth
+                            : framebuffer::kWidth;
+  }
+
+  /// Retrieves the height of the screen in the current resolution mode.
+  ///
+  /// \returns The number of rows.
+  auto GetHeight() const noexcept -> unsigned int {
+    return high_resolution_ ? framebuffer::kHighResolutionHeight
+                            : framebuffer::kHeight;
+  }
+
+  /// Determines whether or not the screen is in the high resolution mode.
+  ///
+  /// \returns true if the screen is 128x64, or false if it is 64x32.
+  auto IsHighResolution() const noexcept -> bool { return high_resolution_; }
+
+  /// Switches between the resolution modes, clearing every plane.
+  ///
+  /// \param high_resolution true for 128x64, or false for 64x32.
+  void SetHighResolution(const bool high_resolution) noexcept {
+    high_resolution_ = high_resolution;
+    Clear();
+  }
+
+  /// Turns every pixel of some planes off.
+  ///
+  /// \param planes The mask of the planes to clear.
+  void Clear(const unsigned int planes = kAllPlanes) noexcept {
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      if ((planes & (1U << plane)) != 0) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        planes_[plane].fill(Row{});
+      }
+    }
+  }
+
+  /// Retrieves every row of a plane, including the ones not in use in the low
+  /// resolution mode.
+  ///
+  /// \param plane The plane, which must be less than \p NumPlanes.
+  ///
+  /// \returns The rows of the plane.
+  auto GetPlane(const unsigned int plane) const noexcept -> const Plane& {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    return planes_[plane];
+  }
+
+  /// Retrieves a row of pixels of a plane.
+  ///
+  /// \param y The row, which must be less than \ref GetHeight().
+  /// \param plane The plane, which must be less than \p NumPlanes.
+  ///
+  /// \returns The packed pixels of the row. Only the first
+  /// `GetWidth() / kWordBits` words are in use.
+  auto GetRow(const unsigned int y, const unsigned int plane = 0) const noexcept
+      -> const Row& {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    return planes_[plane][y];
+  }
+
+  /// Retrieves the color of a pixel.
+  ///
+  /// \param x The column, which must be less than \ref GetWidth().
+  /// \param y The row, which must be less than \ref GetHeight().
+  ///
+  /// \returns The color of the pixel, 0 if it is off in every plane.
+  auto GetPixel(const unsigned int x, const unsigned int y) const noexcept
+      -> unsigned int {
+    const auto word = x / kWordBits;
+    const auto shift = kWordBits - 1 - (x % kWordBits);
+
+    unsigned int color = 0;
+
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      color |= ((planes_[plane][y][word] >> shift) & 1) << plane;
+    }
+    return color;
+  }
+
+  /// Determines whether or not a pixel is on in any plane.
+  ///
+  /// \param x The column, which must be less than \ref GetWidth().
+  /// \param y The row, which must be less than \ref GetHeight().
+  ///
+  /// \returns true if the pixel is on, or false otherwise.
+  auto IsPixelOn(const unsigned int x, const unsigned int y) const noexcept
+      -> bool {
+    return GetPixel(x, y) != 0;
+  }
+
+  /// XORs a row of a sprite onto a plane.
+  ///
+  /// \param x The column of the leftmost pixel of the sprite, which must be
+  /// less than \ref GetWidth().
+  ///
+  /// \param y The row, which must be less than \ref GetHeight().
+  ///
+  /// \param bits The pixels of the sprite row, leftmost pixel in the most
+  /// significant of the \p width lowest bits.
+  ///
+  /// \param width The number of pixels in the sprite row, at most 16.
+  ///
+  /// \param clip true to drop the pixels past the right edge of the screen, or
+  /// false to wrap them around to the left edge.
+  ///
+  /// \param plane The plane to draw to, which must be less than \p
+  /// NumPlanes.
+  ///
+  /// \returns true if a pixel that was on has been turned off, or false
+  /// otherwise.
+  auto DrawSpriteRow(const unsigned int x, const unsigned int y,
+                     const unsigned int bits, const unsigned int width,
+                     const bool clip, const unsigned int plane = 0) noexcept
+      -> bool {
+    const auto num_words = GetWidth() / kWordBits;
+
+    // The sprite is lined up with the leftmost pixel of a word, then shifted
+    // into place. It can straddle two words, and may overflow into the word
+    // just past the edge of the screen.
+    const auto sprite = static_cast<Word>(bits) << (kWordBits - width);
+    const auto word = x / kWordBits;
+    const auto shift = x % kWordBits;
+
+    std::array<Word, kWordsPerRow + 1> mask{};
+    mask[word] = sprite >> shift;
+
+    if (shift != 0) {
+      mask[word + 1] = sprite << (kWordBits - shift);
+    }
+
+    // The screen is a whole number of words wide, so whatever overflowed
+    // wraps around to the first word as is.
+    if (!clip) {
+      mask[0] |= mask[num_words];
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    auto& row = planes_[plane][y];
+    Word collisions = 0;
+
+    for (unsigned int index = 0; index < num_words; ++index) {
+      collisions |= row[index] & mask[index];
+      row[index] ^= mask[index];
+    }
+    return collisions != 0;
+  }
+
+  /// Scrolls some planes down. Rows scrolled in at the top are blank.
+  ///
+  /// \param num_rows The number of rows to scroll by.
+  /// \param planes The mask of the planes to scroll.
+  void ScrollDown(const unsigned int num_rows,
+                  const unsigned int planes = kAllPlanes) noexcept {
+    const auto height = GetHeight();
+    const auto count = (num_rows < height) ? num_rows : height;
+
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      if ((planes & (1U << plane)) == 0) {
+        continue;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      auto* const rows = planes_[plane].data();
+
+      // Rows are contiguous, so this moves the whole plane in one go.
+      std::memmove(rows + count, rows, (height - count) * sizeof(Row));
+      std::memset(rows, 0, count * sizeof(Row));
+    }
+  }
+
+  /// Scrolls some planes up. Rows scrolled in at the bottom are blank.
+  ///
+  /// \param num_rows The number of rows to scroll by.
+  /// \param planes The mask of the planes to scroll.
+  void ScrollUp(const unsigned int num_rows,
+                const unsigned int planes = kAllPlanes) noexcept {
+    const auto height = GetHeight();
+    const auto count = (num_rows < height) ? num_rows : height;
+
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      if ((planes & (1U << plane)) == 0) {
+        continue;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      auto* const rows = planes_[plane].data();
+
+      std::memmove(rows, rows + count, (height - count) * sizeof(Row));
+      std::memset(rows + (height - count), 0, count * sizeof(Row));
+    }
+  }
+
+  /// Scrolls some planes right. Pixels scrolled past the right edge are lost,
+  /// and the ones scrolled in at the left edge are off.
+  ///
+  /// \param num_pixels The number of pixels to scroll by, less than 64.
+  /// \param planes The mask of the planes to scroll.
+  void ScrollRight(const unsigned int num_pixels,
+                   const unsigned int planes = kAllPlanes) noexcept {
+    if (num_pixels == 0) {
+      return;
+    }
+
+    const auto height = GetHeight();
+
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      if ((planes & (1U << plane)) == 0) {
+        continue;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      auto& rows = planes_[plane];
+
+      if (!high_resolution_) {
+        for (unsigned int y = 0; y < height; ++y) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+          rows[y][0] >>= num_pixels;
+        }
+        continue;
+      }
+
+      for (unsigned int y = 0; y < height; ++y) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        auto& row = rows[y];
+
+        row[1] = (row[1] >> num_pixels) | (row[0] << (kWordBits - num_pixels));
+        row[0] >>= num_pixels;
+      }
+    }
+  }
+
+  /// Scrolls some planes left. Pixels scrolled past the left edge are lost,
+  /// and the ones scrolled in at the right edge are off.
+  ///
+  /// \param num_pixels The number of pixels to scroll by, less than 64.
+  /// \param planes The mask of the planes to scroll.
+  void ScrollLeft(const unsigned int num_pixels,
+                  const unsigned int planes = kAllPlanes) noexcept {
+    if (num_pixels == 0) {
+      return;
+    }
+
+    const auto height = GetHeight();
+
+    for (unsigned int plane = 0; plane < NumPlanes; ++plane) {
+      if ((planes & (1U << plane)) == 0) {
+        continue;
+      }
+
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+      auto& rows = planes_[plane];
+
+      if (!high_resolution_) {
+        for (unsigned int y = 0; y < height; ++y) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+          rows[y][0] <<= num_pixels;
+        }
+        continue;
+      }
+
+      for (unsigned int y = 0; y < height; ++y) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        auto& row = rows[y];
+
+        row[0] = (row[0] << num_pixels) | (row[1] >> (kWordBits - num_pixels));
+        row[1] <<= num_pixels;
+      }
+    }
+  }
+
+  /// Compares two framebuffers.
+  ///
+  /// \param other The framebuffer to compare against.
+  ///
+  /// \returns true if both are in the same resolution mode and show the same
+  /// pixels, or false otherwise.
+  auto operator==(const BasicFramebuffer& other) const noexcept -> bool {
+    return (high_resolution_ == other.high_resolution_) &&
+           (planes_ == other.planes_);
+  }
+
+  /// Compares two framebuffers.
+  ///
+  /// \param other The framebuffer to compare against.
+  ///
+  /// \returns true if the framebuffers differ, or false otherwise.
+  auto operator!=(const BasicFramebuffer& other) const noexcept -> bool {
+    return !(*this == other);
+  }
+
+ private:
+  /// The planes of the screen, in the layout described above.
+  std::array<Plane, NumPlanes> planes_;
+
+  /// Whether or not the screen is in the high resolution mode.
+  bool high_resolution_ = false;
+};
+
+/// The monochrome screen of CHIP-8 and SUPER-CHIP.
+using Framebuffer = BasicFramebuffer<1>;
+
+/// The screen handed to frontends, with enough planes for any implementation,
+/// so that frontends deal with a single type.
+using Screen = BasicFramebuffer<framebuffer::kMaxPlanes>;
+}  // namespace chip8
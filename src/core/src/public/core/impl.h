@@ -13,9 +13,13 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <tuple>
 
+#include "framebuffer.h"
 #include "logger.h"
+#include "quirks.h"
 #include "spec.h"
 
 namespace chip8 {
@@ -94,15 +98,25 @@ namespace chip8 {
 ///       running works on the original hardware.
 ///
 ///       In many circles, JITs are often referred to as dynamic recompilers.
+///
+/// The size of the internal memory and the number of bitplanes of the screen
+/// differ between variants, and they're fixed for the lifetime of an
+/// implementation. Implementations own both, sized by their template
+/// parameters, so that CHIP-8 doesn't pay for the 64KB of memory and the
+/// extra plane of XO-CHIP; this class only refers to the memory.
 class ImplementationInterface {
  public:
-  /// Type alias to the framebuffer.
-  using Framebuffer = std::array<uint32_t, framebuffer::kSize>;
-
   /// Classes which contain at least one virtual function should have either a
   /// public and virtual destructor, or a protected and non-virtual destructor.
   virtual ~ImplementationInterface() noexcept = default;
 
+  /// Implementations refer to their own memory, so they can't be copied.
+  ImplementationInterface(const ImplementationInterface&) = delete;
+
+  /// Implementations refer to their own memory, so they can't be copied.
+  auto operator=(const ImplementationInterface&)
+      -> ImplementationInterface& = delete;
+
   /// Determines if the implementation should halt, pending a key press.
   ///
   /// Example code:
@@ -150,13 +164,75 @@ class ImplementationInterface {
     ResetInternalMemory();
   }
 
+  /// Copies the screen, widening it to the number of planes frontends deal
+  /// with.
+  ///
+  /// \param screen Where to copy the screen to.
+  virtual void CopyScreen(Screen& screen) const noexcept = 0;
+
+  /// Retrieves the internal memory.
+  ///
+  /// \returns A pointer to the first of \ref GetMemorySize() bytes.
+  auto GetMemory() noexcept -> uint_fast8_t* { return memory_; }
+
+  /// \copydoc GetMemory()
+  auto GetMemory() const noexcept -> const uint_fast8_t* { return memory_; }
+
+  /// Retrieves the size of the internal memory, which is fixed for the
+  /// lifetime of the implementation.
+  ///
+  /// \returns The size of the internal memory, in bytes.
+  auto GetMemorySize() const noexcept -> size_t { return memory_size_; }
+
+  /// One bit per page of internal memory, see \ref MarkMemoryDirty(). Page
+  /// \p n is bit `n % 64` of word `n / 64`.
+  using DirtyPages = std::array<uint64_t, data_size::kXoChipInternalMemory /
+                                              data_size::kMemoryPage / 64>;
+
+  /// Records that part of the internal memory has been written to, so that
+  /// whatever is derived from it, like \ref VMInstance::GetStateHash(), is
+  /// brought up to date.
+  ///
+  /// Implementations call this whenever an instruction writes to memory.
+  /// Anything else writing through \ref GetMemory() must call it as well.
+  ///
+  /// \param address The first byte written to.
+  ///
+  /// \param length The number of bytes written to. Bytes past the end of the
+  /// internal memory are ignored.
+  void MarkMemoryDirty(const size_t address, const size_t length) noexcept {
+    if ((length == 0) || (address >= memory_size_)) {
+      return;
+    }
+
+    const auto first_page = address / data_size::kMemoryPage;
+    const auto last_page =
+        (std::min(address + length, memory_size_) - 1) / data_size::kMemoryPage;
+
+    for (auto page = first_page; page <= last_page; ++page) {
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+      dirty_pages_[page / 64] |= uint64_t{1} << (page % 64);
+    }
+  }
+
+  /// Retrieves the pages of internal memory written to since the last call,
+  /// and forgets about them.
+  ///
+  /// \returns The pages written to.
+  auto TakeDirtyPages() noexcept -> DirtyPages {
+    const auto dirty_pages = dirty_pages_;
+    dirty_pages_.fill(0);
+
+    return dirty_pages;
+  }
+
   /// Sets the program counter, performing bounds checking.
   ///
-  /// If the default implementation is used, the specified new program counter
-  /// cannot exceed 4094 (0xFFE). While the internal memory can reference a
-  /// range between 0 to 4095 (0xFFF), instructions are two bytes long. When
-  /// fetching an instruction, any value over 0xFFE will lead to an
-  /// out-of-bounds array access, and thus is undefined behavior.
+  /// The specified new program counter cannot exceed the size of the internal
+  /// memory minus 2, e.g. 4094 (0xFFE) for CHIP-8. While the internal memory
+  /// can reference a range between 0 to 4095 (0xFFF), instructions are two
+  /// bytes long. When fetching an instruction, any value over 0xFFE will lead
+  /// to an out-of-bounds array access, and thus is undefined behavior.
   ///
   /// Example code:
   ///   \code
@@ -168,7 +244,8 @@ class ImplementationInterface {
   /// \returns \p true if the program counter was changed, or \p false if the
   /// program counter was too large.
   auto SetProgramCounter(const size_t new_program_counter) noexcept -> bool {
-    if (new_program_counter > chip8::data_limits::kProgramCounter) {
+    if (new_program_counter >
+        (memory_size_ - chip8::data_size::kInstructionLength)) {
       return false;
     }
 
@@ -233,25 +310,13 @@ class ImplementationInterface {
   /// to the location in which the last subroutine address was stored.
   std::array<uint_fast16_t, chip8::data_size::kStack> stack_;
 
-  /// CHIP-8 contains an internal memory space totaling 4,096 bytes (or 4KB).
-  /// Historically, the first 512 bytes (0x000-0x1FF) contained the virtual
-  /// machine itself. In modern implementations, a font set totaling 80 bytes
-  /// (0x50) is stored at the beginning of this memory area. Programs may choose
-  /// to use the font set, but it is not mandatory.
-  std::array<uint_fast8_t, chip8::data_size::kInternalMemory> memory_;
-
-  /// CHIP-8 contains a 64x32 monochrome framebuffer used for displaying
-  /// graphics. In our implementation, we store BGRA32 values to allow for easy
-  /// displaying through modern APIs.
-  Framebuffer framebuffer_;
-
   /// CHIP-8 contains a hexadecimal keypad, consisting of 16 keys.
   std::array<chip8::KeyState, chip8::data_size::kKeypad> keypad_;
 
   /// The program counter is an index into internal memory. It may be between
-  /// the ranges of 0 or 4094 (0xFFE). While the internal memory can reference a
-  /// range between 0 to 4095 (0xFFF), instructions are two bytes long. When
-  /// fetching an instruction, any value over 0xFFE will lead to an
+  /// the ranges of 0 or 4094 (0xFFE) on CHIP-8. While the internal memory can
+  /// reference a range between 0 to 4095 (0xFFF), instructions are two bytes
+  /// long. When fetching an instruction, any value over 0xFFE will lead to an
   /// out-of-bounds array access, and thus is undefined behavior.
   size_t program_counter_;
 
@@ -280,10 +345,46 @@ class ImplementationInterface {
   /// instructions.
   unsigned int I_;
 
+  /// The behavior the guest program expects from instructions that differ
+  /// between interpreters, see \ref Quirks. This is configuration rather than
+  /// state, so \ref Reset() leaves it untouched.
+  Quirks quirks_;
+
+  /// The flavor of CHIP-8 the guest program is written for. Instructions of
+  /// other flavors are invalid. Like \ref quirks_, this is configuration, so
+  /// \ref Reset() leaves it untouched.
+  Variant variant_ = Variant::kChip8;
+
+  /// SUPER-CHIP programs can save up to 8 registers here with `LD R, Vx`, and
+  /// XO-CHIP programs all 16. On the HP-48 calculators these were the RPL user
+  /// flags, which survive the program exiting, so \ref Reset() leaves them
+  /// untouched too.
+  std::array<uint_fast8_t, data_size::kXoChipRplFlags> rpl_flags_{};
+
+  /// The mask of the planes XO-CHIP programs draw to, clear and scroll, set
+  /// with `PLANE n`. Other variants always use the first plane.
+  unsigned int selected_planes_;
+
+  /// The 1-bit samples XO-CHIP programs play while the sound timer is
+  /// non-zero, loaded with `LD AUDIO, [I]`, most significant bit first.
+  std::array<uint_fast8_t, data_size::kAudioPattern> audio_pattern_;
+
+  /// The rate XO-CHIP programs play \ref audio_pattern_ at, set with `LD
+  /// PITCH, Vx`: the pattern is played at 4000*2^((pitch-64)/48) samples per
+  /// second.
+  uint_fast8_t pitch_;
+
  protected:
-  /// Instantiates the virtual machine instance, automatically resetting it to
-  /// the default startup state.
-  ImplementationInterface() noexcept { Reset(); }
+  /// Instantiates the virtual machine instance. Implementations must call
+  /// \ref Reset() once they're fully constructed.
+  ///
+  /// \param memory The internal memory of the implementation, which must
+  /// outlive this instance.
+  ///
+  /// \param memory_size The size of the internal memory, in bytes.
+  ImplementationInterface(uint_fast8_t* const memory,
+                          const size_t memory_size) noexcept
+      : memory_(memory), memory_size_(memory_size) {}
 
   /// Signals that the implementation should halt until a key is pressed.
   ///
@@ -303,26 +404,27 @@ class ImplementationInterface {
     Logger::Get().Emit(Logger::LogLevel::kInfo, "Waiting for key press...");
   }
 
-  /// Clears the framebuffer.
-  ///
-  /// The entire framebuffer will contain \ref chip8::pixel::kBlack.
-  void ResetFramebuffer() noexcept {
-    std::fill(framebuffer_.begin(), framebuffer_.end(), chip8::pixel::kBlack);
-    Logger::Get().Emit(Logger::LogLevel::kDebug, "Framebuffer has been reset");
-  }
+  /// Clears every plane of the framebuffer, and switches it back to the low
+  /// resolution mode.
+  virtual void ResetFramebuffer() noexcept = 0;
 
   /// Sets all of the elements in the internal memory to \ref
-  /// chip8::initial_values::kInternalMemory, and copies the default font set
+  /// chip8::initial_values::kInternalMemory, and copies the default font sets
   /// into internal memory.
   ///
   /// If a guest program was loaded, the program code will be cleared by this
   /// call. It will be necessary to reload the guest program, should one choose.
   void ResetInternalMemory() noexcept {
-    std::fill(memory_.begin(), memory_.end(),
-              chip8::initial_values::kInternalMemory);
+    std::fill_n(memory_, memory_size_, chip8::initial_values::kInternalMemory);
+    MarkMemoryDirty(0, memory_size_);
 
     std::copy(chip8::initial_values::kFontSet.cbegin(),
-              chip8::initial_values::kFontSet.cend(), memory_.begin());
+              chip8::initial_values::kFontSet.cend(),
+              memory_ + chip8::memory_region::kFont);
+
+    std::copy(chip8::initial_values::kBigFontSet.cbegin(),
+              chip8::initial_values::kBigFontSet.cend(),
+              memory_ + chip8::memory_region::kBigFont);
 
     Logger::Get().Emit(Logger::LogLevel::kDebug,
                        "Internal memory has been reset");
@@ -352,6 +454,9 @@ class ImplementationInterface {
     sound_timer_ = chip8::initial_values::kSoundTimer;
     I_ = chip8::initial_values::kI;
     halted_until_key_press_ = chip8::initial_values::kKeyPressHaltState;
+    selected_planes_ = chip8::initial_values::kPlanes;
+    pitch_ = chip8::initial_values::kPitch;
+    audio_pattern_.fill(0);
 
     Logger::Get().Emit(Logger::LogLevel::kDebug,
                        "Registers set to default values");
@@ -391,6 +496,15 @@ class ImplementationInterface {
   }
 
  private:
+  /// The internal memory, owned by the implementation.
+  uint_fast8_t* memory_;
+
+  /// The size of \ref memory_, in bytes.
+  size_t memory_size_;
+
+  /// The pages of \ref memory_ written to, see \ref MarkMemoryDirty().
+  DirtyPages dirty_pages_{};
+
   /// One instruction requires the virtual machine to stop execution until a key
   /// is pressed (0xFx0A, "LD Vx, K"). If this is set to \p true,
   /// implementations should do nothing when their \ref Step() method is
@@ -0,0 +1,114 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "spec.h"
+
+namespace chip8 {
+/// Describes a change in the state of a key, as reported by the frontend.
+struct InputEvent {
+  /// The clock used to timestamp input events.
+  using Clock = std::chrono::steady_clock;
+
+  /// The key whose state changed.
+  Key key_;
+
+  /// The new state of the key.
+  KeyState state_;
+
+  /// The point in time at which the host reported the change.
+  Clock::time_point timestamp_;
+};
+
+/// Describes the points in time at which a change in the state of a key made
+/// it through each stage of the virtual machine.
+struct InputTrace {
+  /// The key whose state changed.
+  Key key_;
+
+  /// The new state of the key.
+  KeyState state_;
+
+  /// The point in time at which the host reported the change.
+  InputEvent::Clock::time_point reported_;
+
+  /// The point in time at which the change was applied to the keypad.
+  InputEvent::Clock::time_point applied_;
+
+  /// The point in time at which the guest program first observed the change,
+  /// either by checking the key with SKP or SKNP, or by being woken up from
+  /// LD Vx, K.
+  InputEvent::Clock::time_point observed_;
+
+  /// The point in time at which the first frame the guest program drew to
+  /// after observing the change was sent to the screen.
+  InputEvent::Clock::time_point frame_sent_;
+};
+
+/// This class is a fixed-size, lock-free queue of input events with exactly one
+/// producer and exactly one consumer.
+///
+/// The frontend (typically its UI thread) pushes events as the user presses
+/// and releases keys, and the thread running the virtual machine pops them at
+/// instruction boundaries. Neither thread ever blocks the other, and the
+/// keypad is only ever touched by the thread running the virtual machine.
+class InputQueue {
+ public:
+  /// The maximum number of events that can be queued at once. This must be a
+  /// power of two.
+  static constexpr size_t kCapacity = 64;
+
+  /// Adds an event to the queue. This must only be called by the producer.
+  ///
+  /// \param event The event to add.
+  ///
+  /// \returns \p true if the event was added, or \p false if the queue is full
+  /// and the event was dropped.
+  auto Push(const InputEvent& event) noexcept -> bool;
+
+  /// Removes the oldest event from the queue. This must only be called by the
+  /// consumer.
+  ///
+  /// \param event Where to store the event that was removed.
+  ///
+  /// \returns \p true if an event was removed, or \p false if the queue is
+  /// empty.
+  auto Pop(InputEvent& event) noexcept -> bool;
+
+  /// Determines whether or not the queue is empty. This is only accurate when
+  /// called by the consumer; the producer may add an event at any time.
+  ///
+  /// \returns \p true if the queue is empty, or \p false otherwise.
+  auto IsEmpty() const noexcept -> bool;
+
+ private:
+  static_assert((kCapacity & (kCapacity - 1)) == 0,
+                "The capacity of the input queue must be a power of two");
+
+  /// The storage for the events.
+  std::array<InputEvent, kCapacity> events_{};
+
+  /// The number of events that have ever been removed. Only the consumer
+  /// writes to this.
+  std::atomic<size_t> head_ = 0;
+
+  /// The number of events that have ever been added. Only the producer writes
+  /// to this.
+  std::atomic<size_t> tail_ = 0;
+};
+}  // namespace chip8
@@ -0,0 +1,172 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "framebuffer.h"
+#include "snapshot.h"
+#include "spec.h"
+#include "vm_instance.h"
+
+namespace chip8 {
+/// Defines how often \ref RunLockstep() compares the implementations.
+enum class LockstepGranularity {
+  /// After every step.
+  kStep,
+
+  /// After every step that doesn't continue with the instruction following it
+  /// in memory: jumps, calls, returns and skips taken.
+  kBlock,
+
+  /// At the end of every frame, when the screen is updated.
+  kFrame
+};
+
+/// A change in the state of a key, made at a fixed point of a lockstep run so
+/// that every implementation sees it at the same time.
+struct ScheduledKeyState {
+  /// The number of steps executed before the change is applied.
+  uintmax_t step_;
+
+  /// The key whose state changes.
+  Key key_;
+
+  /// The new state of the key.
+  KeyState state_;
+};
+
+/// Configures \ref RunLockstep().
+struct LockstepOptions {
+  /// Creates the implementation trusted to be correct.
+  VMInstance::ImplementationFactory reference_ = VMInstance::MakeInterpreter;
+
+  /// Creates the implementation being checked.
+  VMInstance::ImplementationFactory candidate_;
+
+  /// The key state changes to make, sorted by step.
+  std::vector<ScheduledKeyState> inputs_;
+
+  /// How often the implementations are compared. Comparing less often is
+  /// faster; divergences are bisected down to a single step either way.
+  LockstepGranularity granularity_ = LockstepGranularity::kFrame;
+
+  /// The number of steps after which the run stops, if the program hasn't
+  /// stopped by itself.
+  uintmax_t max_steps_ = 0;
+};
+
+/// The state of one implementation right after the first instruction that
+/// left it different from the other.
+struct LockstepState {
+  /// The result of the instruction.
+  StepResult result_;
+
+  /// The hash of the whole state of the implementation, see \ref
+  /// VMInstance::GetStateHash().
+  uint64_t hash_;
+
+  /// The registers and memory.
+  StateSnapshot snapshot_;
+
+  /// The screen.
+  Screen screen_;
+};
+
+/// Where two implementations stopped agreeing.
+struct LockstepDivergence {
+  /// The number of steps executed before the instruction.
+  uintmax_t step_;
+
+  /// The address of the instruction, as seen by the reference implementation.
+  size_t program_counter_;
+
+  /// The state of the reference implementation.
+  LockstepState reference_;
+
+  /// The state of the candidate implementation.
+  LockstepState candidate_;
+};
+
+/// The outcome of \ref RunLockstep().
+struct LockstepResult {
+  /// Whether or not both implementations accepted the program.
+  bool loaded_ = false;
+
+  /// The number of steps executed by both implementations.
+  uintmax_t steps_executed_ = 0;
+
+  /// The number of times the implementations were compared, not counting the
+  /// bisection of a divergence.
+  uintmax_t num_comparisons_ = 0;
+
+  /// The result of the last step. This is \ref StepResult::kSuccess if the
+  /// run went on for the maximum number of steps; otherwise the program
+  /// stopped with an error, or exited.
+  StepResult result_ = StepResult::kSuccess;
+
+  /// Where the implementations stopped agreeing, if they did.
+  std::optional<LockstepDivergence> divergence_;
+};
+
+/// Runs a program on two implementations side by side, and checks that they
+/// agree.
+///
+/// Both implementations run the same program and get the same key presses at
+/// the same steps. The result of every step is compared, and the whole state
+/// of the virtual machine is compared at the chosen granularity, through \ref
+/// VMInstance::GetStateHash(). The memory of the candidate implementation is
+/// hashed in full every time, since it can't be trusted to report its own
+/// writes to memory.
+///
+/// When a comparison fails, the run is replayed from the start to bisect the
+/// steps since the last comparison that succeeded, and the first step after
+/// which the states differ is reported. This assumes that differences don't
+/// vanish and reappear between two comparisons; if they can, compare at every
+/// step.
+///
+/// \param program The program data.
+///
+/// \param program_size The size of the program, in bytes.
+///
+/// \param options The implementations and how to run them.
+///
+/// \returns The outcome of the run.
+auto RunLockstep(const uint_fast8_t* program, size_t program_size,
+                 const LockstepOptions& options) noexcept -> LockstepResult;
+
+/// \copydoc RunLockstep(const uint_fast8_t*, size_t, const LockstepOptions&)
+///
+/// \param program_data A container containing program data. This container
+/// MUST hold elements of the `uint_fast8_t` type.
+template <typename Container,
+          typename = std::enable_if_t<
+              std::is_same_v<typename Container::value_type, uint_fast8_t>>>
+auto RunLockstep(const Container& program_data,
+                 const LockstepOptions& options) noexcept -> LockstepResult {
+  return RunLockstep(program_data.data(), program_data.size(), options);
+}
+
+/// Describes how the states of a divergence differ, one line per difference,
+/// e.g. `V3: $05 != $06`. The reference value comes first.
+///
+/// \param divergence The divergence to describe.
+///
+/// \returns The description.
+auto DescribeDivergence(const LockstepDivergence& divergence) noexcept
+    -> std::string;
+}  // namespace chip8
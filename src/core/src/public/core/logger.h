@@ -30,7 +30,11 @@ class Logger {
   enum class LogLevel { kInfo, kWarning, kError, kDebug };
 
   /// Defines the function prototype that the log message callback must be.
-  using LogMessageFunc = std::function<void(const std::string&)>;
+  ///
+  /// The callback receives the severity of the message separately from the
+  /// message itself, so that the frontend decides how the two are presented.
+  using LogMessageFunc =
+      std::function<void(LogLevel level, const std::string& msg)>;
 
   /// Instantiates the logger if it doesn't exist.
   ///
@@ -48,28 +52,7 @@ class Logger {
   void Emit(const LogLevel level, std::string_view fmt,
             const Args&... args) const noexcept {
     if (log_message_func_) {
-      std::string result;
-
-      switch (level) {
-        case LogLevel::kInfo:
-          result = "[INFO]: ";
-          break;
-
-        case LogLevel::kWarning:
-          result = "[WARNING]: ";
-          break;
-
-        case LogLevel::kError:
-          result = "[ERROR]: ";
-          break;
-
-        case LogLevel::kDebug:
-          result = "[DEBUG]: ";
-          break;
-      }
-
-      result += fmt::format(fmt, args...);
-      log_message_func_(result);
+      log_message_func_(level, fmt::format(fmt, args...));
     }
   }
 
@@ -0,0 +1,66 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+namespace chip8 {
+/// CHIP-8 was never formally specified; the interpreters that followed the
+/// original COSMAC VIP one changed how a handful of instructions behave, and
+/// programs came to depend on whichever interpreter they were written for.
+/// These flags select the behavior a program expects.
+///
+/// The default value of every flag is the behavior of this virtual machine
+/// before quirks existed, which is what most modern programs expect.
+struct Quirks {
+  /// `SHR Vx {, Vy}` and `SHL Vx {, Vy}` shift \p Vy and store the result in
+  /// \p Vx, as the COSMAC VIP did, instead of shifting \p Vx in place.
+  bool shift_uses_vy_ = false;
+
+  /// `LD [I], Vx` and `LD Vx, [I]` leave \p I pointing just past the last
+  /// byte accessed, as the COSMAC VIP did, instead of leaving it untouched.
+  bool load_store_increments_i_ = false;
+
+  /// `JP V0, addr` jumps to `addr + Vx`, where \p x is the highest nibble of
+  /// the address, as CHIP-48 and SUPER-CHIP did.
+  bool jump_uses_vx_ = false;
+
+  /// `OR`, `AND` and `XOR` clear \p VF, as the COSMAC VIP did.
+  bool logic_resets_vf_ = false;
+
+  /// `DRW` cuts off sprites at the edges of the screen instead of wrapping
+  /// them around to the other side. The starting position always wraps.
+  bool clip_sprites_ = false;
+
+  /// Compares two sets of quirks.
+  ///
+  /// \param other The set of quirks to compare against.
+  ///
+  /// \returns true if every flag is the same, or false otherwise.
+  auto operator==(const Quirks& other) const noexcept -> bool {
+    return (shift_uses_vy_ == other.shift_uses_vy_) &&
+           (load_store_increments_i_ == other.load_store_increments_i_) &&
+           (jump_uses_vx_ == other.jump_uses_vx_) &&
+           (logic_resets_vf_ == other.logic_resets_vf_) &&
+           (clip_sprites_ == other.clip_sprites_);
+  }
+
+  /// Compares two sets of quirks.
+  ///
+  /// \param other The set of quirks to compare against.
+  ///
+  /// \returns true if any flag differs, or false otherwise.
+  auto operator!=(const Quirks& other) const noexcept -> bool {
+    return !(*this == other);
+  }
+};
+}  // namespace chip8
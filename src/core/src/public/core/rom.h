@@ -0,0 +1,92 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "spec.h"
+
+namespace chip8 {
+/// Defines the result of \ref LoadRom().
+enum class RomLoadResult {
+  /// The ROM file was read in its entirety.
+  kSuccess,
+
+  /// The ROM file could not be opened. `errno` describes why.
+  kOpenFailed,
+
+  /// An error occurred while reading the ROM file. `errno` describes why.
+  kReadFailed,
+
+  /// The ROM file is larger than the XO-CHIP program area, so it's probably
+  /// not a CHIP-8 ROM.
+  kTooLarge
+};
+
+/// A guest program read from a ROM file.
+///
+/// Programs can never be larger than the XO-CHIP program area, so the data is
+/// stored inline rather than allocated. This also lets a \p Rom be handed to
+/// \ref VMInstance::LoadProgram() as is.
+struct Rom {
+  /// The type of the elements of the program.
+  using value_type = uint_fast8_t;
+
+  /// Retrieves the program data.
+  ///
+  /// \returns A pointer to the first byte of the program.
+  auto data() const noexcept -> const uint_fast8_t* { return data_.data(); }
+
+  /// Retrieves the size of the program.
+  ///
+  /// \returns The size of the program, in bytes.
+  auto size() const noexcept -> size_t { return size_; }
+
+  /// The program data. Only the first \ref size_ bytes are part of the
+  /// program.
+  std::array<uint_fast8_t, memory_region::kXoChipProgramAreaSize> data_;
+
+  /// The size of the program, in bytes.
+  size_t size_ = 0;
+};
+
+/// Reads a ROM file.
+///
+/// The file is read with a single unbuffered read straight into \p rom; its
+/// size isn't queried separately, as reading past the end of the program area
+/// is enough to tell that it is too large.
+///
+/// \param file_name The path to the ROM file.
+///
+/// \param rom Where to store the program. If the ROM file can't be read in its
+/// entirety, the contents are unspecified.
+///
+/// \returns The result of the operation, see \ref RomLoadResult.
+auto LoadRom(const std::string& file_name, Rom& rom) noexcept -> RomLoadResult;
+
+/// Determines the variant a ROM file is written for from the extension of its
+/// name, which is the only hint most ROM files come with.
+///
+/// The extensions are matched regardless of case: `.ch8` and `.c8` are
+/// CHIP-8, `.sc8` is SUPER-CHIP and `.xo8` is XO-CHIP.
+///
+/// \param file_name The path to the ROM file.
+///
+/// \returns The variant, or nothing if the file isn't a ROM file.
+auto GetVariantFromExtension(const std::string& file_name) noexcept
+    -> std::optional<Variant>;
+}  // namespace chip8
@@ -0,0 +1,140 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "quirks.h"
+#include "spec.h"
+
+namespace chip8 {
+/// Defines how a particular guest program should be run.
+struct RomProfile {
+  /// The number of instructions to execute per second, or 0 to keep the
+  /// number the frontend configured through \ref VMInstance::SetTiming().
+  unsigned int instructions_per_second_ = 0;
+
+  /// The behavior the guest program expects, see \ref Quirks.
+  Quirks quirks_;
+
+  /// The flavor of CHIP-8 the guest program is written for.
+  Variant variant_ = Variant::kChip8;
+};
+
+/// A guest program known to the database.
+struct RomDatabaseEntry {
+  /// The hash of the program, see \ref analysis::HashProgram().
+  uint64_t hash_;
+
+  /// The name of the program, for whoever maintains the database.
+  const char* title_;
+
+  /// How the program should be run.
+  RomProfile profile_;
+};
+
+/// This class determines how guest programs should be run, so that the
+/// timing and quirks don't have to be configured by hand for every program.
+///
+/// Programs are identified by the hash of their contents, which is cheap
+/// enough to compute every time a program is loaded; file names are
+/// meaningless, as the same program is distributed under many of them.
+///
+/// Profiles come from a table of entries built into the database, and can be
+/// overridden per program, typically from the user's settings. Programs found
+/// in neither get the default \ref RomProfile.
+///
+/// This class is thread-safe.
+class RomDatabase {
+ public:
+  /// Retrieves the database shared by the whole program, whose entries are
+  /// the ones built into the core.
+  ///
+  /// \returns The shared instance of \p RomDatabase.
+  static auto Get() noexcept -> RomDatabase&;
+
+  /// Constructs a database.
+  ///
+  /// \param entries The entries built into the database, sorted by hash. The
+  /// entries are not copied, so they must outlive the database.
+  ///
+  /// \param num_entries The number of entries.
+  RomDatabase(const RomDatabaseEntry* entries, size_t num_entries) noexcept;
+
+  /// Searches the entries built into the database, ignoring any override.
+  ///
+  /// \param hash The hash of the program, see \ref analysis::HashProgram().
+  ///
+  /// \returns The built-in profile of the program, if any.
+  auto FindBuiltInProfile(uint64_t hash) const noexcept
+      -> std::optional<RomProfile>;
+
+  /// Searches the overrides, then the entries built into the database.
+  ///
+  /// \param hash The hash of the program, see \ref analysis::HashProgram().
+  ///
+  /// \returns The override of the program if there is one, otherwise its
+  /// built-in profile if there is one, otherwise nothing, meaning that the
+  /// database doesn't know the program.
+  auto Find(uint64_t hash) const noexcept -> std::optional<RomProfile>;
+
+  /// Determines how a program should be run.
+  ///
+  /// \param hash The hash of the program, see \ref analysis::HashProgram().
+  ///
+  /// \returns The override of the program if there is one, otherwise its
+  /// built-in profile if there is one, otherwise the default profile.
+  auto Lookup(uint64_t hash) const noexcept -> RomProfile;
+
+  /// \copydoc Lookup(uint64_t) const
+  ///
+  /// \param program The program data.
+  ///
+  /// \param program_size The size of the program, in bytes.
+  auto Lookup(const uint_fast8_t* program, size_t program_size) const noexcept
+      -> RomProfile;
+
+  /// Overrides how a program should be run, replacing any previous override.
+  ///
+  /// \param hash The hash of the program, see \ref analysis::HashProgram().
+  ///
+  /// \param profile How the program should be run.
+  void SetOverride(uint64_t hash, const RomProfile& profile) noexcept;
+
+  /// Removes the override of a program, if any.
+  ///
+  /// \param hash The hash of the program, see \ref analysis::HashProgram().
+  void ClearOverride(uint64_t hash) noexcept;
+
+  /// Removes every override.
+  void ClearOverrides() noexcept;
+
+ private:
+  /// The entries built into the database, sorted by hash.
+  const RomDatabaseEntry* entries_;
+
+  /// The number of entries built into the database.
+  size_t num_entries_;
+
+  /// Protects \ref overrides_.
+  mutable std::mutex mutex_;
+
+  /// The overridden profiles, indexed by hash.
+  std::unordered_map<uint64_t, RomProfile> overrides_;
+};
+}  // namespace chip8
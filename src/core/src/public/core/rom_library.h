@@ -0,0 +1,122 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "spec.h"
+
+namespace chip8 {
+/// A ROM file indexed by \ref RomLibrary.
+struct RomLibraryEntry {
+  /// The screen of the program, one bit per pixel, scaled down to 64x32 if it
+  /// is in the high resolution mode. Rows are stored from top to bottom, and
+  /// the most significant bit of each byte is the leftmost pixel.
+  using Thumbnail = std::array<uint8_t, framebuffer::kSize / CHAR_BIT>;
+
+  /// Determines whether or not a pixel of the thumbnail is on.
+  ///
+  /// \param x The column of the pixel.
+  /// \param y The row of the pixel.
+  ///
+  /// \returns true if the pixel is on, or false otherwise.
+  auto IsPixelOn(unsigned int x, unsigned int y) const noexcept -> bool;
+
+  /// The path to the ROM file.
+  std::string path_;
+
+  /// The time the ROM file was last modified, in the units of the file system
+  /// clock.
+  int64_t modified_time_;
+
+  /// The size of the program, in bytes.
+  uint64_t size_;
+
+  /// The hash of the program, see \ref analysis::HashProgram().
+  uint64_t hash_;
+
+  /// The screen after the program ran for \ref RomLibrary::kThumbnailFrames
+  /// frames, or until it stopped to wait for a key press.
+  Thumbnail thumbnail_;
+
+  /// The number of basic blocks found by static analysis, see \ref
+  /// analysis::ProgramAnalysis::blocks_.
+  uint32_t num_blocks_;
+
+  /// The number of subroutines found by static analysis, see \ref
+  /// analysis::ProgramAnalysis::subroutines_.
+  uint32_t num_subroutines_;
+
+  /// The number of indirect jumps found by static analysis, see \ref
+  /// analysis::ProgramAnalysis::indirect_jumps_.
+  uint32_t num_indirect_jumps_;
+
+  /// The number of bytes of the program that are reachable code.
+  uint32_t code_size_;
+};
+
+/// This class keeps an index of the ROM files found in a directory, so that
+/// a frontend can list them without reading every file.
+///
+/// Scanning is incremental: a ROM file is only read again if its size or
+/// modification time changed since it was last indexed. The index can be
+/// saved to and loaded from a compact cache file, which is specific to the
+/// machine that wrote it.
+class RomLibrary {
+ public:
+  /// The number of frames a program runs for to take its thumbnail.
+  static constexpr auto kThumbnailFrames = 60;
+
+  /// Defines the function prototype of the function that tells \ref Scan()
+  /// to stop early.
+  using CancelFunc = std::function<bool()>;
+
+  /// Brings the index up to date with the ROM files in a directory and its
+  /// subdirectories. Files with the `.c8` or `.ch8` extension that fit in the
+  /// program area are considered ROM files.
+  ///
+  /// \param directory The directory to scan.
+  ///
+  /// \param cancel_func If specified, called between files; if it returns
+  /// \p true, the scan stops and the index is left as it was.
+  ///
+  /// \returns The number of ROM files that were read, as opposed to taken from
+  /// the index.
+  auto Scan(const std::string& directory,
+            const CancelFunc& cancel_func = nullptr) noexcept -> size_t;
+
+  /// Saves the index to a cache file.
+  ///
+  /// \param file_name The cache file to write.
+  ///
+  /// \returns true if the cache file was written, or false otherwise.
+  auto Save(const std::string& file_name) const noexcept -> bool;
+
+  /// Replaces the index with the contents of a cache file.
+  ///
+  /// \param file_name The cache file to read.
+  ///
+  /// \returns true if the cache file was read, or false if it doesn't exist or
+  /// isn't a valid cache file, in which case the index is left empty.
+  auto Load(const std::string& file_name) noexcept -> bool;
+
+  /// The ROM files indexed, sorted by path.
+  std::vector<RomLibraryEntry> entries_;
+};
+}  // namespace chip8
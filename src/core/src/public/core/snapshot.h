@@ -0,0 +1,131 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "impl.h"
+#include "spec.h"
+#include "vm_instance.h"
+
+namespace chip8 {
+/// A copy of the state of the virtual machine that the debugger inspects,
+/// taken at a single point in time.
+struct StateSnapshot {
+  /// Copies the state of an implementation. An implementation has no
+  /// breakpoints, so \ref breakpoints_ is left empty.
+  ///
+  /// \param impl The implementation to copy the state of.
+  void Capture(const ImplementationInterface& impl) noexcept;
+
+  /// Copies the state of a virtual machine, along with its breakpoints.
+  ///
+  /// \param vm_instance The virtual machine to copy the state of.
+  void Capture(const VMInstance& vm_instance) noexcept;
+
+  /// See \ref ImplementationInterface::V_.
+  std::array<uint_fast8_t, data_size::kV> V_{};
+
+  /// See \ref ImplementationInterface::stack_.
+  std::array<uint_fast16_t, data_size::kStack> stack_{};
+
+  /// See \ref ImplementationInterface::GetMemory(). This is as large as the
+  /// memory of the implementation; it's only reallocated when a program of
+  /// another variant is loaded.
+  std::vector<uint_fast8_t> memory_;
+
+  /// See \ref ImplementationInterface::program_counter_.
+  size_t program_counter_ = 0;
+
+  /// See \ref ImplementationInterface::stack_pointer_.
+  ptrdiff_t stack_pointer_ = 0;
+
+  /// See \ref ImplementationInterface::delay_timer_.
+  uint_fast8_t delay_timer_ = 0;
+
+  /// See \ref ImplementationInterface::sound_timer_.
+  uint_fast8_t sound_timer_ = 0;
+
+  /// See \ref ImplementationInterface::I_.
+  unsigned int I_ = 0;
+
+  /// The addresses of the breakpoints of \ref VMInstance::breakpoints_, in
+  /// the same order.
+  std::vector<VMInstance::ProgramCounter> breakpoints_;
+
+  /// Determines whether or not there is a breakpoint at an address.
+  ///
+  /// \param address The address to check.
+  ///
+  /// \returns \p true if there is a breakpoint at the address, or \p false
+  /// otherwise.
+  auto HasBreakpoint(size_t address) const noexcept -> bool;
+};
+
+/// This class hands consistent snapshots of the virtual machine from exactly
+/// one producer to exactly one consumer, without locking.
+///
+/// The thread running the virtual machine publishes a snapshot at frame
+/// boundaries, and a debugger on another thread picks up the most recent one
+/// whenever it likes. Three snapshots are kept: one being written, one being
+/// read, and the most recently published one in between, so that neither
+/// thread ever waits for or tears the data of the other. Snapshots published
+/// faster than they're picked up are simply overwritten.
+class SnapshotBuffer {
+ public:
+  /// Copies the state of an implementation and makes it the most recent
+  /// snapshot. This must only be called by the producer.
+  ///
+  /// \param impl The implementation to copy the state of.
+  void Publish(const ImplementationInterface& impl) noexcept;
+
+  /// Copies the state of a virtual machine, along with its breakpoints, and
+  /// makes it the most recent snapshot. This must only be called by the
+  /// producer.
+  ///
+  /// \param vm_instance The virtual machine to copy the state of.
+  void Publish(const VMInstance& vm_instance) noexcept;
+
+  /// Picks up the most recent snapshot. This must only be called by the
+  /// consumer.
+  ///
+  /// \returns The most recent snapshot, which stays untouched until the next
+  /// call, or \p nullptr if no snapshot has been published since the last
+  /// call.
+  auto Acquire() noexcept -> const StateSnapshot*;
+
+ private:
+  /// Set in \ref shared_ when the snapshot it refers to hasn't been picked up
+  /// yet.
+  static constexpr uint_fast8_t kNewSnapshot = 0x80;
+
+  /// Makes the snapshot just written the most recent one.
+  void HandOver() noexcept;
+
+  /// The snapshots being written, read, and handed over.
+  std::array<StateSnapshot, 3> snapshots_;
+
+  /// The index of the snapshot handed over, along with \ref kNewSnapshot.
+  std::atomic<uint_fast8_t> shared_ = 0;
+
+  /// The index of the snapshot being written. Only the producer touches this.
+  uint_fast8_t write_index_ = 1;
+
+  /// The index of the snapshot being read. Only the consumer touches this.
+  uint_fast8_t read_index_ = 2;
+};
+}  // namespace chip8
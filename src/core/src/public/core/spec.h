@@ -189,6 +189,13 @@ enum KeyState : bool { kPressed = true, kReleased = false };
 namespace pixel {
 constexpr auto kWhite = 0xFFFFFF;
 constexpr auto kBlack = 0x000000;
+constexpr auto kLightGray = 0xAAAAAA;
+constexpr auto kDarkGray = 0x555555;
+
+/// The color of each value of a pixel, see \ref BasicFramebuffer::GetPixel().
+/// Pixels set in the first plane only are white, so that programs drawing to
+/// a single plane look the same as on a monochrome screen.
+inline constexpr std::array kPalette = {kBlack, kWhite, kLightGray, kDarkGray};
 }  // namespace pixel
 
 namespace instruction_groups {
@@ -213,12 +220,30 @@ constexpr auto kRND = 0xC;
 constexpr auto kDRW = 0xD;
 }  // namespace ungrouped_instructions
 
-/// There are no additional operands for these instructions.
+/// There are no additional operands for these instructions, except for \p
+/// SCD and \p SCU whose lowest 4 bits are the number of rows to scroll. Every
+/// instruction but \p CLS and \p RET is a SUPER-CHIP extension, except for
+/// \p SCU which is an XO-CHIP one.
 namespace control_flow_and_screen_instructions {
+constexpr uint_fast8_t kSCD = 0xC0;
+constexpr uint_fast8_t kSCU = 0xD0;
 constexpr uint_fast8_t kCLS = 0xE0;
 constexpr uint_fast8_t kRET = 0xEE;
+constexpr uint_fast8_t kSCR = 0xFB;
+constexpr uint_fast8_t kSCL = 0xFC;
+constexpr uint_fast8_t kEXIT = 0xFD;
+constexpr uint_fast8_t kLOW = 0xFE;
+constexpr uint_fast8_t kHIGH = 0xFF;
 }  // namespace control_flow_and_screen_instructions
 
+/// XO-CHIP tells these instructions apart from `SE Vx, Vy` by their lowest 4
+/// bits. They access the registers from \p Vx through \p Vy, in that order,
+/// at the address in \p I without changing it.
+namespace register_range_instructions {
+constexpr auto kLD_I_Vx_Vy = 0x2;
+constexpr auto kLD_Vx_Vy_I = 0x3;
+}  // namespace register_range_instructions
+
 /// The operands for these instructions are assumed to be `Vx, Vy`. If an
 /// operand is specified, the one NOT specified is not used in the instruction.
 namespace math_instructions {
@@ -239,16 +264,27 @@ constexpr uint_fast8_t kSKP = 0x9E;
 constexpr uint_fast8_t kSKNP = 0xA1;
 }  // namespace keyboard_control_flow_instructions
 
+/// \p LD_I_Long, \p PLANE, \p LD_AUDIO_I and \p LD_PITCH_Vx are XO-CHIP
+/// extensions. \p LD_I_Long is followed by a word holding the address to load
+/// into \p I, and \p PLANE takes the mask of the planes to select in place of
+/// \p x.
 namespace timer_and_memory_control_instructions {
+constexpr uint_fast8_t kLD_I_Long = 0x00;
+constexpr uint_fast8_t kPLANE = 0x01;
+constexpr uint_fast8_t kLD_AUDIO_I = 0x02;
 constexpr uint_fast8_t kLD_Vx_DT = 0x07;
 constexpr uint_fast8_t kLD_Vx_K = 0x0A;
 constexpr uint_fast8_t kLD_DT_Vx = 0x15;
 constexpr uint_fast8_t kLD_ST_Vx = 0x18;
 constexpr uint_fast8_t kADD_I_Vx = 0x1E;
 constexpr uint_fast8_t kLD_F_Vx = 0x29;
+constexpr uint_fast8_t kLD_HF_Vx = 0x30;
 constexpr uint_fast8_t kLD_B_Vx = 0x33;
+constexpr uint_fast8_t kLD_PITCH_Vx = 0x3A;
 constexpr uint_fast8_t kLD_I_Vx = 0x55;
 constexpr uint_fast8_t kLD_Vx_I = 0x65;
+constexpr uint_fast8_t kLD_R_Vx = 0x75;
+constexpr uint_fast8_t kLD_Vx_R = 0x85;
 }  // namespace timer_and_memory_control_instructions
 
 /// Defines the sizes of various CHIP-8 data types.
@@ -256,9 +292,19 @@ namespace data_size {
 constexpr auto kV = 16;
 constexpr auto kStack = 16;
 constexpr auto kInternalMemory = 4096;
+constexpr auto kXoChipInternalMemory = 65536;
 constexpr auto kInstructionLength = 2;
+constexpr auto kLongInstructionLength = 4;
 constexpr auto kKeypad = 16;
 constexpr auto kFontLength = 5;
+constexpr auto kBigFontLength = 10;
+constexpr auto kRplFlags = 8;
+constexpr auto kXoChipRplFlags = 16;
+constexpr auto kAudioPattern = 16;
+
+/// The granularity at which writes to internal memory are tracked, see \ref
+/// ImplementationInterface::MarkMemoryDirty().
+constexpr auto kMemoryPage = 64;
 }  // namespace data_size
 
 /// Defines the limits of various CHIP-8 types.
@@ -267,6 +313,9 @@ namespace data_limits {
 constexpr auto kProgramCounter =
     data_size::kInternalMemory - data_size::kInstructionLength;
 
+/// The largest value of the \p I register, which is 16 bits wide.
+constexpr auto kIndexRegister = 0xFFFFU;
+
 /// The minimum random number to generate.
 constexpr auto kMinRandomValue = 0;
 
@@ -276,8 +325,23 @@ constexpr auto kMaxRandomValue = 255;
 
 /// Defines the various regions of internal memory.
 namespace memory_region {
+/// The start of the font set, see \ref initial_values::kFontSet.
+constexpr auto kFont = 0x000;
+
+/// The start of the SUPER-CHIP font set, right after the regular one, see
+/// \ref initial_values::kBigFontSet.
+constexpr auto kBigFont = 0x050;
+
 /// The start of the program area.
 constexpr auto kProgramArea = 0x200;
+
+/// The size of the program area, which is the largest a program can be.
+constexpr size_t kProgramAreaSize = data_size::kInternalMemory - kProgramArea;
+
+/// The size of the program area of XO-CHIP, which is the largest a program of
+/// any variant can be.
+constexpr size_t kXoChipProgramAreaSize =
+    data_size::kXoChipInternalMemory - kProgramArea;
 }  // namespace memory_region
 
 /// Defines timing information. The information here is used to initialize the
@@ -290,11 +354,18 @@ constexpr auto kDefaultInstructionsPerSecond = 500;
 constexpr auto kDefaultFrameRate = 60.0;
 }  // namespace timing
 
-/// Defines the dimensions of the framebuffer.
+/// Defines the dimensions of the framebuffer. SUPER-CHIP programs may switch
+/// to a high resolution mode, which doubles both dimensions, and XO-CHIP
+/// programs draw to up to 2 bitplanes.
 namespace framebuffer {
 constexpr auto kWidth = 64;
 constexpr auto kHeight = 32;
 constexpr auto kSize = kWidth * kHeight;
+
+constexpr auto kHighResolutionWidth = kWidth * 2;
+constexpr auto kHighResolutionHeight = kHeight * 2;
+
+constexpr auto kMaxPlanes = 2U;
 }  // namespace framebuffer
 
 /// Defines the initial values of virtual machine registers.
@@ -309,11 +380,13 @@ constexpr auto kKeypad = KeyState::kReleased;
 constexpr auto kKeyPressHaltState = false;
 constexpr auto kInternalMemory = 0x00;
 constexpr auto kV = 0x00;
+constexpr auto kPlanes = 0x1;
+constexpr auto kPitch = 64;
 
 /// This font set can be used by guest programs to display predefined
 /// hexadecimal sprites, ranging from 0 to F. It should be copied to the
 /// beginning of an implementation's internal memory following a reset.
-constexpr std::array kFontSet = {
+inline constexpr std::array kFontSet = {
     0xF0, 0x90, 0x90, 0x90, 0xF0,  // 0
     0x20, 0x60, 0x20, 0x20, 0x70,  // 1
     0xF0, 0x10, 0xF0, 0x80, 0xF0,  // 2
@@ -331,8 +404,44 @@ constexpr std::array kFontSet = {
     0xF0, 0x80, 0xF0, 0x80, 0xF0,  // E
     0xF0, 0x80, 0xF0, 0x80, 0x80   // F
 };
+
+/// SUPER-CHIP programs can also use this font set, whose sprites are twice as
+/// tall. It should be copied to \ref memory_region::kBigFont following a
+/// reset.
+inline constexpr std::array kBigFontSet = {
+    0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C,  // 0
+    0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C,  // 1
+    0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF,  // 2
+    0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C,  // 3
+    0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06,  // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C,  // 5
+    0x3E, 0x7C, 0xE0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C,  // 6
+    0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60,  // 7
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C,  // 8
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C,  // 9
+    0x3C, 0x7E, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3,  // A
+    0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC,  // B
+    0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C,  // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,  // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xFF, 0xFF,  // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0   // F
+};
 }  // namespace initial_values
 
+/// Defines the flavors of CHIP-8 a guest program may be written for.
+enum class Variant {
+  /// The original CHIP-8.
+  kChip8,
+
+  /// SUPER-CHIP 1.1, which adds a 128x64 high resolution mode, scrolling,
+  /// 16x16 sprites, a bigger font and the \p EXIT instruction.
+  kSuperChip,
+
+  /// XO-CHIP, which builds on SUPER-CHIP with 64KB of memory, 2 bitplanes,
+  /// long loads of \p I and an audio pattern.
+  kXoChip
+};
+
 /// Defines the results of execution steps.
 enum class StepResult {
   /// No error occurred.
@@ -364,6 +473,9 @@ enum class StepResult {
   kNotInSubroutine,
 
   /// A breakpoint was reached during execution.
-  kBreakpointReached
+  kBreakpointReached,
+
+  /// The guest program executed the SUPER-CHIP \p EXIT instruction.
+  kExited
 };
 }  // namespace chip8
@@ -12,14 +12,18 @@
 
 #pragma once
 
+#include <array>
 #include <fstream>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <vector>
 
+#include "analysis.h"
 #include "impl.h"
+#include "input_queue.h"
 #include "logger.h"
+#include "rom_database.h"
 
 namespace chip8 {
 /// This class represents the entire virtual machine. This is the only class
@@ -46,10 +50,52 @@ class VMInstance {
   /// Alias to enhance readability of \ref FindBreakpoint().
   using BreakpointsIterator = std::vector<BreakpointInfo>::iterator;
 
+  /// Defines what \ref RunForOneFrame() does while the guest program is
+  /// waiting for a key press.
+  enum class KeyWaitMode {
+    // Return \ref chip8::StepResult::kHaltUntilKeyPress right away; the
+    // frontend is expected to stop running frames until a key is pressed.
+    kStopExecution,
+
+    // Keep going until the end of the frame without executing instructions.
+    // The timers keep ticking and the screen keeps being updated, as they
+    // would on real hardware.
+    kIdle
+  };
+
+  /// Creates the implementation that programs of a variant are run on, see
+  /// \ref SetImplementationFactory().
+  using ImplementationFactory =
+      std::function<std::unique_ptr<ImplementationInterface>(Variant)>;
+
   /// Configures the virtual machine to execute 500 instructions per second
   /// (500Hz) within 60 frames.
   VMInstance() noexcept;
 
+  /// Creates the interpreter, which is the reference every other
+  /// implementation is checked against.
+  ///
+  /// \param variant The variant of the programs to be run. XO-CHIP programs
+  /// get 64 KB of memory and two bitplanes; every other program gets the
+  /// classic 4 KB and a single plane.
+  ///
+  /// \returns The new interpreter.
+  static auto MakeInterpreter(Variant variant) noexcept
+      -> std::unique_ptr<ImplementationInterface>;
+
+  /// Changes how \ref LoadProgram() creates implementations.
+  ///
+  /// By default, the interpreter is used and only replaced when a program
+  /// needs a different amount of memory. With a factory set, every program
+  /// loaded gets a fresh implementation from it, so that alternative
+  /// implementations can be run and checked against the interpreter, see
+  /// \ref RunLockstep().
+  ///
+  /// \param factory The function creating implementations, or \p nullptr to
+  /// go back to the interpreter. It must return an implementation with at
+  /// least as much memory as \ref MakeInterpreter() would.
+  void SetImplementationFactory(ImplementationFactory factory) noexcept;
+
   /// Enables tracing to a file.
   ///
   /// Tracing logs the execution of the program to a file.
@@ -77,6 +123,12 @@ class VMInstance {
   /// \returns The target number of frames per second.
   auto GetTargetFrameRate() const noexcept -> unsigned int;
 
+  /// Retrieves the exact number of frames per second, which unlike \ref
+  /// GetTargetFrameRate() may have a fractional part.
+  ///
+  /// \returns The exact number of frames per second.
+  auto GetFrameRate() const noexcept -> double;
+
   /// Retrieves the maximum frame time in milliseconds as determined by the last
   /// call to \ref SetTiming().
   ///
@@ -84,6 +136,65 @@ class VMInstance {
   /// call to \ref SetTiming().
   auto GetMaxFrameTime() const noexcept -> double;
 
+  /// Retrieves the total number of steps executed since the last call to \ref
+  /// Reset(). This includes the idle steps taken while waiting for a key press,
+  /// see \ref SetKeyWaitMode().
+  ///
+  /// \returns The total number of steps executed.
+  auto GetNumberOfStepsExecuted() const noexcept -> uintmax_t;
+
+  /// Determines whether or not the beeper is sounding; this is the case as
+  /// long as the sound timer is non-zero.
+  ///
+  /// \returns true if the beeper is sounding, or false otherwise.
+  auto IsBeeperOn() const noexcept -> bool;
+
+  /// Retrieves how the program that was last loaded is being run, as
+  /// determined by \ref RomDatabase.
+  ///
+  /// \returns The profile of the program.
+  auto GetRomProfile() const noexcept -> const RomProfile&;
+
+  /// Changes the variant of the programs unknown to \ref RomDatabase that are
+  /// loaded from now on. Programs the database knows keep their own variant.
+  ///
+  /// The program that is already loaded is unaffected, until it is loaded
+  /// again.
+  ///
+  /// \param variant The variant, typically picked by the user or guessed
+  /// from the extension of the ROM file, see \ref GetVariantFromExtension().
+  void SetDefaultVariant(Variant variant) noexcept;
+
+  /// Retrieves the variant of the programs unknown to \ref RomDatabase, see
+  /// \ref SetDefaultVariant().
+  ///
+  /// \returns The variant, \ref Variant::kChip8 by default.
+  auto GetDefaultVariant() const noexcept -> Variant;
+
+  /// Computes a 64-bit hash of the whole state of the virtual machine: the
+  /// internal memory, the registers, the stack, the timers and the screen.
+  /// Virtual machines in the same state have the same hash, whatever their
+  /// implementation, so the hash can stand in for the state when checking
+  /// replays or comparing implementations.
+  ///
+  /// Memory is hashed in pages of \ref data_size::kMemoryPage bytes, and only
+  /// the pages written to since the last call are hashed again, see \ref
+  /// ImplementationInterface::MarkMemoryDirty(). Hashing every frame costs
+  /// little more than hashing the registers and the screen.
+  ///
+  /// \returns The hash of the state.
+  auto GetStateHash() noexcept -> uint64_t;
+
+  /// Retrieves the control flow of the program that was last loaded, as it is
+  /// currently in memory.
+  ///
+  /// The analysis is cached by \ref analysis::AnalysisCache, so this is cheap
+  /// to call repeatedly as long as the program doesn't modify itself.
+  ///
+  /// \returns The analysis of the program.
+  auto GetProgramAnalysis() const noexcept
+      -> std::shared_ptr<const analysis::ProgramAnalysis>;
+
   /// Checks to see if a breakpoint exists.
   ///
   /// \param address The address to search for.
@@ -103,7 +214,9 @@ class VMInstance {
   /// Adjusts the number of steps per frame, with respect to a desired frame
   /// rate and number of instructions per second.
   ///
-  /// This method can be called at any time.
+  /// This method can be called at any time. The number of instructions per
+  /// second also becomes the one used for programs whose \ref RomProfile
+  /// doesn't specify one.
   ///
   /// \param instructions_per_second The total number of instructions to execute
   /// within a specified number of desired frames.
@@ -118,7 +231,8 @@ class VMInstance {
   /// Adjust the number of instructions per second, with respect to the current
   /// frame rate.
   ///
-  /// This method can be called at any time.
+  /// This method can be called at any time. Like \ref SetTiming(), it also
+  /// changes the number used for programs that don't specify one.
   ///
   /// \param instructions_per_second The total number of instructions to execute
   /// within the current number of desired frames.
@@ -147,40 +261,68 @@ class VMInstance {
   /// calling this method. If this method is not successful, the state of the
   /// virtual machine will be unchanged.
   ///
-  /// \param program_data A container containing program data. This container
-  /// MUST hold elements of the `uint_fast8_t` type.
+  /// The program is copied straight into internal memory, so callers can pass
+  /// a view of data they already hold, see \ref Rom.
+  ///
+  /// \param program The program data.
+  ///
+  /// \param program_size The size of the program, in bytes.
   ///
   /// \returns true if the program data was successfully loaded, or false if the
-  /// program data is larger than the CHIP-8 program area.
+  /// program data is larger than the program area of its variant.
+  ///
+  /// The program is looked up in \ref RomDatabase, and its variant, quirks
+  /// and number of instructions per second are applied, see \ref
+  /// GetRomProfile(). Programs the database doesn't know get the default
+  /// profile, with the variant set by \ref SetDefaultVariant(). XO-CHIP programs get an implementation with 64 KB of
+  /// memory and two bitplanes; every other program gets the classic 4 KB,
+  /// single plane one, so \ref impl_ may be a different object afterwards.
+  /// See \ref SetImplementationFactory() for running programs on another
+  /// implementation.
+  auto LoadProgram(const uint_fast8_t* program, size_t program_size) noexcept
+      -> bool;
+
+  /// \copydoc LoadProgram(const uint_fast8_t*, size_t)
+  ///
+  /// \param program_data A container containing program data. This container
+  /// MUST hold elements of the `uint_fast8_t` type.
   template <typename Container,
             typename = std::enable_if_t<
                 std::is_same_v<typename Container::value_type, uint_fast8_t>>>
   auto LoadProgram(const Container& program_data) noexcept -> bool {
-    auto logger = Logger::Get();
-
-    constexpr auto kMaxProgramSize =
-        chip8::data_size::kInternalMemory - chip8::memory_region::kProgramArea;
-
-    if (program_data.size() > kMaxProgramSize) {
-      logger.Emit(Logger::LogLevel::kError,
-                  "Could not load the requested program as it is too "
-                  "large to fit ({} > {})",
-                  program_data.size(), kMaxProgramSize);
-      return false;
-    }
-
-    Reset();
-    std::copy(program_data.cbegin(), program_data.cend(),
-              impl_->memory_.begin() + chip8::memory_region::kProgramArea);
-
-    logger.Emit(Logger::LogLevel::kDebug,
-                "Loaded a program of size {} into internal memory",
-                program_data.size());
-    return true;
+    return LoadProgram(program_data.data(), program_data.size());
   }
 
+  /// Changes what \ref RunForOneFrame() does while the guest program is
+  /// waiting for a key press.
+  ///
+  /// This method can be called at any time.
+  ///
+  /// \param key_wait_mode The new key wait mode, refer to \ref KeyWaitMode for
+  /// details.
+  void SetKeyWaitMode(KeyWaitMode key_wait_mode) noexcept;
+
+  /// Retrieves what \ref RunForOneFrame() does while the guest program is
+  /// waiting for a key press.
+  ///
+  /// \returns The current key wait mode.
+  auto GetKeyWaitMode() const noexcept -> KeyWaitMode;
+
   /// Executes the number of steps necessary to count as a full frame, based on
-  /// the current timing configuration.
+  /// the current timing configuration, and updates the screen at the end of
+  /// it.
+  ///
+  /// The number of instructions per second need not be a multiple of the
+  /// frame rate; the fraction of a step left over at the end of a frame is
+  /// carried over to the next one, so that the number of instructions
+  /// executed per second is exact over time.
+  ///
+  /// If the key wait mode is \ref KeyWaitMode::kIdle, steps taken while the
+  /// guest program is waiting for a key press are idle steps: they don't
+  /// execute instructions, trace, or check breakpoints, but they do count
+  /// towards the timers and screen updates. Waiting for a key press is then
+  /// not reported as \ref chip8::StepResult::kHaltUntilKeyPress; frontends
+  /// can check \ref ImplementationInterface::IsHaltedUntilKeyPress() instead.
   ///
   /// \returns The result of the execution, refer to \ref chip8::StepResult for
   /// more details.
@@ -192,6 +334,32 @@ class VMInstance {
   /// operation; refer to \ref chip8::StepResult for details.
   auto Step() noexcept -> chip8::StepResult;
 
+  /// Queues a change in the state of a key, to be applied before the next
+  /// instruction is executed.
+  ///
+  /// This is the only method that may be called from a thread other than the
+  /// one running the virtual machine, as long as only one such thread calls
+  /// it. The keypad itself is only ever modified by the thread running the
+  /// virtual machine, so guest programs never observe a key changing state in
+  /// the middle of an instruction.
+  ///
+  /// \param key The key whose state changed.
+  /// \param state The new state of the key.
+  /// \param timestamp The point in time at which the host reported the change,
+  /// used to measure input latency.
+  ///
+  /// \returns \p true if the change was queued, or \p false if too many
+  /// changes are pending and it was dropped.
+  auto QueueKeyState(Key key, KeyState state,
+                     InputEvent::Clock::time_point timestamp =
+                         InputEvent::Clock::now()) noexcept -> bool;
+
+  /// Applies every key state change queued by \ref QueueKeyState().
+  ///
+  /// This is done automatically before every instruction; frontends only need
+  /// to call this method to apply input between frames.
+  void ApplyQueuedInput() noexcept;
+
   /// Adds a breakpoint corresponding to the address of the first non CALL
   /// instruction in the current scope.
   auto PrepareForStepOver() noexcept -> void;
@@ -212,24 +380,45 @@ class VMInstance {
   /// This is the function that will be called when it is time to update the
   /// screen. This may be safely set to `nullptr` if for some reason you don't
   /// care about graphics.
-  std::function<void(const ImplementationInterface::Framebuffer&)>
-      update_screen_func_;
-
-  /// This is the function that will be called when it is time to play a tone.
+  std::function<void(const Screen&)> update_screen_func_;
+
+  /// This is the function that will be called when the beeper is switched on
+  /// or off. The beeper is switched on as soon as an instruction sets the sound
+  /// timer, and switched off on the timer tick that brings it back to zero (or
+  /// as soon as an instruction clears it). This may be safely set to `nullptr`
+  /// if for some reason you don't care about sound.
+  std::function<void(const bool)> beeper_func_;
+
+  /// This is the function that will be called when a key state change queued
+  /// by \ref QueueKeyState() has been applied, with the time elapsed since the
+  /// host reported it. This may be safely set to `nullptr` if for some reason
+  /// you don't care about input latency.
+  std::function<void(std::chrono::nanoseconds)> input_latency_func_;
+
+  /// This is the function that will be called when a key state change queued
+  /// by \ref QueueKeyState() has been observed by the guest program, and the
+  /// first frame the guest program drew to afterwards has been sent to \ref
+  /// update_screen_func_. Changes that are never observed are not reported.
   /// This may be safely set to `nullptr` if for some reason you don't care
-  /// about sound.
-  std::function<void(const double)> play_tone_func_;
+  /// about input latency; nothing is traced in that case.
+  std::function<void(const InputTrace&)> input_trace_func_;
 
   // Defines a list of breakpoints.
   std::vector<BreakpointInfo> breakpoints_;
 
  private:
-  /// Calculates the duration a tone should be.
+  /// Does the work of \ref SetTiming(), without changing the number of
+  /// instructions per second used for programs that don't specify one.
   ///
-  /// The duration calculated is based on the current sound timer value.
+  /// \param instructions_per_second The total number of instructions to execute
+  /// within a specified number of desired frames.
   ///
-  /// \returns The duration of a tone in milliseconds.
-  auto CalculateDurationOfTone() const noexcept -> double;
+  /// \param desired_frame_rate The desired frame rate target.
+  ///
+  /// \returns true if the timing was changed successfully, or false if not due
+  /// to bad parameters.
+  auto ApplyTiming(unsigned int instructions_per_second,
+                   double desired_frame_rate) noexcept -> bool;
 
   /// Checks to see if the timers have to be decremented.
   void CheckTimers() noexcept;
@@ -238,14 +427,70 @@ class VMInstance {
   /// as 8 machine steps).
   void DecrementTimers() noexcept;
 
-  /// The number of steps that constitute one frame. The value of this variable
-  /// is determined by the call to the \ref SetTiming() method.
+  /// Calls the beeper function if the beeper has been switched on or off since
+  /// the last time this method was called.
+  void UpdateBeeper() noexcept;
+
+  /// Takes a step without executing an instruction, while waiting for a key
+  /// press. The timers and screen are updated as if an instruction had been
+  /// executed.
+  void IdleStep() noexcept;
+
+  /// Updates the screen if enough steps have been executed to make up a frame.
+  void CheckScreenUpdate() noexcept;
+
+  /// Starts tracing a key state change that has just been applied.
+  ///
+  /// \param event The key state change.
+  /// \param applied The point in time at which it was applied.
+  /// \param observed Whether or not applying the change woke the guest
+  /// program up from waiting for a key press.
+  void StartInputTrace(const InputEvent& event,
+                       InputEvent::Clock::time_point applied,
+                       bool observed) noexcept;
+
+  /// Advances the traced key state changes past the instruction about to be
+  /// executed: an instruction checking a traced key observes it, and an
+  /// instruction drawing to the screen after that marks the frame.
+  ///
+  /// \param instruction The instruction about to be executed.
+  void TraceInstruction(const Instruction& instruction) noexcept;
+
+  /// Reports every observed key state change, now that a frame the guest
+  /// program drew to has been sent to the screen.
+  void FinishInputTraces() noexcept;
+
+  /// Stops tracing every key state change.
+  void ClearInputTraces() noexcept;
+
+  /// The number of whole steps that constitute one frame. The value of this
+  /// variable is determined by the call to the \ref SetTiming() method.
   unsigned int number_of_steps_per_frame_;
 
+  /// The exact number of steps that constitute one frame, which may have a
+  /// fractional part. The value of this variable is determined by the call to
+  /// the \ref SetTiming() method.
+  double exact_steps_per_frame_;
+
+  /// The fraction of a step left over from the previous frame.
+  double step_remainder_ = 0.0;
+
+  /// The number of steps left until the screen is updated.
+  unsigned int steps_until_screen_update_ = 0;
+
+  /// The screen passed to \ref update_screen_func_, copied from the
+  /// implementation at the end of every frame.
+  Screen screen_;
+
   /// The current number of instructions to execute per second as set by the
   /// last call to \ref SetTiming().
   unsigned int instructions_per_sec_;
 
+  /// The number of instructions to execute per second as set by the last call
+  /// to \ref SetTiming() or \ref SetInstructionsPerSecond(), used for
+  /// programs whose \ref RomProfile doesn't specify one.
+  unsigned int default_instructions_per_sec_;
+
   /// The target frame rate as passed by the last call to the \ref SetTiming()
   /// method.
   unsigned int target_frame_rate_;
@@ -254,10 +499,32 @@ class VMInstance {
   /// method.
   uintmax_t number_of_steps_executed_;
 
-  /// If this is set to true, we're currently playing a tone and don't need to
-  /// call the play tone callback. We need to do this, so we can decrement the
-  /// sound timer normally.
-  bool is_playing_tone_;
+  /// The hash of every page of the internal memory, see \ref GetStateHash().
+  std::vector<uint64_t> page_hashes_;
+
+  /// The sum of \ref page_hashes_.
+  uint64_t memory_hash_ = 0;
+
+  /// The implementation \ref page_hashes_ belong to. Any other one has all
+  /// of its pages hashed.
+  const ImplementationInterface* hashed_impl_ = nullptr;
+
+  /// Creates implementations for \ref LoadProgram(), see \ref
+  /// SetImplementationFactory().
+  ImplementationFactory impl_factory_;
+
+  /// The size of the program that was last loaded by \ref LoadProgram().
+  size_t program_size_ = 0;
+
+  /// The profile of the program that was last loaded by \ref LoadProgram().
+  RomProfile rom_profile_;
+
+  /// The variant of programs unknown to \ref RomDatabase, see \ref
+  /// SetDefaultVariant().
+  Variant default_variant_ = Variant::kChip8;
+
+  /// The beeper state last reported to the beeper function.
+  bool beeper_on_;
 
   /// The maximum frame time as determined by the last call to the \ref
   /// SetTiming() method.
@@ -266,6 +533,39 @@ class VMInstance {
   /// The current frame rate as set by the last call to \ref SetTiming().
   double frame_rate_;
 
+  /// What to do while waiting for a key press, see \ref SetKeyWaitMode().
+  KeyWaitMode key_wait_mode_ = KeyWaitMode::kStopExecution;
+
+  /// The key state changes that have yet to be applied, see \ref
+  /// QueueKeyState().
+  InputQueue input_queue_;
+
+  /// A key state change being traced, see \ref input_trace_func_.
+  struct PendingInputTrace {
+    /// The trace so far.
+    InputTrace trace_;
+
+    /// Whether or not this key state change is being traced.
+    bool active_ = false;
+
+    /// Whether or not the guest program has observed the change.
+    bool observed_ = false;
+  };
+
+  /// The traced key state changes, indexed by key. Only the latest change of
+  /// each key is traced.
+  std::array<PendingInputTrace, data_size::kKeypad> input_traces_{};
+
+  /// The number of key state changes being traced.
+  unsigned int num_active_input_traces_ = 0;
+
+  /// The number of traced key state changes the guest program has observed.
+  unsigned int num_observed_input_traces_ = 0;
+
+  /// Whether or not the guest program has drawn to the screen since it
+  /// observed a traced key state change.
+  bool input_trace_frame_drawn_ = false;
+
   struct {
     std::ofstream file_handle_;
     std::string file_name_;
@@ -0,0 +1,193 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by kaichiuchu <kaichiuchu@protonmail.com>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include <core/analysis.h>
+
+#include <array>
+
+#include "gtest/gtest.h"
+
+namespace {
+using chip8::analysis::BlockExit;
+using Successors = std::vector<uint_fast16_t>;
+
+TEST(Analysis, SplitsBlocksAtBranchesAndTheirTargets) {
+  // $200: LD V0, $05
+  // $202: SE V0, $05
+  // $204: JP $208
+  // $206: CLS
+  // $208: JP $208
+  constexpr std::array<uint_fast8_t, 10> program_data{
+      0x60, 0x05, 0x30, 0x05, 0x12, 0x08, 0x00, 0xE0, 0x12, 0x08};
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(program_data);
+  ASSERT_EQ(analysis.blocks_.size(), 4);
+
+  const auto& skip_block = analysis.blocks_[0];
+  ASSERT_EQ(skip_block.start_, 0x200);
+  ASSERT_EQ(skip_block.end_, 0x204);
+  ASSERT_EQ(skip_block.exit_, BlockExit::kSkip);
+  ASSERT_EQ(skip_block.successors_, (Successors{0x204, 0x206}));
+
+  const auto& jump_block = analysis.blocks_[1];
+  ASSERT_EQ(jump_block.start_, 0x204);
+  ASSERT_EQ(jump_block.exit_, BlockExit::kJump);
+  ASSERT_EQ(jump_block.successors_, Successors{0x208});
+
+  // The instruction that may be skipped runs into the target of the jump.
+  const auto& skipped_block = analysis.blocks_[2];
+  ASSERT_EQ(skipped_block.start_, 0x206);
+  ASSERT_EQ(skipped_block.exit_, BlockExit::kFallThrough);
+  ASSERT_EQ(skipped_block.successors_, Successors{0x208});
+
+  const auto& loop_block = analysis.blocks_[3];
+  ASSERT_EQ(loop_block.start_, 0x208);
+  ASSERT_EQ(loop_block.end_, 0x20A);
+  ASSERT_EQ(loop_block.successors_, Successors{0x208});
+
+  ASSERT_EQ(analysis.FindBlock(0x202), &skip_block);
+  ASSERT_EQ(analysis.FindBlock(0x209), &loop_block);
+  ASSERT_EQ(analysis.FindBlock(0x20A), nullptr);
+}
+
+TEST(Analysis, BuildsCallGraph) {
+  // $200: CALL $206
+  // $202: CALL $20A
+  // $204: JP $204
+  // $206: CALL $20A
+  // $208: RET
+  // $20A: RET
+  constexpr std::array<uint_fast8_t, 12> program_data{
+      0x22, 0x06, 0x22, 0x0A, 0x12, 0x04, 0x22, 0x0A, 0x00, 0xEE, 0x00, 0xEE};
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(program_data);
+
+  ASSERT_EQ(analysis.subroutines_, (Successors{0x200, 0x206, 0x20A}));
+  ASSERT_EQ(analysis.calls_.size(), 3);
+
+  const std::array<std::array<uint_fast16_t, 3>, 3> expected_calls{
+      {{0x200, 0x200, 0x206}, {0x200, 0x202, 0x20A}, {0x206, 0x206, 0x20A}}};
+
+  for (size_t index = 0; index < expected_calls.size(); ++index) {
+    const auto& call = analysis.calls_[index];
+    const auto& [caller, address, callee] = expected_calls[index];
+
+    ASSERT_EQ(call.caller_, caller);
+    ASSERT_EQ(call.address_, address);
+    ASSERT_EQ(call.callee_, callee);
+  }
+
+  // Calls continue at the next instruction once the subroutine returns.
+  const auto* call_block = analysis.FindBlock(0x206);
+  ASSERT_NE(call_block, nullptr);
+  ASSERT_EQ(call_block->exit_, BlockExit::kCall);
+  ASSERT_EQ(call_block->successors_, Successors{0x208});
+  ASSERT_EQ(analysis.FindBlock(0x208)->exit_, BlockExit::kReturn);
+}
+
+TEST(Analysis, SeparatesCodeFromData) {
+  // $200: LD I, $206
+  // $202: DRW V0, V1, 5
+  // $204: JP V0, $20A
+  // $206: 5 bytes of sprite data
+  constexpr std::array<uint_fast8_t, 11> program_data{
+      0xA2, 0x06, 0xD0, 0x15, 0xB2, 0x0A, 0xF0, 0x90, 0x90, 0x90, 0xF0};
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(program_data);
+
+  ASSERT_EQ(analysis.blocks_.size(), 1);
+  ASSERT_EQ(analysis.blocks_[0].exit_, BlockExit::kIndirectJump);
+  ASSERT_TRUE(analysis.blocks_[0].successors_.empty());
+  ASSERT_EQ(analysis.indirect_jumps_, Successors{0x204});
+
+  for (uint_fast16_t address = 0x200; address < 0x206; ++address) {
+    ASSERT_TRUE(analysis.IsCode(address));
+    ASSERT_FALSE(analysis.data_[address]);
+  }
+
+  for (uint_fast16_t address = 0x206; address < 0x20B; ++address) {
+    ASSERT_FALSE(analysis.IsCode(address));
+    ASSERT_TRUE(analysis.data_[address]);
+  }
+
+  // Nothing past the end of the program is data.
+  ASSERT_FALSE(analysis.data_[0x20B]);
+}
+
+TEST(Analysis, DoesNotFollowBranchesOutOfProgram) {
+  // $200: SE V0, $00
+  // $202: JP $300
+  constexpr std::array<uint_fast8_t, 4> program_data{0x30, 0x00, 0x13, 0x00};
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(program_data);
+  ASSERT_EQ(analysis.blocks_.size(), 2);
+
+  // Skipping the jump leaves the program.
+  ASSERT_EQ(analysis.blocks_[0].successors_, Successors{0x202});
+
+  ASSERT_EQ(analysis.blocks_[1].exit_, BlockExit::kJump);
+  ASSERT_TRUE(analysis.blocks_[1].successors_.empty());
+}
+
+TEST(Analysis, EndsBlockAtEndOfProgram) {
+  // $200: LD V0, $01
+  // $202: ADD V0, $01
+  constexpr std::array<uint_fast8_t, 4> program_data{0x60, 0x01, 0x70, 0x01};
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(program_data);
+
+  ASSERT_EQ(analysis.blocks_.size(), 1);
+  ASSERT_EQ(analysis.blocks_[0].end_, 0x204);
+  ASSERT_EQ(analysis.blocks_[0].exit_, BlockExit::kLeavesProgram);
+}
+
+TEST(Analysis, FollowsLongInstructions) {
+  // $200: SE V0, $00
+  // $202: LD I, $0300
+  // $206: JP $206
+  constexpr std::array<uint_fast8_t, 8> program_data{0x30, 0x00, 0xF0, 0x00,
+                                                     0x03, 0x00, 0x12, 0x06};
+
+  const auto analysis = chip8::analysis::AnalyzeProgram(program_data);
+  ASSERT_EQ(analysis.blocks_.size(), 3);
+
+  // Skipping the long load skips its address as well.
+  ASSERT_EQ(analysis.blocks_[0].successors_, (Successors{0x202, 0x206}));
+  ASSERT_EQ(analysis.blocks_[1].end_, 0x206);
+
+  for (uint_fast16_t address = 0x200; address < 0x208; ++address) {
+    ASSERT_TRUE(analysis.IsCode(address));
+  }
+}
+
+TEST(Analysis, CachesAnalysisByProgram) {
+  chip8::analysis::AnalysisCache analysis_cache;
+
+  // $200: JP $200
+  std::vector<uint_fast8_t> program_data{0x12, 0x00};
+
+  const auto first = analysis_cache.Analyze(program_data.data(), 2);
+  const auto second = analysis_cache.Analyze(program_data.data(), 2);
+
+  ASSERT_EQ(first, second);
+  ASSERT_EQ(analysis_cache.GetNumberOfAnalyses(), 1);
+
+  // $200: RET
+  program_data = {0x00, 0xEE};
+
+  const auto third = analysis_cache.Analyze(program_data.data(), 2);
+
+  ASSERT_NE(third, first);
+  ASSERT_EQ(third->blocks_[0].exit_, BlockExit::kReturn);
+  ASSERT_EQ(analysis_cache.GetNumberOfAnalyses(), 2);
+}
+}  // namespace
\ No newline at end of file
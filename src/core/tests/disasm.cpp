@@ -12,6 +12,9 @@
 
 #include <core/disasm.h>
 
+#include <array>
+#include <iterator>
+
 #include "gtest/gtest.h"
 
 namespace {
@@ -53,9 +56,17 @@ const std::vector<TestDataInfo> test_data{
     {0xF115, "LD DT, V1"},     {0xF118, "LD ST, V1"},
     {0xF11E, "ADD I, V1"},     {0xF129, "LD F, V1"},
     {0xF133, "LD B, V1"},      {0xF155, "LD [I], V1"},
-    {0xF165, "LD V1, [I]"},    {0x00EF, "ILLEGAL $00EF"},
-    {0x812F, "ILLEGAL $812F"}, {0xE1A4, "ILLEGAL $E1A4"},
-    {0xF1FF, "ILLEGAL $F1FF"}};
+    {0xF165, "LD V1, [I]"},    {0x00C5, "SCD 5"},
+    {0x00FB, "SCR"},           {0x00FC, "SCL"},
+    {0x00FD, "EXIT"},          {0x00FE, "LOW"},
+    {0x00FF, "HIGH"},          {0xF130, "LD HF, V1"},
+    {0xF175, "LD R, V1"},      {0xF185, "LD V1, R"},
+    {0x00D3, "SCU 3"},         {0x5122, "LD [I], V1-V2"},
+    {0x5213, "LD V2-V1, [I]"}, {0xF000, "LD I, LONG"},
+    {0xF201, "PLANE 2"},       {0xF002, "LD AUDIO, [I]"},
+    {0xF13A, "LD PITCH, V1"},  {0xF100, "ILLEGAL $F100"},
+    {0x00EF, "ILLEGAL $00EF"}, {0x812F, "ILLEGAL $812F"},
+    {0xE1A4, "ILLEGAL $E1A4"}, {0xF1FF, "ILLEGAL $F1FF"}};
 
 TEST_P(DisassemblerTest, VerifyOutputOfInstructions) {
   const auto [instruction, expected_disassembly_result] = GetParam();
@@ -67,6 +78,61 @@ TEST_P(DisassemblerTest, VerifyOutputOfInstructions) {
   ASSERT_EQ(disassembly_result, expected_disassembly_result);
 }
 
+TEST_P(DisassemblerTest, VerifyOutputIntoCharacterBuffer) {
+  const auto [instruction, expected_disassembly_result] = GetParam();
+
+  std::array<char, chip8::debug::kMaxDisassemblyLength> disassembly;
+  const auto length = chip8::debug::DisassembleInstruction(
+      chip8::Instruction(instruction), disassembly.data(), disassembly.size());
+
+  ASSERT_EQ(std::string_view(disassembly.data(), length),
+            expected_disassembly_result);
+}
+
+TEST_P(DisassemblerTest, VerifyOutputAppendedToMemoryBuffer) {
+  const auto [instruction, expected_disassembly_result] = GetParam();
+
+  fmt::memory_buffer buffer;
+  fmt::format_to(std::back_inserter(buffer), "$0200: ");
+
+  const auto length = chip8::debug::DisassembleInstruction(
+      chip8::Instruction(instruction), buffer);
+
+  ASSERT_EQ(length, expected_disassembly_result.size());
+  ASSERT_EQ(fmt::to_string(buffer),
+            fmt::format("$0200: {}", expected_disassembly_result));
+}
+
 INSTANTIATE_TEST_SUITE_P(VirtualMachineCore, DisassemblerTest,
                          testing::ValuesIn(test_data));
+
+TEST(Disassembler, TruncatesOutputToCharacterBuffer) {
+  std::array<char, 4> disassembly{};
+
+  // "DRW V1, V2, 15" doesn't fit, but its full length is still reported.
+  const auto length = chip8::debug::DisassembleInstruction(
+      chip8::Instruction(0xD12F), disassembly.data(), disassembly.size());
+
+  ASSERT_EQ(length, 14);
+  ASSERT_EQ(std::string_view(disassembly.data(), disassembly.size()), "DRW ");
+}
+
+TEST(Disassembler, AllOverloadsAgreeOnEveryInstruction) {
+  fmt::memory_buffer buffer;
+  std::array<char, chip8::debug::kMaxDisassemblyLength> disassembly;
+
+  for (auto value = 0; value <= 0xFFFF; ++value) {
+    const chip8::Instruction instruction(value);
+    const auto expected = chip8::debug::DisassembleInstruction(instruction);
+
+    buffer.clear();
+    ASSERT_EQ(chip8::debug::DisassembleInstruction(instruction, buffer),
+              expected.size());
+    ASSERT_EQ(fmt::to_string(buffer), expected);
+
+    const auto length = chip8::debug::DisassembleInstruction(
+        instruction, disassembly.data(), disassembly.size());
+    ASSERT_EQ(std::string_view(disassembly.data(), length), expected);
+  }
+}
 }  // namespace
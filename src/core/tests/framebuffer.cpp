@@ -0,0 +1,198 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/framebuffer.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+TEST(Framebuffer, StartsBlankInLowResolution) {
+  const chip8::Framebuffer framebuffer;
+
+  ASSERT_FALSE(framebuffer.IsHighResolution());
+  ASSERT_EQ(framebuffer.GetWidth(), chip8::framebuffer::kWidth);
+  ASSERT_EQ(framebuffer.GetHeight(), chip8::framebuffer::kHeight);
+
+  for (unsigned int y = 0; y < framebuffer.GetHeight(); ++y) {
+    ASSERT_EQ(framebuffer.GetRow(y), chip8::Framebuffer::Row{});
+  }
+}
+
+TEST(Framebuffer, DrawsSpriteRowsAcrossWords) {
+  chip8::Framebuffer framebuffer;
+  framebuffer.SetHighResolution(true);
+
+  // A 16 pixel wide row straddling both words of a high resolution row.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_FALSE(framebuffer.DrawSpriteRow(60, 5, 0xFFFF, 16, false));
+
+  const auto& row = framebuffer.GetRow(5);
+  ASSERT_EQ(row[0], 0xFULL);
+  ASSERT_EQ(row[1], 0xFFF0000000000000ULL);
+
+  for (unsigned int x = 0; x < framebuffer.GetWidth(); ++x) {
+    ASSERT_EQ(framebuffer.IsPixelOn(x, 5), (x >= 60) && (x < 76));
+  }
+
+  // Drawing it again erases it, and reports the collision.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(framebuffer.DrawSpriteRow(60, 5, 0xFFFF, 16, false));
+  ASSERT_EQ(framebuffer.GetRow(5), chip8::Framebuffer::Row{});
+}
+
+TEST(Framebuffer, WrapsOrClipsAtRightEdge) {
+  chip8::Framebuffer framebuffer;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(60, 0, 0xFF, 8, false);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(framebuffer.GetRow(0)[0], 0xF00000000000000FULL);
+
+  // Nothing may leak into the part of the row only used in high resolution.
+  ASSERT_EQ(framebuffer.GetRow(0)[1], 0);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(60, 1, 0xFF, 8, true);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(framebuffer.GetRow(1)[0], 0xFULL);
+
+  framebuffer.SetHighResolution(true);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(124, 0, 0xFF, 8, false);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(framebuffer.GetRow(0)[0], 0xF000000000000000ULL);
+  ASSERT_EQ(framebuffer.GetRow(0)[1], 0xFULL);
+}
+
+TEST(Framebuffer, ScrollsDown) {
+  chip8::Framebuffer framebuffer;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(0, 0, 0x80, 8, false);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(0, 30, 0x80, 8, false);
+
+  framebuffer.ScrollDown(1);
+
+  ASSERT_FALSE(framebuffer.IsPixelOn(0, 0));
+  ASSERT_TRUE(framebuffer.IsPixelOn(0, 1));
+  ASSERT_FALSE(framebuffer.IsPixelOn(0, 30));
+  ASSERT_TRUE(framebuffer.IsPixelOn(0, 31));
+
+  // The bottom row is scrolled off the screen, not into the rows only used
+  // in high resolution.
+  framebuffer.ScrollDown(1);
+  framebuffer.SetHighResolution(false);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.ScrollDown(100);
+
+  for (unsigned int y = 0; y < framebuffer.GetHeight(); ++y) {
+    ASSERT_EQ(framebuffer.GetRow(y), chip8::Framebuffer::Row{});
+  }
+}
+
+TEST(Framebuffer, ScrollsHorizontally) {
+  chip8::Framebuffer framebuffer;
+  framebuffer.SetHighResolution(true);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(62, 0, 0xC0, 8, false);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.ScrollRight(4);
+
+  ASSERT_TRUE(framebuffer.IsPixelOn(66, 0));
+  ASSERT_TRUE(framebuffer.IsPixelOn(67, 0));
+  ASSERT_FALSE(framebuffer.IsPixelOn(62, 0));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.ScrollLeft(8);
+
+  ASSERT_TRUE(framebuffer.IsPixelOn(58, 0));
+  ASSERT_TRUE(framebuffer.IsPixelOn(59, 0));
+  ASSERT_EQ(framebuffer.GetRow(0)[1], 0);
+
+  // Pixels scrolled past the edges are lost.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(120, 1, 0xFF, 8, false);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.ScrollRight(4);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.ScrollLeft(4);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(framebuffer.GetRow(1)[1], 0xF0ULL);
+}
+
+TEST(Framebuffer, ScrollsOnlySelectedPlanes) {
+  chip8::Screen screen;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  screen.DrawSpriteRow(0, 4, 0x80, 8, false, 0);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  screen.DrawSpriteRow(0, 4, 0x80, 8, false, 1);
+  ASSERT_EQ(screen.GetPixel(0, 4), 3);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  screen.ScrollUp(2, 0b10);
+
+  ASSERT_EQ(screen.GetPixel(0, 4), 1);
+  ASSERT_EQ(screen.GetPixel(0, 2), 2);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  screen.ScrollRight(4, 0b01);
+
+  ASSERT_EQ(screen.GetPixel(0, 4), 0);
+  ASSERT_EQ(screen.GetPixel(4, 4), 1);
+  ASSERT_EQ(screen.GetPixel(0, 2), 2);
+
+  screen.Clear(0b01);
+  ASSERT_FALSE(screen.IsPixelOn(4, 4));
+  ASSERT_TRUE(screen.IsPixelOn(0, 2));
+}
+
+TEST(Framebuffer, WidensToMorePlanes) {
+  chip8::Framebuffer framebuffer;
+  framebuffer.SetHighResolution(true);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  framebuffer.DrawSpriteRow(100, 50, 0x80, 8, false);
+
+  chip8::Screen screen;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  screen.DrawSpriteRow(0, 0, 0xFF, 8, false, 1);
+  screen.Assign(framebuffer);
+
+  ASSERT_TRUE(screen.IsHighResolution());
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(screen.GetPixel(100, 50), 1);
+
+  // Planes the source doesn't have are blank.
+  ASSERT_EQ(screen.GetPlane(1), chip8::Screen::Plane{});
+  ASSERT_EQ(chip8::Screen(framebuffer), screen);
+}
+}  // namespace
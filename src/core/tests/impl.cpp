@@ -27,7 +27,9 @@ class ImplementationTest : public testing::Test {
   T impl_;
 };
 
-using ImplementationTypes = ::testing::Types<InterpreterImplementation>;
+using ImplementationTypes =
+    ::testing::Types<InterpreterImplementation,
+                     XoChipInterpreterImplementation>;
 TYPED_TEST_SUITE(ImplementationTest, ImplementationTypes);
 
 namespace {
@@ -52,10 +54,10 @@ void InjectInstruction(chip8::ImplementationInterface& impl,
   constexpr auto kInstructionIndexLo = kInstructionIndexHi + 1;
 
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
-  impl.memory_[kInstructionIndexHi] = hi;
+  impl.GetMemory()[kInstructionIndexHi] = hi;
 
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
-  impl.memory_[kInstructionIndexLo] = lo;
+  impl.GetMemory()[kInstructionIndexLo] = lo;
 }
 
 void Inject_RET(chip8::ImplementationInterface& impl) noexcept {
@@ -202,6 +204,23 @@ void Inject_SKNP_Vx(chip8::ImplementationInterface& impl,
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
   InjectInstruction(impl, 0xE0, 0xA1);
 }
+
+/// Counts the pixels of a framebuffer that are on.
+///
+/// \param framebuffer The framebuffer to examine.
+///
+/// \returns The number of pixels on, in the current resolution mode.
+template <typename Framebuffer>
+auto CountPixelsOn(const Framebuffer& framebuffer) noexcept -> size_t {
+  size_t num_pixels_on = 0;
+
+  for (unsigned int y = 0; y < framebuffer.GetHeight(); ++y) {
+    for (unsigned int x = 0; x < framebuffer.GetWidth(); ++x) {
+      num_pixels_on += framebuffer.IsPixelOn(x, y) ? 1 : 0;
+    }
+  }
+  return num_pixels_on;
+}
 }  // namespace
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -216,10 +235,8 @@ TYPED_TEST(ImplementationTest, Opcode_CLS) {
   ASSERT_EQ(this->impl_.program_counter_,
             chip8::initial_values::kProgramCounter + 2);
 
-  // Make sure that the entire framebuffer is filled with black pixels.
-  ASSERT_TRUE(std::all_of(
-      this->impl_.framebuffer_.cbegin(), this->impl_.framebuffer_.cend(),
-      [](const uint_fast32_t pixel) { return pixel == chip8::pixel::kBlack; }));
+  // Make sure that every pixel of the framebuffer is off.
+  ASSERT_EQ(CountPixelsOn(this->impl_.framebuffer_), 0);
 }
 
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
@@ -227,13 +244,13 @@ TYPED_TEST(ImplementationTest, Opcode_RET) {
   // Put a fake address within the stack at the first element.
   //
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
-  this->impl_.stack_[0] = 0xBEE6;
+  this->impl_.stack_[0] = 0xBE6;
 
   // Pretend that the stack pointer is 0.
   this->impl_.stack_pointer_ = 0;
 
   // The stack pointer is 0, and the subroutine address at stack element 0 is
-  // 0xBEE6, so calling RET should set the program counter to 0xBEE6.
+  // 0xBE6, so calling RET should set the program counter to 0xBE6.
   Inject_RET(this->impl_);
 
   // Make sure the instruction succeeded.
@@ -241,7 +258,7 @@ TYPED_TEST(ImplementationTest, Opcode_RET) {
 
   // Make sure the program counter is at the fake subroutine address from the
   // stack.
-  ASSERT_EQ(this->impl_.program_counter_, 0xBEE6);
+  ASSERT_EQ(this->impl_.program_counter_, 0xBE6);
 
   // Make sure the stack pointer underflowed.
   ASSERT_EQ(this->impl_.stack_pointer_, -1);
@@ -262,6 +279,19 @@ TYPED_TEST(ImplementationTest, Opcode_RET_Detect_StackUnderflow) {
             chip8::initial_values::kProgramCounter);
 }
 
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Opcode_RET_DetectInvalidAddress) {
+  // No whole instruction can be fetched from the last byte of memory.
+  this->impl_.stack_[0] = this->impl_.memory_.size() - 1;
+  this->impl_.stack_pointer_ = 0;
+
+  Inject_RET(this->impl_);
+
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kInvalidMemoryLocation);
+  ASSERT_EQ(this->impl_.program_counter_,
+            chip8::initial_values::kProgramCounter);
+}
+
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 TYPED_TEST(ImplementationTest, Opcode_JP) {
   // We can pretty much just try and jump to any arbitrary location, in this
@@ -846,6 +876,20 @@ TYPED_TEST(ImplementationTest, Opcode_ADD_I_Vx) {
   ASSERT_EQ(this->impl_.I_, 0xC4);
 }
 
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Opcode_ADD_I_Vx_WrapsAround) {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[0] = 0x05;
+  this->impl_.I_ = chip8::data_limits::kIndexRegister;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF0, 0x1E);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // I is 16 bits wide.
+  ASSERT_EQ(this->impl_.I_, 0x04);
+}
+
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 TYPED_TEST(ImplementationTest, Opcode_LD_F_Vx) {
   // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -942,4 +986,704 @@ TYPED_TEST(ImplementationTest, Opcode_LD_Vx_I) {
                   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
                   ASSERT_EQ(value, this->impl_.memory_[this->impl_.I_++]);
                 });
-}
\ No newline at end of file
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Opcode_LD_I_Vx_Detect_MemoryOverrun) {
+  // Only 15 of the 16 registers fit before the end of memory.
+  this->impl_.I_ = this->impl_.memory_.size() - (this->impl_.V_.size() - 1);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_.fill(0xAA);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xFF, 0x55);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kInvalidMemoryLocation);
+
+  ASSERT_TRUE(std::all_of(this->impl_.memory_.cbegin() + this->impl_.I_,
+                          this->impl_.memory_.cend(),
+                          [](const auto value) { return value == 0; }));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xFF, 0x65);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kInvalidMemoryLocation);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(this->impl_.V_[0xF], 0xAA);
+
+  // One register less fits.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xFE, 0x55);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Opcode_LD_I_Vx_MarksMemoryDirty) {
+  // Resetting marks every page.
+  static_cast<void>(this->impl_.TakeDirtyPages());
+
+  // V0 to V3 straddle the pages at $300 and $340.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.I_ = 0x33E;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF3, 0x55);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  const auto dirty_pages = this->impl_.TakeDirtyPages();
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(dirty_pages[0], (uint64_t{1} << 12) | (uint64_t{1} << 13));
+  ASSERT_TRUE(std::all_of(dirty_pages.cbegin() + 1, dirty_pages.cend(),
+                          [](const auto bits) { return bits == 0; }));
+
+  // The pages are only reported once.
+  ASSERT_EQ(this->impl_.TakeDirtyPages()[0], 0);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Quirk_ShiftUsesVy) {
+  this->impl_.quirks_.shift_uses_vy_ = true;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[0] = 0xFF;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[1] = 0x81;
+
+  // SHR V0, V1
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x80, 0x16);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // V0 should contain V1 shifted, and the carry flag should be V1's LSB.
+  ASSERT_EQ(this->impl_.V_[0], 0x40);
+  ASSERT_EQ(this->impl_.V_[0xF], 1);
+
+  // SHL V0, V1
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x80, 0x1E);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  ASSERT_EQ(this->impl_.V_[0], 0x02);
+  ASSERT_EQ(this->impl_.V_[0xF], 1);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Quirk_LoadStoreIncrementsI) {
+  this->impl_.quirks_.load_store_increments_i_ = true;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.I_ = 0x300;
+
+  // LD [I], V3
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF3, 0x55);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(this->impl_.I_, 0x304);
+
+  // LD V1, [I]
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF1, 0x65);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(this->impl_.I_, 0x306);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Quirk_JumpUsesVx) {
+  this->impl_.quirks_.jump_uses_vx_ = true;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[0] = 0x20;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[1] = 0x10;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xB1, 0x23);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // The highest nibble of the address selects V1, so (0x10 + 0x123) = 0x133.
+  ASSERT_EQ(this->impl_.program_counter_, 0x133);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Quirk_LogicResetsVF) {
+  this->impl_.quirks_.logic_resets_vf_ = true;
+  this->impl_.V_[0xF] = 1;
+
+  const auto [V0, V1] =
+      InjectBitInstruction(this->impl_, 0x80, 0x11, 0xB0, 0xB4);
+
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(V0, V1);
+  ASSERT_EQ(this->impl_.V_[0xF], 0);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, Quirk_ClipSprites) {
+  // An 8x2 sprite drawn at the bottom right corner, past both edges.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.I_ = 0x300;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.memory_[0x300] = 0xFF;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.memory_[0x301] = 0xFF;
+
+  // The starting position wraps around regardless of the quirk.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[0] = chip8::framebuffer::kWidth + 60;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[1] = chip8::framebuffer::kHeight - 1;
+
+  // DRW V0, V1, 2
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xD0, 0x12);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // Without the quirk, the whole sprite wraps around.
+  ASSERT_EQ(CountPixelsOn(this->impl_.framebuffer_), 16);
+
+  this->impl_.quirks_.clip_sprites_ = true;
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // Only the 4 pixels of the first row that are on screen are erased.
+  ASSERT_EQ(CountPixelsOn(this->impl_.framebuffer_), 12);
+  ASSERT_EQ(this->impl_.V_[0xF], 1);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_RejectedWithoutVariant) {
+  // SCR, SCL, EXIT, LOW, HIGH, SCD 1, LD HF, V0, LD R, V0, LD V0, R
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  const std::array<std::pair<uint_fast8_t, uint_fast8_t>, 9> instructions{
+      {{0x00, 0xFB},
+       {0x00, 0xFC},
+       {0x00, 0xFD},
+       {0x00, 0xFE},
+       {0x00, 0xFF},
+       {0x00, 0xC1},
+       {0xF0, 0x30},
+       {0xF0, 0x75},
+       {0xF0, 0x85}}};
+
+  for (const auto& [hi, lo] : instructions) {
+    InjectInstruction(this->impl_, hi, lo);
+    this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+
+    ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kInvalidInstruction);
+  }
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_HIGH_LOW) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+
+  // HIGH
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x00, 0xFF);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  ASSERT_TRUE(this->impl_.framebuffer_.IsHighResolution());
+  ASSERT_EQ(this->impl_.framebuffer_.GetWidth(),
+            chip8::framebuffer::kHighResolutionWidth);
+  ASSERT_EQ(this->impl_.framebuffer_.GetHeight(),
+            chip8::framebuffer::kHighResolutionHeight);
+
+  // LOW
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x00, 0xFE);
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  ASSERT_FALSE(this->impl_.framebuffer_.IsHighResolution());
+  ASSERT_EQ(this->impl_.framebuffer_.GetWidth(), chip8::framebuffer::kWidth);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_Scroll) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+  this->impl_.framebuffer_.SetHighResolution(true);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.framebuffer_.DrawSpriteRow(10, 10, 0x80, 8, false);
+
+  // SCD 3
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x00, 0xC3);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(this->impl_.framebuffer_.IsPixelOn(10, 13));
+
+  // SCR
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x00, 0xFB);
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(this->impl_.framebuffer_.IsPixelOn(14, 13));
+
+  // SCL
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x00, 0xFC);
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(this->impl_.framebuffer_.IsPixelOn(10, 13));
+  ASSERT_EQ(CountPixelsOn(this->impl_.framebuffer_), 1);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_DRW_Large) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+  this->impl_.framebuffer_.SetHighResolution(true);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.I_ = 0x300;
+
+  // A 16x16 sprite with only the left column of the top row and the right
+  // column of the bottom row set.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.memory_[0x300] = 0x80;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.memory_[0x31F] = 0x01;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[0] = 100;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[1] = 40;
+
+  // DRW V0, V1, 0
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xD0, 0x10);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(this->impl_.framebuffer_.IsPixelOn(100, 40));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(this->impl_.framebuffer_.IsPixelOn(115, 55));
+  ASSERT_EQ(CountPixelsOn(this->impl_.framebuffer_), 2);
+  ASSERT_EQ(this->impl_.V_[0xF], 0);
+
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  ASSERT_EQ(CountPixelsOn(this->impl_.framebuffer_), 0);
+  ASSERT_EQ(this->impl_.V_[0xF], 1);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_EXIT) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0x00, 0xFD);
+
+  // The program stays exited.
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kExited);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kExited);
+  ASSERT_EQ(this->impl_.program_counter_,
+            chip8::initial_values::kProgramCounter);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_LD_HF_Vx) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  this->impl_.V_[2] = 0xA;
+
+  // LD HF, V2
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF2, 0x30);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  const auto expected_location = chip8::memory_region::kBigFont + 0xA * 10;
+  ASSERT_EQ(this->impl_.I_, expected_location);
+
+  for (size_t index = 0; index < chip8::data_size::kBigFontLength; ++index) {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    ASSERT_EQ(this->impl_.memory_[expected_location + index],
+              chip8::initial_values::kBigFontSet[0xA * 10 + index]);
+  }
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, SuperChip_LD_R_Vx_LD_Vx_R) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+
+  for (size_t index = 0; index < 4; ++index) {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    this->impl_.V_[index] = 0x10 + index;
+  }
+
+  // LD R, V3
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF3, 0x75);
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  this->impl_.V_ = {};
+
+  // LD V3, R
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF3, 0x85);
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kSuccess);
+
+  for (size_t index = 0; index < 4; ++index) {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    ASSERT_EQ(this->impl_.V_[index], 0x10 + index);
+  }
+
+  // There are only 8 flags.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(this->impl_, 0xF8, 0x75);
+  this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kInvalidInstruction);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TYPED_TEST(ImplementationTest, XoChip_RejectedWithoutVariant) {
+  this->impl_.variant_ = chip8::Variant::kSuperChip;
+
+  // SCU 1, LD I, LONG, PLANE 1, LD AUDIO, [I], LD PITCH, V0
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  const std::array<std::pair<uint_fast8_t, uint_fast8_t>, 5> instructions{
+      {{0x00, 0xD1}, {0xF0, 0x00}, {0xF1, 0x01}, {0xF0, 0x02}, {0xF0, 0x3A}}};
+
+  for (const auto& [hi, lo] : instructions) {
+    InjectInstruction(this->impl_, hi, lo);
+    this->impl_.program_counter_ = chip8::initial_values::kProgramCounter;
+
+    ASSERT_EQ(this->impl_.Step(), chip8::StepResult::kInvalidInstruction);
+  }
+}
+
+namespace {
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(ClassicImplementation, DetectsControlLeavingMemory) {
+  InterpreterImplementation impl;
+
+  // JP $FFF
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0x1F, 0xFF);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidMemoryLocation);
+  ASSERT_EQ(impl.program_counter_, chip8::initial_values::kProgramCounter);
+
+  // JP V0, $FFF
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.V_[0] = 0xFF;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xBF, 0xFF);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidMemoryLocation);
+
+  // SE V0, $FF, skipping past the last instruction.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0xFFC] = 0x30;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0xFFD] = 0xFF;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.program_counter_ = 0xFFC;
+
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidMemoryLocation);
+  ASSERT_EQ(impl.program_counter_, 0xFFC);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, RejectedByClassicImplementation) {
+  InterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+
+  // The classic implementation has neither the memory nor the planes, so
+  // it doesn't even run the SUPER-CHIP subset.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF0, 0x00);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidInstruction);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0x00, 0xFF);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidInstruction);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, HasMoreMemory) {
+  InterpreterImplementation classic_impl;
+  XoChipInterpreterImplementation xo_chip_impl;
+
+  ASSERT_EQ(classic_impl.GetMemorySize(), chip8::data_size::kInternalMemory);
+  ASSERT_EQ(xo_chip_impl.GetMemorySize(),
+            chip8::data_size::kXoChipInternalMemory);
+  ASSERT_EQ(xo_chip_impl.GetMemory(), xo_chip_impl.memory_.data());
+
+  // The font is loaded the same way.
+  ASSERT_TRUE(std::equal(chip8::initial_values::kFontSet.cbegin(),
+                         chip8::initial_values::kFontSet.cend(),
+                         xo_chip_impl.memory_.cbegin()));
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, LD_I_Long) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+
+  // LD I, $E000
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF0, 0x00);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x202] = 0xE0;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x203] = 0x00;
+
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(impl.I_, 0xE000);
+  ASSERT_EQ(impl.program_counter_, 0x204);
+
+  // Only F000 is a long load.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF1, 0x00);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidInstruction);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, SkipsOverLongLoad) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+
+  // SE V0, $00
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0x30, 0x00);
+
+  // LD I, $1234
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x202] = 0xF0;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x203] = 0x00;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x204] = 0x12;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x205] = 0x34;
+
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(impl.program_counter_, 0x206);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, DrawsToSelectedPlanes) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+
+  // A 1 row sprite for each plane: 10000000, then 01000000.
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.I_ = 0x300;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x300] = 0x80;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.memory_[0x301] = 0x40;
+
+  // PLANE 3
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF3, 0x01);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(impl.selected_planes_, 3);
+
+  // DRW V0, V0, 1
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xD0, 0x01);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  ASSERT_EQ(impl.framebuffer_.GetPixel(0, 0), 1);
+  ASSERT_EQ(impl.framebuffer_.GetPixel(1, 0), 2);
+  ASSERT_EQ(impl.V_[0xF], 0);
+
+  // PLANE 2, then CLS only clears the second plane.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF2, 0x01);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  InjectInstruction(impl, 0x00,
+                    chip8::control_flow_and_screen_instructions::kCLS);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  ASSERT_EQ(impl.framebuffer_.GetPixel(0, 0), 1);
+  ASSERT_EQ(impl.framebuffer_.GetPixel(1, 0), 0);
+
+  // Only 2 planes exist.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF4, 0x01);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidInstruction);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, SCU) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.framebuffer_.DrawSpriteRow(0, 5, 0x80, 8, false);
+
+  // SCU 2
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0x00, 0xD2);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(impl.framebuffer_.IsPixelOn(0, 3));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_FALSE(impl.framebuffer_.IsPixelOn(0, 5));
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, LD_I_Vx_Vy_LD_Vx_Vy_I) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.I_ = 0x300;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.V_[2] = 0x22;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.V_[3] = 0x33;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.V_[4] = 0x44;
+
+  // LD [I], V4-V2: the registers are stored backwards, and I is left alone.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0x54, 0x22);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(impl.memory_[0x300], 0x44);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(impl.memory_[0x302], 0x22);
+  ASSERT_EQ(impl.I_, 0x300);
+
+  // LD V5-V7, [I]
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0x55, 0x73);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(impl.V_[5], 0x44);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(impl.V_[7], 0x22);
+
+  // The end of memory can't be crossed.
+  impl.I_ = chip8::data_size::kXoChipInternalMemory - 1;
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kInvalidMemoryLocation);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, LD_AUDIO_I_LD_PITCH_Vx) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.I_ = 0x300;
+
+  for (size_t index = 0; index < impl.audio_pattern_.size(); ++index) {
+    impl.memory_[impl.I_ + index] = index;
+  }
+
+  // LD AUDIO, [I]
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF0, 0x02);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  for (size_t index = 0; index < impl.audio_pattern_.size(); ++index) {
+    ASSERT_EQ(impl.audio_pattern_[index], index);
+  }
+
+  // LD PITCH, V1
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.V_[1] = 0x70;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xF1, 0x3A);
+  impl.program_counter_ = chip8::initial_values::kProgramCounter;
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(impl.pitch_, 0x70);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+TEST(XoChipImplementation, Has16RplFlags) {
+  XoChipInterpreterImplementation impl;
+  impl.variant_ = chip8::Variant::kXoChip;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  impl.V_[0xF] = 0xAB;
+
+  // LD R, VF
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  InjectInstruction(impl, 0xFF, 0x75);
+  ASSERT_EQ(impl.Step(), chip8::StepResult::kSuccess);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_EQ(impl.rpl_flags_[0xF], 0xAB);
+}
+}  // namespace
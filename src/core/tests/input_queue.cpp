@@ -0,0 +1,97 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by kaichiuchu <kaichiuchu@protonmail.com>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include <core/input_queue.h>
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace {
+auto MakeEvent(const chip8::Key key, const chip8::KeyState state) noexcept
+    -> chip8::InputEvent {
+  return {key, state, chip8::InputEvent::Clock::now()};
+}
+
+TEST(InputQueue, PopsEventsInOrder) {
+  chip8::InputQueue input_queue;
+  chip8::InputEvent event{};
+
+  ASSERT_TRUE(input_queue.IsEmpty());
+  ASSERT_FALSE(input_queue.Pop(event));
+
+  ASSERT_TRUE(input_queue.Push(
+      MakeEvent(chip8::Key::k1, chip8::KeyState::kPressed)));
+  ASSERT_TRUE(input_queue.Push(
+      MakeEvent(chip8::Key::k1, chip8::KeyState::kReleased)));
+  ASSERT_TRUE(input_queue.Push(
+      MakeEvent(chip8::Key::kF, chip8::KeyState::kPressed)));
+
+  ASSERT_TRUE(input_queue.Pop(event));
+  ASSERT_EQ(event.key_, chip8::Key::k1);
+  ASSERT_EQ(event.state_, chip8::KeyState::kPressed);
+
+  ASSERT_TRUE(input_queue.Pop(event));
+  ASSERT_EQ(event.key_, chip8::Key::k1);
+  ASSERT_EQ(event.state_, chip8::KeyState::kReleased);
+
+  ASSERT_TRUE(input_queue.Pop(event));
+  ASSERT_EQ(event.key_, chip8::Key::kF);
+  ASSERT_EQ(event.state_, chip8::KeyState::kPressed);
+
+  ASSERT_TRUE(input_queue.IsEmpty());
+}
+
+TEST(InputQueue, DropsEventsWhenFull) {
+  chip8::InputQueue input_queue;
+
+  for (auto index = 0U; index < chip8::InputQueue::kCapacity; ++index) {
+    ASSERT_TRUE(input_queue.Push(
+        MakeEvent(chip8::Key::k0, chip8::KeyState::kPressed)));
+  }
+
+  ASSERT_FALSE(input_queue.Push(
+      MakeEvent(chip8::Key::k0, chip8::KeyState::kPressed)));
+
+  // Making room allows events to be added again.
+  chip8::InputEvent event{};
+  ASSERT_TRUE(input_queue.Pop(event));
+  ASSERT_TRUE(input_queue.Push(
+      MakeEvent(chip8::Key::k0, chip8::KeyState::kPressed)));
+}
+
+TEST(InputQueue, TransfersEventsBetweenThreads) {
+  chip8::InputQueue input_queue;
+  constexpr auto kNumEvents = 10000U;
+
+  std::thread producer([&input_queue]() {
+    for (auto index = 0U; index < kNumEvents; ++index) {
+      const auto key = static_cast<chip8::Key>(index % 16);
+
+      while (!input_queue.Push(MakeEvent(key, chip8::KeyState::kPressed))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  // Every event must arrive exactly once, in order.
+  for (auto index = 0U; index < kNumEvents; ++index) {
+    chip8::InputEvent event{};
+
+    while (!input_queue.Pop(event)) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(event.key_, static_cast<chip8::Key>(index % 16));
+  }
+  producer.join();
+}
+}  // namespace
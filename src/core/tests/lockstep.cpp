@@ -0,0 +1,240 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by kaichiuchu <kaichiuchu@protonmail.com>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include <core/lockstep.h>
+
+#include <array>
+
+#include "gtest/gtest.h"
+
+// Yuck.
+#include "../src/private/impl_interpreter.h"
+
+namespace {
+using chip8::LockstepGranularity;
+
+/// Fetches the instruction an implementation is about to execute.
+///
+/// \param impl The implementation.
+///
+/// \returns The instruction at the program counter.
+auto Fetch(const chip8::ImplementationInterface& impl) -> uint_fast16_t {
+  const auto* const memory = impl.GetMemory();
+  return (memory[impl.program_counter_] << 8) |
+         memory[impl.program_counter_ + 1];
+}
+
+// An interpreter whose `ADD V0, $01` is off by one when V0 reaches $20,
+// standing in for an alternative implementation with a bug.
+class OffByOneImplementation : public InterpreterImplementation {
+ public:
+  auto Step() noexcept -> chip8::StepResult override {
+    const auto instruction = Fetch(*this);
+    const auto result = InterpreterImplementation::Step();
+
+    if ((instruction == 0x7001) && (V_[0] == 0x20)) {
+      ++V_[0];
+    }
+    return result;
+  }
+};
+
+// An interpreter whose `SKP Vx` never skips.
+class IgnoresKeysImplementation : public InterpreterImplementation {
+ public:
+  auto Step() noexcept -> chip8::StepResult override {
+    if ((Fetch(*this) & 0xF0FF) == 0xE09E) {
+      program_counter_ += chip8::data_size::kInstructionLength;
+      return chip8::StepResult::kSuccess;
+    }
+    return InterpreterImplementation::Step();
+  }
+};
+
+// An interpreter whose `LD [I], Vx` also overwrites a byte $100 past I, on
+// another page of memory, without reporting the write.
+class StrayStoreImplementation : public InterpreterImplementation {
+ public:
+  auto Step() noexcept -> chip8::StepResult override {
+    const auto instruction = Fetch(*this);
+    const auto address = I_;
+    const auto result = InterpreterImplementation::Step();
+
+    if ((instruction & 0xF0FF) == 0xF055) {
+      GetMemory()[address + 0x100] = 0xFF;
+    }
+    return result;
+  }
+};
+
+// $200: ADD V0, $01
+// $202: LD I, $300
+// $204: LD [I], V0
+// $206: SE V0, $40
+// $208: JP $200
+// $20A: JP $20A
+constexpr std::array<uint_fast8_t, 12> kCountingProgram{
+    0x70, 0x01, 0xA3, 0x00, 0xF0, 0x55, 0x30, 0x40, 0x12, 0x00, 0x12, 0x0A};
+
+auto MakeOptions(const chip8::VMInstance::ImplementationFactory& candidate,
+                 const LockstepGranularity granularity)
+    -> chip8::LockstepOptions {
+  chip8::LockstepOptions options;
+  options.candidate_ = candidate;
+  options.granularity_ = granularity;
+  options.max_steps_ = 1000;
+
+  return options;
+}
+
+auto MakeOffByOne(chip8::Variant)
+    -> std::unique_ptr<chip8::ImplementationInterface> {
+  return std::make_unique<OffByOneImplementation>();
+}
+
+auto MakeStrayStore(chip8::Variant)
+    -> std::unique_ptr<chip8::ImplementationInterface> {
+  return std::make_unique<StrayStoreImplementation>();
+}
+
+auto MakeNothing(chip8::Variant)
+    -> std::unique_ptr<chip8::ImplementationInterface> {
+  return nullptr;
+}
+
+TEST(Lockstep, AgreesWithItself) {
+  const auto result = chip8::RunLockstep(
+      kCountingProgram, MakeOptions(chip8::VMInstance::MakeInterpreter,
+                                    LockstepGranularity::kStep));
+
+  ASSERT_TRUE(result.loaded_);
+  ASSERT_FALSE(result.divergence_.has_value());
+  ASSERT_EQ(result.steps_executed_, 1000);
+  ASSERT_EQ(result.result_, chip8::StepResult::kSuccess);
+
+  // Once before the first step, then after every step.
+  ASSERT_EQ(result.num_comparisons_, 1001);
+}
+
+TEST(Lockstep, BisectsToFirstDifferingInstruction) {
+  // The 32nd `ADD V0, $01` is the first to differ; every iteration of the loop
+  // takes 5 steps.
+  constexpr uintmax_t kDifferingStep = 31 * 5;
+
+  uintmax_t num_step_comparisons = 0;
+
+  for (const auto granularity :
+       {LockstepGranularity::kStep, LockstepGranularity::kBlock,
+        LockstepGranularity::kFrame}) {
+    const auto result = chip8::RunLockstep(
+        kCountingProgram, MakeOptions(MakeOffByOne, granularity));
+
+    ASSERT_TRUE(result.divergence_.has_value());
+
+    const auto& divergence = *result.divergence_;
+    ASSERT_EQ(divergence.step_, kDifferingStep);
+    ASSERT_EQ(divergence.program_counter_, 0x200);
+
+    ASSERT_EQ(divergence.reference_.snapshot_.V_[0], 0x20);
+    ASSERT_EQ(divergence.candidate_.snapshot_.V_[0], 0x21);
+    ASSERT_NE(divergence.reference_.hash_, divergence.candidate_.hash_);
+
+    if (granularity == LockstepGranularity::kStep) {
+      num_step_comparisons = result.num_comparisons_;
+    } else {
+      // Coarser comparisons catch the divergence later, but less often.
+      ASSERT_GT(result.steps_executed_, kDifferingStep + 1);
+      ASSERT_LT(result.num_comparisons_, num_step_comparisons);
+    }
+  }
+}
+
+TEST(Lockstep, DescribesDifferences) {
+  const auto result = chip8::RunLockstep(
+      kCountingProgram, MakeOptions(MakeOffByOne, LockstepGranularity::kStep));
+
+  ASSERT_TRUE(result.divergence_.has_value());
+
+  const auto description = chip8::DescribeDivergence(*result.divergence_);
+
+  ASSERT_NE(description.find("V0: $20 != $21\n"), std::string::npos);
+  ASSERT_EQ(description.find("PC:"), std::string::npos);
+
+  // Only the register differs; memory catches up on the next instruction.
+  ASSERT_EQ(description.find("Memory"), std::string::npos);
+}
+
+TEST(Lockstep, CatchesUnreportedMemoryWrites) {
+  const auto result = chip8::RunLockstep(
+      kCountingProgram,
+      MakeOptions(MakeStrayStore, LockstepGranularity::kFrame));
+
+  ASSERT_TRUE(result.divergence_.has_value());
+  ASSERT_EQ(result.divergence_->step_, 2);
+  ASSERT_EQ(result.divergence_->program_counter_, 0x204);
+
+  const auto description = chip8::DescribeDivergence(*result.divergence_);
+  ASSERT_NE(description.find("Memory $0400: $00 != $FF\n"), std::string::npos);
+}
+
+TEST(Lockstep, FeedsSameInputToBoth) {
+  // $200: LD V1, $05
+  // $202: SKP V1
+  // $204: JP $202
+  // $206: JP $206
+  constexpr std::array<uint_fast8_t, 8> program_data{0x61, 0x05, 0xE1, 0x9E,
+                                                     0x12, 0x02, 0x12, 0x06};
+
+  auto options = MakeOptions(
+      [](chip8::Variant) -> std::unique_ptr<chip8::ImplementationInterface> {
+        return std::make_unique<IgnoresKeysImplementation>();
+      },
+      LockstepGranularity::kBlock);
+
+  // Without a key press, nothing tells the implementations apart.
+  ASSERT_FALSE(
+      chip8::RunLockstep(program_data, options).divergence_.has_value());
+
+  // The key is pressed before a jump; the `SKP V1` that follows is the first
+  // to see it.
+  options.inputs_ = {{10, chip8::Key::k5, chip8::KeyState::kPressed}};
+
+  const auto result = chip8::RunLockstep(program_data, options);
+
+  ASSERT_TRUE(result.divergence_.has_value());
+  ASSERT_EQ(result.divergence_->step_, 11);
+  ASSERT_EQ(result.divergence_->program_counter_, 0x202);
+  ASSERT_EQ(result.divergence_->reference_.snapshot_.program_counter_, 0x206);
+  ASSERT_EQ(result.divergence_->candidate_.snapshot_.program_counter_, 0x204);
+}
+
+TEST(Lockstep, StopsWhenProgramStops) {
+  // $200: RET
+  constexpr std::array<uint_fast8_t, 2> program_data{0x00, 0xEE};
+
+  const auto result = chip8::RunLockstep(
+      program_data, MakeOptions(chip8::VMInstance::MakeInterpreter,
+                                LockstepGranularity::kFrame));
+
+  ASSERT_FALSE(result.divergence_.has_value());
+  ASSERT_EQ(result.steps_executed_, 1);
+  ASSERT_EQ(result.result_, chip8::StepResult::kStackUnderflow);
+}
+
+TEST(Lockstep, ReportsCandidateThatCannotLoad) {
+  const auto result = chip8::RunLockstep(
+      kCountingProgram, MakeOptions(MakeNothing, LockstepGranularity::kStep));
+
+  ASSERT_FALSE(result.loaded_);
+  ASSERT_FALSE(result.divergence_.has_value());
+}
+}  // namespace
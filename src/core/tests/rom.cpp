@@ -0,0 +1,123 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/rom.h>
+#include <core/vm_instance.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+/// Writes a ROM file to the temporary directory. The file is named after the
+/// running test, since ctest may run tests in parallel.
+///
+/// \param size The size of the ROM file, in bytes.
+///
+/// \returns The path to the ROM file.
+auto WriteRomFile(const size_t size) -> std::string {
+  const auto* test_info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+
+  const auto path =
+      std::filesystem::temp_directory_path() /
+      (std::string{"vm_tutorial_core_rom_"} + test_info->name() + ".ch8");
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+
+  for (size_t index = 0; index < size; ++index) {
+    file.put(static_cast<char>(index));
+  }
+  return path.string();
+}
+
+TEST(Rom, ReadsWholeFile) {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  const auto path = WriteRomFile(300);
+
+  chip8::Rom rom;
+  ASSERT_EQ(chip8::LoadRom(path, rom), chip8::RomLoadResult::kSuccess);
+  ASSERT_EQ(rom.size(), 300);
+
+  for (size_t index = 0; index < rom.size(); ++index) {
+    ASSERT_EQ(rom.data()[index], static_cast<uint_fast8_t>(index));
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(Rom, ReadsLargestProgram) {
+  const auto path = WriteRomFile(chip8::memory_region::kXoChipProgramAreaSize);
+
+  chip8::Rom rom;
+  ASSERT_EQ(chip8::LoadRom(path, rom), chip8::RomLoadResult::kSuccess);
+  ASSERT_EQ(rom.size(), chip8::memory_region::kXoChipProgramAreaSize);
+
+  std::filesystem::remove(path);
+}
+
+TEST(Rom, RejectsFileLargerThanProgramArea) {
+  const auto path =
+      WriteRomFile(chip8::memory_region::kXoChipProgramAreaSize + 1);
+
+  chip8::Rom rom;
+  ASSERT_EQ(chip8::LoadRom(path, rom), chip8::RomLoadResult::kTooLarge);
+
+  std::filesystem::remove(path);
+}
+
+TEST(Rom, ReportsMissingFile) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    "vm_tutorial_core_rom_test_missing.ch8";
+
+  chip8::Rom rom;
+  errno = 0;
+
+  ASSERT_EQ(chip8::LoadRom(path.string(), rom),
+            chip8::RomLoadResult::kOpenFailed);
+  ASSERT_EQ(errno, ENOENT);
+}
+
+TEST(Rom, DeterminesVariantFromExtension) {
+  ASSERT_EQ(chip8::GetVariantFromExtension("roms/pong.ch8"),
+            chip8::Variant::kChip8);
+  ASSERT_EQ(chip8::GetVariantFromExtension("PONG.C8"), chip8::Variant::kChip8);
+  ASSERT_EQ(chip8::GetVariantFromExtension("car.sc8"),
+            chip8::Variant::kSuperChip);
+  ASSERT_EQ(chip8::GetVariantFromExtension("Octo.XO8"),
+            chip8::Variant::kXoChip);
+
+  ASSERT_FALSE(chip8::GetVariantFromExtension("readme.txt").has_value());
+  ASSERT_FALSE(chip8::GetVariantFromExtension("ch8").has_value());
+}
+
+TEST(Rom, LoadsIntoInternalMemory) {
+  const auto path = WriteRomFile(4);
+
+  chip8::Rom rom;
+  ASSERT_EQ(chip8::LoadRom(path, rom), chip8::RomLoadResult::kSuccess);
+
+  chip8::VMInstance vm_instance;
+  ASSERT_TRUE(vm_instance.LoadProgram(rom));
+
+  const auto* const program_area =
+      vm_instance.impl_->GetMemory() + chip8::memory_region::kProgramArea;
+
+  ASSERT_TRUE(std::equal(rom.data(), rom.data() + rom.size(), program_area));
+  std::filesystem::remove(path);
+}
+}  // namespace
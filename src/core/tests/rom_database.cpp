@@ -0,0 +1,151 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/analysis.h>
+#include <core/rom_database.h>
+#include <core/vm_instance.h>
+
+#include <array>
+
+#include "gtest/gtest.h"
+
+namespace {
+// $200: JP $200
+constexpr std::array<uint_fast8_t, 2> kProgram{0x12, 0x00};
+
+/// Builds a profile that differs from the default one in every way.
+///
+/// \param instructions_per_second The number of instructions per second.
+///
+/// \returns The profile.
+auto MakeProfile(const unsigned int instructions_per_second) noexcept
+    -> chip8::RomProfile {
+  chip8::RomProfile profile;
+
+  profile.instructions_per_second_ = instructions_per_second;
+  profile.quirks_.shift_uses_vy_ = true;
+  profile.quirks_.load_store_increments_i_ = true;
+  return profile;
+}
+
+TEST(RomDatabase, FindsBuiltInEntriesByHash) {
+  const std::array<chip8::RomDatabaseEntry, 3> entries{
+      {{0x10, "First", MakeProfile(100)},
+       {0x20, "Second", MakeProfile(200)},
+       {0x30, "Third", MakeProfile(300)}}};
+
+  const chip8::RomDatabase rom_database{entries.data(), entries.size()};
+
+  for (const auto& entry : entries) {
+    const auto profile = rom_database.FindBuiltInProfile(entry.hash_);
+
+    ASSERT_TRUE(profile.has_value());
+    ASSERT_EQ(profile->instructions_per_second_,
+              entry.profile_.instructions_per_second_);
+    ASSERT_EQ(profile->quirks_, entry.profile_.quirks_);
+  }
+
+  ASSERT_FALSE(rom_database.FindBuiltInProfile(0x00).has_value());
+  ASSERT_FALSE(rom_database.FindBuiltInProfile(0x25).has_value());
+  ASSERT_FALSE(rom_database.FindBuiltInProfile(0x40).has_value());
+}
+
+TEST(RomDatabase, UnknownProgramsGetDefaultProfile) {
+  const chip8::RomDatabase rom_database{nullptr, 0};
+  const auto profile = rom_database.Lookup(kProgram.data(), kProgram.size());
+
+  ASSERT_EQ(profile.instructions_per_second_, 0);
+  ASSERT_EQ(profile.quirks_, chip8::Quirks{});
+  ASSERT_EQ(profile.variant_, chip8::Variant::kChip8);
+}
+
+TEST(RomDatabase, OverridesTakePrecedence) {
+  const auto hash =
+      chip8::analysis::HashProgram(kProgram.data(), kProgram.size());
+
+  const std::array<chip8::RomDatabaseEntry, 1> entries{
+      {{hash, "Program", MakeProfile(100)}}};
+
+  chip8::RomDatabase rom_database{entries.data(), entries.size()};
+  ASSERT_EQ(rom_database.Lookup(hash).instructions_per_second_, 100);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  rom_database.SetOverride(hash, MakeProfile(700));
+  ASSERT_EQ(rom_database.Lookup(kProgram.data(), kProgram.size())
+                .instructions_per_second_,
+            700);
+
+  // The built-in entry is still there underneath.
+  ASSERT_EQ(rom_database.FindBuiltInProfile(hash)->instructions_per_second_,
+            100);
+
+  rom_database.ClearOverride(hash);
+  ASSERT_EQ(rom_database.Lookup(hash).instructions_per_second_, 100);
+}
+
+TEST(RomDatabase, LoadingProgramAppliesProfile) {
+  auto& rom_database = chip8::RomDatabase::Get();
+  const auto hash =
+      chip8::analysis::HashProgram(kProgram.data(), kProgram.size());
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  rom_database.SetOverride(hash, MakeProfile(600));
+
+  chip8::VMInstance vm_instance;
+  ASSERT_TRUE(vm_instance.LoadProgram(kProgram));
+
+  ASSERT_EQ(vm_instance.GetRomProfile().instructions_per_second_, 600);
+  ASSERT_EQ(vm_instance.impl_->quirks_, MakeProfile(600).quirks_);
+
+  // 600 instructions per second at 60 frames per second.
+  vm_instance.RunForOneFrame();
+  ASSERT_EQ(vm_instance.GetNumberOfStepsExecuted(), 10);
+
+  // Without a profile, the number of instructions per second set by the
+  // frontend applies again.
+  rom_database.ClearOverrides();
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  ASSERT_TRUE(vm_instance.SetTiming(120, 60.0));
+  ASSERT_TRUE(vm_instance.LoadProgram(kProgram));
+
+  ASSERT_EQ(vm_instance.impl_->quirks_, chip8::Quirks{});
+  vm_instance.RunForOneFrame();
+  ASSERT_EQ(vm_instance.GetNumberOfStepsExecuted(), 2);
+}
+
+TEST(RomDatabase, UnknownProgramsGetDefaultVariant) {
+  auto& rom_database = chip8::RomDatabase::Get();
+  const auto hash =
+      chip8::analysis::HashProgram(kProgram.data(), kProgram.size());
+
+  chip8::VMInstance vm_instance;
+  vm_instance.SetDefaultVariant(chip8::Variant::kXoChip);
+
+  ASSERT_TRUE(vm_instance.LoadProgram(kProgram));
+  ASSERT_EQ(vm_instance.GetRomProfile().variant_, chip8::Variant::kXoChip);
+  ASSERT_EQ(vm_instance.impl_->GetMemorySize(),
+            chip8::data_size::kXoChipInternalMemory);
+
+  // Programs the database knows keep their own variant.
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  rom_database.SetOverride(hash, MakeProfile(600));
+
+  ASSERT_TRUE(vm_instance.LoadProgram(kProgram));
+  ASSERT_EQ(vm_instance.GetRomProfile().variant_, chip8::Variant::kChip8);
+  ASSERT_EQ(vm_instance.impl_->GetMemorySize(),
+            chip8::data_size::kInternalMemory);
+
+  rom_database.ClearOverride(hash);
+}
+}  // namespace
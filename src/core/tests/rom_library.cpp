@@ -0,0 +1,204 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/analysis.h>
+#include <core/rom_library.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+namespace fs = std::filesystem;
+
+/// Gives every test an empty directory of its own to put ROM files in, since
+/// ctest may run tests in parallel.
+class RomLibraryTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* test_info =
+        ::testing::UnitTest::GetInstance()->current_test_info();
+
+    directory_ = fs::temp_directory_path() /
+                 (std::string{"vm_tutorial_core_rom_library_"} +
+                  test_info->name());
+    fs::remove_all(directory_);
+    fs::create_directories(directory_ / "subdirectory");
+  }
+
+  void TearDown() override { fs::remove_all(directory_); }
+
+  /// Writes a file to the directory.
+  ///
+  /// \param name The name of the file, relative to the directory.
+  /// \param data The contents of the file.
+  ///
+  /// \returns The path to the file.
+  auto WriteFile(const std::string& name,
+                 const std::vector<uint_fast8_t>& data) const -> std::string {
+    const auto path = directory_ / name;
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+
+    return path.string();
+  }
+
+  fs::path directory_;
+};
+
+// $200: LD I, $000
+// $202: DRW V0, V0, 5
+// $204: JP $204
+const std::vector<uint_fast8_t> kDrawZero = {0xA0, 0x00, 0xD0,
+                                             0x05, 0x12, 0x04};
+
+// $200: JP $200
+const std::vector<uint_fast8_t> kLoop = {0x12, 0x00};
+
+TEST_F(RomLibraryTest, IndexesRomFiles) {
+  const auto draw_zero = WriteFile("draw_zero.ch8", kDrawZero);
+  const auto loop = WriteFile("subdirectory/LOOP.C8", kLoop);
+
+  WriteFile("readme.txt", kLoop);
+  WriteFile("too_large.ch8",
+            std::vector<uint_fast8_t>(
+                chip8::memory_region::kXoChipProgramAreaSize + 1));
+
+  chip8::RomLibrary library;
+  ASSERT_EQ(library.Scan(directory_.string()), 2);
+  ASSERT_EQ(library.entries_.size(), 2);
+
+  const auto& entry = library.entries_[0];
+  ASSERT_EQ(entry.path_, draw_zero);
+  ASSERT_EQ(entry.size_, kDrawZero.size());
+  ASSERT_EQ(entry.hash_, chip8::analysis::HashProgram(kDrawZero.data(),
+                                                      kDrawZero.size()));
+  ASSERT_EQ(entry.num_blocks_, 2);
+  ASSERT_EQ(entry.num_subroutines_, 1);
+  ASSERT_EQ(entry.num_indirect_jumps_, 0);
+  ASSERT_EQ(entry.code_size_, kDrawZero.size());
+
+  // The top left corner shows the "0" sprite of the font.
+  ASSERT_TRUE(entry.IsPixelOn(0, 0));
+  ASSERT_TRUE(entry.IsPixelOn(3, 0));
+  ASSERT_TRUE(entry.IsPixelOn(0, 1));
+  ASSERT_FALSE(entry.IsPixelOn(1, 1));
+  ASSERT_FALSE(entry.IsPixelOn(4, 0));
+
+  ASSERT_EQ(library.entries_[1].path_, loop);
+}
+
+TEST_F(RomLibraryTest, TakesVariantFromExtension) {
+  // Too large for the classic program area, so only an XO-CHIP program can
+  // be loaded.
+  auto large = kLoop;
+  large.resize(chip8::memory_region::kProgramAreaSize + 2);
+
+  const auto large_xo_chip = WriteFile("large.xo8", large);
+  const auto loop = WriteFile("loop.sc8", kLoop);
+  WriteFile("large.ch8", large);
+
+  chip8::RomLibrary library;
+  ASSERT_EQ(library.Scan(directory_.string()), 2);
+  ASSERT_EQ(library.entries_.size(), 2);
+
+  ASSERT_EQ(library.entries_[0].path_, large_xo_chip);
+  ASSERT_EQ(library.entries_[0].size_, large.size());
+  ASSERT_EQ(library.entries_[1].path_, loop);
+}
+
+TEST_F(RomLibraryTest, RescansIncrementally) {
+  WriteFile("draw_zero.ch8", kDrawZero);
+  const auto loop = WriteFile("loop.ch8", kLoop);
+
+  chip8::RomLibrary library;
+  ASSERT_EQ(library.Scan(directory_.string()), 2);
+
+  // Nothing changed.
+  ASSERT_EQ(library.Scan(directory_.string()), 0);
+  ASSERT_EQ(library.entries_.size(), 2);
+
+  WriteFile("loop.ch8", kDrawZero);
+  fs::remove(directory_ / "draw_zero.ch8");
+
+  ASSERT_EQ(library.Scan(directory_.string()), 1);
+  ASSERT_EQ(library.entries_.size(), 1);
+  ASSERT_EQ(library.entries_[0].path_, loop);
+  ASSERT_EQ(library.entries_[0].size_, kDrawZero.size());
+}
+
+TEST_F(RomLibraryTest, KeepsIndexIfDirectoryIsMissing) {
+  WriteFile("loop.ch8", kLoop);
+
+  chip8::RomLibrary library;
+  library.Scan(directory_.string());
+
+  ASSERT_EQ(library.Scan((directory_ / "missing").string()), 0);
+  ASSERT_EQ(library.entries_.size(), 1);
+}
+
+TEST_F(RomLibraryTest, StopsWhenCancelled) {
+  WriteFile("loop.ch8", kLoop);
+
+  chip8::RomLibrary library;
+
+  ASSERT_EQ(library.Scan(directory_.string(), []() { return true; }), 0);
+  ASSERT_TRUE(library.entries_.empty());
+}
+
+TEST_F(RomLibraryTest, SavesAndLoadsCache) {
+  WriteFile("draw_zero.ch8", kDrawZero);
+  WriteFile("loop.ch8", kLoop);
+
+  chip8::RomLibrary library;
+  library.Scan(directory_.string());
+
+  const auto cache_file = (directory_ / "library.cache").string();
+  ASSERT_TRUE(library.Save(cache_file));
+
+  chip8::RomLibrary loaded_library;
+  ASSERT_TRUE(loaded_library.Load(cache_file));
+  ASSERT_EQ(loaded_library.entries_.size(), library.entries_.size());
+
+  for (size_t index = 0; index < library.entries_.size(); ++index) {
+    const auto& expected = library.entries_[index];
+    const auto& actual = loaded_library.entries_[index];
+
+    ASSERT_EQ(actual.path_, expected.path_);
+    ASSERT_EQ(actual.modified_time_, expected.modified_time_);
+    ASSERT_EQ(actual.size_, expected.size_);
+    ASSERT_EQ(actual.hash_, expected.hash_);
+    ASSERT_EQ(actual.thumbnail_, expected.thumbnail_);
+    ASSERT_EQ(actual.num_blocks_, expected.num_blocks_);
+    ASSERT_EQ(actual.code_size_, expected.code_size_);
+  }
+
+  // The loaded index is up to date with the directory.
+  ASSERT_EQ(loaded_library.Scan(directory_.string()), 0);
+}
+
+TEST_F(RomLibraryTest, RejectsInvalidCache) {
+  const auto cache_file = WriteFile("library.cache", kLoop);
+
+  chip8::RomLibrary library;
+  ASSERT_FALSE(library.Load(cache_file));
+  ASSERT_TRUE(library.entries_.empty());
+
+  ASSERT_FALSE(library.Load((directory_ / "missing.cache").string()));
+}
+}  // namespace
@@ -0,0 +1,166 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include <core/snapshot.h>
+#include <core/vm_instance.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace {
+TEST(SnapshotBuffer, AcquiresEachSnapshotOnce) {
+  chip8::VMInstance vm_instance;
+  chip8::SnapshotBuffer snapshot_buffer;
+
+  ASSERT_EQ(snapshot_buffer.Acquire(), nullptr);
+
+  vm_instance.impl_->V_[0xA] = 0x12;
+  vm_instance.impl_->GetMemory()[0x300] = 0x34;
+  vm_instance.impl_->program_counter_ = 0x246;
+  vm_instance.impl_->stack_[1] = 0x202;
+  vm_instance.impl_->stack_pointer_ = 1;
+  vm_instance.impl_->delay_timer_ = 0x56;
+  vm_instance.impl_->sound_timer_ = 0x78;
+  vm_instance.impl_->I_ = 0x9AB;
+
+  snapshot_buffer.Publish(*vm_instance.impl_);
+
+  const auto* snapshot = snapshot_buffer.Acquire();
+  ASSERT_NE(snapshot, nullptr);
+
+  ASSERT_EQ(snapshot->V_, vm_instance.impl_->V_);
+  ASSERT_EQ(snapshot->memory_.size(), vm_instance.impl_->GetMemorySize());
+  ASSERT_TRUE(std::equal(snapshot->memory_.cbegin(), snapshot->memory_.cend(),
+                         vm_instance.impl_->GetMemory()));
+  ASSERT_EQ(snapshot->program_counter_, 0x246);
+  ASSERT_EQ(snapshot->stack_, vm_instance.impl_->stack_);
+  ASSERT_EQ(snapshot->stack_pointer_, 1);
+  ASSERT_EQ(snapshot->delay_timer_, 0x56);
+  ASSERT_EQ(snapshot->sound_timer_, 0x78);
+  ASSERT_EQ(snapshot->I_, 0x9AB);
+
+  ASSERT_EQ(snapshot_buffer.Acquire(), nullptr);
+}
+
+TEST(SnapshotBuffer, CopiesBreakpoints) {
+  chip8::VMInstance vm_instance;
+  chip8::SnapshotBuffer snapshot_buffer;
+
+  vm_instance.breakpoints_.push_back(
+      {0x204, chip8::VMInstance::BreakpointFlags::kPreserve});
+  vm_instance.breakpoints_.push_back(
+      {0x20A, chip8::VMInstance::BreakpointFlags::kClearAfterTrigger});
+
+  snapshot_buffer.Publish(vm_instance);
+
+  // The virtual machine may clear its breakpoints while the snapshot is read.
+  vm_instance.breakpoints_.clear();
+
+  const auto* snapshot = snapshot_buffer.Acquire();
+  ASSERT_NE(snapshot, nullptr);
+
+  ASSERT_EQ(snapshot->breakpoints_.size(), 2);
+  ASSERT_TRUE(snapshot->HasBreakpoint(0x204));
+  ASSERT_TRUE(snapshot->HasBreakpoint(0x20A));
+  ASSERT_FALSE(snapshot->HasBreakpoint(0x206));
+
+  // Snapshots of an implementation alone have no breakpoints, even when the
+  // buffer they're written to held some before.
+  for (auto index = 0; index < 3; ++index) {
+    snapshot_buffer.Publish(*vm_instance.impl_);
+  }
+  ASSERT_TRUE(snapshot_buffer.Acquire()->breakpoints_.empty());
+}
+
+TEST(SnapshotBuffer, KeepsOnlyMostRecentSnapshot) {
+  chip8::VMInstance vm_instance;
+  chip8::SnapshotBuffer snapshot_buffer;
+
+  for (auto value = 1U; value <= 5; ++value) {
+    vm_instance.impl_->V_[0] = value;
+    snapshot_buffer.Publish(*vm_instance.impl_);
+  }
+
+  const auto* snapshot = snapshot_buffer.Acquire();
+  ASSERT_NE(snapshot, nullptr);
+  ASSERT_EQ(snapshot->V_[0], 5);
+  ASSERT_EQ(snapshot_buffer.Acquire(), nullptr);
+}
+
+TEST(SnapshotBuffer, LeavesAcquiredSnapshotUntouched) {
+  chip8::VMInstance vm_instance;
+  chip8::SnapshotBuffer snapshot_buffer;
+
+  vm_instance.impl_->V_[0] = 1;
+  snapshot_buffer.Publish(*vm_instance.impl_);
+
+  const auto* snapshot = snapshot_buffer.Acquire();
+  ASSERT_NE(snapshot, nullptr);
+
+  // The producer cycles through every other snapshot in the meantime.
+  for (auto value = 2U; value <= 5; ++value) {
+    vm_instance.impl_->V_[0] = value;
+    snapshot_buffer.Publish(*vm_instance.impl_);
+  }
+  ASSERT_EQ(snapshot->V_[0], 1);
+
+  snapshot = snapshot_buffer.Acquire();
+  ASSERT_NE(snapshot, nullptr);
+  ASSERT_EQ(snapshot->V_[0], 5);
+}
+
+TEST(SnapshotBuffer, TransfersConsistentSnapshotsBetweenThreads) {
+  chip8::VMInstance vm_instance;
+  chip8::SnapshotBuffer snapshot_buffer;
+  constexpr auto kNumSnapshots = 10000U;
+
+  std::thread producer([&vm_instance, &snapshot_buffer]() {
+    for (auto index = 1U; index <= kNumSnapshots; ++index) {
+      auto& impl = *vm_instance.impl_;
+
+      impl.V_.fill(index & 0xFF);
+      std::fill_n(impl.GetMemory(), impl.GetMemorySize(), index & 0xFF);
+      impl.program_counter_ = index;
+
+      snapshot_buffer.Publish(impl);
+    }
+  });
+
+  // Every snapshot must be in one piece, and newer than the one before.
+  size_t last_index = 0;
+
+  while (last_index != kNumSnapshots) {
+    const auto* snapshot = snapshot_buffer.Acquire();
+
+    if (!snapshot) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const auto index = snapshot->program_counter_;
+    ASSERT_GT(index, last_index);
+
+    const auto value = index & 0xFF;
+
+    ASSERT_TRUE(std::all_of(snapshot->V_.cbegin(), snapshot->V_.cend(),
+                            [value](const auto v) { return v == value; }));
+    ASSERT_TRUE(std::all_of(snapshot->memory_.cbegin(),
+                            snapshot->memory_.cend(),
+                            [value](const auto v) { return v == value; }));
+    last_index = index;
+  }
+  producer.join();
+}
+}  // namespace
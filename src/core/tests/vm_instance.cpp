@@ -12,6 +12,8 @@
 
 #include <core/vm_instance.h>
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace {
@@ -28,10 +30,8 @@ TEST(VMInstance, LoadsProgramSuccessfully) {
 
   // Now verify that the program code made it into the implementation.
   ASSERT_TRUE(std::equal(
-      chip8_vm.impl_->memory_.cbegin() + chip8::memory_region::kProgramArea,
-      chip8_vm.impl_->memory_.cbegin() + chip8::memory_region::kProgramArea +
-          program_data.size(),
-      program_data.cbegin()));
+      program_data.cbegin(), program_data.cend(),
+      chip8_vm.impl_->GetMemory() + chip8::memory_region::kProgramArea));
 }
 
 TEST(VMInstance, RejectsLargeProgram) {
@@ -46,4 +46,455 @@ TEST(VMInstance, RejectsLargeProgram) {
   // a program.
   ASSERT_FALSE(chip8_vm.LoadProgram(program_data));
 }
+
+TEST(VMInstance, PicksImplementationByVariant) {
+  chip8::VMInstance chip8_vm;
+  ASSERT_EQ(chip8_vm.impl_->GetMemorySize(), chip8::data_size::kInternalMemory);
+
+  // Too large for CHIP-8, but not for XO-CHIP.
+  constexpr auto kProgramSize = 8192;
+  const std::vector<uint_fast8_t> program_data(kProgramSize, 0x12);
+
+  const auto hash = chip8::analysis::HashProgram(program_data.data(),
+                                                 program_data.size());
+
+  auto& rom_database = chip8::RomDatabase::Get();
+  ASSERT_FALSE(chip8_vm.LoadProgram(program_data));
+
+  chip8::RomProfile profile;
+  profile.variant_ = chip8::Variant::kXoChip;
+  rom_database.SetOverride(hash, profile);
+
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+  ASSERT_EQ(chip8_vm.impl_->GetMemorySize(),
+            chip8::data_size::kXoChipInternalMemory);
+  ASSERT_EQ(chip8_vm.impl_->variant_, chip8::Variant::kXoChip);
+  ASSERT_EQ(chip8_vm.impl_->GetMemory()[chip8::memory_region::kProgramArea +
+                                        kProgramSize - 1],
+            0x12);
+
+  rom_database.ClearOverride(hash);
+
+  // Classic programs go back to the 4 KB implementation.
+  constexpr std::array<uint_fast8_t, 2> classic_program{0x12, 0x00};
+  ASSERT_TRUE(chip8_vm.LoadProgram(classic_program));
+  ASSERT_EQ(chip8_vm.impl_->GetMemorySize(), chip8::data_size::kInternalMemory);
+}
+
+TEST(VMInstance, CreatesImplementationsThroughFactory) {
+  chip8::VMInstance chip8_vm;
+
+  std::vector<chip8::Variant> variants;
+
+  chip8_vm.SetImplementationFactory([&variants](const chip8::Variant variant) {
+    variants.push_back(variant);
+    return chip8::VMInstance::MakeInterpreter(variant);
+  });
+
+  // Every program gets a fresh implementation, even of the same size.
+  constexpr std::array<uint_fast8_t, 2> program_data{0x12, 0x00};
+  const auto* const original_impl = chip8_vm.impl_.get();
+
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+  ASSERT_NE(chip8_vm.impl_.get(), original_impl);
+  ASSERT_EQ(variants, std::vector<chip8::Variant>{chip8::Variant::kChip8});
+
+  // Implementations that can't hold the program are turned down, and the
+  // current one is kept.
+  const auto* const loaded_impl = chip8_vm.impl_.get();
+  chip8_vm.SetImplementationFactory(
+      [](chip8::Variant) -> std::unique_ptr<chip8::ImplementationInterface> {
+        return nullptr;
+      });
+
+  ASSERT_FALSE(chip8_vm.LoadProgram(program_data));
+  ASSERT_EQ(chip8_vm.impl_.get(), loaded_impl);
+
+  chip8_vm.SetImplementationFactory(nullptr);
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+  ASSERT_EQ(chip8_vm.impl_.get(), loaded_impl);
+}
+
+TEST(VMInstance, StopsFrameWhenWaitingForKeyPressByDefault) {
+  chip8::VMInstance chip8_vm;
+
+  // LD V0, K
+  constexpr std::array<uint_fast8_t, 2> program_data{0xF0, 0x0A};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  ASSERT_EQ(chip8_vm.GetKeyWaitMode(),
+            chip8::VMInstance::KeyWaitMode::kStopExecution);
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kHaltUntilKeyPress);
+}
+
+TEST(VMInstance, KeepsTimersAndScreenRunningWhileIdlingForKeyPress) {
+  chip8::VMInstance chip8_vm;
+  chip8_vm.SetKeyWaitMode(chip8::VMInstance::KeyWaitMode::kIdle);
+
+  auto num_screen_updates = 0;
+  chip8_vm.update_screen_func_ =
+      [&num_screen_updates](const chip8::Screen&) { num_screen_updates++; };
+
+  // LD V0, K
+  constexpr std::array<uint_fast8_t, 2> program_data{0xF0, 0x0A};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  constexpr auto kDelayTimerValue = 10;
+  chip8_vm.impl_->delay_timer_ = kDelayTimerValue;
+
+  constexpr auto kNumFrames = 3;
+
+  for (auto frame = 0; frame < kNumFrames; ++frame) {
+    ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+  }
+
+  // We're still waiting, and haven't gone past the instruction that started
+  // the wait...
+  ASSERT_TRUE(chip8_vm.impl_->IsHaltedUntilKeyPress());
+  ASSERT_EQ(chip8_vm.impl_->program_counter_,
+            chip8::memory_region::kProgramArea +
+                chip8::data_size::kInstructionLength);
+
+  // ...but the delay timer has ticked once per frame, and every frame has been
+  // presented.
+  ASSERT_EQ(chip8_vm.impl_->delay_timer_, kDelayTimerValue - kNumFrames);
+  ASSERT_EQ(num_screen_updates, kNumFrames);
+}
+
+TEST(VMInstance, DoesNotCheckBreakpointsWhileIdlingForKeyPress) {
+  chip8::VMInstance chip8_vm;
+  chip8_vm.SetKeyWaitMode(chip8::VMInstance::KeyWaitMode::kIdle);
+
+  // LD V0, K
+  // JP $202
+  constexpr std::array<uint_fast8_t, 4> program_data{0xF0, 0x0A, 0x12, 0x02};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  constexpr auto kBreakpointAddress = chip8::memory_region::kProgramArea +
+                                      chip8::data_size::kInstructionLength;
+
+  chip8_vm.breakpoints_.push_back(
+      {kBreakpointAddress, chip8::VMInstance::BreakpointFlags::kPreserve});
+
+  // The program counter sits on the breakpoint while we wait, but we're not
+  // executing anything.
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+
+  // Once a key has been pressed, execution continues and the breakpoint is
+  // hit right away.
+  chip8_vm.impl_->SetKeyState(chip8::Key::k5, chip8::KeyState::kPressed);
+
+  ASSERT_EQ(chip8_vm.impl_->V_[0], chip8::Key::k5);
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kBreakpointReached);
+}
+
+TEST(VMInstance, AppliesQueuedKeyStateBeforeNextInstruction) {
+  chip8::VMInstance chip8_vm;
+
+  auto num_latency_reports = 0;
+  chip8_vm.input_latency_func_ =
+      [&num_latency_reports](const std::chrono::nanoseconds latency) {
+        ASSERT_GE(latency.count(), 0);
+        num_latency_reports++;
+      };
+
+  // SKP V0
+  constexpr std::array<uint_fast8_t, 2> program_data{0xE0, 0x9E};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  chip8_vm.impl_->V_[0] = chip8::Key::kA;
+  ASSERT_TRUE(
+      chip8_vm.QueueKeyState(chip8::Key::kA, chip8::KeyState::kPressed));
+
+  // Nothing happens until the virtual machine gets around to it...
+  ASSERT_EQ(chip8_vm.impl_->keypad_[chip8::Key::kA],
+            chip8::KeyState::kReleased);
+
+  // ...which is right before the next instruction, so the key press is seen
+  // and the next instruction is skipped.
+  ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(chip8_vm.impl_->keypad_[chip8::Key::kA], chip8::KeyState::kPressed);
+  ASSERT_EQ(chip8_vm.impl_->program_counter_,
+            chip8::memory_region::kProgramArea +
+                (chip8::data_size::kInstructionLength * 2));
+  ASSERT_EQ(num_latency_reports, 1);
+}
+
+TEST(VMInstance, QueuedKeyPressEndsIdleWait) {
+  chip8::VMInstance chip8_vm;
+  chip8_vm.SetKeyWaitMode(chip8::VMInstance::KeyWaitMode::kIdle);
+
+  // LD V0, K
+  // JP $202
+  constexpr std::array<uint_fast8_t, 4> program_data{0xF0, 0x0A, 0x12, 0x02};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+  ASSERT_TRUE(chip8_vm.impl_->IsHaltedUntilKeyPress());
+
+  ASSERT_TRUE(
+      chip8_vm.QueueKeyState(chip8::Key::k3, chip8::KeyState::kPressed));
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+
+  ASSERT_FALSE(chip8_vm.impl_->IsHaltedUntilKeyPress());
+  ASSERT_EQ(chip8_vm.impl_->V_[0], chip8::Key::k3);
+}
+
+TEST(VMInstance, TracesKeyPressUntilFrameIsDrawnTo) {
+  chip8::VMInstance chip8_vm;
+
+  std::vector<chip8::InputTrace> traces;
+  chip8_vm.input_trace_func_ = [&traces](const chip8::InputTrace& trace) {
+    traces.push_back(trace);
+  };
+
+  // $200: SKP V0
+  // $202: JP $200
+  // $204: DRW V0, V0, 1
+  // $206: JP $206
+  constexpr std::array<uint_fast8_t, 8> program_data{0xE0, 0x9E, 0x12, 0x00,
+                                                     0xD0, 0x01, 0x12, 0x06};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  chip8_vm.impl_->V_[0] = chip8::Key::kA;
+
+  const auto reported = chip8::InputEvent::Clock::now();
+  ASSERT_TRUE(chip8_vm.QueueKeyState(chip8::Key::kA,
+                                     chip8::KeyState::kPressed, reported));
+
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(traces.size(), 1);
+
+  const auto& trace = traces.front();
+
+  ASSERT_EQ(trace.key_, chip8::Key::kA);
+  ASSERT_EQ(trace.state_, chip8::KeyState::kPressed);
+  ASSERT_EQ(trace.reported_, reported);
+  ASSERT_LE(trace.reported_, trace.applied_);
+  ASSERT_LE(trace.applied_, trace.observed_);
+  ASSERT_LE(trace.observed_, trace.frame_sent_);
+}
+
+TEST(VMInstance, DoesNotTraceUnobservedKeyStateChanges) {
+  chip8::VMInstance chip8_vm;
+
+  auto num_traces = 0;
+  chip8_vm.input_trace_func_ = [&num_traces](const chip8::InputTrace&) {
+    num_traces++;
+  };
+
+  // DRW V0, V0, 1
+  // JP $200
+  constexpr std::array<uint_fast8_t, 4> program_data{0xD0, 0x01, 0x12, 0x00};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  ASSERT_TRUE(
+      chip8_vm.QueueKeyState(chip8::Key::k1, chip8::KeyState::kPressed));
+
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(num_traces, 0);
+}
+
+TEST(VMInstance, KeyPressEndingIdleWaitIsObservedWhenApplied) {
+  chip8::VMInstance chip8_vm;
+  chip8_vm.SetKeyWaitMode(chip8::VMInstance::KeyWaitMode::kIdle);
+
+  std::vector<chip8::InputTrace> traces;
+  chip8_vm.input_trace_func_ = [&traces](const chip8::InputTrace& trace) {
+    traces.push_back(trace);
+  };
+
+  // $200: LD V0, K
+  // $202: DRW V0, V0, 1
+  // $204: JP $204
+  constexpr std::array<uint_fast8_t, 6> program_data{0xF0, 0x0A, 0xD0,
+                                                     0x01, 0x12, 0x04};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+  ASSERT_TRUE(chip8_vm.impl_->IsHaltedUntilKeyPress());
+
+  ASSERT_TRUE(
+      chip8_vm.QueueKeyState(chip8::Key::k7, chip8::KeyState::kPressed));
+  ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+
+  ASSERT_EQ(traces.size(), 1);
+  ASSERT_EQ(traces.front().key_, chip8::Key::k7);
+  ASSERT_EQ(traces.front().applied_, traces.front().observed_);
+}
+
+TEST(VMInstance, CarriesFractionalStepsOverToNextFrame) {
+  chip8::VMInstance chip8_vm;
+
+  auto num_screen_updates = 0;
+  chip8_vm.update_screen_func_ =
+      [&num_screen_updates](const chip8::Screen&) { num_screen_updates++; };
+
+  // 3.75 steps per frame.
+  constexpr auto kInstructionsPerSecond = 150;
+  constexpr auto kFrameRate = 40.0;
+  ASSERT_TRUE(chip8_vm.SetTiming(kInstructionsPerSecond, kFrameRate));
+  ASSERT_DOUBLE_EQ(chip8_vm.GetFrameRate(), kFrameRate);
+
+  // JP $200
+  constexpr std::array<uint_fast8_t, 2> program_data{0x12, 0x00};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  // Frames take 3, 4, 4 and 4 steps, and each one is presented exactly once.
+  constexpr auto kNumFrames = 4;
+
+  for (auto frame = 0; frame < kNumFrames; ++frame) {
+    ASSERT_EQ(chip8_vm.RunForOneFrame(), chip8::StepResult::kSuccess);
+    ASSERT_EQ(num_screen_updates, frame + 1);
+  }
+  ASSERT_EQ(chip8_vm.GetNumberOfStepsExecuted(), 15);
+}
+
+TEST(VMInstance, SwitchesBeeperWithSoundTimer) {
+  chip8::VMInstance chip8_vm;
+
+  std::vector<bool> beeper_states;
+  chip8_vm.beeper_func_ = [&beeper_states](const bool beeper_on) {
+    beeper_states.push_back(beeper_on);
+  };
+
+  // LD V0, $02
+  // LD ST, V0
+  // JP $204
+  constexpr std::array<uint_fast8_t, 6> program_data{0x60, 0x02, 0xF0,
+                                                     0x18, 0x12, 0x04};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  // The beeper goes on as soon as the sound timer is set, not on the next
+  // timer tick.
+  ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+  ASSERT_FALSE(chip8_vm.IsBeeperOn());
+  ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+  ASSERT_TRUE(chip8_vm.IsBeeperOn());
+  ASSERT_EQ(beeper_states, std::vector<bool>{true});
+
+  // The timers tick every 8 steps, so the sound timer reaches zero on the 16th
+  // step, and not a step sooner.
+  constexpr auto kStepsUntilSilence = 16;
+
+  while (chip8_vm.GetNumberOfStepsExecuted() < (kStepsUntilSilence - 1)) {
+    ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+    ASSERT_TRUE(chip8_vm.IsBeeperOn());
+  }
+
+  ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+  ASSERT_FALSE(chip8_vm.IsBeeperOn());
+  ASSERT_EQ(beeper_states, (std::vector<bool>{true, false}));
+}
+
+TEST(VMInstance, SwitchesBeeperOffOnReset) {
+  chip8::VMInstance chip8_vm;
+
+  auto beeper_on = false;
+  chip8_vm.beeper_func_ = [&beeper_on](const bool on) { beeper_on = on; };
+
+  // LD V0, $FF
+  // LD ST, V0
+  constexpr std::array<uint_fast8_t, 4> program_data{0x60, 0xFF, 0xF0, 0x18};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+  ASSERT_EQ(chip8_vm.Step(), chip8::StepResult::kSuccess);
+  ASSERT_TRUE(beeper_on);
+
+  chip8_vm.Reset();
+  ASSERT_FALSE(beeper_on);
+  ASSERT_FALSE(chip8_vm.IsBeeperOn());
+}
+TEST(VMInstance, HashesSameStateAlike) {
+  // $200: LD V0, $05
+  // $202: LD F, V0
+  // $204: DRW V0, V0, 5
+  // $206: JP $206
+  constexpr std::array<uint_fast8_t, 8> program_data{0x60, 0x05, 0xF0, 0x29,
+                                                     0xD0, 0x05, 0x12, 0x06};
+
+  chip8::VMInstance first_vm;
+  chip8::VMInstance second_vm;
+
+  ASSERT_TRUE(first_vm.LoadProgram(program_data));
+  ASSERT_TRUE(second_vm.LoadProgram(program_data));
+  ASSERT_EQ(first_vm.GetStateHash(), second_vm.GetStateHash());
+
+  // Every instruction changes something, be it a register or the screen.
+  for (auto step = 0; step < 3; ++step) {
+    const auto hash = first_vm.GetStateHash();
+
+    ASSERT_EQ(first_vm.Step(), chip8::StepResult::kSuccess);
+    ASSERT_NE(first_vm.GetStateHash(), hash);
+
+    ASSERT_EQ(second_vm.Step(), chip8::StepResult::kSuccess);
+    ASSERT_EQ(first_vm.GetStateHash(), second_vm.GetStateHash());
+  }
+}
+
+TEST(VMInstance, HashesMemoryIncrementally) {
+  // $200: LD I, $300
+  // $202: ADD V0, $11
+  // $204: LD [I], V7
+  // $206: JP $202
+  //
+  // I is incremented after every store, so every page from $300 onwards ends
+  // up written to.
+  constexpr std::array<uint_fast8_t, 8> program_data{0xA3, 0x00, 0x70, 0x11,
+                                                     0xF7, 0x55, 0x12, 0x02};
+
+  const auto hash = chip8::analysis::HashProgram(program_data.data(),
+                                                 program_data.size());
+
+  chip8::RomProfile profile;
+  profile.quirks_.load_store_increments_i_ = true;
+
+  auto& rom_database = chip8::RomDatabase::Get();
+  rom_database.SetOverride(hash, profile);
+
+  chip8::VMInstance incremental_vm;
+  chip8::VMInstance full_vm;
+
+  ASSERT_TRUE(incremental_vm.LoadProgram(program_data));
+  ASSERT_TRUE(full_vm.LoadProgram(program_data));
+
+  rom_database.ClearOverride(hash);
+
+  // One virtual machine hashes after every step, only hashing the pages
+  // written to since. The other hashes every page at the very end.
+  constexpr auto kNumSteps = 600;
+
+  for (auto step = 0; step < kNumSteps; ++step) {
+    ASSERT_EQ(incremental_vm.Step(), chip8::StepResult::kSuccess);
+    static_cast<void>(incremental_vm.GetStateHash());
+
+    ASSERT_EQ(full_vm.Step(), chip8::StepResult::kSuccess);
+  }
+
+  ASSERT_EQ(incremental_vm.GetStateHash(), full_vm.GetStateHash());
+}
+
+TEST(VMInstance, HashesMemoryWrittenFromOutside) {
+  chip8::VMInstance chip8_vm;
+
+  constexpr std::array<uint_fast8_t, 2> program_data{0x12, 0x00};
+  ASSERT_TRUE(chip8_vm.LoadProgram(program_data));
+
+  const auto original_hash = chip8_vm.GetStateHash();
+
+  constexpr auto kAddress = 0xE00;
+  auto* const memory = chip8_vm.impl_->GetMemory();
+
+  memory[kAddress] = 0xAA;
+  chip8_vm.impl_->MarkMemoryDirty(kAddress, 1);
+
+  ASSERT_NE(chip8_vm.GetStateHash(), original_hash);
+
+  memory[kAddress] = 0x00;
+  chip8_vm.impl_->MarkMemoryDirty(kAddress, 1);
+
+  ASSERT_EQ(chip8_vm.GetStateHash(), original_hash);
+}
 }  // namespace
\ No newline at end of file
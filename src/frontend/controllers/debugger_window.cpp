@@ -17,20 +17,31 @@
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QMessageBox>
+#include <algorithm>
+
+DebuggerWindowController::DebuggerWindowController(VMThread& vm_thread) noexcept
+    : vm_thread_(vm_thread), vm_instance_(vm_thread.vm_instance_) {
+  // The models size themselves after the memory of the snapshot, so it has to
+  // match the virtual machine before they're built. While it runs, only the
+  // size is taken here; the contents follow with the first published
+  // snapshot.
+  if (vm_thread_.IsRunning()) {
+    snapshot_.memory_.resize(vm_instance_.impl_->GetMemorySize());
+  } else {
+    snapshot_.Capture(vm_instance_);
+  }
+
+  disasm_model_ = new DebuggerDisasmModel(this, snapshot_);
+  registers_model_ = new DebuggerRegistersModel(this, snapshot_);
+  stack_model_ = new DebuggerStackModel(this, snapshot_);
 
-DebuggerWindowController::DebuggerWindowController(
-    chip8::VMInstance& vm_instance) noexcept
-    : vm_instance_(vm_instance),
-      disasm_model_(new DebuggerDisasmModel(this, vm_instance)),
-      registers_model_(new DebuggerRegistersModel(this, vm_instance)),
-      stack_model_(new DebuggerStackModel(this, vm_instance)) {
   view_.setupUi(this);
 
   view_.disasmView->setModel(disasm_model_);
   view_.registerView->setModel(registers_model_);
   view_.stackView->setModel(stack_model_);
 
-  view_.memoryView->SetData(vm_instance_.impl_->memory_);
+  view_.memoryView->SetData(snapshot_.memory_);
 
   ConnectSignalsToSlots();
   SetupFromAppSettings();
@@ -120,11 +131,59 @@ void DebuggerWindowController::EnableControls(const bool enabled) noexcept {
   view_.actionTrace->setEnabled(enabled);
 
   if (enabled) {
-    ScrollToAddress(vm_instance_.impl_->program_counter_);
+    // The virtual machine is paused, so it is safe to look at it directly.
+    refresh_timer_.stop();
+
+    CaptureSnapshot();
+    RefreshViews();
+
+    ScrollToAddress(snapshot_.program_counter_);
+  } else {
+    refresh_timer_.start();
   }
 }
 
+void DebuggerWindowController::CaptureSnapshot() noexcept {
+  const auto* memory = snapshot_.memory_.data();
+  const auto memory_size = snapshot_.memory_.size();
+
+  snapshot_.Capture(vm_instance_);
+  RebindMemoryView(memory, memory_size);
+}
+
+void DebuggerWindowController::PollSnapshot() noexcept {
+  const auto* snapshot = vm_thread_.AcquireSnapshot();
+
+  if (snapshot) {
+    const auto* memory = snapshot_.memory_.data();
+    const auto memory_size = snapshot_.memory_.size();
+
+    snapshot_ = *snapshot;
+    RebindMemoryView(memory, memory_size);
+    RefreshViews();
+  }
+}
+
+void DebuggerWindowController::RebindMemoryView(
+    const uint_fast8_t* memory, const size_t memory_size) noexcept {
+  // Loading a program of another variant changes the size of memory, and
+  // possibly where the snapshot stores it.
+  if ((snapshot_.memory_.data() != memory) ||
+      (snapshot_.memory_.size() != memory_size)) {
+    view_.memoryView->SetData(snapshot_.memory_);
+  }
+}
+
+void DebuggerWindowController::RefreshViews() noexcept {
+  disasm_model_->Refresh();
+  registers_model_->Refresh();
+  stack_model_->Refresh();
+  view_.memoryView->Refresh();
+}
+
 void DebuggerWindowController::ConnectSignalsToSlots() noexcept {
+  connect(&refresh_timer_, &QTimer::timeout, [this]() { PollSnapshot(); });
+
   connect(view_.actionPause_Continue, &QAction::triggered,
           [this]() { emit ToggleRunState(); });
 
@@ -135,7 +194,7 @@ void DebuggerWindowController::ConnectSignalsToSlots() noexcept {
 
     if (!indices.empty()) {
       vm_instance_.breakpoints_.push_back(
-          {indices[0].row() * 2,
+          {disasm_model_->GetAddressFromRow(indices[0].row()),
            chip8::VMInstance::BreakpointFlags::kClearAfterTrigger});
       emit ToggleRunState();
     }
@@ -143,7 +202,7 @@ void DebuggerWindowController::ConnectSignalsToSlots() noexcept {
 
   connect(view_.actionStep_Into, &QAction::triggered, [this]() {
     EnableControls(false);
-    const auto result = vm_instance_.Step();
+    emit Step(1);
 
     EnableControls(true);
     NotifyBreakpointHit(vm_instance_.impl_->program_counter_);
@@ -232,19 +291,31 @@ void DebuggerWindowController::ConnectSignalsToSlots() noexcept {
 
             if (bp) {
               vm_instance_.breakpoints_.erase(bp.value());
-              return;
+            } else {
+              vm_instance_.breakpoints_.push_back(
+                  {address, chip8::VMInstance::BreakpointFlags::kPreserve});
             }
 
-            vm_instance_.breakpoints_.push_back(
-                {address, chip8::VMInstance::BreakpointFlags::kPreserve});
+            // Breakpoints can only be toggled while the virtual machine is
+            // paused, so the snapshot is brought up to date directly.
+            CaptureSnapshot();
+            disasm_model_->Refresh();
           });
 }
 
 void DebuggerWindowController::SetupFromAppSettings() noexcept {
-  const auto font = AppSettingsModel().GetDebuggerFont();
+  AppSettingsModel app_settings;
+
+  const auto font = app_settings.GetDebuggerFont();
 
   view_.disasmView->setFont(font);
   view_.registerView->setFont(font);
   view_.stackView->setFont(font);
   view_.breakpointsWidget->setFont(font);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  constexpr auto kMillisecondsPerSecond = 1000;
+
+  const auto refresh_rate = std::max(app_settings.GetDebuggerRefreshRate(), 1);
+  refresh_timer_.setInterval(kMillisecondsPerSecond / refresh_rate);
 }
\ No newline at end of file
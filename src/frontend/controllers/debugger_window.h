@@ -13,9 +13,12 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QTimer>
 
 #include "../types.h"
+#include "../vm_thread.h"
 #include "core/impl.h"
+#include "core/snapshot.h"
 #include "models/debugger_disasm.h"
 #include "models/debugger_registers.h"
 #include "models/debugger_stack.h"
@@ -26,14 +29,19 @@
 ///
 /// The debugger window contains various controls used to inspect, but not
 /// modify the contents of the virtual machine.
+///
+/// The views show a snapshot of the virtual machine. While it is paused, the
+/// snapshot is taken directly; while it runs, the snapshots published by the
+/// virtual machine thread are picked up at the rate configured by the user,
+/// so the views follow along without slowing it down.
 class DebuggerWindowController : public QMainWindow {
   Q_OBJECT
 
  public:
   /// Constructs the debugger window.
   ///
-  /// \param vm_instance The virtual machine instance.
-  explicit DebuggerWindowController(chip8::VMInstance& vm_instance) noexcept;
+  /// \param vm_thread The thread the virtual machine lives in.
+  explicit DebuggerWindowController(VMThread& vm_thread) noexcept;
 
   /// Notifies the user that a breakpoint has been reached, and adjusts the view
   /// accordingly.
@@ -84,6 +92,25 @@ class DebuggerWindowController : public QMainWindow {
   /// \param trace_file The file that was unable to be opened for tracing.
   void NotifyTraceFileOpenError(const QString& trace_file) noexcept;
 
+  /// Takes a snapshot of the virtual machine directly, which is only safe
+  /// while it is paused.
+  void CaptureSnapshot() noexcept;
+
+  /// Picks up the most recent snapshot published by the virtual machine
+  /// thread, if there is a new one, and refreshes the views with it.
+  void PollSnapshot() noexcept;
+
+  /// Points the memory view at the memory of the snapshot again, if it was
+  /// moved or resized since the view last read it.
+  ///
+  /// \param memory Where the memory of the snapshot was stored before.
+  /// \param memory_size The size of the memory of the snapshot before.
+  void RebindMemoryView(const uint_fast8_t* memory,
+                        size_t memory_size) noexcept;
+
+  /// Refreshes every view with the current snapshot.
+  void RefreshViews() noexcept;
+
   /// Connects signals from various widgets to slots.
   void ConnectSignalsToSlots() noexcept;
 
@@ -93,6 +120,12 @@ class DebuggerWindowController : public QMainWindow {
   /// The widget view as generated by the User Interface Compiler (UIC).
   Ui::DebuggerWindow view_;
 
+  /// The state of the virtual machine shown by the views.
+  chip8::StateSnapshot snapshot_;
+
+  /// Polls for new snapshots while the virtual machine is running.
+  QTimer refresh_timer_;
+
   /// The model which handles the CHIP-8 disassembly.
   DebuggerDisasmModel* disasm_model_;
 
@@ -102,10 +135,20 @@ class DebuggerWindowController : public QMainWindow {
   /// The model which handles the CHIP-8 stack data.
   DebuggerStackModel* stack_model_;
 
+  /// The thread the virtual machine lives in.
+  VMThread& vm_thread_;
+
   /// The CHIP-8 virtual machine instance.
   chip8::VMInstance& vm_instance_;
 
  signals:
   /// Emitted when the Pause/Continue button has been pressed.
   void ToggleRunState();
+
+  /// Emitted when the user wishes to execute instructions one at a time while
+  /// the virtual machine is paused. The instructions have been executed by the
+  /// time the signal returns.
+  ///
+  /// \param num_steps The number of instructions to execute.
+  void Step(unsigned int num_steps);
 };
@@ -12,21 +12,65 @@
 
 #include "logger_window.h"
 
-#include <QDateTime>
+#include <QScrollBar>
+#include <array>
 
-LoggerWindowController::LoggerWindowController() noexcept {
+#include "models/app_settings.h"
+
+namespace {
+/// How often the log buffer is drained, in milliseconds.
+constexpr auto kDrainInterval = 50;
+}  // namespace
+
+LoggerWindowController::LoggerWindowController(LogBuffer& log_buffer) noexcept
+    : log_buffer_(log_buffer), log_model_(new LogModel(this)) {
   view_.setupUi(this);
+  view_.listView->setModel(log_model_);
+
+  log_model_->SetMaxMessages(
+      static_cast<size_t>(AppSettingsModel().GetLogMaxMessages()));
 
   ConnectSignalsToSlots();
-  view_.plainTextEdit->setReadOnly(true);
+
+  drain_timer_.start(kDrainInterval);
+
+  // Show whatever was logged while the window was closed right away.
+  DrainLogBuffer();
 }
 
-void LoggerWindowController::ConnectSignalsToSlots() noexcept {}
+void LoggerWindowController::ConnectSignalsToSlots() noexcept {
+  connect(&drain_timer_, &QTimer::timeout, [this]() { DrainLogBuffer(); });
+
+  const std::array<std::pair<QAction*, chip8::Logger::LogLevel>, 4>
+      level_actions = {{
+          {view_.actionShowInfo, chip8::Logger::LogLevel::kInfo},
+          {view_.actionShowWarnings, chip8::Logger::LogLevel::kWarning},
+          {view_.actionShowErrors, chip8::Logger::LogLevel::kError},
+          {view_.actionShowDebug, chip8::Logger::LogLevel::kDebug},
+      }};
+
+  for (const auto& [action, level] : level_actions) {
+    connect(action, &QAction::toggled,
+            [this, level = level](const bool checked) {
+              log_model_->SetLevelVisible(level, checked);
+            });
+  }
+}
+
+void LoggerWindowController::DrainLogBuffer() noexcept {
+  const auto num_suppressed = log_buffer_.Drain(drained_messages_);
+
+  if (drained_messages_.empty() && (num_suppressed == 0)) {
+    return;
+  }
+
+  const auto* const scroll_bar = view_.listView->verticalScrollBar();
+  const auto at_bottom = scroll_bar->value() == scroll_bar->maximum();
 
-void LoggerWindowController::AddMessage(const QString& msg) noexcept {
-  const auto date =
-      QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-  const auto formatted = QString{"[%1]: %2"}.arg(date).arg(msg);
+  log_model_->Append(drained_messages_, num_suppressed);
+  drained_messages_.clear();
 
-  view_.plainTextEdit->appendPlainText(formatted);
+  if (at_bottom) {
+    view_.listView->scrollToBottom();
+  }
 }
\ No newline at end of file
@@ -13,7 +13,10 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QTimer>
 
+#include "log_buffer.h"
+#include "models/log_model.h"
 #include "ui_logger_window.h"
 
 /// This class handles the logic of user actions that take place in the logger
@@ -26,18 +29,33 @@ class LoggerWindowController : public QMainWindow {
 
  public:
   /// Constructs the logger window.
-  LoggerWindowController() noexcept;
-
-  /// Adds a message to the logger which originated from the virtual machine
-  /// instance.
   ///
-  /// \param msg The message from the virtual machine instance.
-  void AddMessage(const QString& msg) noexcept;
+  /// \param log_buffer The buffer that messages from the virtual machine
+  /// instance are delivered to.
+  explicit LoggerWindowController(LogBuffer& log_buffer) noexcept;
 
  private:
   /// Connects signals from various widgets to slots.
   void ConnectSignalsToSlots() noexcept;
 
+  /// Moves the messages waiting in the log buffer to the log model. If the
+  /// view was scrolled to the bottom, it stays there.
+  void DrainLogBuffer() noexcept;
+
   /// The widget view as generated by the User Interface Compiler (UIC).
   Ui::LoggerWindow view_;
-};
+
+  /// The buffer that messages from the virtual machine instance are delivered
+  /// to.
+  LogBuffer& log_buffer_;
+
+  /// The messages displayed.
+  LogModel* log_model_;
+
+  /// The messages drained from the log buffer, kept around to reuse its
+  /// storage.
+  std::vector<LogBuffer::Message> drained_messages_;
+
+  /// Periodically drains the log buffer.
+  QTimer drain_timer_;
+};
\ No newline at end of file
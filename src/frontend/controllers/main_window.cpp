@@ -17,15 +17,27 @@
 
 #include "models/app_settings.h"
 
-MainWindowController::MainWindowController() noexcept {
+MainWindowController::MainWindowController() noexcept
+    : rom_library_model_(new RomLibraryModel(this)) {
   view_.setupUi(this);
   CreateStatusBarWidgets();
 
+  view_.romLibraryView->setModel(rom_library_model_);
+
+  // The ROM library can be closed; this brings it back.
+  view_.toolBar->insertAction(view_.actionDisplay_Debugger,
+                              view_.romLibraryDock->toggleViewAction());
+
+  connect(view_.romLibraryView, &QListView::activated, this,
+          [this](const QModelIndex& index) {
+            emit StartROM(rom_library_model_->GetPath(index));
+          });
+
   connect(view_.actionStart_ROM, &QAction::triggered, this, [this]() {
     const auto file_name = QFileDialog::getOpenFileName(
         this, tr("Open CHIP-8 ROM file"),
         AppSettingsModel().GetProgramFilesPath(),
-        tr("CHIP-8 ROM files (*.c8, *.ch8);;All files (*)"));
+        tr("CHIP-8 ROM files (*.c8 *.ch8 *.sc8 *.xo8);;All files (*)"));
 
     if (!file_name.isEmpty()) {
       emit StartROM(file_name);
@@ -41,6 +53,31 @@ MainWindowController::MainWindowController() noexcept {
   connect(view_.actionReset, &QAction::triggered,
           [this]() { emit ResetEmulation(); });
 
+  connect(view_.actionTurbo, &QAction::toggled, [this](const bool enabled) {
+    speed_info_->setVisible(enabled);
+    emit ToggleTurbo(enabled);
+  });
+
+  connect(view_.actionFrameTelemetry, &QAction::toggled,
+          [this](const bool show) {
+            AppSettingsModel().SetShowFrameTelemetry(show);
+            telemetry_info_->setVisible(show);
+
+            if (!show) {
+              GetRenderer()->SetOverlayText({});
+            }
+          });
+
+  connect(view_.actionExportInputTraces, &QAction::triggered, [this]() {
+    const auto trace_file = QFileDialog::getSaveFileName(
+        this, tr("Export input latency traces"), "",
+        tr("CSV files (*.csv);;All files (*.*)"));
+
+    if (!trace_file.isEmpty()) {
+      emit ExportInputTraces(trace_file);
+    }
+  });
+
   connect(view_.actionDisplay_Debugger, &QAction::triggered,
           [this]() { emit DisplayDebugger(); });
 
@@ -92,23 +129,18 @@ void MainWindowController::ReportROMTooLargeError(
   QMessageBox::critical(this, tr("Error opening ROM"), error_message);
 }
 
-void MainWindowController::ReportROMBadRead(
-    const QString& rom_file, const quint64 bytes_read,
-    const quint64 bytes_expected) noexcept {
-  auto error_message = QString(tr("Failed to fully read ROM file"));
-  error_message += QString(" %1: ").arg(rom_file);
-  error_message += QString("%1 ").arg(bytes_read);
-
-  const auto bytes_read_word_pluralized =
-      QString("byte%1").arg(bytes_read != 1 ? "s" : "");
-  error_message += QString(tr(qPrintable(bytes_read_word_pluralized)));
-  error_message += QString(tr(" read, expected"));
-  error_message += QString(" %1 ").arg(bytes_expected);
+void MainWindowController::ReportInputTraceExportError(
+    const QString& trace_file) noexcept {
+  auto error_message = QString(tr("Unable to write input latency traces to"));
+  error_message += QString(" %1").arg(trace_file);
 
-  const auto bytes_expected_word_pluralized =
-      QString("byte%1").arg(bytes_expected != 1 ? "s" : "");
+  QMessageBox::critical(this, tr("Error exporting traces"), error_message);
+}
 
-  error_message += QString(tr(qPrintable(bytes_expected_word_pluralized)));
+void MainWindowController::ReportROMBadRead(
+    const QString& rom_file, const QString& error_string) noexcept {
+  auto error_message = QString(tr("Failed to fully read ROM file"));
+  error_message += QString(" %1: %2").arg(rom_file).arg(error_string);
 
   QMessageBox::critical(this, tr("Error reading ROM"), error_message);
 }
@@ -167,42 +199,108 @@ void MainWindowController::SetWindowTitleGuestProgramInfo(
   setWindowTitle(QString{"vm-tutorial - running %1"}.arg(program_file_name));
 }
 
-void MainWindowController::UpdateFPSInfo(const unsigned int current_fps,
-                                         const unsigned int target_fps,
-                                         const double average_fps) noexcept {
-  const auto average_fps_text = QString::number(average_fps, 'f', 2);
+void MainWindowController::UpdateFPSInfo(
+    const VMThread::PerformanceCounters& perf_counters) noexcept {
+  const auto average_fps_text =
+      QString::number(perf_counters.average_frame_period_, 'f', 2);
+  const auto pacing_error_text =
+      QString::number(perf_counters.average_pacing_error_, 'f', 3);
+
+  fps_info_->setText(QString{"FPS: %1/%2 (avg. %3ms, jitter %4ms)"}
+                         .arg(perf_counters.current_fps_)
+                         .arg(perf_counters.target_fps_)
+                         .arg(average_fps_text)
+                         .arg(pacing_error_text));
+
+  speed_info_->setText(QString{"Turbo: %1 FPS, %2 MIPS"}
+                           .arg(perf_counters.current_fps_)
+                           .arg(QString::number(perf_counters.mips_, 'f', 2)));
+
+  // Each distribution is displayed as p50/p95/p99/max.
+  const auto format = [](const FrameTimeHistogram::Summary& summary) {
+    return QString{"%1/%2/%3/%4"}
+        .arg(summary.p50_)
+        .arg(summary.p95_)
+        .arg(summary.p99_)
+        .arg(summary.max_);
+  };
+
+  telemetry_info_->setText(
+      QString{"Emulate: %1us | Sleep: %2us | Present: %3us | Steps: %4"}
+          .arg(format(perf_counters.emulation_time_))
+          .arg(format(perf_counters.sleep_time_))
+          .arg(format(perf_counters.present_latency_))
+          .arg(format(perf_counters.steps_per_frame_)));
+
+  if (!view_.actionFrameTelemetry->isChecked()) {
+    return;
+  }
 
-  fps_info_->setText(QString{"FPS: %1/%2 (avg. %3ms)"}
-                         .arg(current_fps)
-                         .arg(target_fps)
-                         .arg(average_fps_text));
+  // The input latency is broken down by stage on top of the screen, where it
+  // can be watched while playing.
+  const auto& input_latency = perf_counters.input_latency_;
+
+  GetRenderer()->SetOverlayText(
+      QString{"Input to photon (us, p50/p95/p99/max)\n"
+              "Apply:   %1\n"
+              "Observe: %2\n"
+              "Draw:    %3\n"
+              "Present: %4\n"
+              "Total:   %5"}
+          .arg(format(input_latency.apply_))
+          .arg(format(input_latency.observe_))
+          .arg(format(input_latency.draw_))
+          .arg(format(input_latency.present_))
+          .arg(format(input_latency.total_)));
 }
 
 Renderer* MainWindowController::GetRenderer() const noexcept {
   return view_.openGLWidget;
 }
 
+void MainWindowController::SetRomLibrary(
+    std::vector<chip8::RomLibraryEntry> entries) noexcept {
+  rom_library_model_->SetEntries(std::move(entries));
+}
+
 void MainWindowController::CreateStatusBarWidgets() noexcept {
   fps_info_ = new QLabel(view_.statusBar);
   view_.statusBar->addPermanentWidget(fps_info_);
+
+  speed_info_ = new QLabel(view_.statusBar);
+  speed_info_->setVisible(false);
+  view_.statusBar->addPermanentWidget(speed_info_);
+
+  const auto show_telemetry = AppSettingsModel().GetShowFrameTelemetry();
+
+  telemetry_info_ = new QLabel(view_.statusBar);
+  telemetry_info_->setToolTip(
+      tr("Frame time distribution over the last second (p50/p95/p99/max)"));
+  telemetry_info_->setVisible(show_telemetry);
+  view_.statusBar->addWidget(telemetry_info_);
+
+  view_.actionFrameTelemetry->setChecked(show_telemetry);
 }
 
 void MainWindowController::keyPressEvent(QKeyEvent* key_event) noexcept {
+  // This is where input latency starts being measured.
+  const auto timestamp = chip8::InputEvent::Clock::now();
   const auto key = key_event->key();
 
   if (!key_bindings_.count(key)) {
     QMainWindow::keyPressEvent(key_event);
     return;
   }
-  emit CHIP8KeyPress(key_bindings_[key]);
+  emit CHIP8KeyPress(key_bindings_[key], timestamp);
 }
 
 void MainWindowController::keyReleaseEvent(QKeyEvent* key_event) noexcept {
+  const auto timestamp = chip8::InputEvent::Clock::now();
   const auto key = key_event->key();
 
   if (!key_bindings_.count(key)) {
     QMainWindow::keyPressEvent(key_event);
     return;
   }
-  emit CHIP8KeyRelease(key_bindings_[key]);
+  emit CHIP8KeyRelease(key_bindings_[key], timestamp);
 }
\ No newline at end of file
@@ -17,6 +17,8 @@
 #include <QMainWindow>
 
 #include "../types.h"
+#include "../vm_thread.h"
+#include "models/rom_library.h"
 #include "ui_main_window.h"
 
 /// This class handles the logic of user actions that take place in the main
@@ -61,11 +63,14 @@ class MainWindowController : public QMainWindow {
   /// its entirety.
   ///
   /// \param rom_file The ROM file that the user selected.
-  /// \param bytes_read The number of bytes that were able to be read from the
-  /// file.
-  /// \param bytes_expected The number of bytes that were expected to be read.
-  void ReportROMBadRead(const QString& rom_file, quint64 bytes_read,
-                        quint64 bytes_expected) noexcept;
+  /// \param error_string The error that occurred while reading the file.
+  void ReportROMBadRead(const QString& rom_file,
+                        const QString& error_string) noexcept;
+
+  /// Reports to the user that the input latency traces could not be written.
+  ///
+  /// \param trace_file The file that the user selected.
+  void ReportInputTraceExportError(const QString& trace_file) noexcept;
 
   /// Reports to the user that the virtual machine encountered a fatal error.
   ///
@@ -84,31 +89,41 @@ class MainWindowController : public QMainWindow {
       const QString& program_file_name) noexcept;
 
   /// Updates the FPS (frames per second) informational counter located in the
-  /// status bar.
-  ///
-  /// \param current_fps The number of frames that have been generated in 1
-  /// second.
-  ///
-  /// \param target_fps The number of frames we want to generate in 1 second
-  /// based on the current virtual machine timing configuration.
+  /// status bar, along with the turbo mode speed and the frame time telemetry
+  /// if they are displayed.
   ///
-  /// \param average_fps The time in milliseconds needed to draw a frame,
-  /// averaged on 1 second.
-  void UpdateFPSInfo(const unsigned int current_fps,
-                     const unsigned int target_fps,
-                     const double average_fps) noexcept;
+  /// \param perf_counters The performance information collected by the
+  /// virtual machine thread over 1 second.
+  void UpdateFPSInfo(
+      const VMThread::PerformanceCounters& perf_counters) noexcept;
 
   /// Retrieves the renderer instance.
   ///
   /// \returns The OpenGL renderer instance.
   Renderer* GetRenderer() const noexcept;
 
+  /// Replaces the ROM files listed in the ROM library.
+  ///
+  /// \param entries The ROM files to list.
+  void SetRomLibrary(std::vector<chip8::RomLibraryEntry> entries) noexcept;
+
  private:
   /// This widget is part of the status bar, which displays the number of frames
   /// per second, the desired number of frames per second, and the average
   /// number of frames in milliseconds.
   QLabel* fps_info_;
 
+  /// This widget is part of the status bar, which displays the effective
+  /// speed of the virtual machine while turbo mode is enabled.
+  QLabel* speed_info_;
+
+  /// This widget is part of the status bar, which displays the distribution
+  /// of frame times when the user has asked for it.
+  QLabel* telemetry_info_;
+
+  /// The ROM files listed in the ROM library.
+  RomLibraryModel* rom_library_model_;
+
   /// Creates the status bar widgets.
   void CreateStatusBarWidgets() noexcept;
 
@@ -177,12 +192,17 @@ class MainWindowController : public QMainWindow {
   /// key.
   ///
   /// \param key The CHIP-8 key to signal as pressed.
-  void CHIP8KeyPress(chip8::Key key);
+  /// \param timestamp The point in time at which the key press was received.
+  void CHIP8KeyPress(chip8::Key key,
+                     chip8::InputEvent::Clock::time_point timestamp);
 
   /// Emitted when the user has released a key that corresponds to a CHIP-8 key.
   ///
   /// \param key The CHIP-8 key to signal as released.
-  void CHIP8KeyRelease(chip8::Key key);
+  /// \param timestamp The point in time at which the key release was
+  /// received.
+  void CHIP8KeyRelease(chip8::Key key,
+                       chip8::InputEvent::Clock::time_point timestamp);
 
   /// Emitted when the user wishes to resume the execution of the virtual
   /// machine.
@@ -196,6 +216,11 @@ class MainWindowController : public QMainWindow {
   /// state with the current program.
   void ResetEmulation();
 
+  /// Emitted when the user wishes to enable or disable turbo mode.
+  ///
+  /// \param enabled Whether or not turbo mode should be enabled.
+  void ToggleTurbo(bool enabled);
+
   /// Emitted when the user wishes to open the debugger.
   void DisplayDebugger();
 
@@ -205,6 +230,11 @@ class MainWindowController : public QMainWindow {
   /// Emitted when the user wishes to open the program settings.
   void DisplayProgramSettings();
 
+  /// Emitted when the user wishes to save the input latency traces.
+  ///
+  /// \param trace_file The file to save the traces to.
+  void ExportInputTraces(const QString& trace_file);
+
   /// Emitted when the user has selected a ROM file to execute.
   void StartROM(const QString& rom_file_path);
 };
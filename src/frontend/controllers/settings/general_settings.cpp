@@ -35,8 +35,17 @@ void GeneralSettingsController::ConnectSignalsToSlots() noexcept {
       view_.programFilesPath->setText(dir);
     }
   });
+
+  connect(view_.debuggerRefreshRateSpinBox, &QSpinBox::valueChanged,
+          [](const int value) {
+            AppSettingsModel().SetDebuggerRefreshRate(value);
+          });
 }
 
 void GeneralSettingsController::PopulateDataFromAppSettings() noexcept {
-  view_.programFilesPath->setText(AppSettingsModel().GetProgramFilesPath());
+  AppSettingsModel app_settings;
+
+  view_.programFilesPath->setText(app_settings.GetProgramFilesPath());
+  view_.debuggerRefreshRateSpinBox->setValue(
+      app_settings.GetDebuggerRefreshRate());
 }
\ No newline at end of file
@@ -18,7 +18,8 @@
 
 /// This class handles the logic of user actions that take place in the general
 /// settings widget. The general settings widget handles, so far, the default
-/// location where to look for CHIP-8 programs.
+/// location where to look for CHIP-8 programs, and how often the debugger
+/// refreshes.
 class GeneralSettingsController : public QWidget {
   Q_OBJECT
 
@@ -35,6 +35,11 @@ void LoggerSettingsController::ConnectSignalsToSlots() noexcept {
   connect(view_.debugColorSelect, &QPushButton::clicked,
           [this]() { SelectLevelColor(view_.debugColorSelect, "debug"); });
 
+  connect(view_.maxMessagesSpinBox, &QSpinBox::valueChanged,
+          [](const int value) {
+            AppSettingsModel().SetLogMaxMessages(value);
+          });
+
   connect(view_.fontSelect, &QPushButton::clicked, [this]() {
     bool ok;
 
@@ -62,6 +67,8 @@ void LoggerSettingsController::PopulateDataFromAppSettings() noexcept {
   SetButtonColor(view_.debugColorSelect,
                  app_settings.GetLogLevelColor("debug"));
 
+  view_.maxMessagesSpinBox->setValue(app_settings.GetLogMaxMessages());
+
   const auto font = AppSettingsModel().GetLogFont();
 
   if (font) {
@@ -34,6 +34,32 @@ void MachineSettingsController::ConnectSignalsToSlots() noexcept {
             AppSettingsModel().SetMachineFrameRate(static_cast<double>(value));
             emit MachineFrameRateChanged(static_cast<double>(value));
           });
+
+  connect(view_.turboFrameSkipSpinBox, &QSpinBox::valueChanged,
+          [this](const int value) {
+            AppSettingsModel().SetMachineTurboFrameSkip(value);
+            emit MachineTurboFrameSkipChanged(value);
+          });
+
+  connect(view_.vsyncPacingCheckBox, &QCheckBox::toggled,
+          [this](const bool enabled) {
+            AppSettingsModel().SetMachineVsyncPacing(enabled);
+            emit MachineVsyncPacingChanged(enabled);
+          });
+
+  // The variant is read every time a ROM is started, so there's nobody to
+  // notify.
+  connect(view_.variantComboBox, &QComboBox::currentIndexChanged,
+          [](const int index) {
+            std::optional<chip8::Variant> variant;
+
+            // The first item guesses the variant from the extension, the
+            // others follow the order of chip8::Variant.
+            if (index > 0) {
+              variant = static_cast<chip8::Variant>(index - 1);
+            }
+            AppSettingsModel().SetMachineVariant(variant);
+          });
 }
 
 void MachineSettingsController::PopulateDataFromAppSettings() noexcept {
@@ -44,4 +70,13 @@ void MachineSettingsController::PopulateDataFromAppSettings() noexcept {
 
   view_.frameRateSpinBox->setValue(
       static_cast<int>(app_settings.GetMachineFrameRate()));
+
+  view_.turboFrameSkipSpinBox->setValue(
+      app_settings.GetMachineTurboFrameSkip());
+
+  view_.vsyncPacingCheckBox->setChecked(app_settings.GetMachineVsyncPacing());
+
+  const auto variant = app_settings.GetMachineVariant();
+  view_.variantComboBox->setCurrentIndex(
+      variant ? (static_cast<int>(*variant) + 1) : 0);
 }
\ No newline at end of file
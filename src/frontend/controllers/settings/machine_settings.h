@@ -20,7 +20,7 @@
 /// settings widget.
 ///
 /// The machine settings widget allows the user to change the timing of the
-/// virtual machine.
+/// virtual machine, and the variant of the programs it doesn't know.
 class MachineSettingsController : public QWidget {
   Q_OBJECT
 
@@ -49,4 +49,12 @@ class MachineSettingsController : public QWidget {
   /// Emitted when the user has requested to change the number of frames per
   /// second.
   void MachineFrameRateChanged(double value);
+
+  /// Emitted when the user has requested to change how often a frame is
+  /// presented in turbo mode.
+  void MachineTurboFrameSkipChanged(int value);
+
+  /// Emitted when the user has requested to change whether or not the display
+  /// paces the virtual machine.
+  void MachineVsyncPacingChanged(bool enabled);
 };
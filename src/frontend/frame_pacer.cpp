@@ -0,0 +1,133 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+/// Converts a duration to milliseconds as a floating point value.
+///
+/// \param duration The duration to convert.
+///
+/// \returns The duration in milliseconds.
+auto ToMilliseconds(const std::chrono::nanoseconds duration) noexcept
+    -> double {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+}  // namespace
+
+void FramePacer::Start(const double frame_time) noexcept {
+  frame_time_ = std::chrono::duration<double, std::milli>(frame_time);
+  epoch_ = Clock::now();
+  next_frame_ = 0;
+
+  ResetStatistics();
+}
+
+void FramePacer::SetFrameTime(const double frame_time) noexcept {
+  // Anchor the new schedule at the next deadline, so the frame currently in
+  // progress keeps the deadline it was promised.
+  epoch_ = GetNextDeadline();
+  next_frame_ = 0;
+
+  frame_time_ = std::chrono::duration<double, std::milli>(frame_time);
+}
+
+void FramePacer::RestartNow() noexcept {
+  epoch_ = Clock::now();
+  next_frame_ = 0;
+}
+
+auto FramePacer::GetFrameTime() const noexcept -> double {
+  return std::chrono::duration<double, std::milli>(frame_time_).count();
+}
+
+auto FramePacer::BeginFrame() noexcept -> FrameStart {
+  const auto now = Clock::now();
+  const auto scheduled = GetDeadline(next_frame_);
+
+  FrameStart frame_start{
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::max(now - scheduled, Clock::duration::zero())),
+      0};
+
+  if (frame_start.error_ > frame_time_) {
+    // We've fallen more than a whole frame behind. Skip the frames we missed,
+    // and restart the schedule from here; this frame starts now.
+    frame_start.frames_skipped_ =
+        static_cast<unsigned int>(frame_start.error_ / frame_time_);
+
+    epoch_ = now;
+    next_frame_ = 0;
+
+    stats_.frames_skipped_ += frame_start.frames_skipped_;
+  }
+
+  stats_.total_error_ += frame_start.error_;
+  stats_.max_error_ = std::max(stats_.max_error_, frame_start.error_);
+  stats_.num_frames_++;
+
+  next_frame_++;
+  return frame_start;
+}
+
+void FramePacer::WaitForNextFrame() const noexcept {
+  std::this_thread::sleep_until(GetCoarseWakeupTime());
+  SpinUntilDeadline();
+}
+
+auto FramePacer::GetNextDeadline() const noexcept -> Clock::time_point {
+  return GetDeadline(next_frame_);
+}
+
+auto FramePacer::GetCoarseWakeupTime() const noexcept -> Clock::time_point {
+  return GetNextDeadline() - kSpinThreshold;
+}
+
+void FramePacer::SpinUntilDeadline() const noexcept {
+  const auto deadline = GetNextDeadline();
+
+  while (Clock::now() < deadline) {
+    // Give other threads a chance to run, we're not doing anything useful.
+    std::this_thread::yield();
+  }
+}
+
+auto FramePacer::GetAverageError() const noexcept -> double {
+  if (stats_.num_frames_ == 0) {
+    return 0.0;
+  }
+  return ToMilliseconds(stats_.total_error_) / stats_.num_frames_;
+}
+
+auto FramePacer::GetMaxError() const noexcept -> double {
+  return ToMilliseconds(stats_.max_error_);
+}
+
+auto FramePacer::GetFramesSkipped() const noexcept -> unsigned int {
+  return stats_.frames_skipped_;
+}
+
+void FramePacer::ResetStatistics() noexcept {
+  stats_.total_error_ = std::chrono::nanoseconds::zero();
+  stats_.max_error_ = std::chrono::nanoseconds::zero();
+  stats_.num_frames_ = 0;
+  stats_.frames_skipped_ = 0;
+}
+
+auto FramePacer::GetDeadline(const uintmax_t frame) const noexcept
+    -> Clock::time_point {
+  return epoch_ + std::chrono::duration_cast<Clock::duration>(
+                      frame_time_ * static_cast<double>(frame));
+}
@@ -0,0 +1,158 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/// This class paces a run loop to a target frame time.
+///
+/// Frame deadlines are not accumulated by adding a (rounded) frame time to the
+/// previous deadline; instead, the deadline of frame \p n is computed as
+/// `epoch + n * frame_time` using nanosecond precision floating point. This
+/// means a 16.67ms frame time really is 16.67ms, and rounding errors can never
+/// pile up into drift no matter how long the loop runs.
+///
+/// Operating system sleep functions only promise to sleep *at least* as long
+/// as requested, and routinely overshoot by the length of a scheduler tick. To
+/// hit a deadline precisely, we sleep until shortly before the deadline and
+/// spin for the remainder.
+///
+/// If the run loop falls more than a frame behind (the host is overloaded, or
+/// the thread was descheduled for a long time), the missed frames are skipped
+/// and the schedule is restarted from the current time. Trying to catch up
+/// would only make the guest program run in fast forward for a while.
+class FramePacer {
+ public:
+  /// The clock used for all pacing decisions.
+  using Clock = std::chrono::steady_clock;
+
+  /// Information about the start of a frame, as returned by \ref BeginFrame().
+  struct FrameStart {
+    /// How late the frame started with respect to its scheduled start time.
+    std::chrono::nanoseconds error_;
+
+    /// The number of frames that were skipped because the run loop fell too
+    /// far behind the schedule.
+    unsigned int frames_skipped_;
+  };
+
+  /// Restarts the schedule with the specified frame time. The first frame is
+  /// scheduled to start immediately.
+  ///
+  /// \param frame_time The length of one frame, in milliseconds.
+  void Start(double frame_time) noexcept;
+
+  /// Changes the frame time without restarting the schedule. The new frame time
+  /// takes effect after the next deadline.
+  ///
+  /// \param frame_time The length of one frame, in milliseconds.
+  void SetFrameTime(double frame_time) noexcept;
+
+  /// Restarts the schedule from the current time, keeping the frame time and
+  /// the statistics. The next frame is scheduled to start immediately.
+  void RestartNow() noexcept;
+
+  /// Retrieves the current frame time.
+  ///
+  /// \returns The length of one frame, in milliseconds.
+  auto GetFrameTime() const noexcept -> double;
+
+  /// Marks the start of a frame.
+  ///
+  /// This method should be called once per frame, before any work is done for
+  /// the frame.
+  ///
+  /// \returns Information about the start of the frame.
+  auto BeginFrame() noexcept -> FrameStart;
+
+  /// Blocks until the start of the next frame, using a coarse sleep followed by
+  /// a short spin.
+  ///
+  /// This is equivalent to sleeping until \ref GetCoarseWakeupTime() and then
+  /// calling \ref SpinUntilDeadline().
+  void WaitForNextFrame() const noexcept;
+
+  /// Retrieves the time point at which the next frame is scheduled to start.
+  ///
+  /// \returns The time point of the next deadline.
+  auto GetNextDeadline() const noexcept -> Clock::time_point;
+
+  /// Retrieves the time point at which a coarse sleep for the next frame
+  /// should end, leaving the rest of the wait to \ref SpinUntilDeadline().
+  ///
+  /// \returns The time point at which to stop sleeping.
+  auto GetCoarseWakeupTime() const noexcept -> Clock::time_point;
+
+  /// Spins until the next deadline has been reached. This method returns
+  /// immediately if the deadline has already passed.
+  void SpinUntilDeadline() const noexcept;
+
+  /// Retrieves the average error between the scheduled and actual start of
+  /// the frames since the last call to \ref ResetStatistics().
+  ///
+  /// \returns The average frame start error, in milliseconds.
+  auto GetAverageError() const noexcept -> double;
+
+  /// Retrieves the largest error between the scheduled and actual start of a
+  /// frame since the last call to \ref ResetStatistics().
+  ///
+  /// \returns The largest frame start error, in milliseconds.
+  auto GetMaxError() const noexcept -> double;
+
+  /// Retrieves the number of frames that were skipped since the last call to
+  /// \ref ResetStatistics().
+  ///
+  /// \returns The number of frames skipped.
+  auto GetFramesSkipped() const noexcept -> unsigned int;
+
+  /// Clears the error and frame skip statistics.
+  void ResetStatistics() noexcept;
+
+ private:
+  /// Computes the time point at which a frame is scheduled to start.
+  ///
+  /// \param frame The frame number, relative to the epoch.
+  ///
+  /// \returns The time point at which the frame is scheduled to start.
+  auto GetDeadline(uintmax_t frame) const noexcept -> Clock::time_point;
+
+  /// How long before a deadline we stop sleeping and begin spinning. This has
+  /// to cover the wakeup latency of the operating system scheduler; on Windows
+  /// in particular, a sleep can overshoot by a full millisecond or more.
+  static constexpr std::chrono::microseconds kSpinThreshold{2000};
+
+  /// The time point of frame 0.
+  Clock::time_point epoch_;
+
+  /// The length of one frame, in nanoseconds.
+  std::chrono::duration<double, std::nano> frame_time_{0.0};
+
+  /// The number of the next frame to start, relative to the epoch.
+  uintmax_t next_frame_ = 0;
+
+  /// The frame start statistics, see \ref ResetStatistics().
+  struct {
+    /// The sum of the frame start errors.
+    std::chrono::nanoseconds total_error_{0};
+
+    /// The largest frame start error.
+    std::chrono::nanoseconds max_error_{0};
+
+    /// The number of frames the errors were collected from.
+    unsigned int num_frames_ = 0;
+
+    /// The number of frames that were skipped.
+    unsigned int frames_skipped_ = 0;
+  } stats_;
+};
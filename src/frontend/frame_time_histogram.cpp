@@ -0,0 +1,127 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#include "frame_time_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+/// The fractions of samples the reported percentiles are computed for.
+constexpr auto kP50 = 0.50;
+constexpr auto kP95 = 0.95;
+constexpr auto kP99 = 0.99;
+}  // namespace
+
+void FrameTimeHistogram::Record(const uint64_t value) noexcept {
+  buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+
+  auto max = max_.load(std::memory_order_relaxed);
+
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+auto FrameTimeHistogram::Summarize() const noexcept -> Summary {
+  // Take a copy of the counts first, so all of the percentiles are computed
+  // from the same data even if samples are being recorded right now.
+  std::array<uint64_t, kNumBuckets> counts{};
+  uint64_t total = 0;
+
+  for (auto index = 0U; index < kNumBuckets; ++index) {
+    counts[index] = buckets_[index].load(std::memory_order_relaxed);
+    total += counts[index];
+  }
+
+  Summary summary;
+
+  summary.count_ = total;
+  summary.max_ = max_.load(std::memory_order_relaxed);
+
+  if (total == 0) {
+    return summary;
+  }
+
+  // A bucket's upper bound may lie above every sample actually counted in it;
+  // never report a percentile larger than the largest sample.
+  const auto percentile = [&](const double fraction) {
+    return std::min(GetPercentile(counts, total, fraction), summary.max_);
+  };
+
+  summary.p50_ = percentile(kP50);
+  summary.p95_ = percentile(kP95);
+  summary.p99_ = percentile(kP99);
+
+  return summary;
+}
+
+void FrameTimeHistogram::Reset() noexcept {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  max_.store(0, std::memory_order_relaxed);
+}
+
+auto FrameTimeHistogram::GetBucketIndex(const uint64_t value) noexcept
+    -> unsigned int {
+  if (value < kNumSubBuckets) {
+    return static_cast<unsigned int>(value);
+  }
+
+  // Find the most significant bit; the bits right below it select the
+  // sub-bucket.
+  auto msb = 0U;
+
+  for (auto v = value; v > 1; v >>= 1) {
+    msb++;
+  }
+
+  const auto shift = msb - kSubBucketBits;
+  const auto sub_bucket = (value >> shift) & (kNumSubBuckets - 1);
+
+  return ((shift + 1) * kNumSubBuckets) + static_cast<unsigned int>(sub_bucket);
+}
+
+auto FrameTimeHistogram::GetBucketUpperBound(
+    const unsigned int bucket_index) noexcept -> uint64_t {
+  if (bucket_index < kNumSubBuckets) {
+    return bucket_index;
+  }
+
+  const auto shift = (bucket_index / kNumSubBuckets) - 1;
+  const auto sub_bucket = bucket_index % kNumSubBuckets;
+
+  const auto lower_bound = static_cast<uint64_t>(kNumSubBuckets + sub_bucket)
+                           << shift;
+
+  return lower_bound + ((uint64_t{1} << shift) - 1);
+}
+
+auto FrameTimeHistogram::GetPercentile(
+    const std::array<uint64_t, kNumBuckets>& counts, const uint64_t total,
+    const double fraction) noexcept -> uint64_t {
+  const auto rank = static_cast<uint64_t>(
+      std::ceil(fraction * static_cast<double>(total)));
+
+  uint64_t seen = 0;
+
+  for (auto index = 0U; index < kNumBuckets; ++index) {
+    seen += counts[index];
+
+    if (seen >= rank && counts[index] != 0) {
+      return GetBucketUpperBound(index);
+    }
+  }
+  return std::numeric_limits<uint64_t>::max();
+}
@@ -0,0 +1,108 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/// This class collects a distribution of non-negative integer samples, such as
+/// frame times in microseconds, and answers percentile queries on it.
+///
+/// Samples are counted in logarithmic buckets: every power of two is divided
+/// into 4 sub-buckets, so a reported percentile is never off by more than 25%
+/// of its true value, regardless of its magnitude. Values below 4 are counted
+/// exactly.
+///
+/// Recording a sample is lock-free and wait-free apart from keeping track of
+/// the largest sample, so it is safe to record samples from any number of
+/// threads while another thread takes a summary. A summary taken concurrently
+/// with recording may or may not include the samples being recorded.
+class FrameTimeHistogram {
+ public:
+  /// A summary of the samples collected by the histogram.
+  struct Summary {
+    /// The number of samples collected.
+    uint64_t count_ = 0;
+
+    /// The value below which 50% of the samples fall.
+    uint64_t p50_ = 0;
+
+    /// The value below which 95% of the samples fall.
+    uint64_t p95_ = 0;
+
+    /// The value below which 99% of the samples fall.
+    uint64_t p99_ = 0;
+
+    /// The largest sample collected. Unlike the percentiles, this is exact.
+    uint64_t max_ = 0;
+  };
+
+  /// Adds a sample to the histogram.
+  ///
+  /// \param value The value of the sample.
+  void Record(uint64_t value) noexcept;
+
+  /// Computes a summary of the samples collected since the last call to \ref
+  /// Reset().
+  ///
+  /// \returns The summary of the samples.
+  auto Summarize() const noexcept -> Summary;
+
+  /// Discards all collected samples.
+  void Reset() noexcept;
+
+ private:
+  /// The number of sub-buckets each power of two is divided into, as a power
+  /// of two.
+  static constexpr unsigned int kSubBucketBits = 2;
+
+  /// The number of sub-buckets each power of two is divided into.
+  static constexpr unsigned int kNumSubBuckets = 1U << kSubBucketBits;
+
+  /// The number of buckets needed to cover every 64-bit value.
+  static constexpr unsigned int kNumBuckets =
+      (64 - kSubBucketBits + 1) * kNumSubBuckets;
+
+  /// Determines which bucket a value is counted in.
+  ///
+  /// \param value The value to look up.
+  ///
+  /// \returns The index of the bucket.
+  static auto GetBucketIndex(uint64_t value) noexcept -> unsigned int;
+
+  /// Determines the largest value counted in a bucket.
+  ///
+  /// \param bucket_index The index of the bucket.
+  ///
+  /// \returns The largest value counted in the bucket.
+  static auto GetBucketUpperBound(unsigned int bucket_index) noexcept
+      -> uint64_t;
+
+  /// Finds the value below which the specified fraction of samples fall.
+  ///
+  /// \param counts A copy of the bucket counts.
+  /// \param total The sum of \p counts.
+  /// \param fraction The fraction of samples, between 0 and 1.
+  ///
+  /// \returns The upper bound of the bucket containing the percentile.
+  static auto GetPercentile(const std::array<uint64_t, kNumBuckets>& counts,
+                            uint64_t total, double fraction) noexcept
+      -> uint64_t;
+
+  /// The number of samples counted in each bucket.
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+
+  /// The largest sample collected.
+  std::atomic<uint64_t> max_ = 0;
+};
@@ -0,0 +1,57 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include "log_buffer.h"
+
+LogBuffer::LogBuffer() noexcept : messages_(kCapacity) {}
+
+void LogBuffer::Push(const chip8::Logger::LogLevel level,
+                     const std::string& text) noexcept {
+  const auto timestamp = Clock::now();
+
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  size_t index;
+
+  if (size_ == kCapacity) {
+    // Overwrite the oldest message.
+    index = head_;
+    head_ = (head_ + 1) % kCapacity;
+    ++num_dropped_;
+  } else {
+    index = (head_ + size_) % kCapacity;
+    ++size_;
+  }
+
+  auto& message = messages_[index];
+
+  message.timestamp_ = timestamp;
+  message.level_ = level;
+  message.text_ = text;
+}
+
+auto LogBuffer::Drain(std::vector<Message>& messages) noexcept -> size_t {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  messages.reserve(messages.size() + size_);
+
+  for (; size_ != 0; --size_) {
+    messages.push_back(std::move(messages_[head_]));
+    head_ = (head_ + 1) % kCapacity;
+  }
+
+  const auto num_dropped = num_dropped_;
+  num_dropped_ = 0;
+
+  return num_dropped;
+}
@@ -0,0 +1,89 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <core/logger.h>
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// This class carries log messages from the virtual machine thread to the
+/// logger window.
+///
+/// Delivering every message through a queued signal lets a chatty guest
+/// program flood the event loop of the GUI thread, one event per message.
+/// Instead, messages are stored in a bounded ring buffer which the logger
+/// window drains in batches on a timer. If messages arrive faster than they're
+/// drained, the oldest ones are overwritten and counted, so the logger window
+/// can tell the user how many were lost.
+///
+/// This class is thread-safe.
+class LogBuffer {
+ public:
+  /// The clock used to timestamp log messages.
+  using Clock = std::chrono::system_clock;
+
+  /// The maximum number of messages waiting to be drained.
+  static constexpr size_t kCapacity = 4096;
+
+  /// A log message waiting to be displayed.
+  struct Message {
+    /// When the message was emitted.
+    Clock::time_point timestamp_;
+
+    /// The severity of the message.
+    chip8::Logger::LogLevel level_;
+
+    /// The message itself.
+    std::string text_;
+  };
+
+  /// Constructs the log buffer.
+  LogBuffer() noexcept;
+
+  /// Adds a message to the buffer. If the buffer is full, the oldest message
+  /// is dropped.
+  ///
+  /// \param level The severity of the message.
+  /// \param text The message itself.
+  void Push(chip8::Logger::LogLevel level, const std::string& text) noexcept;
+
+  /// Moves every message waiting in the buffer to the end of \p messages,
+  /// oldest first.
+  ///
+  /// \param messages The container to move the messages to.
+  ///
+  /// \returns The number of messages dropped since the last time the buffer
+  /// was drained. The dropped messages are older than any message moved.
+  auto Drain(std::vector<Message>& messages) noexcept -> size_t;
+
+ private:
+  /// Protects every member below.
+  std::mutex mutex_;
+
+  /// The storage of the ring buffer, \ref kCapacity messages long.
+  std::vector<Message> messages_;
+
+  /// The index of the oldest message in the buffer.
+  size_t head_ = 0;
+
+  /// The number of messages in the buffer.
+  size_t size_ = 0;
+
+  /// The number of messages dropped since the last drain.
+  size_t num_dropped_ = 0;
+};
@@ -12,8 +12,12 @@
 
 #include "memory_view.h"
 
+#include <QPaintEvent>
 #include <QPainter>
 #include <QScrollBar>
+#include <algorithm>
+#include <array>
+#include <cctype>
 
 #include "models/app_settings.h"
 
@@ -28,9 +32,65 @@ void MemoryViewWidget::SetData(const void* data,
   current_data_ = data;
   current_data_size_ = size;
 
+  const auto* bytes = static_cast<const uint_fast8_t*>(current_data_);
+
+  refreshed_data_.assign(bytes, bytes + size);
+  change_time_points_.assign(size, {});
+  highlight_alpha_.assign(size, 0);
+  highlight_changes_ = false;
+
   UpdateContent();
 }
 
+void MemoryViewWidget::Refresh() noexcept {
+  if (!current_data_) {
+    return;
+  }
+
+  const auto* bytes = static_cast<const uint_fast8_t*>(current_data_);
+
+  if (!highlight_changes_) {
+    // Whatever the data was before the first refresh, nothing has changed as
+    // far as the user is concerned.
+    std::copy(bytes, bytes + current_data_size_, refreshed_data_.begin());
+    highlight_changes_ = true;
+
+    viewport()->update();
+    return;
+  }
+
+  const auto now = Clock::now();
+  const auto rows_visible = (end_offset_ - start_offset_) / bytes_per_line_;
+
+  auto offset = 0U;
+
+  // Bytes out of view aren't drawn, but they still have to be highlighted
+  // when they're scrolled into view.
+  for (; offset < start_offset_; ++offset) {
+    RefreshByte(offset, now);
+  }
+
+  for (auto row = 0U; row <= rows_visible; ++row) {
+    const auto line_end =
+        std::min(offset + bytes_per_line_, current_data_size_);
+
+    auto line_dirty = false;
+
+    for (; offset < line_end; ++offset) {
+      line_dirty |= RefreshByte(offset, now);
+    }
+
+    if (line_dirty) {
+      viewport()->update(0, GetLineTop(row), viewport()->width(),
+                         static_cast<int>(font_metrics_.char_height_));
+    }
+  }
+
+  for (; offset < current_data_size_; ++offset) {
+    RefreshByte(offset, now);
+  }
+}
+
 void MemoryViewWidget::SetFont(const QFont& font) noexcept {
   QAbstractScrollArea::setFont(font);
   UpdateFontMetrics();
@@ -45,10 +105,12 @@ void MemoryViewWidget::paintEvent(QPaintEvent* event) noexcept {
   painter.setFont(font());
   painter.setPen(viewport()->palette().color(QPalette::WindowText));
 
-  DrawColumns(painter);
+  const auto& rect = event->rect();
+
+  DrawColumns(painter, rect);
   DrawAddressDivider(painter);
   DrawHeaderDivider(painter);
-  DrawData(painter);
+  DrawData(painter, rect);
 }
 
 void MemoryViewWidget::resizeEvent(QResizeEvent* event) noexcept {
@@ -72,9 +134,101 @@ void MemoryViewWidget::UpdateFontMetrics() noexcept {
 
   font_metrics_.char_width_ = font_metrics.horizontalAdvance('0');
   font_metrics_.char_height_ = font_metrics.height();
+  font_metrics_.ascent_ = font_metrics.ascent();
 
   font_metrics_.ascii_start_x_ =
       (font_metrics_.data_width_ * bytes_per_line_ * 2) + 36;
+
+  RenderGlyphAtlas();
+}
+
+void MemoryViewWidget::RenderGlyphAtlas() noexcept {
+  const auto pixel_ratio = devicePixelRatioF();
+  const auto num_glyphs = kLastGlyph - kFirstGlyph + 1;
+
+  glyph_atlas_ = QPixmap(
+      QSize(static_cast<int>(font_metrics_.char_width_) * num_glyphs,
+            static_cast<int>(font_metrics_.char_height_)) *
+      pixel_ratio);
+  glyph_atlas_.setDevicePixelRatio(pixel_ratio);
+  glyph_atlas_.fill(Qt::transparent);
+
+  QPainter painter(&glyph_atlas_);
+  painter.setFont(font());
+  painter.setPen(palette().color(QPalette::WindowText));
+
+  for (auto glyph = kFirstGlyph; glyph <= kLastGlyph; ++glyph) {
+    const auto x = (glyph - kFirstGlyph) * font_metrics_.char_width_;
+
+    painter.drawText(static_cast<int>(x),
+                     static_cast<int>(font_metrics_.ascent_),
+                     QChar(glyph));
+  }
+}
+
+void MemoryViewWidget::DrawGlyph(QPainter& painter, const int x, const int y,
+                                 const char glyph) const noexcept {
+  const auto pixel_ratio = glyph_atlas_.devicePixelRatio();
+
+  const auto width = static_cast<int>(font_metrics_.char_width_);
+  const auto height = static_cast<int>(font_metrics_.char_height_);
+
+  const QRectF source((glyph - kFirstGlyph) * width * pixel_ratio, 0,
+                      width * pixel_ratio, height * pixel_ratio);
+
+  painter.drawPixmap(QRectF(x, y, width, height), glyph_atlas_, source);
+}
+
+void MemoryViewWidget::DrawHex(QPainter& painter, int x, const int y,
+                               const unsigned int value,
+                               const int num_digits) const noexcept {
+  constexpr std::array<char, 16> kHexDigits{'0', '1', '2', '3', '4', '5',
+                                            '6', '7', '8', '9', 'A', 'B',
+                                            'C', 'D', 'E', 'F'};
+
+  for (auto digit = num_digits - 1; digit >= 0; --digit) {
+    DrawGlyph(painter, x, y, kHexDigits[(value >> (digit * 4)) & 0xF]);
+    x += static_cast<int>(font_metrics_.char_width_);
+  }
+}
+
+auto MemoryViewWidget::GetLineTop(const unsigned int row) const noexcept
+    -> int {
+  // The data starts under the header, which is one line tall.
+  return static_cast<int>((font_metrics_.char_height_ * (row + 2)) -
+                          font_metrics_.ascent_);
+}
+
+auto MemoryViewWidget::RefreshByte(const unsigned int offset,
+                                   const Clock::time_point now) noexcept
+    -> bool {
+  const auto value = static_cast<const uint_fast8_t*>(current_data_)[offset];
+
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  constexpr auto kMaxHighlightAlpha = 160;
+
+  if (value != refreshed_data_[offset]) {
+    refreshed_data_[offset] = value;
+    change_time_points_[offset] = now;
+  }
+
+  const auto since_change = now - change_time_points_[offset];
+
+  uint_fast8_t alpha = 0;
+
+  if (since_change < kHighlightDuration) {
+    const auto remaining = kHighlightDuration - since_change;
+
+    alpha = static_cast<uint_fast8_t>(kMaxHighlightAlpha * remaining /
+                                      kHighlightDuration);
+  }
+
+  if (alpha == highlight_alpha_[offset]) {
+    return false;
+  }
+
+  highlight_alpha_[offset] = alpha;
+  return true;
 }
 
 void MemoryViewWidget::DrawAddressDivider(QPainter& painter) noexcept {
@@ -88,7 +242,15 @@ void MemoryViewWidget::DrawHeaderDivider(QPainter& painter) noexcept {
   painter.drawLine(0, kPaddedHeight, width(), kPaddedHeight);
 }
 
-void MemoryViewWidget::DrawColumns(QPainter& painter) noexcept {
+void MemoryViewWidget::DrawColumns(QPainter& painter,
+                                   const QRect& rect) noexcept {
+  // The header only has to be drawn if it is part of what's being redrawn.
+  const auto draw_header =
+      rect.top() <= static_cast<int>(font_metrics_.char_height_);
+
+  const auto header_y =
+      static_cast<int>(font_metrics_.char_height_ - font_metrics_.ascent_);
+
   auto x = ((font_metrics_.data_width_ * 2) + 8);
   auto ascii_x_ = font_metrics_.ascii_start_x_;
 
@@ -100,60 +262,55 @@ void MemoryViewWidget::DrawColumns(QPainter& painter) noexcept {
                        viewport()->palette().color(QPalette::AlternateBase));
     }
 
-    const auto col_text =
-        QString{"%1"}.arg(col, 1, 16).rightJustified(2, '0').toUpper();
-
-    painter.drawText(x, font_metrics_.char_height_, col_text);
-
-    const auto ch =
-        (col < 0xA) ? (QChar('0' + col)) : (QChar('A' + (col - 0xA)));
-    painter.drawText(ascii_x_, font_metrics_.char_height_, ch);
+    if (draw_header) {
+      DrawHex(painter, x, header_y, col, 2);
+      DrawHex(painter, ascii_x_, header_y, col, 1);
+    }
   }
 }
 
-void MemoryViewWidget::DrawData(QPainter& painter) noexcept {
-  // We need to start UNDER the lines we drew.
-  auto y = font_metrics_.char_height_ * 2;
-
+void MemoryViewWidget::DrawData(QPainter& painter,
+                                const QRect& rect) noexcept {
+  const auto line_height = static_cast<int>(font_metrics_.char_height_);
   const auto row_count = (end_offset_ - start_offset_) / bytes_per_line_;
 
-  auto offset = start_offset_;
+  // Only the lines that are part of what's being redrawn are drawn.
+  const auto first_row = static_cast<unsigned int>(
+      std::max((rect.top() - GetLineTop(0)) / line_height, 0));
+  const auto last_row = std::min(
+      static_cast<unsigned int>(
+          std::max((rect.bottom() - GetLineTop(0)) / line_height, 0)),
+      row_count);
 
-  for (auto row = 0; row <= row_count; ++row, y += font_metrics_.char_height_) {
-    auto ascii_offset = font_metrics_.ascii_start_x_;
-    auto x = 0;
+  auto highlight_color = viewport()->palette().color(QPalette::Highlight);
 
+  for (auto row = first_row; row <= last_row; ++row) {
+    const auto y = GetLineTop(row);
     const auto row_address = start_offset_ + (row * bytes_per_line_);
 
-    const auto address_text =
-        QString{"%1"}.arg(row_address, 1, 16).rightJustified(4, '0').toUpper();
-
-    painter.drawText(x, y, address_text);
+    DrawHex(painter, 0, y, row_address, 4);
 
-    x = (font_metrics_.data_width_ * 2) + 8;
+    auto x = static_cast<int>((font_metrics_.data_width_ * 2) + 8);
+    auto ascii_x = static_cast<int>(font_metrics_.ascii_start_x_);
 
-    for (auto col = 0;
-         ((col < bytes_per_line_) && (offset < current_data_size_));
-         ++col, ++offset) {
-      uint_fast8_t value;
-      std::memcpy(&value,
-                  static_cast<const uint_fast8_t*>(current_data_) + offset,
-                  sizeof(uint_fast8_t));
+    for (auto offset = row_address;
+         (offset < row_address + bytes_per_line_) &&
+         (offset < current_data_size_);
+         ++offset) {
+      const auto value = refreshed_data_[offset] & 0xFF;
 
-      value &= 0xFF;
-
-      const auto value_text =
-          QString{"%1"}.arg(value, 1, 16).rightJustified(2, '0').toUpper();
-
-      painter.drawText(x, y, value_text);
-      x += (font_metrics_.data_width_ * 2);
-
-      if (!std::isprint(value)) {
-        value = '.';
+      if (highlight_alpha_[offset] != 0) {
+        highlight_color.setAlpha(highlight_alpha_[offset]);
+        painter.fillRect(x, y, static_cast<int>(font_metrics_.data_width_),
+                         line_height, highlight_color);
       }
 
-      painter.drawText(ascii_offset, y, QChar(value));
-      ascii_offset += (font_metrics_.char_width_ * 2);
+      DrawHex(painter, x, y, value, 2);
+      x += static_cast<int>(font_metrics_.data_width_ * 2);
+
+      DrawGlyph(painter, ascii_x, y,
+                std::isprint(value) ? static_cast<char>(value) : '.');
+      ascii_x += static_cast<int>(font_metrics_.char_width_ * 2);
     }
   }
 }
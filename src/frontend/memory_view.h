@@ -13,9 +13,17 @@
 #pragma once
 
 #include <QAbstractScrollArea>
+#include <QPixmap>
+#include <chrono>
+#include <vector>
 
 /// This class defines a memory view widget. It allows a user to inspect, but
 /// not modify, the contents of data in a hexadecimal and ASCII fashion.
+///
+/// The widget is meant to follow data that changes many times per second.
+/// Characters are drawn from a glyph atlas rendered once per font, and only
+/// the lines whose bytes changed are redrawn. Changed bytes are highlighted,
+/// and the highlight fades out over a short time.
 class MemoryViewWidget : public QAbstractScrollArea {
   Q_OBJECT
 
@@ -36,10 +44,20 @@ class MemoryViewWidget : public QAbstractScrollArea {
 
   /// Sets the data to display.
   ///
+  /// The data must stay valid for as long as it is displayed. It is only read
+  /// again by \ref Refresh().
+  ///
   /// \param data The data to display.
   /// \param size The size of the data, in bytes.
   void SetData(const void* data, unsigned int size) noexcept;
 
+  /// Reads the data again, and redraws the lines whose bytes have changed or
+  /// whose highlight is fading out.
+  ///
+  /// Changes found by the first refresh after \ref SetData() aren't
+  /// highlighted.
+  void Refresh() noexcept;
+
   /// Sets the font to use when drawing the data.
   ///
   /// \param font The font to use when draawing the data.
@@ -111,6 +129,17 @@ class MemoryViewWidget : public QAbstractScrollArea {
   void resizeEvent(QResizeEvent* event) noexcept override;
 
  private:
+  /// The clock used to time highlights.
+  using Clock = std::chrono::steady_clock;
+
+  /// How long it takes for the highlight of a changed byte to fade out.
+  static constexpr auto kHighlightDuration = std::chrono::milliseconds{500};
+
+  /// The first and last characters of the glyph atlas: the printable ASCII
+  /// range, which includes every hexadecimal digit.
+  static constexpr char kFirstGlyph = ' ';
+  static constexpr char kLastGlyph = '~';
+
   /// Connects signals from various widgets to slots.
   void ConnectSignalsToSlots() noexcept;
 
@@ -135,6 +164,46 @@ class MemoryViewWidget : public QAbstractScrollArea {
   /// Updates the font metrics, using the current font.
   void UpdateFontMetrics() noexcept;
 
+  /// Renders every glyph the widget draws into \ref glyph_atlas_, using the
+  /// current font.
+  void RenderGlyphAtlas() noexcept;
+
+  /// Draws a glyph from the glyph atlas.
+  ///
+  /// \param painter The painter to use to draw on the widget.
+  /// \param x The X position of the glyph.
+  /// \param y The Y position of the top of the line the glyph is on.
+  /// \param glyph The glyph to draw, between \ref kFirstGlyph and \ref
+  /// kLastGlyph.
+  void DrawGlyph(QPainter& painter, int x, int y, char glyph) const noexcept;
+
+  /// Draws a value in hexadecimal, padded with zeros.
+  ///
+  /// \param painter The painter to use to draw on the widget.
+  /// \param x The X position of the first digit.
+  /// \param y The Y position of the top of the line the value is on.
+  /// \param value The value to draw.
+  /// \param num_digits The number of digits to draw.
+  void DrawHex(QPainter& painter, int x, int y, unsigned int value,
+               int num_digits) const noexcept;
+
+  /// Determines the Y position of the top of a line of data.
+  ///
+  /// \param row The line, relative to the first visible one.
+  ///
+  /// \returns The Y position of the top of the line.
+  auto GetLineTop(unsigned int row) const noexcept -> int;
+
+  /// Compares a byte against its value as of the last refresh, and updates
+  /// its highlight.
+  ///
+  /// \param offset The offset of the byte.
+  /// \param now The point in time of the refresh.
+  ///
+  /// \returns \p true if the byte has to be redrawn, or \p false otherwise.
+  auto RefreshByte(unsigned int offset, Clock::time_point now) noexcept
+      -> bool;
+
   /// Draws the divider separating the addresses from the columns and data.
   ///
   /// \param painter The painter to use to draw on the widget.
@@ -149,12 +218,14 @@ class MemoryViewWidget : public QAbstractScrollArea {
   /// ASCII header.
   ///
   /// \param painter The painter to use to draw on the widget.
-  void DrawColumns(QPainter& painter) noexcept;
+  /// \param rect The area being redrawn.
+  void DrawColumns(QPainter& painter, const QRect& rect) noexcept;
 
-  /// Draws the data.
+  /// Draws the lines of data within the area being redrawn.
   ///
   /// \param painter The painter to use to draw the data.
-  void DrawData(QPainter& painter) noexcept;
+  /// \param rect The area being redrawn.
+  void DrawData(QPainter& painter, const QRect& rect) noexcept;
 
   /// The current data from which we are rendering its contents.
   const void* current_data_ = nullptr;
@@ -182,8 +253,27 @@ class MemoryViewWidget : public QAbstractScrollArea {
 
     /// The X position of the ASCII area.
     unsigned int ascii_start_x_;
+
+    /// The distance from the top of a line to the baseline.
+    unsigned int ascent_;
   } font_metrics_;
 
+  /// The characters rendered side by side, from \ref kFirstGlyph to \ref
+  /// kLastGlyph, each one \ref font_metrics_.char_width_ wide.
+  QPixmap glyph_atlas_;
+
+  /// The data as of the last refresh. This is what is drawn.
+  std::vector<uint_fast8_t> refreshed_data_;
+
+  /// The point in time at which each byte last changed.
+  std::vector<Clock::time_point> change_time_points_;
+
+  /// The opacity of the highlight of each byte, or 0 if it isn't highlighted.
+  std::vector<uint_fast8_t> highlight_alpha_;
+
+  /// Whether or not changes found by \ref Refresh() are highlighted.
+  bool highlight_changes_ = false;
+
   unsigned int start_offset_;
   unsigned int end_offset_;
 
@@ -15,6 +15,29 @@
 #include <QDir>
 #include <QFontDatabase>
 
+namespace {
+/// Parses a variant as stored within the configuration file.
+///
+/// \param variant One of `chip8`, `schip` or `xochip`.
+///
+/// \returns The variant, or nothing if \p variant is none of them.
+auto ParseVariant(const QString& variant) noexcept
+    -> std::optional<chip8::Variant> {
+  if (variant == QStringLiteral("chip8")) {
+    return chip8::Variant::kChip8;
+  }
+
+  if (variant == QStringLiteral("schip")) {
+    return chip8::Variant::kSuperChip;
+  }
+
+  if (variant == QStringLiteral("xochip")) {
+    return chip8::Variant::kXoChip;
+  }
+  return std::nullopt;
+}
+}  // namespace
+
 AppSettingsModel::AppSettingsModel(QObject* parent_object) noexcept
     : QSettings(QStringLiteral("vm-tutorial.ini"), QSettings::IniFormat,
                 parent_object) {}
@@ -60,6 +83,16 @@ auto AppSettingsModel::GetLogFont() noexcept -> std::optional<QFont> {
   return f;
 }
 
+auto AppSettingsModel::GetLogMaxMessages() const noexcept -> int {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  return value(QStringLiteral("logger/max_messages"), 10000).toInt();
+}
+
+auto AppSettingsModel::GetDebuggerRefreshRate() const noexcept -> int {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  return value(QStringLiteral("debugger/refresh_rate"), 30).toInt();
+}
+
 auto AppSettingsModel::GetMachineFrameRate() const noexcept -> double {
   return value(QStringLiteral("machine/frame_rate"), 60.0).toDouble();
 }
@@ -68,6 +101,75 @@ auto AppSettingsModel::GetMachineInstructionsPerSecond() const noexcept -> int {
   return value(QStringLiteral("machine/instructions_per_second"), 500).toInt();
 }
 
+auto AppSettingsModel::GetMachineTurboFrameSkip() const noexcept -> int {
+  return value(QStringLiteral("machine/turbo_frame_skip"), 0).toInt();
+}
+
+auto AppSettingsModel::GetMachineVsyncPacing() const noexcept -> bool {
+  return value(QStringLiteral("machine/vsync_pacing"), false).toBool();
+}
+
+auto AppSettingsModel::GetMachineVariant() const noexcept
+    -> std::optional<chip8::Variant> {
+  return ParseVariant(value(QStringLiteral("machine/variant")).toString());
+}
+
+auto AppSettingsModel::GetRomProfileOverrides() noexcept
+    -> std::vector<std::pair<uint64_t, chip8::RomProfile>> {
+  std::vector<std::pair<uint64_t, chip8::RomProfile>> overrides;
+  beginGroup(QStringLiteral("roms"));
+
+  for (const auto& group : childGroups()) {
+    auto hash_valid = false;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    const auto hash = group.toULongLong(&hash_valid, 16);
+
+    if (!hash_valid) {
+      continue;
+    }
+
+    auto profile = chip8::RomDatabase::Get().FindBuiltInProfile(hash).value_or(
+        chip8::RomProfile{});
+
+    auto& quirks = profile.quirks_;
+    beginGroup(group);
+
+    profile.instructions_per_second_ =
+        value(QStringLiteral("instructions_per_second"),
+              profile.instructions_per_second_)
+            .toUInt();
+
+    quirks.shift_uses_vy_ =
+        value(QStringLiteral("shift_uses_vy"), quirks.shift_uses_vy_).toBool();
+
+    quirks.load_store_increments_i_ =
+        value(QStringLiteral("load_store_increments_i"),
+              quirks.load_store_increments_i_)
+            .toBool();
+
+    quirks.jump_uses_vx_ =
+        value(QStringLiteral("jump_uses_vx"), quirks.jump_uses_vx_).toBool();
+
+    quirks.logic_resets_vf_ =
+        value(QStringLiteral("logic_resets_vf"), quirks.logic_resets_vf_)
+            .toBool();
+
+    quirks.clip_sprites_ =
+        value(QStringLiteral("clip_sprites"), quirks.clip_sprites_).toBool();
+
+    profile.variant_ =
+        ParseVariant(value(QStringLiteral("variant")).toString())
+            .value_or(profile.variant_);
+
+    endGroup();
+    overrides.emplace_back(hash, profile);
+  }
+
+  endGroup();
+  return overrides;
+}
+
 auto AppSettingsModel::GetDebuggerFont() const noexcept -> QFont {
   const auto font = value(QStringLiteral("debugger/font")).toString();
 
@@ -91,6 +193,11 @@ auto AppSettingsModel::GetDebuggerFont() const noexcept -> QFont {
   return f;
 }
 
+auto AppSettingsModel::GetShowFrameTelemetry() const noexcept -> bool {
+  return value(QStringLiteral("main_window/show_frame_telemetry"), false)
+      .toBool();
+}
+
 void AppSettingsModel::SetMachineFrameRate(double frame_rate) noexcept {
   setValue(QStringLiteral("machine/frame_rate"), frame_rate);
 }
@@ -101,6 +208,44 @@ void AppSettingsModel::SetMachineInstructionsPerSecond(
            instructions_per_second);
 }
 
+void AppSettingsModel::SetMachineTurboFrameSkip(const int frame_skip) noexcept {
+  setValue(QStringLiteral("machine/turbo_frame_skip"), frame_skip);
+}
+
+void AppSettingsModel::SetMachineVsyncPacing(const bool enabled) noexcept {
+  setValue(QStringLiteral("machine/vsync_pacing"), enabled);
+}
+
+void AppSettingsModel::SetMachineVariant(
+    const std::optional<chip8::Variant> variant) noexcept {
+  if (!variant) {
+    remove(QStringLiteral("machine/variant"));
+    return;
+  }
+
+  switch (*variant) {
+    case chip8::Variant::kChip8:
+      setValue(QStringLiteral("machine/variant"), QStringLiteral("chip8"));
+      return;
+
+    case chip8::Variant::kSuperChip:
+      setValue(QStringLiteral("machine/variant"), QStringLiteral("schip"));
+      return;
+
+    case chip8::Variant::kXoChip:
+      setValue(QStringLiteral("machine/variant"), QStringLiteral("xochip"));
+      return;
+  }
+}
+
+void AppSettingsModel::SetShowFrameTelemetry(const bool show) noexcept {
+  setValue(QStringLiteral("main_window/show_frame_telemetry"), show);
+}
+
+void AppSettingsModel::SetDebuggerRefreshRate(const int refresh_rate) noexcept {
+  setValue(QStringLiteral("debugger/refresh_rate"), refresh_rate);
+}
+
 void AppSettingsModel::SetProgramFilesPath(const QString& path) noexcept {
   setValue(QStringLiteral("paths/program_files"), path);
 }
@@ -126,6 +271,10 @@ void AppSettingsModel::SetLogFont(const QFont& font) noexcept {
   setValue(QStringLiteral("logger/font"), font.toString());
 }
 
+void AppSettingsModel::SetLogMaxMessages(const int max_messages) noexcept {
+  setValue(QStringLiteral("logger/max_messages"), max_messages);
+}
+
 void AppSettingsModel::SetLogLevelColor(const QString& level_name,
                                         const QColor& color) noexcept {
   const auto level_str = QString{"logger/%1_level_color"}.arg(level_name);
@@ -12,11 +12,15 @@
 
 #pragma once
 
+#include <core/rom_database.h>
 #include <core/spec.h>
 
 #include <QColor>
 #include <QFont>
 #include <QSettings>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include "types.h"
 
@@ -79,6 +83,12 @@ class AppSettingsModel : public QSettings {
   /// no font exists, the default font on the system should be used.
   auto GetLogFont() noexcept -> std::optional<QFont>;
 
+  /// Tries to determine how many messages the logger window keeps before
+  /// discarding the oldest ones.
+  ///
+  /// \returns The maximum number of log messages, or 10000 by default.
+  auto GetLogMaxMessages() const noexcept -> int;
+
   /// Tries to find the desired frame rate for the virtual machine.
   ///
   /// \returns The desired frame rate of the virtual machine, if any, or \p 60.0
@@ -92,6 +102,41 @@ class AppSettingsModel : public QSettings {
   /// machine, if any, or \p 500 by default.
   auto GetMachineInstructionsPerSecond() const noexcept -> int;
 
+  /// Tries to find how often a frame should be presented when the virtual
+  /// machine runs in turbo mode.
+  ///
+  /// \returns The number of frames executed per frame presented, if any, or \p
+  /// 0 by default, meaning at most one frame per host refresh is presented.
+  auto GetMachineTurboFrameSkip() const noexcept -> int;
+
+  /// Tries to determine whether or not the display should pace the virtual
+  /// machine.
+  ///
+  /// \returns \p true if one frame should be executed per display refresh, or
+  /// \p false by default.
+  auto GetMachineVsyncPacing() const noexcept -> bool;
+
+  /// Tries to find the variant of the programs unknown to \ref
+  /// chip8::RomDatabase, stored as one of `chip8`, `schip` or `xochip`.
+  ///
+  /// \returns The variant, if any, or nothing by default, meaning that it
+  /// should be guessed from the extension of the ROM file.
+  auto GetMachineVariant() const noexcept -> std::optional<chip8::Variant>;
+
+  /// Tries to find the programs whose profile the user overrode within the
+  /// configuration file.
+  ///
+  /// Each program has a `roms/<hash>` group, where the hash is that of \ref
+  /// chip8::analysis::HashProgram() in hexadecimal. The group may contain
+  /// `instructions_per_second`, a key per quirk, named after the members of
+  /// \ref chip8::Quirks without the trailing underscore, and `variant`, which
+  /// is one of `chip8`, `schip` or `xochip`. Any key left out keeps the value
+  /// of the built-in profile.
+  ///
+  /// \returns The hash and overridden profile of each program.
+  auto GetRomProfileOverrides() noexcept
+      -> std::vector<std::pair<uint64_t, chip8::RomProfile>>;
+
   /// Tries to determine the font of the debugger.
   ///
   /// \returns The font of the debugger. If no font was set, a default font is
@@ -101,6 +146,19 @@ class AppSettingsModel : public QSettings {
   /// the default fixed font of the system is used.
   auto GetDebuggerFont() const noexcept -> QFont;
 
+  /// Tries to determine how many times per second the debugger refreshes its
+  /// views while the virtual machine is running.
+  ///
+  /// \returns The refresh rate of the debugger in Hz, or 30 by default.
+  auto GetDebuggerRefreshRate() const noexcept -> int;
+
+  /// Tries to determine whether or not the frame time telemetry should be
+  /// displayed in the status bar of the main window.
+  ///
+  /// \returns \p true if the telemetry should be displayed, or \p false by
+  /// default.
+  auto GetShowFrameTelemetry() const noexcept -> bool;
+
   /// Sets frame rate within the configuration file.
   ///
   /// \param frame_rate The new desired frame rate of the virtual machine.
@@ -113,6 +171,39 @@ class AppSettingsModel : public QSettings {
   /// execute per second.
   void SetMachineInstructionsPerSecond(int instructions_per_second) noexcept;
 
+  /// Sets how often a frame should be presented in turbo mode within the
+  /// configuration file.
+  ///
+  /// \param frame_skip The number of frames executed per frame presented, or
+  /// \p 0 to present at most one frame per host refresh.
+  void SetMachineTurboFrameSkip(int frame_skip) noexcept;
+
+  /// Sets whether or not the display should pace the virtual machine within
+  /// the configuration file.
+  ///
+  /// \param enabled Whether or not one frame should be executed per display
+  /// refresh.
+  void SetMachineVsyncPacing(bool enabled) noexcept;
+
+  /// Sets the variant of the programs unknown to \ref chip8::RomDatabase
+  /// within the configuration file.
+  ///
+  /// \param variant The variant, or nothing to guess it from the extension of
+  /// the ROM file.
+  void SetMachineVariant(std::optional<chip8::Variant> variant) noexcept;
+
+  /// Sets whether or not the frame time telemetry should be displayed in the
+  /// status bar of the main window.
+  ///
+  /// \param show Whether or not the telemetry should be displayed.
+  void SetShowFrameTelemetry(bool show) noexcept;
+
+  /// Sets how many times per second the debugger should refresh its views
+  /// while the virtual machine is running within the configuration file.
+  ///
+  /// \param refresh_rate The refresh rate of the debugger, in Hz.
+  void SetDebuggerRefreshRate(int refresh_rate) noexcept;
+
   /// Sets the default path of the guest program files within the configuration
   /// file.
   ///
@@ -145,6 +236,12 @@ class AppSettingsModel : public QSettings {
   /// \param font The log font to use.
   void SetLogFont(const QFont& font) noexcept;
 
+  /// Sets how many messages the logger window keeps before discarding the
+  /// oldest ones within the configuration file.
+  ///
+  /// \param max_messages The maximum number of log messages.
+  void SetLogMaxMessages(int max_messages) noexcept;
+
   /// Sets the color of a log level within the configuration file.
   ///
   /// \param level_name The name of a level to associate a color with.
@@ -15,20 +15,23 @@
 #include <core/disasm.h>
 
 #include <QIcon>
+#include <array>
 
 DebuggerDisasmModel::DebuggerDisasmModel(
-    QObject* parent_object, chip8::VMInstance& vm_instance) noexcept
+    QObject* parent_object, const chip8::StateSnapshot& snapshot) noexcept
     : QAbstractTableModel(parent_object),
-      vm_instance_(vm_instance),
+      snapshot_(snapshot),
       breakpoint_pixmap_(QIcon(QStringLiteral(":/assets/bp_indicator.png"))
                              .pixmap(QSize(12, 12))),
       current_address_pixmap_(
           QIcon(QStringLiteral(":/assets/current_pointer.png"))
-              .pixmap(QSize(12, 12))) {}
+              .pixmap(QSize(12, 12))) {
+  RenderAllRows();
+}
 
 auto DebuggerDisasmModel::GetRowFromAddress(
     const uint_fast16_t address) const noexcept -> int {
-  return static_cast<int>((start_address_ - address) /
+  return static_cast<int>((address - start_address_) /
                           chip8::data_size::kInstructionLength);
 }
 
@@ -39,17 +42,153 @@ auto DebuggerDisasmModel::GetAddressFromRow(
 
 auto DebuggerDisasmModel::SetStartAddress(uint_fast16_t address) noexcept
     -> bool {
-  if (address >= chip8::data_size::kInternalMemory) {
+  if (address >= snapshot_.memory_.size()) {
     return false;
   }
 
+  const auto alignment = address % chip8::data_size::kInstructionLength;
+
+  if (alignment == start_address_) {
+    return true;
+  }
+
   beginResetModel();
-  start_address_ = address;
+  start_address_ = alignment;
+  RenderAllRows();
   endResetModel();
 
   return true;
 }
 
+void DebuggerDisasmModel::Refresh() noexcept {
+  if (rows_.size() != GetNumberOfRows()) {
+    beginResetModel();
+    RenderAllRows();
+    endResetModel();
+    return;
+  }
+
+  std::vector<bool> text_changed(rows_.size(), false);
+  std::vector<bool> indicator_changed(rows_.size(), false);
+
+  for (auto row = 0; row < static_cast<int>(rows_.size()); ++row) {
+    auto& cached_row = rows_[row];
+
+    const auto instruction = FetchInstruction(row);
+
+    if (instruction != cached_row.instruction_) {
+      cached_row.instruction_ = instruction;
+      RenderRow(row);
+
+      text_changed[row] = true;
+    }
+
+    const auto indicator = DetermineIndicator(row);
+
+    if (indicator != cached_row.indicator_) {
+      cached_row.indicator_ = indicator;
+      indicator_changed[row] = true;
+    }
+  }
+
+  EmitRowsChanged(text_changed, Section::kRawInstruction,
+                  Section::kDisassembly);
+  EmitRowsChanged(indicator_changed, Section::kBreakpoint,
+                  Section::kBreakpoint);
+}
+
+auto DebuggerDisasmModel::FetchInstruction(const int row) const noexcept
+    -> uint_fast16_t {
+  const auto address = GetAddressFromRow(row);
+
+  const auto hi = snapshot_.memory_[address + 0];
+  const auto lo = snapshot_.memory_[address + 1];
+
+  return (hi << 8) | lo;
+}
+
+auto DebuggerDisasmModel::DetermineIndicator(const int row) noexcept
+    -> Indicator {
+  const auto address = GetAddressFromRow(row);
+
+  if (snapshot_.HasBreakpoint(address)) {
+    return Indicator::kBreakpoint;
+  }
+
+  if (snapshot_.program_counter_ == address) {
+    return Indicator::kCurrentAddress;
+  }
+  return Indicator::kNone;
+}
+
+void DebuggerDisasmModel::RenderRow(const int row) noexcept {
+  auto& cached_row = rows_[row];
+
+  cached_row.raw_instruction_ =
+      QStringLiteral("%1")
+          .arg(cached_row.instruction_, 4, 16, QLatin1Char('0'))
+          .toUpper();
+
+  const chip8::Instruction instruction(cached_row.instruction_);
+
+  std::array<char, chip8::debug::kMaxDisassemblyLength> disassembly;
+  const auto length = chip8::debug::DisassembleInstruction(
+      instruction, disassembly.data(), disassembly.size());
+
+  cached_row.disassembly_ =
+      QString::fromLatin1(disassembly.data(), static_cast<qsizetype>(length));
+}
+
+void DebuggerDisasmModel::RenderAllRows() noexcept {
+  const auto num_rows = GetNumberOfRows();
+
+  rows_.clear();
+  rows_.resize(num_rows);
+
+  for (auto row = 0; row < static_cast<int>(num_rows); ++row) {
+    auto& cached_row = rows_[row];
+
+    cached_row.instruction_ = FetchInstruction(row);
+    cached_row.indicator_ = DetermineIndicator(row);
+    cached_row.address_ =
+        QStringLiteral("$%1")
+            .arg(GetAddressFromRow(row), 4, 16, QLatin1Char('0'))
+            .toUpper();
+    RenderRow(row);
+  }
+}
+
+auto DebuggerDisasmModel::GetNumberOfRows() const noexcept -> size_t {
+  const auto memory_size = snapshot_.memory_.size();
+
+  if (start_address_ >= memory_size) {
+    return 0;
+  }
+
+  // The last instruction must fit in memory as a whole.
+  return (memory_size - start_address_) / chip8::data_size::kInstructionLength;
+}
+
+void DebuggerDisasmModel::EmitRowsChanged(const std::vector<bool>& changed,
+                                          const int first_column,
+                                          const int last_column) noexcept {
+  const auto num_rows = static_cast<int>(changed.size());
+
+  for (auto row = 0; row < num_rows; ++row) {
+    if (!changed[row]) {
+      continue;
+    }
+
+    const auto first_row = row;
+
+    while ((row + 1 < num_rows) && changed[row + 1]) {
+      ++row;
+    }
+
+    emit dataChanged(index(first_row, first_column), index(row, last_column));
+  }
+}
+
 auto DebuggerDisasmModel::columnCount(const QModelIndex& parent) const noexcept
     -> int {
   return 5;
@@ -57,42 +196,24 @@ auto DebuggerDisasmModel::columnCount(const QModelIndex& parent) const noexcept
 
 auto DebuggerDisasmModel::rowCount(const QModelIndex& parent) const noexcept
     -> int {
-  return (chip8::data_size::kInternalMemory - start_address_) /
-         chip8::data_size::kInstructionLength;
+  return static_cast<int>(rows_.size());
 }
 
 auto DebuggerDisasmModel::data(const QModelIndex& index,
                                int role) const noexcept -> QVariant {
-  const auto address = GetAddressFromRow(index.row());
+  const auto& row = rows_[index.row()];
 
   switch (role) {
     case Qt::DisplayRole:
       switch (index.column()) {
         case Section::kAddress:
-          return QStringLiteral("$%1")
-              .arg(address, 4, 16, QLatin1Char('0'))
-              .toUpper();
+          return row.address_;
 
-        case Section::kRawInstruction: {
-          const auto hi = vm_instance_.impl_->memory_[address + 0];
-          const auto lo = vm_instance_.impl_->memory_[address + 1];
+        case Section::kRawInstruction:
+          return row.raw_instruction_;
 
-          const auto result = (hi << 8) | lo;
-
-          return QStringLiteral("%1")
-              .arg(result, 4, 16, QLatin1Char('0'))
-              .toUpper();
-        }
-
-        case Section::kDisassembly: {
-          const auto hi = vm_instance_.impl_->memory_[address + 0];
-          const auto lo = vm_instance_.impl_->memory_[address + 1];
-
-          chip8::Instruction instruction((hi << 8) | lo);
-          const auto result = chip8::debug::DisassembleInstruction(instruction);
-
-          return QString::fromStdString(result);
-        }
+        case Section::kDisassembly:
+          return row.disassembly_;
 
         case Section::kResult:
           return {};
@@ -104,14 +225,16 @@ auto DebuggerDisasmModel::data(const QModelIndex& index,
     case Qt::DecorationRole:
       switch (index.column()) {
         case Section::kBreakpoint:
-          if (vm_instance_.FindBreakpoint(address)) {
-            return breakpoint_pixmap_;
-          }
+          switch (row.indicator_) {
+            case Indicator::kBreakpoint:
+              return breakpoint_pixmap_;
+
+            case Indicator::kCurrentAddress:
+              return current_address_pixmap_;
 
-          if (vm_instance_.impl_->program_counter_ == address) {
-            return current_address_pixmap_;
+            default:
+              return {};
           }
-          return {};
 
         default:
           return {};
@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <core/snapshot.h>
 #include <core/vm_instance.h>
 
 #include <QAbstractTableModel>
 #include <QPixmap>
+#include <vector>
 
 /// This class provides a model to display CHIP-8 disassembly.
 class DebuggerDisasmModel : public QAbstractTableModel {
@@ -27,9 +29,10 @@ class DebuggerDisasmModel : public QAbstractTableModel {
   /// \param parent_widget The parent object of which this class is a child of
   /// it.
   ///
-  /// \param vm_instance The virtual machine instance.
+  /// \param snapshot The state of the virtual machine to disassemble, along
+  /// with the breakpoints to show.
   explicit DebuggerDisasmModel(QObject* parent_object,
-                               chip8::VMInstance& vm_instance) noexcept;
+                               const chip8::StateSnapshot& snapshot) noexcept;
 
   /// Determines the row within the model based on the address passed.
   ///
@@ -40,6 +43,10 @@ class DebuggerDisasmModel : public QAbstractTableModel {
 
   /// Sets the address to start disassembling from.
   ///
+  /// Every row remains in the model; only the alignment of the instructions
+  /// is taken from \p address, so the model is only reset when the alignment
+  /// changes.
+  ///
   /// \param address The address to disassemble from.
   ///
   /// \returns \p true if the address was valid, or \p false otherwise.
@@ -50,6 +57,15 @@ class DebuggerDisasmModel : public QAbstractTableModel {
   /// \returns The address associated with a row.
   auto GetAddressFromRow(unsigned int row) const noexcept -> uint_fast16_t;
 
+  /// Brings the rendered rows up to date with the snapshot and the
+  /// breakpoints.
+  ///
+  /// Only the rows whose instruction, breakpoint or program counter state
+  /// changed since the last call are rendered again, and only those rows are
+  /// announced through \ref QAbstractItemModel::dataChanged(). If the size of
+  /// memory changed, the model is reset instead.
+  void Refresh() noexcept;
+
  private:
   /// From Qt documentation:
   ///
@@ -118,10 +134,75 @@ class DebuggerDisasmModel : public QAbstractTableModel {
     kResult
   };
 
-  /// The address to start disassembling from. This is necessary because CHIP-8
-  /// instructions are sadly not byte-aligned.
+  /// Defines the indicator shown in the \ref Section::kBreakpoint column.
+  enum class Indicator { kNone, kBreakpoint, kCurrentAddress };
+
+  /// A row as it is displayed, rendered ahead of time so that painting the
+  /// view doesn't decode or format anything.
+  struct Row {
+    /// The instruction the row was rendered from.
+    uint_fast16_t instruction_;
+
+    /// The indicator to show next to the row.
+    Indicator indicator_;
+
+    /// The rendered \ref Section::kAddress column.
+    QString address_;
+
+    /// The rendered \ref Section::kRawInstruction column.
+    QString raw_instruction_;
+
+    /// The rendered \ref Section::kDisassembly column.
+    QString disassembly_;
+  };
+
+  /// Reads the instruction a row refers to from memory.
+  ///
+  /// \param row The row.
+  ///
+  /// \returns The instruction.
+  auto FetchInstruction(int row) const noexcept -> uint_fast16_t;
+
+  /// Determines the indicator a row should show.
+  ///
+  /// \param row The row.
+  ///
+  /// \returns The indicator.
+  auto DetermineIndicator(int row) noexcept -> Indicator;
+
+  /// Renders the text of a row from its instruction.
+  ///
+  /// \param row The row to render.
+  void RenderRow(int row) noexcept;
+
+  /// Renders every row from scratch. Views must be told about this, for
+  /// example by a model reset.
+  void RenderAllRows() noexcept;
+
+  /// Determines how many rows there are from the start address to the end of
+  /// the memory of the snapshot, which depends on the variant of the program.
+  ///
+  /// \returns The number of rows.
+  auto GetNumberOfRows() const noexcept -> size_t;
+
+  /// Emits \ref QAbstractItemModel::dataChanged() for each run of consecutive
+  /// rows that changed.
+  ///
+  /// \param changed Whether or not each row changed.
+  ///
+  /// \param first_column The first column that changed.
+  ///
+  /// \param last_column The last column that changed.
+  void EmitRowsChanged(const std::vector<bool>& changed, int first_column,
+                       int last_column) noexcept;
+
+  /// The alignment of the instructions, which is the address of the first row.
+  /// This is necessary because CHIP-8 instructions are sadly not byte-aligned.
   uint_fast16_t start_address_ = 0x000;
 
+  /// The rendered rows.
+  std::vector<Row> rows_;
+
   /// The pixmap used to indicate that a breakpoint is set on an address.
   QPixmap breakpoint_pixmap_;
 
@@ -129,6 +210,6 @@ class DebuggerDisasmModel : public QAbstractTableModel {
   /// current stack pointer.
   QPixmap current_address_pixmap_;
 
-  /// The virtual machine instance.
-  chip8::VMInstance& vm_instance_;
+  /// The state of the virtual machine to disassemble.
+  const chip8::StateSnapshot& snapshot_;
 };
\ No newline at end of file
@@ -12,16 +12,33 @@
 
 #include "debugger_registers.h"
 
+#include <QColor>
+#include <algorithm>
+
 DebuggerRegistersModel::DebuggerRegistersModel(
-    QObject* parent_object, chip8::VMInstance& vm_instance) noexcept
-    : QAbstractListModel(parent_object), vm_instance_(vm_instance) {}
+    QObject* parent_object, const chip8::StateSnapshot& snapshot) noexcept
+    : QAbstractListModel(parent_object), snapshot_(snapshot) {}
+
+void DebuggerRegistersModel::Refresh() noexcept {
+  RowChangeTracker<kNumRows>::Values values;
+
+  std::copy(snapshot_.V_.cbegin(), snapshot_.V_.cend(), values.begin());
+
+  values[Rows::kSP] = snapshot_.stack_pointer_;
+  values[Rows::kPC] = snapshot_.program_counter_;
+  values[Rows::kDT] = snapshot_.delay_timer_;
+  values[Rows::kST] = snapshot_.sound_timer_;
+
+  row_change_tracker_.Update(values);
+  row_change_tracker_.ForEachDirtyRun([this](const int first, const int last) {
+    emit dataChanged(index(first, Columns::kValue),
+                     index(last, Columns::kValue));
+  });
+}
 
 auto DebuggerRegistersModel::rowCount(const QModelIndex&) const noexcept
     -> int {
-  /// The additional rows are for the program counter, stack pointer, delay and
-  /// sound timers.
-  constexpr auto kAdditionalRows = 4;
-  return chip8::data_size::kV + kAdditionalRows;
+  return kNumRows;
 }
 
 auto DebuggerRegistersModel::columnCount(const QModelIndex&) const noexcept
@@ -61,28 +78,25 @@ auto DebuggerRegistersModel::data(const QModelIndex& index,
           switch (row) {
             case Rows::kV0... Rows::kVF:
               return QStringLiteral("$%1")
-                  .arg(vm_instance_.impl_->V_[row], 2, 16, QLatin1Char('0'))
+                  .arg(snapshot_.V_[row], 2, 16, QLatin1Char('0'))
                   .toUpper();
 
             case Rows::kSP:
-              return QString::number(vm_instance_.impl_->stack_pointer_);
+              return QString::number(snapshot_.stack_pointer_);
 
             case Rows::kPC:
               return QStringLiteral("$%1")
-                  .arg(vm_instance_.impl_->program_counter_, 4, 16,
-                       QLatin1Char('0'))
+                  .arg(snapshot_.program_counter_, 4, 16, QLatin1Char('0'))
                   .toUpper();
 
             case Rows::kDT:
               return QStringLiteral("$%1")
-                  .arg(vm_instance_.impl_->delay_timer_, 2, 16,
-                       QLatin1Char('0'))
+                  .arg(snapshot_.delay_timer_, 2, 16, QLatin1Char('0'))
                   .toUpper();
 
             case Rows::kST:
               return QStringLiteral("$%1")
-                  .arg(vm_instance_.impl_->sound_timer_, 2, 16,
-                       QLatin1Char('0'))
+                  .arg(snapshot_.sound_timer_, 2, 16, QLatin1Char('0'))
                   .toUpper();
 
             default:
@@ -93,6 +107,13 @@ auto DebuggerRegistersModel::data(const QModelIndex& index,
           return {};
       }
 
+    case Qt::ForegroundRole:
+      if ((index.column() == Columns::kValue) &&
+          row_change_tracker_.IsHighlighted(row)) {
+        return QColor(Qt::red);
+      }
+      return {};
+
     default:
       return {};
   }
@@ -12,10 +12,12 @@
 
 #pragma once
 
-#include <core/vm_instance.h>
+#include <core/snapshot.h>
 
 #include <QAbstractListModel>
 
+#include "row_change_tracker.h"
+
 /// This class provides a model to display the current CHIP-8 registers data.
 class DebuggerRegistersModel : public QAbstractListModel {
   Q_OBJECT
@@ -26,9 +28,13 @@ class DebuggerRegistersModel : public QAbstractListModel {
   /// \param parent_widget The parent object of which this class is a child of
   /// it.
   ///
-  /// \param vm_instance The virtual machine instance.
+  /// \param snapshot The state of the virtual machine to display.
   DebuggerRegistersModel(QObject* parent_object,
-                         chip8::VMInstance& vm_instance) noexcept;
+                         const chip8::StateSnapshot& snapshot) noexcept;
+
+  /// Notifies the views of the registers whose value changed since the last
+  /// refresh, and highlights them for a short time.
+  void Refresh() noexcept;
 
  private:
   /// From Qt documentation:
@@ -123,6 +129,12 @@ class DebuggerRegistersModel : public QAbstractListModel {
     kST,
   };
 
-  /// The virtual machine instance.
-  chip8::VMInstance& vm_instance_;
+  /// The number of rows.
+  static constexpr size_t kNumRows = Rows::kST + 1;
+
+  /// Finds the registers that changed between refreshes.
+  RowChangeTracker<kNumRows> row_change_tracker_;
+
+  /// The state of the virtual machine to display.
+  const chip8::StateSnapshot& snapshot_;
 };
@@ -12,16 +12,38 @@
 
 #include "debugger_stack.h"
 
+#include <QColor>
 #include <QIcon>
+#include <algorithm>
 
-DebuggerStackModel::DebuggerStackModel(QObject* parent_object,
-                                       chip8::VMInstance& vm_instance) noexcept
+DebuggerStackModel::DebuggerStackModel(
+    QObject* parent_object, const chip8::StateSnapshot& snapshot) noexcept
     : QAbstractListModel(parent_object),
-      vm_instance_(vm_instance),
+      snapshot_(snapshot),
       current_stack_pixmap_(
           QIcon(QStringLiteral(":/assets/current_pointer.png"))
               .pixmap(QSize(12, 12))) {}
 
+void DebuggerStackModel::Refresh() noexcept {
+  RowChangeTracker<chip8::data_size::kStack>::Values values;
+  std::copy(snapshot_.stack_.cbegin(), snapshot_.stack_.cend(), values.begin());
+
+  row_change_tracker_.Update(values);
+
+  // The pointer to the current entry moves without changing any value.
+  if (snapshot_.stack_pointer_ != stack_pointer_) {
+    row_change_tracker_.MarkDirty(stack_pointer_);
+    row_change_tracker_.MarkDirty(snapshot_.stack_pointer_);
+
+    stack_pointer_ = snapshot_.stack_pointer_;
+  }
+
+  row_change_tracker_.ForEachDirtyRun([this](const int first, const int last) {
+    emit dataChanged(index(first, Columns::kEntry),
+                     index(last, Columns::kValue));
+  });
+}
+
 auto DebuggerStackModel::rowCount(const QModelIndex&) const noexcept -> int {
   return chip8::data_size::kStack;
 }
@@ -42,7 +64,7 @@ auto DebuggerStackModel::data(const QModelIndex& index, int role) const noexcept
 
         case Columns::kValue:
           return QStringLiteral("$%1")
-              .arg(vm_instance_.impl_->stack_[row], 4, 16, QLatin1Char('0'))
+              .arg(snapshot_.stack_[row], 4, 16, QLatin1Char('0'))
               .toUpper();
 
         default:
@@ -52,11 +74,18 @@ auto DebuggerStackModel::data(const QModelIndex& index, int role) const noexcept
 
     case Qt::DecorationRole:
       if ((index.column() == Columns::kEntry) &&
-          (index.row() == vm_instance_.impl_->stack_pointer_)) {
+          (index.row() == stack_pointer_)) {
         return current_stack_pixmap_;
       }
       return {};
 
+    case Qt::ForegroundRole:
+      if ((index.column() == Columns::kValue) &&
+          row_change_tracker_.IsHighlighted(index.row())) {
+        return QColor(Qt::red);
+      }
+      return {};
+
     default:
       return {};
   }
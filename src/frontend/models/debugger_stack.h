@@ -12,11 +12,13 @@
 
 #pragma once
 
-#include <core/vm_instance.h>
+#include <core/snapshot.h>
 
 #include <QAbstractListModel>
 #include <QPixmap>
 
+#include "row_change_tracker.h"
+
 /// This class provides a model to display the current CHIP-8 stack data.
 class DebuggerStackModel : public QAbstractListModel {
   Q_OBJECT
@@ -27,9 +29,13 @@ class DebuggerStackModel : public QAbstractListModel {
   /// \param parent_widget The parent object of which this class is a child of
   /// it.
   ///
-  /// \param vm_instance The virtual machine instance.
+  /// \param snapshot The state of the virtual machine to display.
   DebuggerStackModel(QObject* parent_object,
-                     chip8::VMInstance& vm_instance) noexcept;
+                     const chip8::StateSnapshot& snapshot) noexcept;
+
+  /// Notifies the views of the stack entries whose value changed since the
+  /// last refresh, and highlights them for a short time.
+  void Refresh() noexcept;
 
  private:
   /// From Qt documentation:
@@ -95,6 +101,12 @@ class DebuggerStackModel : public QAbstractListModel {
   /// Defines the column locations within a tree widget.
   enum Columns { kEntry, kValue };
 
-  /// The virtual machine instance.
-  chip8::VMInstance& vm_instance_;
+  /// Finds the stack entries that changed between refreshes.
+  RowChangeTracker<chip8::data_size::kStack> row_change_tracker_;
+
+  /// The stack pointer as of the last refresh.
+  ptrdiff_t stack_pointer_ = 0;
+
+  /// The state of the virtual machine to display.
+  const chip8::StateSnapshot& snapshot_;
 };
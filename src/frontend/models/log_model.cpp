@@ -0,0 +1,177 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include "log_model.h"
+
+#include <QDateTime>
+#include <algorithm>
+
+namespace {
+/// Retrieves the name of a log level as it is displayed.
+///
+/// \param level The log level.
+///
+/// \returns The name of \p level.
+auto GetLevelName(const chip8::Logger::LogLevel level) noexcept -> QString {
+  switch (level) {
+    case chip8::Logger::LogLevel::kInfo:
+      return QStringLiteral("INFO");
+
+    case chip8::Logger::LogLevel::kWarning:
+      return QStringLiteral("WARNING");
+
+    case chip8::Logger::LogLevel::kError:
+      return QStringLiteral("ERROR");
+
+    case chip8::Logger::LogLevel::kDebug:
+      return QStringLiteral("DEBUG");
+  }
+  return {};
+}
+}  // namespace
+
+LogModel::LogModel(QObject* parent_object) noexcept
+    : QAbstractListModel(parent_object) {}
+
+void LogModel::Append(std::vector<LogBuffer::Message>& messages,
+                      const size_t num_suppressed) noexcept {
+  const auto first_new = first_sequence_ + entries_.size();
+
+  if (num_suppressed != 0) {
+    // If nothing has been shown since the last counter, there's no point in
+    // showing another one; fold the messages into it instead.
+    if (!visible_.empty() &&
+        (entries_[visible_.back() - first_sequence_].num_suppressed_ != 0)) {
+      entries_[visible_.back() - first_sequence_].num_suppressed_ +=
+          num_suppressed;
+
+      const auto row = index(static_cast<int>(visible_.size() - 1));
+      emit dataChanged(row, row, {Qt::DisplayRole});
+    } else {
+      entries_.push_back({{}, num_suppressed});
+    }
+  }
+
+  for (auto& message : messages) {
+    entries_.push_back({std::move(message), 0});
+  }
+
+  const auto end_sequence = first_sequence_ + entries_.size();
+
+  std::vector<uint64_t> new_rows;
+
+  for (auto sequence = first_new; sequence < end_sequence; ++sequence) {
+    if (IsVisible(entries_[sequence - first_sequence_])) {
+      new_rows.push_back(sequence);
+    }
+  }
+
+  if (!new_rows.empty()) {
+    const auto first_row = static_cast<int>(visible_.size());
+
+    beginInsertRows({}, first_row,
+                    first_row + static_cast<int>(new_rows.size()) - 1);
+    visible_.insert(visible_.end(), new_rows.cbegin(), new_rows.cend());
+    endInsertRows();
+  }
+
+  Trim();
+}
+
+void LogModel::SetMaxMessages(const size_t max_messages) noexcept {
+  max_messages_ = max_messages;
+  Trim();
+}
+
+void LogModel::SetLevelVisible(const chip8::Logger::LogLevel level,
+                               const bool visible) noexcept {
+  auto& level_visible = level_visible_[static_cast<size_t>(level)];
+
+  if (level_visible == visible) {
+    return;
+  }
+
+  level_visible = visible;
+
+  beginResetModel();
+  visible_.clear();
+
+  for (size_t index = 0; index < entries_.size(); ++index) {
+    if (IsVisible(entries_[index])) {
+      visible_.push_back(first_sequence_ + index);
+    }
+  }
+  endResetModel();
+}
+
+auto LogModel::rowCount(const QModelIndex&) const noexcept -> int {
+  return static_cast<int>(visible_.size());
+}
+
+auto LogModel::data(const QModelIndex& index, int role) const noexcept
+    -> QVariant {
+  if (role != Qt::DisplayRole) {
+    return {};
+  }
+
+  const auto& entry = entries_[visible_[index.row()] - first_sequence_];
+
+  if (entry.num_suppressed_ != 0) {
+    return tr("%n message(s) suppressed", nullptr,
+              static_cast<int>(entry.num_suppressed_));
+  }
+
+  const auto& message = entry.message_;
+
+  const auto milliseconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          message.timestamp_.time_since_epoch());
+
+  const auto date = QDateTime::fromMSecsSinceEpoch(milliseconds.count())
+                        .toString(QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz"));
+
+  return QString{"[%1] [%2]: %3"}.arg(date, GetLevelName(message.level_),
+                                      QString::fromStdString(message.text_));
+}
+
+auto LogModel::IsVisible(const Entry& entry) const noexcept -> bool {
+  return (entry.num_suppressed_ != 0) ||
+         level_visible_[static_cast<size_t>(entry.message_.level_)];
+}
+
+void LogModel::Trim() noexcept {
+  if (entries_.size() <= max_messages_) {
+    return;
+  }
+
+  const auto num_discarded = entries_.size() - max_messages_;
+  const auto first_kept = first_sequence_ + num_discarded;
+
+  // Every row shown before the first entry kept goes away with it.
+  const auto rows_end =
+      std::lower_bound(visible_.cbegin(), visible_.cend(), first_kept);
+  const auto num_rows = static_cast<int>(rows_end - visible_.cbegin());
+
+  if (num_rows != 0) {
+    beginRemoveRows({}, 0, num_rows - 1);
+    visible_.erase(visible_.cbegin(), rows_end);
+  }
+
+  entries_.erase(entries_.begin(),
+                 entries_.begin() + static_cast<ptrdiff_t>(num_discarded));
+  first_sequence_ = first_kept;
+
+  if (num_rows != 0) {
+    endRemoveRows();
+  }
+}
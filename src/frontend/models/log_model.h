@@ -0,0 +1,133 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <array>
+#include <deque>
+
+#include "log_buffer.h"
+
+/// This class provides a model to display the messages of the logger window.
+///
+/// Only the rows a view actually shows are formatted, so the number of
+/// messages kept doesn't affect how long it takes to display them. The oldest
+/// messages are discarded once there are more than the configured maximum.
+///
+/// Messages dropped before they could be displayed are represented by a single
+/// row counting them. If more messages are dropped before anything else is
+/// displayed, that row is updated rather than adding another one.
+class LogModel : public QAbstractListModel {
+  Q_OBJECT
+
+ public:
+  /// Constructs the model for the logger window.
+  ///
+  /// \param parent_object The parent object of which this class is a child of
+  /// it.
+  explicit LogModel(QObject* parent_object) noexcept;
+
+  /// Appends messages to the model.
+  ///
+  /// \param messages The messages to append, oldest first. They are moved
+  /// from.
+  ///
+  /// \param num_suppressed The number of messages dropped before \p messages.
+  void Append(std::vector<LogBuffer::Message>& messages,
+              size_t num_suppressed) noexcept;
+
+  /// Sets the maximum number of messages to keep, discarding the oldest
+  /// messages if there are more.
+  ///
+  /// \param max_messages The maximum number of messages to keep.
+  void SetMaxMessages(size_t max_messages) noexcept;
+
+  /// Shows or hides the messages of a log level.
+  ///
+  /// \param level The log level to show or hide.
+  /// \param visible Whether or not messages of \p level should be shown.
+  void SetLevelVisible(chip8::Logger::LogLevel level, bool visible) noexcept;
+
+ private:
+  /// The number of log levels there are.
+  static constexpr size_t kNumLogLevels =
+      static_cast<size_t>(chip8::Logger::LogLevel::kDebug) + 1;
+
+  /// A row of the model.
+  struct Entry {
+    /// The message to display, if this isn't a suppressed message counter.
+    LogBuffer::Message message_;
+
+    /// The number of messages suppressed. If this isn't \p 0, the entry is a
+    /// suppressed message counter.
+    size_t num_suppressed_;
+  };
+
+  /// From Qt documentation:
+  ///
+  /// Returns the number of rows under the given \p parent. When the parent is
+  /// valid it means that rowCount is returning the number of children of
+  /// parent.
+  ///
+  /// Note: When implementing a table based model, \ref
+  /// QAbstractItemModel::rowCount() should return 0 when the parent is valid.
+  ///
+  /// Note: This function can be invoked via the meta-object system and from
+  /// QML. See \ref Q_INVOKABLE.
+  auto rowCount(const QModelIndex& parent = {}) const noexcept -> int override;
+
+  /// From Qt documentation:
+  ///
+  /// Returns the data stored under the given role for the item referred to
+  /// by the index.
+  ///
+  /// Note: If you do not have a value to return, return an invalid
+  /// \ref QVariant instead of returning 0.
+  ///
+  /// Note: This function can be invoked via the meta-object system and from
+  /// QML. See Q_INVOKABLE.
+  auto data(const QModelIndex& index, int role) const noexcept
+      -> QVariant override;
+
+  /// Determines whether or not an entry passes the level filter. Suppressed
+  /// message counters always do.
+  ///
+  /// \param entry The entry to check.
+  ///
+  /// \returns true if the entry should be shown, or false otherwise.
+  auto IsVisible(const Entry& entry) const noexcept -> bool;
+
+  /// Discards the oldest entries until there are no more than the maximum
+  /// number of messages.
+  void Trim() noexcept;
+
+  /// Every entry kept, oldest first.
+  std::deque<Entry> entries_;
+
+  /// The sequence number of the first entry. Entries are numbered in the order
+  /// they were appended, so that discarding the oldest entries doesn't
+  /// invalidate \ref visible_.
+  uint64_t first_sequence_ = 0;
+
+  /// The sequence numbers of the entries shown, one per row.
+  std::deque<uint64_t> visible_;
+
+  /// Whether or not the messages of each log level are shown, indexed by
+  /// \ref chip8::Logger::LogLevel.
+  std::array<bool, kNumLogLevels> level_visible_ = {true, true, true, true};
+
+  /// The maximum number of messages to keep.
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  size_t max_messages_ = 10000;
+};
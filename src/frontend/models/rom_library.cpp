@@ -0,0 +1,91 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include "rom_library.h"
+
+#include <QFileInfo>
+#include <QImage>
+
+RomLibraryModel::RomLibraryModel(QObject* parent_object) noexcept
+    : QAbstractListModel(parent_object) {}
+
+void RomLibraryModel::SetEntries(
+    std::vector<chip8::RomLibraryEntry> entries) noexcept {
+  beginResetModel();
+  entries_ = std::move(entries);
+  thumbnails_.assign(entries_.size(), QPixmap{});
+  endResetModel();
+}
+
+auto RomLibraryModel::GetPath(const QModelIndex& index) const noexcept
+    -> QString {
+  return QString::fromStdString(entries_[index.row()].path_);
+}
+
+auto RomLibraryModel::rowCount(const QModelIndex&) const noexcept -> int {
+  return static_cast<int>(entries_.size());
+}
+
+auto RomLibraryModel::data(const QModelIndex& index, int role) const noexcept
+    -> QVariant {
+  const auto& entry = entries_[index.row()];
+
+  switch (role) {
+    case Qt::DisplayRole:
+      return QFileInfo(QString::fromStdString(entry.path_)).fileName();
+
+    case Qt::DecorationRole:
+      return GetThumbnail(index.row());
+
+    case Qt::ToolTipRole:
+      return tr("%1\n"
+                "%2 bytes, hash %3\n"
+                "%4 basic blocks, %5 subroutines, %6 indirect jumps\n"
+                "%7 bytes of code")
+          .arg(QString::fromStdString(entry.path_))
+          .arg(entry.size_)
+          .arg(entry.hash_, 16, 16, QLatin1Char('0'))
+          .arg(entry.num_blocks_)
+          .arg(entry.num_subroutines_)
+          .arg(entry.num_indirect_jumps_)
+          .arg(entry.code_size_);
+
+    default:
+      return {};
+  }
+}
+
+auto RomLibraryModel::GetThumbnail(const int row) const noexcept
+    -> const QPixmap& {
+  auto& thumbnail = thumbnails_[row];
+
+  if (!thumbnail.isNull()) {
+    return thumbnail;
+  }
+
+  const auto& entry = entries_[row];
+
+  QImage image{chip8::framebuffer::kWidth, chip8::framebuffer::kHeight,
+               QImage::Format_RGB32};
+
+  for (auto y = 0; y < chip8::framebuffer::kHeight; ++y) {
+    for (auto x = 0; x < chip8::framebuffer::kWidth; ++x) {
+      image.setPixelColor(x, y, entry.IsPixelOn(x, y) ? Qt::white : Qt::black);
+    }
+  }
+
+  thumbnail = QPixmap::fromImage(
+      image.scaled(image.size() * kThumbnailScale, Qt::IgnoreAspectRatio,
+                   Qt::FastTransformation));
+  return thumbnail;
+}
@@ -0,0 +1,90 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <core/rom_library.h>
+
+#include <QAbstractListModel>
+#include <QPixmap>
+#include <vector>
+
+/// This class provides a model to list the ROM files of the ROM library, each
+/// with the thumbnail taken when it was indexed.
+class RomLibraryModel : public QAbstractListModel {
+  Q_OBJECT
+
+ public:
+  /// The size of a thumbnail, in pixels per CHIP-8 pixel.
+  static constexpr auto kThumbnailScale = 2;
+
+  /// Constructs the model for the ROM library.
+  ///
+  /// \param parent_object The parent object of which this class is a child of
+  /// it.
+  explicit RomLibraryModel(QObject* parent_object) noexcept;
+
+  /// Replaces the ROM files listed.
+  ///
+  /// \param entries The ROM files to list.
+  void SetEntries(std::vector<chip8::RomLibraryEntry> entries) noexcept;
+
+  /// Retrieves the path to the ROM file of a row.
+  ///
+  /// \param index The row of the ROM file.
+  ///
+  /// \returns The path to the ROM file.
+  auto GetPath(const QModelIndex& index) const noexcept -> QString;
+
+ private:
+  /// From Qt documentation:
+  ///
+  /// Returns the number of rows under the given \p parent. When the parent is
+  /// valid it means that rowCount is returning the number of children of
+  /// parent.
+  ///
+  /// Note: When implementing a table based model, \ref
+  /// QAbstractItemModel::rowCount() should return 0 when the parent is valid.
+  ///
+  /// Note: This function can be invoked via the meta-object system and from
+  /// QML. See \ref Q_INVOKABLE.
+  auto rowCount(const QModelIndex& parent = {}) const noexcept -> int override;
+
+  /// From Qt documentation:
+  ///
+  /// Returns the data stored under the given role for the item referred to
+  /// by the index.
+  ///
+  /// Note: If you do not have a value to return, return an invalid
+  /// \ref QVariant instead of returning 0.
+  ///
+  /// Note: This function can be invoked via the meta-object system and from
+  /// QML. See Q_INVOKABLE.
+  auto data(const QModelIndex& index, int role) const noexcept
+      -> QVariant override;
+
+  /// Retrieves the thumbnail of a ROM file, drawing it the first time it is
+  /// needed.
+  ///
+  /// \param row The row of the ROM file.
+  ///
+  /// \returns The thumbnail of the ROM file.
+  auto GetThumbnail(int row) const noexcept -> const QPixmap&;
+
+  /// The ROM files listed.
+  std::vector<chip8::RomLibraryEntry> entries_;
+
+  /// The thumbnails drawn so far, one per ROM file. Thumbnails are only drawn
+  /// when a view asks for them, so listing thousands of ROM files is cheap.
+  mutable std::vector<QPixmap> thumbnails_;
+};
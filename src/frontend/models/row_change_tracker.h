@@ -0,0 +1,122 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// This class finds the rows of a model whose value changed between two
+/// refreshes, so that only those rows are redrawn, and keeps them highlighted
+/// for a short time afterwards.
+///
+/// A highlight only goes away at a refresh; while the virtual machine is
+/// paused, the rows changed by the last refresh stay highlighted.
+///
+/// \tparam NumRows The number of rows in the model.
+template <size_t NumRows>
+class RowChangeTracker {
+ public:
+  /// The clock used to time highlights.
+  using Clock = std::chrono::steady_clock;
+
+  /// The value of each row.
+  using Values = std::array<uint_fast32_t, NumRows>;
+
+  /// How long a row stays highlighted after its value changed.
+  static constexpr auto kHighlightDuration = std::chrono::milliseconds{500};
+
+  /// Compares the values of each row against the ones from the last update.
+  ///
+  /// The first update only records the values; nothing is highlighted.
+  ///
+  /// \param values The current value of each row.
+  /// \param now The current point in time.
+  void Update(const Values& values,
+              const Clock::time_point now = Clock::now()) noexcept {
+    for (size_t row = 0; row < NumRows; ++row) {
+      const auto changed = values[row] != values_[row];
+
+      if (changed && initialized_) {
+        highlight_end_[row] = now + kHighlightDuration;
+      }
+
+      const auto highlighted = now < highlight_end_[row];
+
+      dirty_[row] = changed || (highlighted != highlighted_[row]);
+      highlighted_[row] = highlighted;
+    }
+
+    values_ = values;
+    initialized_ = true;
+  }
+
+  /// Marks a row as needing to be redrawn for a reason other than its value,
+  /// without highlighting it. This lasts until the next update.
+  ///
+  /// \param row The row to redraw.
+  void MarkDirty(const size_t row) noexcept {
+    if (row < NumRows) {
+      dirty_[row] = true;
+    }
+  }
+
+  /// Determines whether or not a row is highlighted.
+  ///
+  /// \param row The row.
+  ///
+  /// \returns \p true if the value of the row changed recently, or \p false
+  /// otherwise.
+  auto IsHighlighted(const size_t row) const noexcept -> bool {
+    return highlighted_[row];
+  }
+
+  /// Calls a function for each run of consecutive rows that have to be
+  /// redrawn since the last update.
+  ///
+  /// \param function The function to call with the first and last row of
+  /// each run.
+  template <typename Function>
+  void ForEachDirtyRun(Function&& function) const noexcept {
+    for (size_t row = 0; row < NumRows; ++row) {
+      if (!dirty_[row]) {
+        continue;
+      }
+
+      const auto first_row = row;
+
+      while ((row + 1 < NumRows) && dirty_[row + 1]) {
+        ++row;
+      }
+      function(static_cast<int>(first_row), static_cast<int>(row));
+    }
+  }
+
+ private:
+  /// The value of each row as of the last update.
+  Values values_{};
+
+  /// The point in time at which the highlight of each row ends.
+  std::array<Clock::time_point, NumRows> highlight_end_{};
+
+  /// Whether or not each row is highlighted.
+  std::array<bool, NumRows> highlighted_{};
+
+  /// Whether or not each row has to be redrawn since the last update.
+  std::array<bool, NumRows> dirty_{};
+
+  /// Whether or not the values have been updated at least once.
+  bool initialized_ = false;
+};
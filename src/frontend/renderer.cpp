@@ -12,6 +12,9 @@
 
 #include "renderer.h"
 
+#include <QFontDatabase>
+#include <QPainter>
+
 #include "models/app_settings.h"
 
 namespace {
@@ -40,17 +43,53 @@ void Renderer::resizeGL(const int w, const int h) noexcept {
 void Renderer::paintGL() noexcept {
   glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
   glClear(GL_COLOR_BUFFER_BIT);
+
+  // Drawing the overlay with QPainter leaves its own state behind.
+  glUseProgram(program_);
+  glBindVertexArray(vao_);
+
   glBindTexture(GL_TEXTURE_2D, texture_);
   glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
   glBindTexture(GL_TEXTURE_2D, 0);
+
+  if (!overlay_text_.isEmpty()) {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    constexpr auto kMargin = 8;
+
+    QPainter painter{this};
+    painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    painter.setPen(Qt::yellow);
+    painter.drawText(rect().adjusted(kMargin, kMargin, -kMargin, -kMargin),
+                     Qt::AlignLeft | Qt::AlignTop, overlay_text_);
+  }
+
+  emit FramePresented();
+}
+
+void Renderer::SetOverlayText(const QString& text) noexcept {
+  overlay_text_ = text;
+  update();
 }
 
-void Renderer::UpdateScreen(
-    const chip8::ImplementationInterface::Framebuffer& framebuffer) noexcept {
+void Renderer::UpdateScreen(const chip8::Screen& framebuffer) noexcept {
+  const auto width = framebuffer.GetWidth();
+  const auto height = framebuffer.GetHeight();
+
+  // The framebuffer packs a pixel into a bit of each plane; the texture wants
+  // BGRA32.
+  pixels_.resize(static_cast<size_t>(width) * height);
+
+  for (unsigned int y = 0; y < height; ++y) {
+    for (unsigned int x = 0; x < width; ++x) {
+      pixels_[(y * width) + x] =
+          chip8::pixel::kPalette[framebuffer.GetPixel(x, y)];
+    }
+  }
+
   glBindTexture(GL_TEXTURE_2D, texture_);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, chip8::framebuffer::kWidth,
-               chip8::framebuffer::kHeight, 0, GL_BGRA, GL_UNSIGNED_BYTE,
-               framebuffer.data());
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(width),
+               static_cast<GLsizei>(height), 0, GL_BGRA, GL_UNSIGNED_BYTE,
+               pixels_.data());
   update();
 }
 
@@ -16,6 +16,8 @@
 
 #include <QOpenGLFunctions_4_1_Core>
 #include <QOpenGLWidget>
+#include <QString>
+#include <vector>
 
 /// This class handles OpenGL rendering for the CHIP-8 framebuffer. It is
 /// displayed as the central widget of the main window.
@@ -29,11 +31,17 @@ class Renderer : public QOpenGLWidget, public QOpenGLFunctions_4_1_Core {
   /// it.
   explicit Renderer(QWidget* parent_widget) noexcept;
 
-  /// Updates the screen with new framebuffer data.
+  /// Updates the screen with new framebuffer data. Each pixel is drawn in the
+  /// color of \ref chip8::pixel::kPalette its planes select.
   ///
   /// \param framebuffer The framebuffer data to display.
-  void UpdateScreen(
-      const chip8::ImplementationInterface::Framebuffer& framebuffer) noexcept;
+  void UpdateScreen(const chip8::Screen& framebuffer) noexcept;
+
+  /// Sets the text drawn on top of the screen, used to display debugging
+  /// information.
+  ///
+  /// \param text The text to draw, or an empty string to draw nothing.
+  void SetOverlayText(const QString& text) noexcept;
 
  protected:
   /// From Qt documentation:
@@ -131,4 +139,14 @@ class Renderer : public QOpenGLWidget, public QOpenGLFunctions_4_1_Core {
 
   /// The current program object.
   GLuint program_;
+
+  /// The screen in the format of the texture, see \ref UpdateScreen().
+  std::vector<uint32_t> pixels_;
+
+  /// The text drawn on top of the screen, see \ref SetOverlayText().
+  QString overlay_text_;
+
+ signals:
+  /// Emitted when a frame has been drawn.
+  void FramePresented();
 };
\ No newline at end of file
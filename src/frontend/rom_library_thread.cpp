@@ -0,0 +1,66 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#include "rom_library_thread.h"
+
+#include <QDir>
+#include <QStandardPaths>
+
+RomLibraryThread::RomLibraryThread(QObject* parent_object) noexcept
+    : QThread(parent_object) {
+  const auto cache_directory =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+  QDir().mkpath(cache_directory);
+
+  cache_file_name_ =
+      QDir(cache_directory).filePath("rom_library.cache").toStdString();
+}
+
+RomLibraryThread::~RomLibraryThread() noexcept {
+  requestInterruption();
+  wait();
+}
+
+auto RomLibraryThread::LoadCache() noexcept
+    -> const std::vector<chip8::RomLibraryEntry>& {
+  library_.Load(cache_file_name_);
+  return library_.entries_;
+}
+
+void RomLibraryThread::Scan(const QString& directory) noexcept {
+  if (isRunning()) {
+    return;
+  }
+
+  directory_ = directory.toStdString();
+  start(QThread::LowPriority);
+}
+
+auto RomLibraryThread::GetEntries() const noexcept
+    -> const std::vector<chip8::RomLibraryEntry>& {
+  return library_.entries_;
+}
+
+void RomLibraryThread::run() noexcept {
+  const auto num_entries = library_.entries_.size();
+  const auto num_read = library_.Scan(
+      directory_, [this]() { return isInterruptionRequested(); });
+
+  // There's no point in rewriting the cache file if nothing changed.
+  if (isInterruptionRequested() ||
+      ((num_read == 0) && (library_.entries_.size() == num_entries))) {
+    return;
+  }
+  library_.Save(cache_file_name_);
+}
@@ -0,0 +1,84 @@
+// vm-tutorial - Virtual machine tutorial targeting CHIP-8
+//
+// Written in 2021 by Michael Rodriguez aka kaichiuchu <mike@kaichiuchu.dev>
+//
+// To the extent possible under law, the author(s) have dedicated all copyright
+// and related and neighboring rights to this software to the public domain
+// worldwide. This software is distributed without any warranty.
+//
+// You should have received a copy of the CC0 Public Domain Dedication along
+// with this software. If not, see
+// <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+
+#pragma once
+
+#include <core/rom_library.h>
+
+#include <QThread>
+#include <string>
+#include <vector>
+
+/// This class keeps the ROM library up to date on a separate thread.
+///
+/// Indexing a ROM file means running it for a while to take its thumbnail,
+/// which adds up quickly over thousands of ROM files. The index of the last
+/// scan is kept in a cache file, so that the library can be listed right away
+/// at startup while the thread looks for ROM files that changed.
+class RomLibraryThread : public QThread {
+  Q_OBJECT
+
+ public:
+  /// Constructs the ROM library thread. The thread isn't started until \ref
+  /// Scan() is called.
+  ///
+  /// \param parent_object The parent object of which this class is a child of
+  /// it.
+  explicit RomLibraryThread(QObject* parent_object) noexcept;
+
+  /// Stops the scan in progress, if any, waiting for the thread to finish.
+  ~RomLibraryThread() noexcept override;
+
+  /// Loads the index saved by the last scan.
+  ///
+  /// This method must not be called while a scan is in progress.
+  ///
+  /// \returns The ROM files indexed, which are empty if there's no cache file.
+  auto LoadCache() noexcept -> const std::vector<chip8::RomLibraryEntry>&;
+
+  /// Starts bringing the index up to date with a directory. The \ref
+  /// QThread::finished() signal is emitted once the index is up to date and
+  /// has been saved to the cache file.
+  ///
+  /// If a scan is already in progress, this method does nothing.
+  ///
+  /// \param directory The directory to scan.
+  void Scan(const QString& directory) noexcept;
+
+  /// Retrieves the ROM files indexed.
+  ///
+  /// This method must not be called while a scan is in progress; it is meant
+  /// to be called in response to the \ref QThread::finished() signal.
+  ///
+  /// \returns The ROM files indexed.
+  auto GetEntries() const noexcept
+      -> const std::vector<chip8::RomLibraryEntry>&;
+
+ private:
+  /// From Qt documentation:
+  ///
+  /// The starting point for the thread. After calling \ref QThread::start(),
+  /// the newly created thread calls this function. The default implementation
+  /// simply calls \ref QThread::exec().
+  void run() noexcept override;
+
+  /// The index of the ROM files. It belongs to the thread while a scan is in
+  /// progress.
+  chip8::RomLibrary library_;
+
+  /// The directory being scanned.
+  std::string directory_;
+
+  /// The path to the cache file.
+  std::string cache_file_name_;
+};
@@ -12,6 +12,10 @@
 
 #include "sound_manager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "models/app_settings.h"
 
 SoundManager::SoundManager(QObject* parent_object) noexcept
@@ -19,7 +23,11 @@ SoundManager::SoundManager(QObject* parent_object) noexcept
   SetupFromAppSettings();
 }
 
-SoundManager::~SoundManager() noexcept { SDL_Quit(); }
+SoundManager::~SoundManager() noexcept {
+  // The audio thread must be stopped before we go away, as it refers to us.
+  SDL_CloseAudioDevice(audio_output_device_);
+  SDL_Quit();
+}
 
 auto SoundManager::Initialize(QObject* parent_object, QString& error) noexcept
     -> std::optional<SoundManager*> {
@@ -30,44 +38,99 @@ auto SoundManager::Initialize(QObject* parent_object, QString& error) noexcept
   return std::nullopt;
 }
 
-void SoundManager::PlayTone(const double duration) noexcept {
-  const auto output_sample_count =
-      static_cast<int>((duration / 1000) * kSampleRate);
+void SoundManager::SetBeeperOn(const bool beeper_on) noexcept {
+  beeper_on_.store(beeper_on, std::memory_order_relaxed);
+}
 
-  for (auto sample_num = 0; sample_num < output_sample_count; ++sample_num) {
-    const auto t = sample_num / static_cast<double>(kSampleRate);
-    auto wave = 0.0;
+void SoundManager::AudioCallback(void* userdata, Uint8* stream,
+                                 const int length) noexcept {
+  auto* sound_manager = static_cast<SoundManager*>(userdata);
 
-    switch (tone_type_) {
-      case ToneType::kSineWave:
-        wave = std::sin(M_PI * 2 * t * tone_freq_);
-        break;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto* samples = reinterpret_cast<int16_t*>(stream);
+  const auto sample_count = static_cast<size_t>(length) / sizeof(int16_t);
 
-      case ToneType::kSawtooth:
-        wave = (-2 / M_PI) * std::atan(1 / std::tan(tone_freq_ * M_PI * t));
-        break;
+  if (!sound_manager->beeper_on_.load(std::memory_order_relaxed)) {
+    std::fill_n(samples, sample_count, int16_t{0});
+    return;
+  }
 
-      case ToneType::kSquare:
-        wave = std::copysign(1.0, std::sin(M_PI * 2 * t * tone_freq_));
-        break;
+  // The upper bits of the phase are the index into the wavetable.
+  constexpr auto kIndexShift = 32 - 11;
 
-      case ToneType::kTriangle:
-        wave = (2 / M_PI) * std::asin(std::sin(tone_freq_ * M_PI * 2 * t));
-        break;
-    }
+  static_assert((size_t{1} << (32 - kIndexShift)) == kWavetableSize,
+                "The index shift must match the size of the wavetables");
 
-    const int16_t sample = wave * std::numeric_limits<int16_t>::max();
+  const auto tone_type = static_cast<size_t>(sound_manager->tone_type_);
+  const auto& wavetable = sound_manager->wavetables_[tone_type];
 
-    const auto return_code =
-        SDL_QueueAudio(audio_output_device_, &sample, sizeof(int16_t));
+  auto phase = sound_manager->phase_;
+  const auto phase_increment = sound_manager->phase_increment_;
 
-    if (return_code < 0) {
-      emit ErrorEncountered(SDL_GetError());
-    }
+  for (size_t sample_num = 0; sample_num < sample_count; ++sample_num) {
+    samples[sample_num] = wavetable[phase >> kIndexShift];
+    phase += phase_increment;
   }
+  sound_manager->phase_ = phase;
+}
+
+void SoundManager::SetVolume(const unsigned int volume) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  constexpr auto kMaxVolume = 100U;
+
+  SDL_LockAudioDevice(audio_output_device_);
+  volume_ = std::min(volume, kMaxVolume);
+  BuildWavetables();
+  SDL_UnlockAudioDevice(audio_output_device_);
+}
+
+void SoundManager::SetToneFrequency(const unsigned int tone_freq) noexcept {
+  SDL_LockAudioDevice(audio_output_device_);
+  tone_freq_ = tone_freq;
+  UpdatePhaseIncrement();
+  SDL_UnlockAudioDevice(audio_output_device_);
+}
+
+void SoundManager::SetToneType(const ToneType tone_type) noexcept {
+  SDL_LockAudioDevice(audio_output_device_);
+  tone_type_ = tone_type;
+  SDL_UnlockAudioDevice(audio_output_device_);
 }
 
-void SoundManager::SetVolume(const unsigned int volume) noexcept {}
+void SoundManager::UpdatePhaseIncrement() noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  constexpr auto kFullCycle = 4294967296.0;
+
+  phase_increment_ =
+      static_cast<uint32_t>((tone_freq_ * kFullCycle) / kSampleRate);
+}
+
+void SoundManager::BuildWavetables() noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  const auto volume = volume_ / 100.0;
+  const auto amplitude = std::numeric_limits<int16_t>::max() * volume;
+
+  for (size_t index = 0; index < kWavetableSize; ++index) {
+    // The position within the cycle, from 0 inclusive to 1 exclusive.
+    const auto t = index / static_cast<double>(kWavetableSize);
+
+    const auto sine = std::sin(M_PI * 2 * t);
+    const auto sawtooth = (-2 / M_PI) * std::atan(1 / std::tan(M_PI * t));
+    const auto square = std::copysign(1.0, sine);
+    const auto triangle = (2 / M_PI) * std::asin(sine);
+
+    const auto store = [this, index, amplitude](const ToneType tone_type,
+                                                const double wave) {
+      wavetables_[static_cast<size_t>(tone_type)][index] =
+          static_cast<int16_t>(wave * amplitude);
+    };
+
+    store(ToneType::kSineWave, sine);
+    store(ToneType::kSawtooth, sawtooth);
+    store(ToneType::kSquare, square);
+    store(ToneType::kTriangle, triangle);
+  }
+}
 
 void SoundManager::SetAudioOutputDevice(
     const QString& audio_output_device) noexcept {
@@ -77,13 +140,23 @@ void SoundManager::SetAudioOutputDevice(
   audio_spec.freq = kSampleRate;
   audio_spec.format = AUDIO_S16SYS;
   audio_spec.channels = 1;
+  audio_spec.samples = kBlockSize;
+  audio_spec.callback = &SoundManager::AudioCallback;
+  audio_spec.userdata = this;
 
-  const auto audio_output_device_name =
-      audio_output_device.isEmpty() ? nullptr
-                                    : audio_output_device.toLocal8Bit().data();
+  // The callback of the old device refers to us as well; it has to be
+  // stopped before another one may run. Whether or not the old device was
+  // valid doesn't matter.
+  SDL_CloseAudioDevice(audio_output_device_);
+  audio_output_device_ = 0;
 
-  const auto audio_device_id_new =
-      SDL_OpenAudioDevice(audio_output_device_name, 0, &audio_spec, nullptr, 0);
+  // The name must outlive the call below.
+  const auto audio_output_device_name = audio_output_device.toLocal8Bit();
+
+  const auto audio_device_id_new = SDL_OpenAudioDevice(
+      audio_output_device.isEmpty() ? nullptr
+                                    : audio_output_device_name.constData(),
+      0, &audio_spec, nullptr, 0);
 
   if (audio_device_id_new == 0) {
     // We weren't able to open the audio device requested.
@@ -91,10 +164,6 @@ void SoundManager::SetAudioOutputDevice(
     return;
   }
 
-  /// If there was an audio device before, close it now. Whether or not it was
-  /// valid doesn't matter.
-  SDL_CloseAudioDevice(audio_output_device_);
-
   audio_output_device_ = audio_device_id_new;
 
   // Newly-opened audio devices start in the paused state, so we need to disable
@@ -133,9 +202,11 @@ auto SoundManager::GetAudioOutputDevices() noexcept -> std::vector<QString> {
 void SoundManager::SetupFromAppSettings() noexcept {
   AppSettingsModel app_settings;
 
-  SetAudioOutputDevice(app_settings.GetAudioDeviceName());
-
-  tone_freq_ = app_settings.GetAudioToneFrequency();
-  tone_type_ = static_cast<ToneType>(app_settings.GetAudioToneType());
+  // The tone has to be ready before the audio output device starts asking for
+  // samples.
+  SetToneFrequency(app_settings.GetAudioToneFrequency());
+  SetToneType(static_cast<ToneType>(app_settings.GetAudioToneType()));
   SetVolume(app_settings.GetAudioVolume());
+
+  SetAudioOutputDevice(app_settings.GetAudioDeviceName());
 }
\ No newline at end of file
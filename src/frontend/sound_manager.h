@@ -17,11 +17,19 @@
 #include <SDL2/SDL.h>
 
 #include <QObject>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 #include "types.h"
 
 /// This class handles the management of sound devices and tone generation.
+///
+/// Tones are synthesized on SDL's audio thread, which pulls samples from \ref
+/// AudioCallback() whenever the audio output device runs low. The virtual
+/// machine only has to flip the beeper on and off with \ref SetBeeperOn().
 class SoundManager : public QObject {
   Q_OBJECT
 
@@ -45,19 +53,31 @@ class SoundManager : public QObject {
   static auto Initialize(QObject* parent_object, QString& error) noexcept
       -> std::optional<SoundManager*>;
 
-  /// Plays a tone for the specified period.
+  /// Switches the beeper on or off.
   ///
-  /// This method will do nothing if the audio is muted.
+  /// This method is safe to call from any thread, and never blocks: the audio
+  /// thread picks the new state up by the time it fills the next \ref
+  /// kBlockSize samples.
   ///
-  /// \param duration The length of the tone to generate, in milliseconds.
-  void PlayTone(double duration) noexcept;
+  /// \param beeper_on Whether or not a tone should be playing.
+  void SetBeeperOn(bool beeper_on) noexcept;
 
-  /// Sets the audio output volume.
+  /// Sets the audio output volume, rebuilding the wavetables.
   ///
   /// \param volume The new audio output volume. This value cannot exceed 100
   /// and if any value over 100 is passed, the volume will be treated as 100.
   void SetVolume(unsigned int volume) noexcept;
 
+  /// Sets the frequency of generated tones.
+  ///
+  /// \param tone_freq The new frequency, in Hz.
+  void SetToneFrequency(unsigned int tone_freq) noexcept;
+
+  /// Sets the type of generated tones.
+  ///
+  /// \param tone_type The new type of tone.
+  void SetToneType(ToneType tone_type) noexcept;
+
   /// Sets the audio output device to use.
   ///
   /// \param audio_device The audio device to send tone output to.
@@ -68,13 +88,44 @@ class SoundManager : public QObject {
   /// \returns A list of available audio output devices.
   auto GetAudioOutputDevices() noexcept -> std::vector<QString>;
 
-  /// The frequency of a generated tone.
-  unsigned int tone_freq_;
+ private:
+  /// The number of samples in one cycle of a wavetable. This must be a power
+  /// of two.
+  static constexpr size_t kWavetableSize = 2048;
 
-  /// The type of tone to generate.
-  ToneType tone_type_;
+  /// The number of samples the audio output device asks for at once. This
+  /// bounds how long it takes for the beeper to start or stop, at the cost of
+  /// waking up the audio thread more often: 256 samples are ~5.8ms, well under
+  /// a single timer tick.
+  static constexpr uint16_t kBlockSize = 256;
+
+  /// The number of values of \ref ToneType.
+  static constexpr size_t kNumToneTypes = 4;
+
+  /// One cycle of a tone, at the current volume.
+  using Wavetable = std::array<int16_t, kWavetableSize>;
+
+  /// Computes one cycle of every type of tone at the current volume.
+  ///
+  /// The audio device must be locked when calling this method.
+  void BuildWavetables() noexcept;
+
+  /// Computes how far the phase advances every sample at the current tone
+  /// frequency.
+  ///
+  /// The audio device must be locked when calling this method.
+  void UpdatePhaseIncrement() noexcept;
+
+  /// Called by SDL on the audio thread when the audio output device needs more
+  /// samples.
+  ///
+  /// \param userdata The sound manager that opened the audio output device.
+  ///
+  /// \param stream The buffer to fill with samples.
+  ///
+  /// \param length The size of the buffer, in bytes.
+  static void AudioCallback(void* userdata, Uint8* stream, int length) noexcept;
 
- private:
   /// Constructs the sound manager.
   ///
   /// \param parent_widget The parent object of which this class is a child of
@@ -86,11 +137,34 @@ class SoundManager : public QObject {
 
   /// The current interface to send audio data to an audio output device as
   /// determined by the last call to \ref SetAudioOutputDevice().
-  SDL_AudioDeviceID audio_output_device_;
+  SDL_AudioDeviceID audio_output_device_ = 0;
 
   /// The default sample rate.
   const unsigned int kSampleRate = 44100;
 
+  /// The frequency of a generated tone.
+  unsigned int tone_freq_ = 0;
+
+  /// The type of tone to generate.
+  ToneType tone_type_ = ToneType::kSineWave;
+
+  /// The audio output volume, from 0 to 100.
+  unsigned int volume_ = 100;
+
+  /// One cycle of every type of tone, indexed by \ref ToneType.
+  std::array<Wavetable, kNumToneTypes> wavetables_{};
+
+  /// The position within the cycle of the current tone, where 2^32 is a full
+  /// cycle. This carries over from one tone to the next, so that back to back
+  /// tones don't click. Only the audio thread touches this.
+  uint32_t phase_ = 0;
+
+  /// How far \ref phase_ advances every sample.
+  uint32_t phase_increment_ = 0;
+
+  /// Whether or not the beeper is on, as last set by \ref SetBeeperOn().
+  std::atomic<bool> beeper_on_{false};
+
  signals:
   /// Emitted when an internal error has been encountered.
   void ErrorEncountered(const QString& error_str);
@@ -19,4 +19,10 @@
 enum class ToneType { kSineWave, kSawtooth, kSquare, kTriangle };
 
 /// Defines the various run states of the virtual machine.
-enum class RunState { kStopped, kRunning };
\ No newline at end of file
+enum class RunState { kStopped, kRunning };
+
+/// Defines the speeds the virtual machine can run at.
+///
+/// In normal mode, frames are paced to the frame rate of the virtual machine.
+/// In turbo mode, frames are executed back to back as fast as the host allows.
+enum class RunMode { kNormal, kTurbo };
\ No newline at end of file
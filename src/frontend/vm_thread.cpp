@@ -12,34 +12,294 @@
 
 #include "vm_thread.h"
 
-#include <thread>
+#include <core/logger.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
 
 #include "models/app_settings.h"
+#include "sound_manager.h"
+
+namespace {
+/// Converts a duration to a whole number of microseconds, as recorded by the
+/// frame time histograms.
+///
+/// \param duration The duration to convert.
+///
+/// \returns The duration in microseconds, or 0 if it is negative.
+auto ToMicroseconds(const FramePacer::Clock::duration duration) noexcept
+    -> uint64_t {
+  const auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  return us > 0 ? static_cast<uint64_t>(us) : 0;
+}
+}  // namespace
 
 VMThread::VMThread(QObject* parent_object) noexcept : QThread(parent_object) {
   ConnectCallbacksToSlots();
   SetupFromAppSettings();
+
+  // Waiting for a key press shouldn't stop the timers or the screen, nor
+  // should it stop the run loop.
+  vm_instance_.SetKeyWaitMode(chip8::VMInstance::KeyWaitMode::kIdle);
+
+  // The thread lives as long as we do; it will sit idle waiting for commands
+  // until it's asked to do something.
+  start();
 }
 
-void VMThread::StopExecution() noexcept {
-  requestInterruption();
+VMThread::~VMThread() noexcept {
+  PostCommand(Command{Command::Type::kQuit});
   wait();
+}
+
+void VMThread::Resume() noexcept { PostCommand(Command{Command::Type::kRun}); }
+
+void VMThread::Pause() noexcept { PostCommand(Command{Command::Type::kPause}); }
+
+auto VMThread::Step(const unsigned int num_steps) noexcept -> bool {
+  Command command{Command::Type::kStep};
+  command.num_steps_ = num_steps;
+
+  return PostCommand(std::move(command));
+}
+
+void VMThread::Reset() noexcept { PostCommand(Command{Command::Type::kReset}); }
+
+auto VMThread::LoadProgram(std::shared_ptr<const chip8::Rom> rom,
+                           const chip8::Variant default_variant) noexcept
+    -> bool {
+  Command command{Command::Type::kLoadProgram};
+  command.variant_ = default_variant;
+  command.rom_ = std::move(rom);
+
+  return PostCommand(std::move(command));
+}
+
+void VMThread::SetInstructionsPerSecond(
+    const unsigned int instructions_per_second) noexcept {
+  Command command{Command::Type::kSetInstructionsPerSecond};
+  command.instructions_per_second_ = instructions_per_second;
+
+  PostCommand(std::move(command));
+}
+
+void VMThread::SetFrameRate(const double frame_rate) noexcept {
+  Command command{Command::Type::kSetFrameRate};
+  command.frame_rate_ = frame_rate;
+
+  PostCommand(std::move(command));
+}
+
+void VMThread::SetKeyState(
+    const chip8::Key key, const chip8::KeyState key_state,
+    const chip8::InputEvent::Clock::time_point timestamp) noexcept {
+  if (!vm_instance_.QueueKeyState(key, key_state, timestamp)) {
+    chip8::Logger::Get().Emit(chip8::Logger::LogLevel::kWarning,
+                              "Too many key state changes are pending; "
+                              "waiting for the virtual machine to catch up");
+
+    Command command{Command::Type::kSetKeyState};
+    command.key_ = key;
+    command.key_state_ = key_state;
+
+    PostCommand(std::move(command));
+    return;
+  }
+
+  // The virtual machine thread may be sleeping until the next frame. Taking
+  // the lock before notifying it guarantees it either sees the flag before it
+  // goes to sleep, or is already waiting and receives the notification.
+  input_posted_ = true;
+  { std::lock_guard<std::mutex> lock{command_mutex_}; }
+
+  command_posted_.notify_one();
+}
+
+void VMThread::SetVsyncPacing(const bool enabled) noexcept {
+  Command command{Command::Type::kSetVsyncPacing};
+  command.enabled_ = enabled;
+
+  PostCommand(std::move(command));
+}
+
+void VMThread::NotifyDisplayRefreshed() noexcept {
+  using namespace std::chrono_literals;
+
+  // Refreshes further apart than this are not consecutive; the window was
+  // hidden, or the virtual machine was paused.
+  constexpr auto kMaxRefreshInterval = 100ms;
+
+  // The refresh rate is measured over this period, which is long enough for
+  // the timing jitter of individual refreshes to not matter.
+  constexpr auto kMeasurementPeriod = 2s;
+
+  const auto now = FramePacer::Clock::now();
+
+  if ((now - last_display_refresh_time_point_) > kMaxRefreshInterval) {
+    refresh_measurement_start_time_point_ = now;
+    num_refreshes_measured_ = 0;
+  } else {
+    num_refreshes_measured_++;
+
+    const auto elapsed = now - refresh_measurement_start_time_point_;
+
+    if (elapsed >= kMeasurementPeriod) {
+      display_refresh_rate_ =
+          num_refreshes_measured_ /
+          std::chrono::duration<double>(elapsed).count();
+
+      refresh_measurement_start_time_point_ = now;
+      num_refreshes_measured_ = 0;
+    }
+  }
+  last_display_refresh_time_point_ = now;
+
+  // Same as in \ref SetKeyState(), the virtual machine thread may be waiting.
+  display_refreshed_ = true;
+  { std::lock_guard<std::mutex> lock{command_mutex_}; }
+
+  command_posted_.notify_one();
+}
+
+auto VMThread::IsRunning() const noexcept -> bool { return running_; }
+
+void VMThread::SetRunMode(const RunMode run_mode) noexcept {
+  run_mode_ = run_mode;
+}
+
+auto VMThread::GetRunMode() const noexcept -> RunMode { return run_mode_; }
+
+void VMThread::SetTurboFrameSkip(const unsigned int frame_skip) noexcept {
+  turbo_frame_skip_ = frame_skip;
+}
+
+void VMThread::SetHostRefreshRate(const double refresh_rate) noexcept {
+  if (refresh_rate > 0.0) {
+    host_refresh_rate_ = refresh_rate;
+  }
+}
+
+void VMThread::SetSoundManager(SoundManager* sound_manager) noexcept {
+  sound_manager_ = sound_manager;
+}
+
+void VMThread::RecordFramePresented() noexcept {
+  const auto update_screen_time = last_update_screen_time_.exchange(0);
+
+  if (update_screen_time == 0) {
+    return;
+  }
+
+  const auto update_screen_time_point = FramePacer::Clock::time_point{
+      std::chrono::duration_cast<FramePacer::Clock::duration>(
+          std::chrono::nanoseconds{update_screen_time})};
+
+  const auto presented = FramePacer::Clock::now();
 
-  emit RunStateChanged(RunState::kStopped);
+  present_latency_histogram_.Record(
+      ToMicroseconds(presented - update_screen_time_point));
+
+  std::lock_guard<std::mutex> lock{input_trace_mutex_};
+
+  for (const auto& trace : unpresented_input_traces_) {
+    input_observe_histogram_.Record(
+        ToMicroseconds(trace.observed_ - trace.applied_));
+    input_draw_histogram_.Record(
+        ToMicroseconds(trace.frame_sent_ - trace.observed_));
+    input_present_histogram_.Record(
+        ToMicroseconds(presented - trace.frame_sent_));
+    input_total_histogram_.Record(ToMicroseconds(presented - trace.reported_));
+
+    if (input_trace_records_.size() == kMaxInputTraceRecords) {
+      input_trace_records_.pop_front();
+    }
+    input_trace_records_.push_back({trace, presented});
+  }
+  unpresented_input_traces_.clear();
+}
+
+auto VMThread::ExportInputTraces(const std::string& file_name) noexcept
+    -> bool {
+  std::ofstream file{file_name, std::ofstream::out};
+
+  if (!file) {
+    return false;
+  }
+
+  file << "time_us,key,state,apply_us,observe_us,draw_us,present_us,total_us\n";
+
+  std::lock_guard<std::mutex> lock{input_trace_mutex_};
+
+  if (input_trace_records_.empty()) {
+    return !!file;
+  }
+
+  // Times are relative to the oldest change, to keep them readable.
+  const auto first_reported = input_trace_records_.front().trace_.reported_;
+
+  for (const auto& record : input_trace_records_) {
+    const auto& trace = record.trace_;
+
+    file << ToMicroseconds(trace.reported_ - first_reported) << ','
+         << static_cast<int>(trace.key_) << ','
+         << (trace.state_ == chip8::KeyState::kPressed ? "pressed"
+                                                       : "released")
+         << ',' << ToMicroseconds(trace.applied_ - trace.reported_) << ','
+         << ToMicroseconds(trace.observed_ - trace.applied_) << ','
+         << ToMicroseconds(trace.frame_sent_ - trace.observed_) << ','
+         << ToMicroseconds(record.presented_ - trace.frame_sent_) << ','
+         << ToMicroseconds(record.presented_ - trace.reported_) << '\n';
+  }
+  return !!file;
+}
+
+void VMThread::SetPublishSnapshots(const bool enabled) noexcept {
+  publish_snapshots_.store(enabled, std::memory_order_relaxed);
+}
+
+auto VMThread::AcquireSnapshot() noexcept -> const chip8::StateSnapshot* {
+  return snapshot_buffer_.Acquire();
 }
 
 void VMThread::ConnectCallbacksToSlots() noexcept {
-  vm_instance_.update_screen_func_ =
-      [this](const chip8::ImplementationInterface::Framebuffer& framebuffer) {
-        emit UpdateScreen(framebuffer);
-      };
+  vm_instance_.update_screen_func_ = [this](const chip8::Screen& framebuffer) {
+    // In turbo mode, most frames are never shown; there's no point in
+    // flooding the event queue of the UI thread with them.
+    if (present_frame_) {
+      last_update_screen_time_ =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              FramePacer::Clock::now().time_since_epoch())
+              .count();
 
-  vm_instance_.play_tone_func_ = [this](const double tone_duration) {
-    emit PlayTone(tone_duration);
+      emit UpdateScreen(framebuffer);
+    }
   };
 
-  chip8::Logger::Get().log_message_func_ = [this](const std::string& msg) {
-    emit LogMessageEmitted(msg);
+  // Steps taken by the debugger while we're not running shouldn't leave the
+  // beeper on; it is brought back in line when we start running again.
+  vm_instance_.beeper_func_ = [this](const bool beeper_on) {
+    if (running_) {
+      SetBeeperOn(beeper_on);
+    }
+  };
+
+  vm_instance_.input_latency_func_ =
+      [this](const std::chrono::nanoseconds latency) {
+        input_apply_histogram_.Record(ToMicroseconds(latency));
+      };
+
+  // The trace is complete once the frame it was sent with has been drawn, see
+  // \ref RecordFramePresented().
+  vm_instance_.input_trace_func_ = [this](const chip8::InputTrace& trace) {
+    std::lock_guard<std::mutex> lock{input_trace_mutex_};
+
+    // If frames are never drawn, for instance in turbo mode with frame
+    // skipping, there's no point in keeping the traces around.
+    if (unpresented_input_traces_.size() < chip8::data_size::kKeypad) {
+      unpresented_input_traces_.push_back(trace);
+    }
   };
 }
 
@@ -48,17 +308,322 @@ void VMThread::SetupFromAppSettings() noexcept {
 
   vm_instance_.SetTiming(app_settings.GetMachineInstructionsPerSecond(),
                          app_settings.GetMachineFrameRate());
+
+  SetTurboFrameSkip(app_settings.GetMachineTurboFrameSkip());
+
+  // The thread hasn't been started yet; there's nobody to send commands to.
+  frame_rate_ = app_settings.GetMachineFrameRate();
+  vsync_pacing_ = app_settings.GetMachineVsyncPacing();
+}
+
+void VMThread::SetBeeperOn(const bool beeper_on) noexcept {
+  auto* sound_manager = sound_manager_.load();
+
+  if (sound_manager != nullptr) {
+    sound_manager->SetBeeperOn(beeper_on);
+  }
+}
+
+void VMThread::PublishSnapshot() noexcept {
+  if (publish_snapshots_.load(std::memory_order_relaxed)) {
+    snapshot_buffer_.Publish(vm_instance_);
+  }
+}
+
+auto VMThread::ShouldPresentFrame(const RunMode run_mode) noexcept -> bool {
+  if (run_mode == RunMode::kNormal) {
+    return true;
+  }
+
+  const auto frame_skip = turbo_frame_skip_.load();
+
+  if (frame_skip != 0) {
+    // Only every Nth frame is presented.
+    if (++frames_since_present_ < frame_skip) {
+      return false;
+    }
+    frames_since_present_ = 0;
+    return true;
+  }
+
+  // There's no use in presenting more frames than the display can show, so
+  // we present at most one frame per host refresh.
+  const auto now = FramePacer::Clock::now();
+  const auto refresh_period =
+      std::chrono::duration<double>(1.0 / host_refresh_rate_.load());
+
+  if ((now - last_present_time_point_) < refresh_period) {
+    return false;
+  }
+  last_present_time_point_ = now;
+  return true;
+}
+
+auto VMThread::PostCommand(Command command) noexcept -> bool {
+  std::unique_lock<std::mutex> lock{command_mutex_};
+
+  commands_.push_back(std::move(command));
+  const auto command_number = ++num_commands_posted_;
+
+  command_posted_.notify_one();
+
+  // Commands are executed in order, so ours is done once as many commands as
+  // we've posted up to and including it have been completed.
+  command_completed_.wait(lock, [this, command_number]() {
+    return num_commands_completed_ >= command_number;
+  });
+  return last_command_result_;
+}
+
+auto VMThread::WaitForCommand() noexcept -> Command {
+  std::unique_lock<std::mutex> lock{command_mutex_};
+  command_posted_.wait(lock, [this]() { return !commands_.empty(); });
+
+  auto command = std::move(commands_.front());
+  commands_.pop_front();
+
+  return command;
+}
+
+void VMThread::CompleteCommand(const bool result) noexcept {
+  {
+    std::lock_guard<std::mutex> lock{command_mutex_};
+
+    last_command_result_ = result;
+    num_commands_completed_++;
+  }
+  command_completed_.notify_all();
+}
+
+auto VMThread::ExecuteCommand(const Command& command) noexcept -> bool {
+  switch (command.type_) {
+    case Command::Type::kStep:
+      for (auto step = 0U; step < command.num_steps_; ++step) {
+        if (vm_instance_.Step() != chip8::StepResult::kSuccess) {
+          return false;
+        }
+      }
+      return true;
+
+    case Command::Type::kReset:
+      // Without a program, there's only the startup state to go back to.
+      if (!rom_) {
+        vm_instance_.Reset();
+        return true;
+      }
+      return vm_instance_.LoadProgram(*rom_);
+
+    case Command::Type::kLoadProgram: {
+      // Resetting loads the previous program again, so it must keep its
+      // variant if the new one fails to load.
+      const auto previous_variant = vm_instance_.GetDefaultVariant();
+      vm_instance_.SetDefaultVariant(command.variant_);
+
+      if (!vm_instance_.LoadProgram(*command.rom_)) {
+        vm_instance_.SetDefaultVariant(previous_variant);
+        return false;
+      }
+      rom_ = command.rom_;
+      return true;
+    }
+
+    case Command::Type::kSetInstructionsPerSecond:
+      return vm_instance_.SetInstructionsPerSecond(
+          command.instructions_per_second_);
+
+    case Command::Type::kSetFrameRate:
+      frame_rate_ = command.frame_rate_;
+
+      // While the display paces the virtual machine, the frame rate is that
+      // of the display; the new one will apply once it no longer does.
+      return vsync_pacing_ || vm_instance_.SetFrameRate(frame_rate_);
+
+    case Command::Type::kSetVsyncPacing:
+      vsync_pacing_ = command.enabled_;
+
+      if (vsync_pacing_) {
+        MatchFrameRateToDisplay();
+        return true;
+      }
+      return vm_instance_.SetFrameRate(frame_rate_);
+
+    case Command::Type::kSetKeyState:
+      // The changes queued before this one have to be applied first.
+      vm_instance_.ApplyQueuedInput();
+      vm_instance_.impl_->SetKeyState(command.key_, command.key_state_);
+      return true;
+
+    default:
+      // Run, pause and quit are handled by whoever is waiting for commands,
+      // as they change what the thread is doing.
+      return true;
+  }
+}
+
+auto VMThread::ProcessPendingCommands() noexcept -> bool {
+  for (;;) {
+    std::unique_lock<std::mutex> lock{command_mutex_};
+
+    if (commands_.empty()) {
+      return true;
+    }
+
+    auto command = std::move(commands_.front());
+    commands_.pop_front();
+    lock.unlock();
+
+    switch (command.type_) {
+      case Command::Type::kQuit:
+        quit_requested_ = true;
+        [[fallthrough]];
+
+      case Command::Type::kPause:
+        // The command is completed by the run loop once it has actually
+        // stopped, so the caller can rely on the virtual machine being idle.
+        return false;
+
+      default:
+        CompleteCommand(ExecuteCommand(command));
+        break;
+    }
+  }
+}
+
+auto VMThread::WaitForNextFrame() noexcept -> bool {
+  for (;;) {
+    const auto waiting_for_key_press =
+        vm_instance_.impl_->IsHaltedUntilKeyPress();
+
+    // Sleep until shortly before the deadline, unless a command arrives in the
+    // meantime. If the guest program is waiting for a key press, the frame is
+    // going to be idle anyway, so we sleep all the way to the deadline.
+    const auto wakeup_time_point = waiting_for_key_press
+                                       ? frame_pacer_.GetNextDeadline()
+                                       : frame_pacer_.GetCoarseWakeupTime();
+
+    std::unique_lock<std::mutex> lock{command_mutex_};
+
+    const auto woken_up = command_posted_.wait_until(
+        lock, wakeup_time_point, [this]() {
+          return !commands_.empty() || input_posted_.exchange(false);
+        });
+
+    if (!woken_up) {
+      break;
+    }
+    lock.unlock();
+
+    if (!ProcessPendingCommands()) {
+      return false;
+    }
+
+    // Input is normally applied right before the next instruction, but if the
+    // guest program is waiting for it, we need to know now.
+    if (waiting_for_key_press) {
+      vm_instance_.ApplyQueuedInput();
+    }
+
+    if (waiting_for_key_press && !vm_instance_.impl_->IsHaltedUntilKeyPress()) {
+      // The key the guest program was waiting for has been pressed. There's no
+      // reason to make the user wait for the rest of this frame.
+      frame_pacer_.RestartNow();
+      return true;
+    }
+  }
+
+  // The operating system can't be trusted to wake us up on time; spin for the
+  // rest.
+  frame_pacer_.SpinUntilDeadline();
+  return true;
+}
+
+auto VMThread::WaitForDisplayRefresh() noexcept -> bool {
+  const auto timeout_time_point =
+      FramePacer::Clock::now() +
+      std::chrono::duration_cast<FramePacer::Clock::duration>(
+          std::chrono::duration<double, std::milli>{
+              vm_instance_.GetMaxFrameTime() * 2});
+
+  for (;;) {
+    auto refreshed = false;
+
+    std::unique_lock<std::mutex> lock{command_mutex_};
+
+    const auto woken_up = command_posted_.wait_until(
+        lock, timeout_time_point, [this, &refreshed]() {
+          refreshed = display_refreshed_.exchange(false);
+          return refreshed || !commands_.empty();
+        });
+
+    if (!woken_up) {
+      return true;
+    }
+    lock.unlock();
+
+    if (!ProcessPendingCommands()) {
+      return false;
+    }
+
+    // The commands may have turned display pacing off.
+    if (refreshed || !vsync_pacing_) {
+      return true;
+    }
+  }
+}
+
+void VMThread::MatchFrameRateToDisplay() noexcept {
+  auto refresh_rate = display_refresh_rate_.load();
+
+  // Until the refresh rate has been measured, we take the word of the
+  // operating system for it.
+  if (refresh_rate <= 0.0) {
+    refresh_rate = host_refresh_rate_;
+  }
+
+  // Measurements vary slightly; only differences that would noticeably change
+  // the speed of the virtual machine are worth retiming it for. This is still
+  // small enough to tell a 59.94Hz display from a 60Hz one.
+  //
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+  constexpr auto kTolerance = 0.0005;
+
+  const auto frame_rate = vm_instance_.GetFrameRate();
+
+  if (std::abs(refresh_rate - frame_rate) > (frame_rate * kTolerance)) {
+    vm_instance_.SetFrameRate(refresh_rate);
+  }
 }
 
 void VMThread::run() noexcept {
+  while (!quit_requested_) {
+    const auto command = WaitForCommand();
+
+    switch (command.type_) {
+      case Command::Type::kRun:
+        RunUntilStopped();
+        break;
+
+      case Command::Type::kQuit:
+        quit_requested_ = true;
+        CompleteCommand(true);
+        break;
+
+      default:
+        CompleteCommand(ExecuteCommand(command));
+        break;
+    }
+  }
+}
+
+void VMThread::RunUntilStopped() noexcept {
   // We pull in this inline namespace to make parts of the frame limiter code
   // more clear.
   using namespace std::chrono_literals;
 
-  // The deadline time point is used to determine at what future point in time
-  // the thread should stop sleeping. We start at the current time point because
-  // we're not *starting* the run loop in the past or in the future.
-  auto deadline_time_point = std::chrono::steady_clock::now();
+  // The frame pacer determines at what future point in time the thread should
+  // stop sleeping. The first frame is scheduled for the current time point
+  // because we're not *starting* the run loop in the past or in the future.
+  frame_pacer_.Start(vm_instance_.GetMaxFrameTime());
 
   // The FPS (frames per second) time point is used to determine when 1 second
   // has passed to notify listeners of performance information, should anyone
@@ -70,26 +635,90 @@ void VMThread::run() noexcept {
   // specious results to the user who may care about performance information.
   num_frames_ = 0;
 
+  // Likewise, we need to know how many instructions have been executed by the
+  // time performance information is next emitted.
+  auto steps_at_fps_time_point = vm_instance_.GetNumberOfStepsExecuted();
+
+  // The run mode may be changed at any time; we need to know when it does.
+  auto last_run_mode = run_mode_.load();
+
+  // Likewise for whether or not the display paces us.
+  auto last_vsync_pacing = vsync_pacing_;
+
+  running_ = true;
+  SetBeeperOn(vm_instance_.IsBeeperOn());
+
+  // Anyone watching us run starts from where we are now, rather than from
+  // wherever we were the last time we ran.
+  PublishSnapshot();
+
   emit RunStateChanged(RunState::kRunning);
 
-  // This thread will continue running until an interrupt is requested by a call
-  // to \ref QThread::requestInterruption(). The only time the run loop will be
-  // interrupted is if one of the following conditions are met:
+  // Whoever asked us to run doesn't need to wait for anything else.
+  CompleteCommand(true);
+
+  // Whether or not we've been asked to pause or quit, as opposed to stopping
+  // on our own.
+  auto stop_requested = false;
+
+  // The run loop will continue until one of the following conditions are met:
   //
   // 1) an error occurred within the guest program
   // 2) the guest program is waiting for a key press
   // 3) the user has paused execution of the virtual machine
-  while (!isInterruptionRequested()) {
-    // The length of a frame in milliseconds can be retrieved by a call to the
-    // \ref chip8::VMInstance::GetMaxFrameTime() method.
-    //
-    // We want the thread to stop sleeping after one frame. Update the
-    // deadline accordingly.
-    deadline_time_point += std::chrono::milliseconds(
-        static_cast<unsigned int>(vm_instance_.GetMaxFrameTime()));
+  // 4) the thread is being shut down
+  //
+  // Other commands are executed between frames while we keep running.
+  for (;;) {
+    if (!ProcessPendingCommands()) {
+      stop_requested = true;
+      break;
+    }
+
+    const auto run_mode = run_mode_.load();
+
+    // The display paces normal frames only.
+    const auto paced_by_display =
+        (run_mode == RunMode::kNormal) && vsync_pacing_;
+
+    if ((run_mode != last_run_mode) || (vsync_pacing_ != last_vsync_pacing)) {
+      // Coming out of turbo mode or display pacing, the schedule is hopelessly
+      // behind; start a fresh one instead of treating the previous frames as
+      // overload.
+      if ((run_mode == RunMode::kNormal) && !paced_by_display) {
+        frame_pacer_.Start(vm_instance_.GetMaxFrameTime());
+      }
+      last_run_mode = run_mode;
+      last_vsync_pacing = vsync_pacing_;
+    }
+
+    if (vsync_pacing_) {
+      // The refresh rate may have been measured more precisely, or the window
+      // may have moved to a different display.
+      MatchFrameRateToDisplay();
+    }
+
+    if ((run_mode == RunMode::kNormal) && !paced_by_display) {
+      // The length of a frame in milliseconds can be retrieved by a call to
+      // the \ref chip8::VMInstance::GetMaxFrameTime() method. The user may
+      // have changed the frame rate since the last frame; if so, the new frame
+      // time will apply from the next deadline onwards.
+      const auto max_frame_time = vm_instance_.GetMaxFrameTime();
+
+      if (max_frame_time != frame_pacer_.GetFrameTime()) {
+        frame_pacer_.SetFrameTime(max_frame_time);
+      }
+
+      // Mark the start of this frame. The pacer keeps track of how far off
+      // the schedule we are, and skips frames if we have fallen too far
+      // behind.
+      frame_pacer_.BeginFrame();
+    }
+
+    present_frame_ = ShouldPresentFrame(run_mode);
 
     // We need to retrieve the current point in time...
-    auto current_time_point = std::chrono::steady_clock::now();
+    const auto current_time_point = std::chrono::steady_clock::now();
 
     // ...to determine the difference between the current point in time and
     // the last time we checked if we emitted performance information.
@@ -99,25 +728,77 @@ void VMThread::run() noexcept {
 
     // Has one second passed since we emitted performance information?
     if (fps_update_delta >= 1s) {
-      emit PerformanceInfo({num_frames_,
-                            1000.0 / static_cast<double>(num_frames_),
-                            vm_instance_.GetTargetFrameRate()});
+      const auto steps_executed = vm_instance_.GetNumberOfStepsExecuted();
+
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+      constexpr auto kMillion = 1000000.0;
+
+      const auto mips =
+          static_cast<double>(steps_executed - steps_at_fps_time_point) /
+          kMillion /
+          std::chrono::duration<double>(fps_update_delta).count();
+
+      PerformanceCounters perf_counters;
+
+      perf_counters.current_fps_ = num_frames_;
+      perf_counters.average_frame_period_ =
+          1000.0 / static_cast<double>(num_frames_);
+      perf_counters.target_fps_ = vm_instance_.GetTargetFrameRate();
+      perf_counters.average_pacing_error_ = frame_pacer_.GetAverageError();
+      perf_counters.mips_ = mips;
+
+      perf_counters.emulation_time_ = emulation_time_histogram_.Summarize();
+      perf_counters.sleep_time_ = sleep_time_histogram_.Summarize();
+      perf_counters.present_latency_ = present_latency_histogram_.Summarize();
+      perf_counters.steps_per_frame_ = steps_per_frame_histogram_.Summarize();
+      perf_counters.input_latency_.apply_ = input_apply_histogram_.Summarize();
+      perf_counters.input_latency_.observe_ =
+          input_observe_histogram_.Summarize();
+      perf_counters.input_latency_.draw_ = input_draw_histogram_.Summarize();
+      perf_counters.input_latency_.present_ =
+          input_present_histogram_.Summarize();
+      perf_counters.input_latency_.total_ = input_total_histogram_.Summarize();
+
+      emit PerformanceInfo(perf_counters);
+
+      emulation_time_histogram_.Reset();
+      sleep_time_histogram_.Reset();
+      present_latency_histogram_.Reset();
+      steps_per_frame_histogram_.Reset();
+      input_apply_histogram_.Reset();
+      input_observe_histogram_.Reset();
+      input_draw_histogram_.Reset();
+      input_present_histogram_.Reset();
+      input_total_histogram_.Reset();
 
       num_frames_ = 0;
+      steps_at_fps_time_point = steps_executed;
+      frame_pacer_.ResetStatistics();
 
       // We just emitted the performance information, we'll need to update the
       // time point to keep track of the passage of time.
-      fps_time_point = std::chrono::steady_clock::now();
+      fps_time_point = current_time_point;
     }
 
-    // Now run the virtual machine for one frame.
+    // Now run the virtual machine for one frame, and measure how long that
+    // took and how much work was done.
+    const auto steps_before_frame = vm_instance_.GetNumberOfStepsExecuted();
+    const auto emulation_start_time_point = FramePacer::Clock::now();
+
     const auto step_result = vm_instance_.RunForOneFrame();
     num_frames_++;
 
+    emulation_time_histogram_.Record(
+        ToMicroseconds(FramePacer::Clock::now() - emulation_start_time_point));
+    steps_per_frame_histogram_.Record(vm_instance_.GetNumberOfStepsExecuted() -
+                                      steps_before_frame);
+
+    PublishSnapshot();
+
     if (step_result != chip8::StepResult::kSuccess) {
       // A condition has been met in which we have to stop execution of the
       // virtual machine.
-      quit();
+      running_ = false;
       emit RunStateChanged(RunState::kStopped);
 
       if (step_result == chip8::StepResult::kBreakpointReached) {
@@ -128,14 +809,47 @@ void VMThread::run() noexcept {
       // It is not a failure to stop execution until a key has been pressed.
       // We completely stop execution in this case because it would be
       // pointless to run the thread doing absolutely nothing but waiting.
-      if (step_result != chip8::StepResult::kHaltUntilKeyPress) {
+      // Neither is it a failure for a SUPER-CHIP program to exit.
+      if ((step_result != chip8::StepResult::kHaltUntilKeyPress) &&
+          (step_result != chip8::StepResult::kExited)) {
         emit ExecutionFailure(step_result);
         break;
       }
       break;
     }
 
-    // We're done here; sleep until the deadline.
-    std::this_thread::sleep_until(deadline_time_point);
+    // We're done here; sleep until the next frame is due, or until the
+    // display is refreshed if it paces us. In turbo mode, there is no
+    // deadline, the next frame starts immediately.
+    if (run_mode == RunMode::kNormal) {
+      const auto sleep_start_time_point = FramePacer::Clock::now();
+
+      const auto keep_running =
+          paced_by_display ? WaitForDisplayRefresh() : WaitForNextFrame();
+
+      if (!keep_running) {
+        stop_requested = true;
+        break;
+      }
+
+      sleep_time_histogram_.Record(
+          ToMicroseconds(FramePacer::Clock::now() - sleep_start_time_point));
+    }
+  }
+
+  // Frames stepped through by the debugger while we're not running must always
+  // be presented.
+  present_frame_ = true;
+
+  // Whatever the reason we stopped, the tone stops with us.
+  SetBeeperOn(false);
+
+  if (stop_requested) {
+    running_ = false;
+    emit RunStateChanged(RunState::kStopped);
+
+    // Only now that we've actually stopped may whoever asked us to pause or
+    // quit continue.
+    CompleteCommand(true);
   }
 }
\ No newline at end of file
@@ -12,12 +12,25 @@
 
 #pragma once
 
+#include <core/rom.h>
+#include <core/snapshot.h>
 #include <core/vm_instance.h>
 
 #include <QThread>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
+#include "frame_pacer.h"
+#include "frame_time_histogram.h"
 #include "types.h"
 
+class SoundManager;
+
 /// This class defines a separate thread for the virtual machine to live in.
 /// A separate thread is used to allow the virtual machine to run at varying
 /// speeds without risk of blocking the UI thread.
@@ -29,19 +42,82 @@ class VMThread : public QThread {
   Q_OBJECT
 
  public:
-  /// The average number of frames per second, in milliseconds.
-  using AverageFPSInMS = double;
+  /// The distributions of the time spent by key state changes in each stage
+  /// between being reported and being drawn. Only changes the guest program
+  /// responded to by drawing to the screen are counted, except for \ref
+  /// apply_.
+  struct InputLatency {
+    /// From being reported by the UI thread to being applied to the keypad.
+    FrameTimeHistogram::Summary apply_;
+
+    /// From being applied to being observed by the guest program.
+    FrameTimeHistogram::Summary observe_;
+
+    /// From being observed to the next frame drawn to being sent to the
+    /// screen.
+    FrameTimeHistogram::Summary draw_;
+
+    /// From the frame being sent to the screen to it having been drawn.
+    FrameTimeHistogram::Summary present_;
+
+    /// From being reported by the UI thread to having been drawn.
+    FrameTimeHistogram::Summary total_;
+  };
+
+  /// The performance information collected by the run loop over 1 second.
+  ///
+  /// All durations in the frame time distributions are in microseconds.
+  struct PerformanceCounters {
+    /// The number of frames executed.
+    unsigned int current_fps_ = 0;
+
+    /// The average time between the start of two frames, in milliseconds.
+    /// Note that this is the frame period, not the time spent emulating.
+    double average_frame_period_ = 0.0;
+
+    /// The desired number of frames per second.
+    unsigned int target_fps_ = 0;
+
+    /// The average error between the scheduled and actual start of a frame,
+    /// in milliseconds.
+    double average_pacing_error_ = 0.0;
 
-  /// The number of frames per second.
-  using CurrentFPS = unsigned int;
+    /// The number of instructions executed per second, in millions.
+    double mips_ = 0.0;
 
-  /// The desired frames per second.
-  using TargetFPS = unsigned int;
+    /// The time spent executing a frame.
+    FrameTimeHistogram::Summary emulation_time_;
 
-  /// A collection containing the current number of frames per second, the
-  /// average number of frames per second in milliseconds, and the desired
-  /// number of frames per second.
-  using PerformanceCounters = std::tuple<CurrentFPS, AverageFPSInMS, TargetFPS>;
+    /// The time spent waiting for the start of the next frame. This is not
+    /// collected in turbo mode.
+    FrameTimeHistogram::Summary sleep_time_;
+
+    /// The time between a frame being sent to the screen and it having been
+    /// drawn.
+    FrameTimeHistogram::Summary present_latency_;
+
+    /// The number of instructions executed in a frame.
+    FrameTimeHistogram::Summary steps_per_frame_;
+
+    /// The time spent by key state changes in each stage between being
+    /// reported by the UI thread and being drawn.
+    InputLatency input_latency_;
+  };
+
+  /// A key state change that has made it all the way to the screen.
+  struct InputTraceRecord {
+    /// The points in time at which the change went through the virtual
+    /// machine.
+    chip8::InputTrace trace_;
+
+    /// The point in time at which the frame showing the guest program's
+    /// response to the change was drawn.
+    FramePacer::Clock::time_point presented_;
+  };
+
+  /// The maximum number of key state changes kept for \ref
+  /// ExportInputTraces().
+  static constexpr size_t kMaxInputTraceRecords = 4096;
 
   /// Constructs the virtual machine thread.
   ///
@@ -49,6 +125,9 @@ class VMThread : public QThread {
   /// it.
   explicit VMThread(QObject* parent_object) noexcept;
 
+  /// Shuts down the thread, waiting for it to finish.
+  ~VMThread() noexcept override;
+
   /// From Qt documentation:
   ///
   /// The starting point for the thread. After calling \ref QThread::start(),
@@ -61,14 +140,193 @@ class VMThread : public QThread {
   ///
   /// See also \ref QThread::start() and \ref QThread::wait().
   ///
-  /// We override this method to handle execution of the virtual machine and
-  /// handle various events that may occur.
+  /// We override this method to wait for commands and execute them, including
+  /// running the virtual machine, until we're asked to quit. The thread is
+  /// started once upon construction and lives as long as this object does.
   void run() noexcept override;
 
-  /// Stops the execution of the thread.
+  /// Starts or resumes execution of the virtual machine.
+  ///
+  /// This method has no effect if the virtual machine is already running.
+  void Resume() noexcept;
+
+  /// Pauses execution of the virtual machine. When this method returns, the
+  /// virtual machine has stopped and may be safely accessed from the calling
+  /// thread.
+  ///
+  /// This method has no effect if the virtual machine is not running.
+  void Pause() noexcept;
+
+  /// Executes a number of instructions while the virtual machine is paused,
+  /// and waits for them to complete.
+  ///
+  /// \param num_steps The number of instructions to execute.
+  ///
+  /// \returns \p true if every instruction executed successfully, or \p false
+  /// if execution stopped early due to a breakpoint or an error.
+  auto Step(unsigned int num_steps) noexcept -> bool;
+
+  /// Resets the virtual machine to its startup state, with the program that
+  /// was last loaded by \ref LoadProgram().
+  ///
+  /// If the virtual machine is running, it continues to run from the start of
+  /// the program.
+  void Reset() noexcept;
+
+  /// Loads a program into the virtual machine, resetting it.
+  ///
+  /// If the virtual machine is running, it continues to run from the start of
+  /// the new program.
+  ///
+  /// \param rom The program to load. It is shared with the virtual machine
+  /// thread rather than copied, as it is kept for \ref Reset().
+  ///
+  /// \param default_variant The variant of the program, unless the ROM
+  /// database knows better, see \ref chip8::VMInstance::SetDefaultVariant().
+  ///
+  /// \returns \p true if the program was loaded, or \p false if it is too
+  /// large to fit in internal memory, in which case the previous program is
+  /// left untouched.
+  auto LoadProgram(std::shared_ptr<const chip8::Rom> rom,
+                   chip8::Variant default_variant) noexcept -> bool;
+
+  /// Changes the number of instructions the virtual machine executes per
+  /// second. The change takes effect at the next frame.
+  ///
+  /// \param instructions_per_second The number of instructions per second.
+  void SetInstructionsPerSecond(unsigned int instructions_per_second) noexcept;
+
+  /// Changes the number of frames the virtual machine executes per second.
+  /// The change takes effect at the next frame.
+  ///
+  /// \param frame_rate The number of frames per second.
+  void SetFrameRate(double frame_rate) noexcept;
+
+  /// Changes the state of a key on the keypad of the virtual machine. The
+  /// change is queued without locking, and applied by the virtual machine
+  /// thread before the next instruction.
+  ///
+  /// Should the queue be full, the change is sent as a command instead, which
+  /// waits for the virtual machine thread to pick it up; changes are never
+  /// dropped, so keys can't get stuck.
+  ///
+  /// If the guest program is waiting for a key press, the virtual machine
+  /// thread wakes up and continues the guest program right away instead of
+  /// at the next frame.
+  ///
+  /// This method must only be called from the UI thread.
   ///
-  /// This method has no effect if the thread is not running.
-  void StopExecution() noexcept;
+  /// \param key The key to change the state of.
+  /// \param key_state The new state of the key.
+  /// \param timestamp The point in time at which the host reported the
+  /// change, used to measure input latency.
+  void SetKeyState(chip8::Key key, chip8::KeyState key_state,
+                   chip8::InputEvent::Clock::time_point timestamp =
+                       chip8::InputEvent::Clock::now()) noexcept;
+
+  /// Sets whether or not the display paces the virtual machine, instead of
+  /// the frame rate of the virtual machine.
+  ///
+  /// When enabled, one frame is executed every time the display is refreshed,
+  /// see \ref NotifyDisplayRefreshed(), and the frame rate of the virtual
+  /// machine follows the refresh rate of the display so that it still
+  /// executes the right number of instructions per second. This does not
+  /// apply to turbo mode.
+  ///
+  /// \param enabled Whether or not the display paces the virtual machine.
+  void SetVsyncPacing(bool enabled) noexcept;
+
+  /// Notifies the thread that the display has been refreshed with the last
+  /// frame that was drawn. This also measures the refresh rate of the
+  /// display.
+  ///
+  /// This method must only be called from the UI thread.
+  void NotifyDisplayRefreshed() noexcept;
+
+  /// Determines whether or not the virtual machine is currently running.
+  ///
+  /// \returns \p true if the virtual machine is running, or \p false if it is
+  /// paused, or stopped by a breakpoint or an error. Waiting for a key press
+  /// counts as running.
+  auto IsRunning() const noexcept -> bool;
+
+  /// Changes the speed the virtual machine runs at.
+  ///
+  /// This method can be called at any time, including while the thread is
+  /// running; the change takes effect at the next frame.
+  ///
+  /// \param run_mode The new run mode.
+  void SetRunMode(RunMode run_mode) noexcept;
+
+  /// Retrieves the speed the virtual machine runs at.
+  ///
+  /// \returns The current run mode.
+  auto GetRunMode() const noexcept -> RunMode;
+
+  /// Sets how often a frame is presented in turbo mode.
+  ///
+  /// This method can be called at any time.
+  ///
+  /// \param frame_skip If this is \p 0, at most one frame per host refresh is
+  /// presented. Otherwise, only every Nth frame is presented.
+  void SetTurboFrameSkip(unsigned int frame_skip) noexcept;
+
+  /// Sets the refresh rate of the display the virtual machine is shown on.
+  /// This is used to limit the number of frames presented in turbo mode.
+  ///
+  /// This method can be called at any time.
+  ///
+  /// \param refresh_rate The refresh rate of the display, in Hz.
+  void SetHostRefreshRate(double refresh_rate) noexcept;
+
+  /// Sets the sound manager the beeper of the virtual machine drives.
+  ///
+  /// The beeper is switched on and off straight from the virtual machine
+  /// thread, without going through the event queue of the UI thread.
+  ///
+  /// This method can be called at any time.
+  ///
+  /// \param sound_manager The sound manager to drive, or \p nullptr if there is
+  /// no sound.
+  void SetSoundManager(SoundManager* sound_manager) noexcept;
+
+  /// Notifies the thread that the last frame sent to the screen has been
+  /// drawn, to measure the present latency.
+  ///
+  /// This method is meant to be called from the UI thread. Frames that are
+  /// drawn more than once, for instance because the window was resized, are
+  /// only counted the first time.
+  void RecordFramePresented() noexcept;
+
+  /// Writes the most recent key state changes that made it to the screen to a
+  /// CSV file, with the time spent in each stage in microseconds.
+  ///
+  /// This method is meant to be called from the UI thread.
+  ///
+  /// \param file_name The file to write to.
+  ///
+  /// \returns \p true if the file was written, or \p false otherwise.
+  auto ExportInputTraces(const std::string& file_name) noexcept -> bool;
+
+  /// Sets whether or not the state of the virtual machine is published for
+  /// \ref AcquireSnapshot() at every frame while it is running.
+  ///
+  /// Publishing costs a copy of the state per frame, so it should only be
+  /// enabled while somebody is watching, such as the debugger.
+  ///
+  /// This method can be called at any time.
+  ///
+  /// \param enabled Whether or not snapshots should be published.
+  void SetPublishSnapshots(bool enabled) noexcept;
+
+  /// Picks up the most recent snapshot of the virtual machine published while
+  /// it is running. This never waits for the virtual machine thread.
+  ///
+  /// This method must only be called from the UI thread.
+  ///
+  /// \returns The most recent snapshot, which stays valid until the next call,
+  /// or \p nullptr if none has been published since the last call.
+  auto AcquireSnapshot() noexcept -> const chip8::StateSnapshot*;
 
   /// The virtual machine instance.
   chip8::VMInstance vm_instance_;
@@ -81,10 +339,285 @@ class VMThread : public QThread {
   /// Configures the virtual machine based on the current application settings.
   void SetupFromAppSettings() noexcept;
 
+  /// Switches the beeper of the current sound manager on or off, if there is
+  /// one.
+  ///
+  /// \param beeper_on Whether or not a tone should be playing.
+  void SetBeeperOn(bool beeper_on) noexcept;
+
+  /// Publishes the state of the virtual machine, if enabled by \ref
+  /// SetPublishSnapshots(). This is only called by the virtual machine thread,
+  /// at frame boundaries.
+  void PublishSnapshot() noexcept;
+
+  /// A request sent to the virtual machine thread by \ref PostCommand().
+  struct Command {
+    /// The kind of request.
+    enum class Type {
+      kRun,
+      kPause,
+      kStep,
+      kReset,
+      kLoadProgram,
+      kSetInstructionsPerSecond,
+      kSetFrameRate,
+      kSetVsyncPacing,
+      kSetKeyState,
+      kQuit
+    };
+
+    /// Constructs a command.
+    ///
+    /// \param type The kind of request.
+    explicit Command(const Type type) noexcept : type_(type) {}
+
+    /// The kind of request.
+    Type type_;
+
+    /// For \ref Type::kStep, the number of instructions to execute.
+    unsigned int num_steps_ = 0;
+
+    /// For \ref Type::kSetInstructionsPerSecond, the new number of
+    /// instructions per second.
+    unsigned int instructions_per_second_ = 0;
+
+    /// For \ref Type::kSetFrameRate, the new number of frames per second.
+    double frame_rate_ = 0.0;
+
+    /// For \ref Type::kSetVsyncPacing, whether or not the display paces the
+    /// virtual machine.
+    bool enabled_ = false;
+
+    /// For \ref Type::kSetKeyState, the key to change the state of.
+    chip8::Key key_ = chip8::Key::k0;
+
+    /// For \ref Type::kSetKeyState, the new state of the key.
+    chip8::KeyState key_state_ = chip8::KeyState::kReleased;
+
+    /// For \ref Type::kLoadProgram, the variant of the program unless the ROM
+    /// database knows better.
+    chip8::Variant variant_ = chip8::Variant::kChip8;
+
+    /// For \ref Type::kLoadProgram, the program to load. A \ref chip8::Rom
+    /// holds a whole XO-CHIP program area, so it is shared rather than
+    /// carried by every command.
+    std::shared_ptr<const chip8::Rom> rom_;
+  };
+
+  /// Sends a command to the virtual machine thread and waits for it to be
+  /// executed.
+  ///
+  /// Commands are executed in the order they were sent. While the virtual
+  /// machine is running, commands are picked up between frames, including
+  /// while waiting for the next frame to start.
+  ///
+  /// \param command The command to send.
+  ///
+  /// \returns The result of the command.
+  auto PostCommand(Command command) noexcept -> bool;
+
+  /// Blocks until a command has been sent, and removes it from the queue.
+  ///
+  /// \returns The command that was sent.
+  auto WaitForCommand() noexcept -> Command;
+
+  /// Marks the command last removed from the queue as executed, and wakes up
+  /// the thread waiting for it.
+  ///
+  /// \param result The result of the command.
+  void CompleteCommand(bool result) noexcept;
+
+  /// Executes a command that does not affect whether or not the virtual
+  /// machine is running.
+  ///
+  /// \param command The command to execute.
+  ///
+  /// \returns The result of the command.
+  auto ExecuteCommand(const Command& command) noexcept -> bool;
+
+  /// Executes every queued command while the virtual machine is running.
+  ///
+  /// \returns \p true if the virtual machine should keep running, or \p false
+  /// if it was asked to pause or quit.
+  auto ProcessPendingCommands() noexcept -> bool;
+
+  /// Waits until the next frame is due, executing commands as they arrive.
+  ///
+  /// While the guest program is waiting for a key press, there's nothing that
+  /// needs to happen precisely on time, so we sleep without spinning. If the
+  /// key press arrives, the next frame starts right away.
+  ///
+  /// \returns \p true if the virtual machine should keep running, or \p false
+  /// if it was asked to pause or quit.
+  auto WaitForNextFrame() noexcept -> bool;
+
+  /// Waits until the display has been refreshed, executing commands as they
+  /// arrive.
+  ///
+  /// If the display isn't refreshed within two frames, for instance because
+  /// the window is hidden, we stop waiting so that the virtual machine keeps
+  /// running.
+  ///
+  /// \returns \p true if the virtual machine should keep running, or \p false
+  /// if it was asked to pause or quit.
+  auto WaitForDisplayRefresh() noexcept -> bool;
+
+  /// Changes the frame rate of the virtual machine to the refresh rate of the
+  /// display, if it has changed noticeably.
+  void MatchFrameRateToDisplay() noexcept;
+
+  /// Runs the virtual machine until it is paused, or stops due to a
+  /// breakpoint, an error, or the guest program waiting for a key press.
+  void RunUntilStopped() noexcept;
+
+  /// Determines whether or not the frame about to be executed should be sent
+  /// to the screen.
+  ///
+  /// \param run_mode The run mode the frame is executed in.
+  ///
+  /// \returns \p true if the frame should be presented, or \p false otherwise.
+  auto ShouldPresentFrame(RunMode run_mode) noexcept -> bool;
+
   /// The number of frames that have been generated. This is used to calculate
   /// the frame time averaged to 1 second.
   unsigned int num_frames_;
 
+  /// Paces the run loop to the frame rate of the virtual machine.
+  FramePacer frame_pacer_;
+
+  /// The current run mode, see \ref SetRunMode().
+  std::atomic<RunMode> run_mode_ = RunMode::kNormal;
+
+  /// How often a frame is presented in turbo mode, see \ref
+  /// SetTurboFrameSkip().
+  std::atomic<unsigned int> turbo_frame_skip_ = 0;
+
+  /// The refresh rate of the host display in Hz, see \ref
+  /// SetHostRefreshRate().
+  std::atomic<double> host_refresh_rate_ = 60.0;
+
+  /// Whether or not the frame currently being executed should be sent to the
+  /// screen. This is only accessed by the virtual machine thread.
+  bool present_frame_ = true;
+
+  /// The number of frames executed since a frame was last presented in turbo
+  /// mode.
+  unsigned int frames_since_present_ = 0;
+
+  /// The time point at which a frame was last presented in turbo mode.
+  FramePacer::Clock::time_point last_present_time_point_;
+
+  /// The frame rate configured by the user. The frame rate of the virtual
+  /// machine differs while the display paces it. This is only accessed by
+  /// the virtual machine thread.
+  double frame_rate_ = chip8::timing::kDefaultFrameRate;
+
+  /// Whether or not the display paces the virtual machine, see \ref
+  /// SetVsyncPacing(). This is only accessed by the virtual machine thread.
+  bool vsync_pacing_ = false;
+
+  /// Whether or not the display has been refreshed since the virtual machine
+  /// thread last checked.
+  std::atomic<bool> display_refreshed_ = false;
+
+  /// The refresh rate of the display as measured by \ref
+  /// NotifyDisplayRefreshed(), in Hz, or 0 if it hasn't been measured yet.
+  std::atomic<double> display_refresh_rate_ = 0.0;
+
+  /// The time point at which the display was last refreshed. This is only
+  /// accessed by the UI thread.
+  FramePacer::Clock::time_point last_display_refresh_time_point_;
+
+  /// The time point at which the current refresh rate measurement started.
+  /// This is only accessed by the UI thread.
+  FramePacer::Clock::time_point refresh_measurement_start_time_point_;
+
+  /// The number of refreshes counted by the current refresh rate measurement.
+  /// This is only accessed by the UI thread.
+  unsigned int num_refreshes_measured_ = 0;
+
+  /// The time at which the last frame was sent to the screen, in nanoseconds
+  /// since the epoch of \ref FramePacer::Clock, or 0 if it has already been
+  /// drawn.
+  std::atomic<int64_t> last_update_screen_time_ = 0;
+
+  /// The distribution of the time spent executing a frame.
+  FrameTimeHistogram emulation_time_histogram_;
+
+  /// The distribution of the time spent waiting for the next frame.
+  FrameTimeHistogram sleep_time_histogram_;
+
+  /// The distribution of the time between a frame being sent to the screen
+  /// and it having been drawn. This is recorded by the UI thread.
+  FrameTimeHistogram present_latency_histogram_;
+
+  /// The distribution of the number of instructions executed in a frame.
+  FrameTimeHistogram steps_per_frame_histogram_;
+
+  /// The distributions of the time spent by key state changes in each stage,
+  /// see \ref InputLatency.
+  FrameTimeHistogram input_apply_histogram_;
+  FrameTimeHistogram input_observe_histogram_;
+  FrameTimeHistogram input_draw_histogram_;
+  FrameTimeHistogram input_present_histogram_;
+  FrameTimeHistogram input_total_histogram_;
+
+  /// Protects \ref unpresented_input_traces_ and \ref input_trace_records_.
+  std::mutex input_trace_mutex_;
+
+  /// The key state changes whose frame has been sent to the screen, but not
+  /// yet drawn.
+  std::vector<chip8::InputTrace> unpresented_input_traces_;
+
+  /// The most recent key state changes that made it to the screen, oldest
+  /// first. At most \ref kMaxInputTraceRecords are kept.
+  std::deque<InputTraceRecord> input_trace_records_;
+
+  /// Protects the command queue and the command completion state.
+  std::mutex command_mutex_;
+
+  /// Signaled when a command has been added to the queue.
+  std::condition_variable command_posted_;
+
+  /// Signaled when a command has been executed.
+  std::condition_variable command_completed_;
+
+  /// The commands that have yet to be executed.
+  std::deque<Command> commands_;
+
+  /// The number of commands that have been sent.
+  uint64_t num_commands_posted_ = 0;
+
+  /// The number of commands that have been executed.
+  uint64_t num_commands_completed_ = 0;
+
+  /// The result of the command that was executed last.
+  bool last_command_result_ = false;
+
+  /// Whether or not a key state change has been queued since the virtual
+  /// machine thread last checked. This is only used to wake the thread up.
+  std::atomic<bool> input_posted_ = false;
+
+  /// Whether or not the thread has been asked to quit. This is only accessed
+  /// by the virtual machine thread.
+  bool quit_requested_ = false;
+
+  /// Whether or not the virtual machine is running, see \ref IsRunning().
+  std::atomic<bool> running_ = false;
+
+  /// The sound manager set by \ref SetSoundManager().
+  std::atomic<SoundManager*> sound_manager_ = nullptr;
+
+  /// Whether or not snapshots are published, see \ref SetPublishSnapshots().
+  std::atomic<bool> publish_snapshots_ = false;
+
+  /// Hands snapshots of the virtual machine over to the UI thread.
+  chip8::SnapshotBuffer snapshot_buffer_;
+
+  /// The program that was last loaded, if any, used by \ref Reset(). This is
+  /// only accessed by the virtual machine thread.
+  std::shared_ptr<const chip8::Rom> rom_;
+
  signals:
   /// Emitted when the run state of the virtual machine has changed.
   ///
@@ -103,23 +636,12 @@ class VMThread : public QThread {
 
   /// Emitted when a full frame has been completed.
   ///
-  /// \param framebuffer The screen data to render, containing BGRA32 values.
-  void UpdateScreen(
-      const chip8::ImplementationInterface::Framebuffer& framebuffer);
-
-  /// Emitted when the guest program is requesting to play a tone.
-  ///
-  /// \param tone_duration The duration of the tone in milliseconds.
-  void PlayTone(const double tone_duration);
+  /// \param framebuffer The screen to render, at its current resolution.
+  void UpdateScreen(const chip8::Screen& framebuffer);
 
   /// Emitted when a fatal error has occurred within the virtual machine.
   ///
   /// \param step_result The result of the failure, refer to \ref
   /// chip8::StepResult for more details.
   void ExecutionFailure(const chip8::StepResult step_result);
-
-  /// Emitted when a log message has been emitted by the virtual machine.
-  ///
-  /// \param msg The message from the virtual machine.
-  void LogMessageEmitted(const std::string& msg);
 };
\ No newline at end of file
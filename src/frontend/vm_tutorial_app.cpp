@@ -14,14 +14,16 @@
 
 #include <QFileInfo>
 #include <QMessageBox>
-#include <filesystem>
-#include <fstream>
+#include <QScreen>
+#include <cerrno>
+#include <cstring>
 
 #include "models/app_settings.h"
 
 VMTutorialApplication::VMTutorialApplication() noexcept
     : main_window_(new MainWindowController),
-      vm_thread_(new VMThread(main_window_)) {
+      vm_thread_(new VMThread(main_window_)),
+      rom_library_thread_(new RomLibraryThread(this)) {
   // We've initialized the main window and the virtual machine thread
   // immediately because these are mandatory components. The renderer is
   // initialized as part of the main window.
@@ -29,11 +31,58 @@ VMTutorialApplication::VMTutorialApplication() noexcept
   // This may fail and an error message may be displayed before the main window
   // is shown, but it does not constitute a fatal program termination.
   InitializeAudio();
+
+  // Log messages are delivered from whichever thread emits them, so they are
+  // buffered until the logger window picks them up.
+  chip8::Logger::Get().log_message_func_ =
+      [this](const chip8::Logger::LogLevel level, const std::string& msg) {
+        log_buffer_.Push(level, msg);
+      };
+
   ConnectVMThreadSignalsToSlots();
   ConnectMainWindowSignalsToSlots();
+  InitializeRomDatabase();
+  InitializeRomLibrary();
 
   // All set to go; show the main window.
   main_window_->show();
+
+  // The display may pace the virtual machine from the start.
+  vm_thread_->SetHostRefreshRate(main_window_->screen()->refreshRate());
+}
+
+VMTutorialApplication::~VMTutorialApplication() noexcept {
+  // The virtual machine thread is a child of the main window; it finishes
+  // running before the sound manager it drives is destroyed along with us.
+  delete main_window_;
+
+  // Indexing ROM files logs too; the scan has to stop before the log buffer
+  // goes away.
+  delete rom_library_thread_;
+
+  // Nothing is left to log from another thread.
+  chip8::Logger::Get().log_message_func_ = nullptr;
+}
+
+void VMTutorialApplication::InitializeRomLibrary() noexcept {
+  // Reading the cache file is quick, so the library is listed by the time the
+  // main window is shown.
+  main_window_->SetRomLibrary(rom_library_thread_->LoadCache());
+
+  connect(rom_library_thread_, &QThread::finished, this, [this]() {
+    main_window_->SetRomLibrary(rom_library_thread_->GetEntries());
+  });
+
+  rom_library_thread_->Scan(AppSettingsModel().GetProgramFilesPath());
+}
+
+void VMTutorialApplication::InitializeRomDatabase() noexcept {
+  auto& rom_database = chip8::RomDatabase::Get();
+
+  for (const auto& [hash, profile] :
+       AppSettingsModel().GetRomProfileOverrides()) {
+    rom_database.SetOverride(hash, profile);
+  }
 }
 
 void VMTutorialApplication::InitializeAudio() noexcept {
@@ -59,6 +108,13 @@ void VMTutorialApplication::InitializeAudio() noexcept {
                   (*sound_manager_)->GetAudioOutputDevices());
             }
           });
+
+  // The virtual machine thread drives the beeper directly. Should the sound
+  // manager be destroyed first, the thread has to let go of it.
+  vm_thread_->SetSoundManager(*sound_manager_);
+
+  connect((*sound_manager_), &QObject::destroyed, vm_thread_,
+          [this]() { vm_thread_->SetSoundManager(nullptr); });
 }
 
 void VMTutorialApplication::NotifyCriticalAudioFailure(
@@ -90,23 +146,21 @@ void VMTutorialApplication::ConnectVMThreadSignalsToSlots() noexcept {
   connect(vm_thread_, &VMThread::ExecutionFailure, main_window_,
           &MainWindowController::ReportExecutionFailure);
 
-  connect(vm_thread_, &VMThread::PerformanceInfo,
+  // The labels and the overlay of the main window belong to the UI thread.
+  connect(vm_thread_, &VMThread::PerformanceInfo, main_window_,
           [this](const VMThread::PerformanceCounters& perf_counters) {
-            // Unpack the tuple into its separate components for readability's
-            // sake.
-            const auto [current_fps, average_fps, target_fps] = perf_counters;
-
-            main_window_->UpdateFPSInfo(current_fps, target_fps, average_fps);
+            main_window_->UpdateFPSInfo(perf_counters);
           });
 
-  connect(vm_thread_, &VMThread::PlayTone, [this](const double duration) {
-    // It is possible that the sound manager has not been instantiated due to
-    // a failure in initializing it, so we have to check if it actually exists
-    // before playing a tone.
-    if (sound_manager_) {
-      (*sound_manager_)->PlayTone(duration);
-    }
-  });
+  // The present latency is measured from the moment the virtual machine thread
+  // sends a frame to the moment the renderer has drawn it.
+  connect(main_window_->GetRenderer(), &Renderer::FramePresented,
+          [this]() { vm_thread_->RecordFramePresented(); });
+
+  // When the display paces the virtual machine, every buffer swap starts the
+  // next frame.
+  connect(main_window_->GetRenderer(), &Renderer::frameSwapped,
+          [this]() { vm_thread_->NotifyDisplayRefreshed(); });
 
   connect(vm_thread_, &VMThread::RunStateChanged, this,
           [this](const RunState run_state) {
@@ -122,45 +176,38 @@ void VMTutorialApplication::ConnectVMThreadSignalsToSlots() noexcept {
 
   connect(vm_thread_, &VMThread::UpdateScreen, main_window_->GetRenderer(),
           &Renderer::UpdateScreen);
-
-  connect(vm_thread_, &VMThread::LogMessageEmitted, this,
-          [this](const std::string& msg) {
-            if (logger_window_) {
-              logger_window_->AddMessage(QString::fromStdString(msg));
-            }
-          });
 }
 
 void VMTutorialApplication::ConnectMainWindowSignalsToSlots() noexcept {
   connect(main_window_, &MainWindowController::CHIP8KeyPress,
-          [this](const chip8::Key key) {
-            // The virtual machine may be waiting for a key press before
-            // continuing execution. We need to find out now because when
-            // setting CHIP-8 key state, this value will be cleared.
-            const auto halted_until_key_press =
-                vm_thread_->vm_instance_.impl_->IsHaltedUntilKeyPress();
-
-            vm_thread_->vm_instance_.impl_->SetKeyState(
-                key, chip8::KeyState::kPressed);
-
-            if (halted_until_key_press) {
-              // The virtual machine was waiting for a key press, which means
-              // that the virtual machine thread was not running. Start it now.
-              vm_thread_->start();
-            }
+          [this](const chip8::Key key,
+                 const chip8::InputEvent::Clock::time_point timestamp) {
+            // If the guest program is waiting for a key press, the virtual
+            // machine thread will pick it up right away.
+            vm_thread_->SetKeyState(key, chip8::KeyState::kPressed, timestamp);
           });
 
   connect(main_window_, &MainWindowController::CHIP8KeyRelease,
-          [this](const chip8::Key key) {
-            vm_thread_->vm_instance_.impl_->SetKeyState(
-                key, chip8::KeyState::kReleased);
+          [this](const chip8::Key key,
+                 const chip8::InputEvent::Clock::time_point timestamp) {
+            vm_thread_->SetKeyState(key, chip8::KeyState::kReleased,
+                                    timestamp);
+          });
+
+  connect(main_window_, &MainWindowController::ExportInputTraces, this,
+          [this](const QString& trace_file) {
+            if (!vm_thread_->ExportInputTraces(trace_file.toStdString())) {
+              main_window_->ReportInputTraceExportError(trace_file);
+            }
           });
 
   connect(main_window_, &MainWindowController::DisplayDebugger, this, [this]() {
     if (!debugger_window_) {
-      debugger_window_ = new DebuggerWindowController(vm_thread_->vm_instance_);
+      vm_thread_->SetPublishSnapshots(true);
+
+      debugger_window_ = new DebuggerWindowController(*vm_thread_);
       debugger_window_->setAttribute(Qt::WA_DeleteOnClose);
-      debugger_window_->EnableControls(!vm_thread_->isRunning());
+      debugger_window_->EnableControls(!vm_thread_->IsRunning());
 
       ConnectDebuggerSignalsToSlots();
     }
@@ -171,7 +218,7 @@ void VMTutorialApplication::ConnectMainWindowSignalsToSlots() noexcept {
 
   connect(main_window_, &MainWindowController::DisplayLogger, this, [this]() {
     if (!logger_window_) {
-      logger_window_ = new LoggerWindowController();
+      logger_window_ = new LoggerWindowController(log_buffer_);
       logger_window_->setAttribute(Qt::WA_DeleteOnClose);
     }
     // If the logger window already exists, it will be brought to the
@@ -201,25 +248,30 @@ void VMTutorialApplication::ConnectMainWindowSignalsToSlots() noexcept {
   connect(main_window_, &MainWindowController::PauseEmulation, [this]() {
     // It's safe to call this method here, as this signal is only triggerable if
     // and only if the virtual machine is already running.
-    vm_thread_->StopExecution();
+    vm_thread_->Pause();
   });
 
   connect(main_window_, &MainWindowController::ResumeEmulation, [this]() {
     // It's safe to call this method here, as this signal is only triggerable if
     // and only if the virtual machine is not running.
-    vm_thread_->start();
+    vm_thread_->Resume();
   });
 
-  connect(main_window_, &MainWindowController::ResetEmulation, [this]() {
-    // We stop execution so that we're not loading new data as the old ROM is
-    // running, which may cause spurious error messages to be displayed.
-    vm_thread_->StopExecution();
-
-    // The current program was loaded before, so it is guaranteed to be valid.
-    // Upon loading a program, the virtual machine is reset.
-    vm_thread_->vm_instance_.LoadProgram(current_rom_data_);
+  connect(main_window_, &MainWindowController::ToggleTurbo,
+          [this](const bool enabled) {
+            // Turbo mode presents frames at the rate of the display the main
+            // window is on when no frame skip has been configured.
+            vm_thread_->SetHostRefreshRate(
+                main_window_->screen()->refreshRate());
+            vm_thread_->SetRunMode(enabled ? RunMode::kTurbo
+                                           : RunMode::kNormal);
+          });
 
-    vm_thread_->start();
+  connect(main_window_, &MainWindowController::ResetEmulation, [this]() {
+    // The reset is carried out between two frames, so it's safe to do this
+    // while the virtual machine is running. If it was paused, start it again.
+    vm_thread_->Reset();
+    vm_thread_->Resume();
   });
 
   connect(main_window_, &MainWindowController::StartROM, this,
@@ -227,88 +279,53 @@ void VMTutorialApplication::ConnectMainWindowSignalsToSlots() noexcept {
 }
 
 void VMTutorialApplication::StartROM(const QString& rom_file_path) noexcept {
-  // We need to know if the virtual machine was already running, so in the event
-  // of a failure to load a new ROM the one that was already running can be
-  // resumed.
-  const auto vm_thread_was_running = vm_thread_->isRunning();
-
-  // Stop execution of the virtual machine, if and only if it is already
-  // running. If it is not running, this method will perform no operation. We
-  // stop execution so that we're not loading new data as the old ROM is
-  // running, which may cause spurious error messages to be displayed.
-  vm_thread_->StopExecution();
-
-  // We're using C++ I/O facilities, which don't handle QStrings. So, we'll
-  // need to convert the QString into a form that C++ I/O facilities understand,
-  // in this case an std::string. Fortunately, Qt natively provides a method
-  // for this.
-  const auto rom_file = rom_file_path.toStdString();
-
-  // Now, try to open the ROM file in binary I/O mode. Using the initialization
-  // constructor means the file will attempt to be opened immediately.
-  std::ifstream rom_file_handle{rom_file, std::ios::binary};
-
-  if (!rom_file_handle) {
-    // There was an error in opening the file. We need to tell the user of this
-    // error condition, and why it happened.
-    //
-    // We don't support or use exceptions in the tutorial, so we can't throw
-    // something like an `std::system_error` exception. The simplest and most
-    // correct action we can perform under these circumstances is to retrieve
-    // the string that describes the error code specified by the thread-local
-    // `errno` variable.
-    main_window_->ReportROMOpenError(rom_file_path, strerror(errno));
-
-    if (vm_thread_was_running) {
-      // If and only if a ROM was running before this, resume it.
-      vm_thread_->start();
-    }
-    // There's nothing more we can do here.
-    return;
+  // The virtual machine keeps running the current ROM, if any, while we read
+  // the new one. If we fail to do so, nothing has changed for the user.
+
+  // The core reads the whole file in one go. It doesn't handle QStrings, so
+  // we'll need to convert the path into an std::string first.
+  //
+  // The ROM is read straight into the memory the virtual machine thread will
+  // keep it in.
+  auto rom = std::make_shared<chip8::Rom>();
+
+  switch (chip8::LoadRom(rom_file_path.toStdString(), *rom)) {
+    case chip8::RomLoadResult::kSuccess:
+      break;
+
+    case chip8::RomLoadResult::kOpenFailed:
+      // We don't support or use exceptions in the tutorial, so we can't throw
+      // something like an `std::system_error` exception. The simplest and
+      // most correct action we can perform under these circumstances is to
+      // retrieve the string that describes the error code specified by the
+      // thread-local `errno` variable.
+      main_window_->ReportROMOpenError(rom_file_path, strerror(errno));
+      return;
+
+    case chip8::RomLoadResult::kReadFailed:
+      // The file was unable to be read in its entirety, so we won't be able
+      // to use this ROM.
+      main_window_->ReportROMBadRead(rom_file_path, strerror(errno));
+      return;
+
+    case chip8::RomLoadResult::kTooLarge:
+      // The file the user selected is too large to fit into the virtual
+      // machine's internal memory. The file the user selected probably is not
+      // a CHIP-8 ROM.
+      main_window_->ReportROMTooLargeError(rom_file_path);
+      return;
   }
 
-  // We've opened the file successfully. Now, let's copy the contents of it into
-  // our ROM data storage.
-  current_rom_data_ = std::vector<uint_fast8_t>(
-      std::istreambuf_iterator<char>(rom_file_handle), {});
-
-  // We don't need the file opened anymore, we've read the file to the best of
-  // our ability.
-  rom_file_handle.close();
-
-  // We'll need to reference the file size multiple times, so let's store it
-  // once here.
-  const auto rom_file_size = std::filesystem::file_size(rom_file);
-
-  // We'll need to reference the size of the ROM data multiple times, so let's
-  // store it once here.
-  const auto rom_data_size = current_rom_data_.size();
+  // Unless the user picked a variant, the extension is the best guess for the
+  // programs the ROM database doesn't know.
+  const auto variant = AppSettingsModel().GetMachineVariant().value_or(
+      chip8::GetVariantFromExtension(rom_file_path.toStdString())
+          .value_or(chip8::Variant::kChip8));
 
-  if (rom_data_size != rom_file_size) {
-    // The file was unable to be read in its entirety. We need to tell the user
-    // of this error condition, as we won't be able to use this ROM.
-    main_window_->ReportROMBadRead(rom_file_path, rom_data_size, rom_file_size);
-
-    // If and only if a ROM was running before this, resume it.
-    if (vm_thread_was_running) {
-      vm_thread_->start();
-    }
-    // There's nothing more we can do here.
-    return;
-  }
-
-  if (!vm_thread_->vm_instance_.LoadProgram(current_rom_data_)) {
-    // The file the user selected is too large to fit into the virtual machine's
-    // internal memory. This is an error condition we must report to the user,
-    // as we cannot reasonably use it. The file the user selected probably is
-    // not a CHIP-8 ROM.
+  if (!vm_thread_->LoadProgram(std::move(rom), variant)) {
+    // Only XO-CHIP programs may use more than the classic program area; the
+    // program that was running before, if any, is left untouched.
     main_window_->ReportROMTooLargeError(rom_file_path);
-
-    // If and only if a ROM was running before this, resume it.
-    if (vm_thread_was_running) {
-      vm_thread_->start();
-    }
-    // There's nothing more we can do here.
     return;
   }
 
@@ -319,7 +336,7 @@ void VMTutorialApplication::StartROM(const QString& rom_file_path) noexcept {
 
   // The contents of the ROM file have been copied into the virtual machine's
   // internal memory, and no errors have occurred. Start the virtual machine.
-  vm_thread_->start();
+  vm_thread_->Resume();
 }
 
 void VMTutorialApplication::ConnectDebuggerSignalsToSlots() noexcept {
@@ -330,16 +347,26 @@ void VMTutorialApplication::ConnectDebuggerSignalsToSlots() noexcept {
             // the thread to suddenly stop.
             vm_thread_->vm_instance_.breakpoints_.clear();
             vm_thread_->vm_instance_.StopTracing();
+
+            // Nobody is watching the virtual machine run anymore.
+            vm_thread_->SetPublishSnapshots(false);
           });
 
   connect(debugger_window_, &DebuggerWindowController::ToggleRunState, this,
           [this]() {
-            if (vm_thread_->isRunning()) {
-              vm_thread_->StopExecution();
+            if (vm_thread_->IsRunning()) {
+              vm_thread_->Pause();
             } else {
-              vm_thread_->start();
+              vm_thread_->Resume();
             }
           });
+
+  connect(debugger_window_, &DebuggerWindowController::Step, this,
+          [this](const unsigned int num_steps) {
+            // The virtual machine is paused, so this returns once the steps
+            // have been executed.
+            vm_thread_->Step(num_steps);
+          });
 }
 
 void VMTutorialApplication::ConnectAudioSettingsSignalsToSlots() noexcept {
@@ -353,7 +380,7 @@ void VMTutorialApplication::ConnectAudioSettingsSignalsToSlots() noexcept {
   connect(settings_dialog_->audio_settings_,
           &AudioSettingsController::ToneTypeChanged, [this](const int type) {
             // This change will be reflected in the sound output immediately.
-            (*sound_manager_)->tone_type_ = static_cast<ToneType>(type);
+            (*sound_manager_)->SetToneType(static_cast<ToneType>(type));
           });
 
   connect(settings_dialog_->audio_settings_,
@@ -364,7 +391,7 @@ void VMTutorialApplication::ConnectAudioSettingsSignalsToSlots() noexcept {
           &AudioSettingsController::FrequencyChanged, (*sound_manager_),
           [this](const unsigned int freq) {
             // This change will be reflected in the sound output immediately.
-            (*sound_manager_)->tone_freq_ = freq;
+            (*sound_manager_)->SetToneFrequency(freq);
           });
 
   connect(settings_dialog_->audio_settings_,
@@ -378,8 +405,7 @@ void VMTutorialApplication::ConnectMachineSettingsSignalsToSlots() noexcept {
           [this](const int instructions_per_second) {
             // This change will be reflected during the execution of the virtual
             // machine immediately.
-            vm_thread_->vm_instance_.SetInstructionsPerSecond(
-                instructions_per_second);
+            vm_thread_->SetInstructionsPerSecond(instructions_per_second);
           });
 
   connect(settings_dialog_->machine_settings_,
@@ -387,6 +413,23 @@ void VMTutorialApplication::ConnectMachineSettingsSignalsToSlots() noexcept {
           [this](const double frame_rate) {
             // This change will be reflected during the execution of the virtual
             // machine immediately.
-            vm_thread_->vm_instance_.SetFrameRate(frame_rate);
+            vm_thread_->SetFrameRate(frame_rate);
+          });
+
+  connect(settings_dialog_->machine_settings_,
+          &MachineSettingsController::MachineTurboFrameSkipChanged,
+          [this](const int frame_skip) {
+            vm_thread_->SetTurboFrameSkip(
+                static_cast<unsigned int>(frame_skip));
+          });
+
+  connect(settings_dialog_->machine_settings_,
+          &MachineSettingsController::MachineVsyncPacingChanged,
+          [this](const bool enabled) {
+            // Until the refresh rate has been measured, the one reported for
+            // the display the main window is on is used.
+            vm_thread_->SetHostRefreshRate(
+                main_window_->screen()->refreshRate());
+            vm_thread_->SetVsyncPacing(enabled);
           });
 }
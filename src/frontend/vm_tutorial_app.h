@@ -16,6 +16,8 @@
 #include "controllers/logger_window.h"
 #include "controllers/main_window.h"
 #include "controllers/settings/settings_dialog.h"
+#include "log_buffer.h"
+#include "rom_library_thread.h"
 #include "sound_manager.h"
 #include "vm_thread.h"
 
@@ -28,6 +30,11 @@ class VMTutorialApplication : public QObject {
   /// Constructs the vm-tutorial application.
   VMTutorialApplication() noexcept;
 
+  /// Destroys the main window, and with it the virtual machine thread. Both
+  /// it and the ROM library thread are stopped and joined before anything
+  /// they use, like the log buffer, goes away.
+  ~VMTutorialApplication() noexcept override;
+
  private:
   /// Connects the signals from the virtual machine thread to slots.
   void ConnectVMThreadSignalsToSlots() noexcept;
@@ -41,12 +48,21 @@ class VMTutorialApplication : public QObject {
   /// It is not a fatal error.
   void InitializeAudio() noexcept;
 
+  /// Lists the ROM library as of the last scan, and starts looking for ROM
+  /// files that changed since then in the background.
+  void InitializeRomLibrary() noexcept;
+
+  /// Applies the per-program profiles the user configured on top of the ones
+  /// built into the core, so that they are picked up whenever a ROM is loaded.
+  void InitializeRomDatabase() noexcept;
+
   /// Notifies the user that the audio subsystem failed to initialize.
   ///
   /// \param error_message The error message from the audio subsystem.
   void NotifyCriticalAudioFailure(const QString& error_message) noexcept;
 
-  /// The controller for the main window.
+  /// The controller for the main window. It has no parent, so we destroy it
+  /// ourselves.
   MainWindowController* main_window_;
 
   /// The controller for the debugger window. It is encapsulated in a QPointer
@@ -57,6 +73,10 @@ class VMTutorialApplication : public QObject {
   /// because the logger window is optional.
   QPointer<LoggerWindowController> logger_window_;
 
+  /// The log messages waiting to be displayed by the logger window. Messages
+  /// keep being collected while the logger window is closed.
+  LogBuffer log_buffer_;
+
   /// The controller for the settings dialog. It is encapsulated in a QPointer
   /// because the settings dialog is optional.
   QPointer<SettingsDialogController> settings_dialog_;
@@ -69,13 +89,8 @@ class VMTutorialApplication : public QObject {
   /// The virtual machine thread manager.
   VMThread* vm_thread_;
 
-  /// The current ROM data being executed. We store a 2nd copy to handle the
-  /// reset functionality. The first copy is in the internal memory of the
-  /// virtual machine, but we can't be sure if it's self-modifying. That's why
-  /// we have another copy here for resetting.
-  ///
-  /// XXX: I think it is awful to store a 2nd copy...
-  std::vector<uint_fast8_t> current_rom_data_;
+  /// Keeps the ROM library up to date in the background.
+  RomLibraryThread* rom_library_thread_;
 
  private slots:
   /// Called when the user has selected a ROM file to run.